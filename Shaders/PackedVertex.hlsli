@@ -0,0 +1,31 @@
+// Декодирование PackedVertex (src/Core/Mesh/VertexCompression.h).
+// Позиция приходит в [0, 1] и переводится в пространство меша через DequantizePosition
+// по VertexQuantization подмеша; gWorld остаётся обычной матрицей мира. Деквантизацию нельзя
+// домножать на gWorld: её масштаб разный по осям и исказил бы нормали и касательные.
+
+struct PackedVertexIn
+{
+    float4 PosQ : POSITION;      // xyz - позиция, w - знак битангенса (0 или 1)
+    float2 NormalOct : NORMAL;
+    float2 TangentOct : TANGENT;
+    float2 TexC : TEXCOORD;
+};
+
+float3 OctDecode(float2 e)
+{
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+// origin и size - VertexQuantization подмеша
+float3 DequantizePosition(PackedVertexIn vin, float3 origin, float3 size)
+{
+    return origin + vin.PosQ.xyz * size;
+}
+
+float BitangentSign(PackedVertexIn vin)
+{
+    return vin.PosQ.w * 2.0f - 1.0f;
+}
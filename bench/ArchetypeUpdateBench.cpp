@@ -0,0 +1,121 @@
+#include "BenchTimer.h"
+#include "Core/Memory/FrameArena.h"
+#include "FrameworkObjects/Scene.h"
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Updating 100k entities with one IUpdatable component each: the archetype storage through
+// Scene::Update and through a ForEach system loop, against the layout Scene had before, where every
+// entity was a shared_ptr owning its components as separate unique_ptrs and Update was a virtual
+// call per component. Both sides do the same arithmetic; the checksums must match.
+namespace
+{
+    constexpr size_t EntityCount = 100000;
+    constexpr float DeltaTime = 1.0f / 60.0f;
+
+    struct Spinner : Component, IUpdatable
+    {
+        float angle = 0.0f;
+        float speed = 1.0f;
+
+        void Update(float deltaTime) override { angle += speed * deltaTime; }
+    };
+
+    // Not updatable: stands in for the other components an entity usually carries
+    struct Tag : Component
+    {
+        uint32_t value = 0;
+    };
+
+    // Entity and Scene::Update as they were before the archetype storage
+    class LegacyEntity
+    {
+    public:
+        void AddComponent(std::unique_ptr<Component> component)
+        {
+            if (auto* updatable = dynamic_cast<IUpdatable*>(component.get())) updatables.emplace_back(component.get(), updatable);
+            components.push_back(std::move(component));
+        }
+
+        void Update(float deltaTime)
+        {
+            for (auto& [component, updatable] : updatables)
+            {
+                if (component->IsEnabled()) updatable->Update(deltaTime);
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<Component>> components;
+        std::vector<std::pair<Component*, IUpdatable*>> updatables;
+    };
+
+    float SpeedOf(size_t i)
+    {
+        return 0.5f + float(i % 17) * 0.25f;
+    }
+}
+
+int main()
+{
+    std::vector<std::shared_ptr<LegacyEntity>> legacy;
+    std::vector<const Spinner*> legacySpinners; // Only for the checksum
+    legacy.reserve(EntityCount);
+    for (size_t i = 0; i < EntityCount; ++i)
+    {
+        auto entity = std::make_shared<LegacyEntity>();
+        auto spinner = std::make_unique<Spinner>();
+        spinner->speed = SpeedOf(i);
+        legacySpinners.push_back(spinner.get());
+        entity->AddComponent(std::move(spinner));
+        entity->AddComponent(std::make_unique<Tag>());
+        legacy.push_back(std::move(entity));
+    }
+
+    Scene scene;
+    scene.AddEntities<Spinner, Tag>(EntityCount, [](size_t i, Spinner& spinner, Tag& tag)
+    {
+        spinner.speed = SpeedOf(i);
+        tag.value = uint32_t(i);
+    });
+
+    int legacyFrames = 0, sceneFrames = 0, forEachFrames = 0;
+    const double legacyMs = Bench::MedianMs([&]
+    {
+        for (auto& entity : legacy) entity->Update(DeltaTime);
+        ++legacyFrames;
+    });
+    const double sceneMs = Bench::MedianMs([&]
+    {
+        FrameArena::Get().BeginFrame();
+        scene.Update(DeltaTime);
+        ++sceneFrames;
+    });
+
+    // A system-style loop over the same columns, statically dispatched
+    Scene systemScene;
+    systemScene.AddEntities<Spinner, Tag>(EntityCount, [](size_t i, Spinner& spinner, Tag& tag)
+    {
+        spinner.speed = SpeedOf(i);
+        tag.value = uint32_t(i);
+    });
+    const double forEachMs = Bench::MedianMs([&]
+    {
+        systemScene.ForEach<Spinner>([](Entity, Spinner& spinner) { spinner.angle += spinner.speed * DeltaTime; });
+        ++forEachFrames;
+    });
+
+    // Angle sums divided by the frames each side ran
+    double legacySum = 0.0, sceneSum = 0.0, forEachSum = 0.0;
+    for (const Spinner* spinner : legacySpinners) legacySum += spinner->angle;
+    scene.ForEach<Spinner>([&](Entity, Spinner& spinner) { sceneSum += spinner.angle; });
+    systemScene.ForEach<Spinner>([&](Entity, Spinner& spinner) { forEachSum += spinner.angle; });
+
+    std::printf("%zu entities, Spinner + Tag\n", EntityCount);
+    std::printf("%-40s %10.3f ms\n", "unique_ptr components, virtual Update", legacyMs);
+    std::printf("%-40s %10.3f ms (%.1fx)\n", "archetype chunks, Scene::Update", sceneMs, legacyMs / sceneMs);
+    std::printf("%-40s %10.3f ms (%.1fx)\n", "archetype chunks, ForEach", forEachMs, legacyMs / forEachMs);
+    std::printf("angle sums per frame: %.3f / %.3f / %.3f\n", legacySum / legacyFrames, sceneSum / sceneFrames, forEachSum / forEachFrames);
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Timing helpers shared by the benchmarks. Every measurement runs once untimed to warm caches and
+// the job system, then reports the median of the timed repetitions.
+namespace Bench
+{
+    inline double NowMs()
+    {
+        using Clock = std::chrono::steady_clock;
+        return std::chrono::duration<double, std::milli>(Clock::now().time_since_epoch()).count();
+    }
+
+    template<typename Fn>
+    double MedianMs(Fn&& fn, int repetitions = 9)
+    {
+        fn();
+        std::vector<double> times(repetitions);
+        for (double& time : times)
+        {
+            const double start = NowMs();
+            fn();
+            time = NowMs() - start;
+        }
+        std::nth_element(times.begin(), times.begin() + repetitions / 2, times.end());
+        return times[repetitions / 2];
+    }
+
+    // 1, 2, 4, ... up to and including the hardware thread count
+    inline std::vector<unsigned> ThreadCounts(unsigned hardwareThreads)
+    {
+        std::vector<unsigned> counts;
+        for (unsigned count = 1; count < hardwareThreads; count *= 2) counts.push_back(count);
+        counts.push_back(std::max(1u, hardwareThreads));
+        return counts;
+    }
+}
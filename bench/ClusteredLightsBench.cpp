@@ -0,0 +1,83 @@
+#include "BenchTimer.h"
+#include "Core/Common/Camera.h"
+#include "Core/Common/d3dUtil.h"
+#include "Core/Rendering/ClusteredLights.h"
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+// ClusteredLights::Build with 4k point and spot lights spread over a 400 m square around the camera,
+// on the default 16x9x24 grid. Repeated builds must produce identical buffers.
+namespace
+{
+    constexpr size_t LightCount = 4096;
+    constexpr float WorldSize = 400.0f;
+
+    uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    float Random(uint32_t seed, float low, float high)
+    {
+        return low + float(Hash(seed) & 0xFFFFFF) / float(0xFFFFFF) * (high - low);
+    }
+
+    // Three quarters point lights, the rest spots pointing down and sideways; a couple of directional
+    std::vector<Light> MakeLights()
+    {
+        std::vector<Light> lights(LightCount);
+        for (uint32_t i = 0; i < LightCount; ++i)
+        {
+            Light& light = lights[i];
+            const uint32_t seed = 8 * i;
+            light.type = i < 2 ? LightTypeDirectional : (Hash(seed) % 4 == 0 ? LightTypeSpot : LightTypePoint);
+            light.Position = XMFLOAT3(Random(seed + 1, -WorldSize * 0.5f, WorldSize * 0.5f), Random(seed + 2, 0.5f, 20.0f), Random(seed + 3, -WorldSize * 0.5f, WorldSize * 0.5f));
+            light.FalloffStart = 1.0f;
+            light.FalloffEnd = Random(seed + 4, 3.0f, 15.0f);
+            light.SpotPower = Random(seed + 5, 4.0f, 64.0f);
+            XMStoreFloat3(&light.Direction, XMVector3Normalize(XMVectorSet(Random(seed + 6, -1.0f, 1.0f), -1.0f, Random(seed + 7, -1.0f, 1.0f), 0.0f)));
+        }
+        return lights;
+    }
+}
+
+int main()
+{
+    const std::vector<Light> lights = MakeLights();
+    Camera camera;
+    camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 300.0f);
+    camera.LookAt(XMFLOAT3(0.0f, 8.0f, -20.0f), XMFLOAT3(0.0f, 4.0f, 40.0f), XMFLOAT3(0.0f, 1.0f, 0.0f));
+    camera.UpdateViewMatrix();
+
+    ClusteredLights clusters;
+    const double buildMs = Bench::MedianMs([&] { clusters.Build(camera, lights.data(), lights.size()); }, 21);
+
+    const std::vector<ClusterRange> ranges = clusters.GetClusters();
+    const std::vector<uint32_t> indices = clusters.GetLightIndices();
+    clusters.Build(camera, lights.data(), lights.size());
+    bool same = ranges.size() == clusters.GetClusters().size() && indices == clusters.GetLightIndices();
+    for (size_t i = 0; same && i < ranges.size(); ++i)
+    {
+        same = ranges[i].offset == clusters.GetClusters()[i].offset && ranges[i].count == clusters.GetClusters()[i].count;
+    }
+
+    size_t nonEmpty = 0, most = 0;
+    for (const ClusterRange& range : ranges)
+    {
+        nonEmpty += range.count != 0;
+        most = range.count > most ? range.count : most;
+    }
+
+    std::printf("%zu lights, %zu clusters\n", lights.size(), clusters.GetClusterCount());
+    std::printf("%-24s %10.3f ms\n", "Build", buildMs);
+    std::printf("%zu light indices, %zu non-empty clusters, at most %zu lights in one\n", indices.size(), nonEmpty, most);
+    std::printf("repeated builds %s\n", same ? "match" : "DIFFER");
+    return same ? 0 : 1;
+}
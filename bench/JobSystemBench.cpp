@@ -0,0 +1,76 @@
+#include "BenchTimer.h"
+#include "Core/Jobs/JobSystem.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+// Spawn and steal costs of the job system for every thread count up to the hardware's.
+//   spawn:       one thread submits empty jobs and waits for them; cost per job
+//   steal:       one thread submits ~1 us jobs; how many the other workers stole and the speedup
+//   parallelFor: ParallelFor over empty ranges with the default grain; cost per call
+namespace
+{
+    constexpr uint32_t SpawnCount = 100000;
+    constexpr uint32_t StealCount = 20000;
+
+    void Spin(uint32_t iterations)
+    {
+        volatile uint32_t value = 0;
+        for (uint32_t i = 0; i < iterations; ++i) value = value + i;
+    }
+}
+
+int main()
+{
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%u hardware threads\n", hardwareThreads);
+    std::printf("%8s %14s %12s %10s %16s\n", "threads", "spawn ns/job", "steal ms", "stolen %", "parallelFor us");
+
+    // Roughly 1 us of work per stolen job, calibrated once
+    uint32_t spinIterations = 1000;
+    const double spinMs = Bench::MedianMs([&]() { Spin(spinIterations * 1000); });
+    spinIterations = uint32_t(spinIterations / std::max(spinMs, 1e-3));
+
+    for (unsigned threadCount : Bench::ThreadCounts(hardwareThreads))
+    {
+        JobSystem jobs(threadCount);
+
+        const double spawnMs = Bench::MedianMs([&]()
+        {
+            JobCounter counter;
+            for (uint32_t i = 0; i < SpawnCount; ++i) jobs.Run([]() {}, counter);
+            jobs.Wait(counter);
+        });
+
+        std::atomic<uint32_t> stolen{ 0 };
+        const std::thread::id submitter = std::this_thread::get_id();
+        const double stealMs = Bench::MedianMs([&]()
+        {
+            stolen.store(0);
+            JobCounter counter;
+            for (uint32_t i = 0; i < StealCount; ++i)
+            {
+                jobs.Run([&stolen, submitter, spinIterations]()
+                {
+                    Spin(spinIterations);
+                    if (std::this_thread::get_id() != submitter) stolen.fetch_add(1, std::memory_order_relaxed);
+                }, counter);
+            }
+            jobs.Wait(counter);
+        });
+
+        const uint32_t parallelForCalls = 1000;
+        const double parallelForMs = Bench::MedianMs([&]()
+        {
+            for (uint32_t call = 0; call < parallelForCalls; ++call)
+            {
+                jobs.ParallelFor(4096, [](size_t, size_t) {});
+            }
+        });
+
+        std::printf("%8u %14.1f %12.2f %10.1f %16.2f\n", threadCount,
+                    spawnMs * 1e6 / SpawnCount, stealMs, 100.0 * stolen.load() / StealCount,
+                    parallelForMs * 1e3 / parallelForCalls);
+    }
+    return 0;
+}
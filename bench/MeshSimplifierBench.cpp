@@ -0,0 +1,63 @@
+#include "BenchTimer.h"
+#include "Core/Common/GeometryGenerator.h"
+#include "Core/Mesh/MeshOptimizer.h"
+#include "Core/Mesh/MeshSimplifier.h"
+#include <cstdio>
+#include <vector>
+
+// Quadric simplification of a 1M-triangle sphere (with its UV seam and poles) to 10% and 1% of its
+// triangles, a whole LOD chain for it, and chains for eight 130k-triangle meshes built one after
+// another against BuildLodChains, which runs one job per mesh.
+namespace
+{
+    constexpr size_t SmallMeshCount = 8;
+
+    void Simplify(const char* name, const GeometryGenerator::MeshData& mesh, size_t targetIndexCount)
+    {
+        std::vector<uint32_t> destination(mesh.Indices32.size());
+        SimplifySettings settings;
+        settings.targetIndexCount = targetIndexCount;
+        size_t indexCount = 0;
+        float error = 0.0f;
+        const double ms = Bench::MedianMs([&]
+        {
+            indexCount = SimplifyMesh(destination.data(), mesh.Indices32.data(), mesh.Indices32.size(), &mesh.Vertices[0].Position.x,
+                                      sizeof(GeometryGenerator::Vertex), mesh.Vertices.size(), settings, &error);
+        }, 3);
+        std::printf("%-28s %10.3f ms: %zu triangles, error %g\n", name, ms, indexCount / 3, error);
+    }
+}
+
+int main()
+{
+    GeometryGenerator generator;
+    GeometryGenerator::MeshData mesh = generator.CreateSphere(1.0f, 1024, 512);
+    OptimizeMesh(mesh);
+    const size_t indexCount = mesh.Indices32.size();
+    std::printf("%zu triangles, %zu vertices\n", indexCount / 3, mesh.Vertices.size());
+
+    Simplify("SimplifyMesh to 10%", mesh, indexCount / 10 / 3 * 3);
+    Simplify("SimplifyMesh to 1%", mesh, indexCount / 100 / 3 * 3);
+
+    MeshLodChain chain;
+    const double chainMs = Bench::MedianMs([&] { chain = BuildLodChain(mesh); }, 3);
+    std::printf("%-28s %10.3f ms:", "BuildLodChain", chainMs);
+    for (const MeshLodChain::Level& level : chain.levels) std::printf(" %u (%g)", level.indexCount / 3, level.error);
+    std::printf("\n");
+
+    std::vector<GeometryGenerator::MeshData> meshes(SmallMeshCount);
+    for (size_t i = 0; i < SmallMeshCount; ++i)
+    {
+        meshes[i] = generator.CreateSphere(1.0f + float(i) * 0.1f, 256 + uint32_t(i) * 8, 256);
+        OptimizeMesh(meshes[i]);
+    }
+    std::vector<MeshLodChain> chains(SmallMeshCount);
+    const double serialMs = Bench::MedianMs([&]
+    {
+        for (size_t i = 0; i < SmallMeshCount; ++i) chains[i] = BuildLodChain(meshes[i]);
+    }, 3);
+    const double parallelMs = Bench::MedianMs([&] { BuildLodChains(meshes.data(), meshes.size(), chains.data()); }, 3);
+    std::printf("%-28s %10.3f ms\n", "8 chains, one by one", serialMs);
+    std::printf("%-28s %10.3f ms (%.1fx)\n", "8 chains, BuildLodChains", parallelMs, serialMs / parallelMs);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "BenchTimer.h"
+#include "Core/Common/GeometryGenerator.h"
+#include "Core/Memory/FrameArena.h"
+#include "Core/Mesh/MeshOptimizer.h"
+#include "Core/Mesh/Meshlets.h"
+#include "Core/Rendering/FrustumCulling.h"
+#include "Core/Rendering/OcclusionCulling.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+// BuildMeshlets (64 vertices, 124 triangles) on a 1M-triangle sphere, then CullMeshlets for a grid
+// of 8x8 instances of it: frustum and backface cone only, and with a wall in front of the camera
+// rasterized as an occluder. Two builds of the same mesh must be identical.
+namespace
+{
+    constexpr int InstanceRows = 8;
+    constexpr float InstanceSpacing = 3.0f;
+
+    bool SameMeshlets(const MeshletData& a, const MeshletData& b)
+    {
+        return a.meshlets.size() == b.meshlets.size() && a.vertices == b.vertices && a.triangles == b.triangles &&
+               std::memcmp(a.meshlets.data(), b.meshlets.data(), a.meshlets.size() * sizeof(Meshlet)) == 0 &&
+               std::memcmp(a.bounds.data(), b.bounds.data(), a.bounds.size() * sizeof(MeshletBounds)) == 0;
+    }
+}
+
+int main()
+{
+    GeometryGenerator generator;
+    GeometryGenerator::MeshData mesh = generator.CreateSphere(1.0f, 1024, 512);
+    OptimizeMesh(mesh);
+    const float* positions = &mesh.Vertices[0].Position.x;
+    const size_t stride = sizeof(GeometryGenerator::Vertex);
+
+    MeshletData meshlets;
+    const double buildMs = Bench::MedianMs([&]
+    {
+        meshlets = BuildMeshlets(positions, stride, mesh.Vertices.size(), mesh.Indices32.data(), mesh.Indices32.size());
+    }, 5);
+    const bool same = SameMeshlets(meshlets, BuildMeshlets(positions, stride, mesh.Vertices.size(), mesh.Indices32.data(), mesh.Indices32.size()));
+
+    std::vector<XMFLOAT4X4> worlds;
+    for (int z = 0; z < InstanceRows; ++z)
+    {
+        for (int x = 0; x < InstanceRows; ++x)
+        {
+            XMFLOAT4X4 world;
+            XMStoreFloat4x4(&world, XMMatrixTranslation((float(x) - InstanceRows * 0.5f) * InstanceSpacing, 0.0f, 6.0f + float(z) * InstanceSpacing));
+            worlds.push_back(world);
+        }
+    }
+
+    const XMFLOAT3 eye(0.0f, 1.0f, 0.0f);
+    const XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    const XMMATRIX viewProj = XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 200.0f));
+    const Frustum frustum = Frustum::FromViewProj(viewProj);
+
+    std::vector<uint32_t> visible(meshlets.meshlets.size());
+    auto cullAll = [&](const OcclusionCuller* occlusion, MeshletCullStats& stats, size_t& visibleCount)
+    {
+        stats = MeshletCullStats();
+        visibleCount = 0;
+        for (const XMFLOAT4X4& world : worlds)
+        {
+            MeshletCullStats instanceStats;
+            visibleCount += CullMeshlets(meshlets, world, frustum, eye, occlusion, visible.data(), &instanceStats);
+            stats.frustumCulled += instanceStats.frustumCulled;
+            stats.backfaceCulled += instanceStats.backfaceCulled;
+            stats.occlusionCulled += instanceStats.occlusionCulled;
+        }
+    };
+
+    MeshletCullStats coneStats;
+    size_t coneVisible = 0;
+    const double coneMs = Bench::MedianMs([&] { cullAll(nullptr, coneStats, coneVisible); });
+
+    // A narrow wall in front of the camera hiding the middle columns of the grid
+    OccluderMesh wall;
+    wall.positions = { { -1.5f, -2.0f, 4.5f }, { 1.5f, -2.0f, 4.5f }, { 1.5f, 1.5f, 4.5f }, { -1.5f, 1.5f, 4.5f } };
+    wall.indices = { 0, 1, 2, 0, 2, 3 };
+    XMFLOAT4X4 identity;
+    XMStoreFloat4x4(&identity, XMMatrixIdentity());
+    OcclusionCuller occlusion;
+    FrameArena::Get().BeginFrame();
+    occlusion.BeginFrame(viewProj);
+    occlusion.AddOccluder(wall, identity);
+    occlusion.Rasterize();
+
+    MeshletCullStats occlusionStats;
+    size_t occlusionVisible = 0;
+    const double occlusionMs = Bench::MedianMs([&] { cullAll(&occlusion, occlusionStats, occlusionVisible); });
+
+    const size_t total = meshlets.meshlets.size() * worlds.size();
+    std::printf("%zu triangles, %zu meshlets, %zu instances\n", mesh.Indices32.size() / 3, meshlets.meshlets.size(), worlds.size());
+    std::printf("%-32s %10.3f ms (builds %s)\n", "BuildMeshlets", buildMs, same ? "match" : "DIFFER");
+    std::printf("%-32s %10.3f ms: %zu of %zu visible, %u frustum, %u backface\n", "CullMeshlets, frustum + cone", coneMs,
+                coneVisible, total, coneStats.frustumCulled, coneStats.backfaceCulled);
+    std::printf("%-32s %10.3f ms: %zu of %zu visible, %u frustum, %u backface, %u occluded\n", "CullMeshlets, + occlusion", occlusionMs,
+                occlusionVisible, total, occlusionStats.frustumCulled, occlusionStats.backfaceCulled, occlusionStats.occlusionCulled);
+    return same ? 0 : 1;
+}
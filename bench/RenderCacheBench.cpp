@@ -0,0 +1,103 @@
+#include "BenchTimer.h"
+#include "FrameworkObjects/MeshRenderer.h"
+#include "FrameworkObjects/Scene.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Loading a level of 50k MeshRenderer entities into an empty scene: the bulk AddEntities path,
+// entity-by-entity adds with the render cache flushed after every renderer (the default) and with
+// the deferred sort, against the cache as it was before, re-sorted with std::sort on every insert.
+// The old cache is quadratic, so it is timed on a tenth of the renderers.
+namespace
+{
+    constexpr size_t RendererCount = 50000;
+    constexpr size_t LegacyCount = RendererCount / 10;
+
+    uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // A handful of render orders, shuffled, like materials spread across a level
+    int OrderOf(size_t i)
+    {
+        return int(Hash(uint32_t(i)) % 16);
+    }
+
+    // Each repetition loads into a fresh scene; destroying it is not timed
+    template<typename Fn>
+    double MedianLoadMs(Fn&& load, int repetitions = 5)
+    {
+        std::vector<double> times;
+        for (int i = 0; i <= repetitions; ++i)
+        {
+            auto scene = std::make_unique<Scene>();
+            const double start = Bench::NowMs();
+            load(*scene);
+            if (i > 0) times.push_back(Bench::NowMs() - start);
+        }
+        std::nth_element(times.begin(), times.begin() + repetitions / 2, times.end());
+        return times[repetitions / 2];
+    }
+
+    void AddOneByOne(Scene& scene)
+    {
+        for (size_t i = 0; i < RendererCount; ++i)
+        {
+            const Entity entity = scene.CreateEntity();
+            scene.AddComponent<TransformComponent>(entity, float(i % 1000), 0.0f, float(i / 1000));
+            scene.AddComponent<MeshRenderer>(entity, OrderOf(i));
+        }
+    }
+}
+
+int main()
+{
+    const double bulkMs = MedianLoadMs([](Scene& scene)
+    {
+        scene.AddEntities<TransformComponent, MeshRenderer>(RendererCount, [](size_t i, TransformComponent& transform, MeshRenderer& renderer)
+        {
+            transform.SetPosition(DirectX::XMFLOAT3(float(i % 1000), 0.0f, float(i / 1000)));
+            renderer = MeshRenderer(OrderOf(i));
+        });
+        scene.FlushRenderCache();
+    });
+
+    const double immediateMs = MedianLoadMs([](Scene& scene)
+    {
+        AddOneByOne(scene);
+    }, 3);
+
+    const double deferredMs = MedianLoadMs([](Scene& scene)
+    {
+        scene.SetDeferredRenderCacheSort(true);
+        AddOneByOne(scene);
+        scene.FlushRenderCache();
+    });
+
+    // The old Scene::UpdateRenderCache: push the renderer, then sort the whole list by order
+    std::vector<std::unique_ptr<MeshRenderer>> renderers;
+    for (size_t i = 0; i < LegacyCount; ++i) renderers.push_back(std::make_unique<MeshRenderer>(OrderOf(i)));
+    const double legacyMs = Bench::MedianMs([&]
+    {
+        std::vector<RendererComponent*> cache;
+        for (const auto& renderer : renderers)
+        {
+            cache.push_back(renderer.get());
+            std::sort(cache.begin(), cache.end(), [](const RendererComponent* a, const RendererComponent* b) { return a->GetOrder() < b->GetOrder(); });
+        }
+    }, 3);
+
+    std::printf("%-46s %10.3f ms\n", "50k renderers, AddEntities", bulkMs);
+    std::printf("%-46s %10.3f ms\n", "50k renderers, one by one, merged per renderer", immediateMs);
+    std::printf("%-46s %10.3f ms\n", "50k renderers, one by one, deferred sort", deferredMs);
+    std::printf("%-46s %10.3f ms (cache only)\n", "5k renderers, std::sort per renderer (old)", legacyMs);
+    return 0;
+}
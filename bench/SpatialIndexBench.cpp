@@ -0,0 +1,170 @@
+#include "BenchTimer.h"
+#include "Core/Memory/FrameArena.h"
+#include "FrameworkObjects/Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+// The scene's spatial index with 100k static renderers plus 10k movers per frame: the cost of
+// Scene::Update when nothing moves, when transforms move and when only renderer bounds change,
+// then queries through the index against a linear scan over the same entities.
+namespace
+{
+    constexpr uint32_t StaticCount = 100000;
+    constexpr uint32_t MoverCount = 10000;
+    constexpr float WorldSize = 1000.0f;
+    constexpr int QueryCount = 1000;
+
+    struct BoxRenderer : RendererComponent
+    {
+        void Render(ComPtr<ID3D12GraphicsCommandList>&) override {}
+    };
+
+    uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    float Random(uint32_t seed, float range)
+    {
+        return float(Hash(seed) & 0xFFFFFF) / float(0xFFFFFF) * range;
+    }
+
+    XMFLOAT3 RandomPoint(uint32_t seed)
+    {
+        return XMFLOAT3(Random(seed * 3, WorldSize), Random(seed * 3 + 1, 50.0f), Random(seed * 3 + 2, WorldSize));
+    }
+
+    BoundingBox RandomBox(uint32_t seed)
+    {
+        const float size = 0.5f + Random(seed, 2.0f);
+        return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(size, size, size));
+    }
+}
+
+int main()
+{
+    Scene scene;
+    std::vector<Entity> statics;
+    std::vector<Entity> movers;
+    scene.AddEntities<TransformComponent, BoxRenderer>(StaticCount, [](size_t i, TransformComponent& transform, BoxRenderer& renderer)
+    {
+        transform.SetPosition(RandomPoint(uint32_t(i)));
+        renderer.SetBounds(RandomBox(uint32_t(i)));
+    }, &statics);
+    scene.AddEntities<TransformComponent, BoxRenderer>(MoverCount, [](size_t i, TransformComponent& transform, BoxRenderer& renderer)
+    {
+        transform.SetPosition(RandomPoint(uint32_t(StaticCount + i)));
+        renderer.SetBounds(RandomBox(uint32_t(StaticCount + i)));
+    }, &movers);
+
+    FrameArena::Get().BeginFrame();
+    const double buildStart = Bench::NowMs();
+    scene.Update(0.0f);
+    const double buildMs = Bench::NowMs() - buildStart;
+    std::printf("%u static + %u moving renderers\n", StaticCount, MoverCount);
+    std::printf("%-34s %10.3f ms\n", "first Update (builds the index)", buildMs);
+
+    const double idleMs = Bench::MedianMs([&]
+    {
+        FrameArena::Get().BeginFrame();
+        scene.Update(0.0f);
+    });
+    std::printf("%-34s %10.3f ms\n", "Update, nothing moved", idleMs);
+
+    uint32_t frame = 0;
+    const double moveMs = Bench::MedianMs([&]
+    {
+        FrameArena::Get().BeginFrame();
+        ++frame;
+        for (Entity mover : movers)
+        {
+            TransformComponent* transform = scene.GetComponent<TransformComponent>(mover);
+            XMFLOAT3 position = transform->GetPosition();
+            position.x += Random(mover.index + frame, 2.0f) - 1.0f;
+            position.z += Random(mover.index ^ frame, 2.0f) - 1.0f;
+            transform->SetPosition(position);
+        }
+        scene.Update(1.0f / 60.0f);
+    });
+    std::printf("%-34s %10.3f ms\n", "Update, 10k transforms moved", moveMs);
+
+    const double boundsMs = Bench::MedianMs([&]
+    {
+        FrameArena::Get().BeginFrame();
+        ++frame;
+        for (Entity mover : movers)
+        {
+            scene.GetComponent<BoxRenderer>(mover)->SetBounds(RandomBox(mover.index + frame));
+        }
+        scene.Update(1.0f / 60.0f);
+    });
+    std::printf("%-34s %10.3f ms\n", "Update, 10k bounds changed", boundsMs);
+
+    // Queries: the index against testing every entity's world box
+    std::vector<BoundingSphere> spheres;
+    for (int i = 0; i < QueryCount; ++i) spheres.emplace_back(RandomPoint(uint32_t(7 * i + 1)), 20.0f);
+
+    size_t indexHits = 0;
+    const double sphereMs = Bench::MedianMs([&]
+    {
+        indexHits = 0;
+        for (const BoundingSphere& sphere : spheres) scene.QuerySphere(sphere, [&](Entity) { ++indexHits; });
+    });
+
+    size_t scanHits = 0;
+    const double scanMs = Bench::MedianMs([&]
+    {
+        scanHits = 0;
+        scene.ForEach<TransformComponent, BoxRenderer>([&](Entity, TransformComponent& transform, BoxRenderer& renderer)
+        {
+            XMFLOAT3 center, extents;
+            TransformBounds(renderer.GetBounds(), transform.GetWorldMatrix(), center, extents);
+            for (const BoundingSphere& sphere : spheres)
+            {
+                float distanceSquared = 0.0f;
+                const float c[3] = { center.x, center.y, center.z }, e[3] = { extents.x, extents.y, extents.z };
+                const float s[3] = { sphere.Center.x, sphere.Center.y, sphere.Center.z };
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    const float d = std::max(std::abs(s[axis] - c[axis]) - e[axis], 0.0f);
+                    distanceSquared += d * d;
+                }
+                if (distanceSquared <= sphere.Radius * sphere.Radius) ++scanHits;
+            }
+        });
+    }, 3);
+    std::printf("%-34s %10.3f ms (%zu hits)\n", "1000 sphere queries, index", sphereMs, indexHits);
+    std::printf("%-34s %10.3f ms (%zu hits)\n", "1000 sphere queries, linear scan", scanMs, scanHits);
+
+    size_t rayHits = 0;
+    const double rayMs = Bench::MedianMs([&]
+    {
+        rayHits = 0;
+        for (int i = 0; i < QueryCount; ++i)
+        {
+            const XMFLOAT3 origin(Random(uint32_t(i), WorldSize), 200.0f, Random(uint32_t(i) + 77, WorldSize));
+            if (!scene.Raycast(origin, XMFLOAT3(0.0f, -1.0f, 0.0f), 400.0f).IsNull()) ++rayHits;
+        }
+    });
+    std::printf("%-34s %10.3f ms (%zu hits)\n", "1000 raycasts", rayMs, rayHits);
+
+    const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(WorldSize * 0.5f, 30.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    const Frustum frustum = Frustum::FromViewProj(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 300.0f)));
+    size_t frustumHits = 0;
+    const double frustumMs = Bench::MedianMs([&]
+    {
+        frustumHits = 0;
+        scene.QueryFrustum(frustum, [&](Entity) { ++frustumHits; });
+    });
+    std::printf("%-34s %10.3f ms (%zu hits)\n", "frustum query", frustumMs, frustumHits);
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "BenchTimer.h"
+#include "Core/Memory/FrameArena.h"
+#include "FrameworkObjects/Scene.h"
+#include "FrameworkObjects/SceneCommandBuffer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Scene::Update on 200k entities for 1..N job threads: three systems in one wave, two of them
+// iterating in parallel and one also recording structural changes, followed by command playback.
+// The engine-wide JobSystem is sized once per process, so every thread count runs in a child
+// process (the executable started with --threads N). The state hash must be the same on every row.
+namespace
+{
+    constexpr size_t EntityCount = 200000;
+    constexpr int FrameCount = 30;
+
+    struct Position : Component { float x = 0, y = 0, z = 0; };
+    struct Velocity : Component { float x = 0, y = 0, z = 0; };
+    struct Lifetime : Component { uint32_t seed = 0; uint32_t age = 0; };
+
+    uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    class MoveSystem : public System
+    {
+    public:
+        MoveSystem() { Reads<Velocity>(); Writes<Position>(); }
+
+        void Update(Scene& scene, float deltaTime) override
+        {
+            scene.ForEachParallel<Position, Velocity>([deltaTime](Entity, Position& position, Velocity& velocity)
+            {
+                position.x += velocity.x * deltaTime;
+                position.y += velocity.y * deltaTime;
+                position.z += velocity.z * deltaTime;
+            });
+        }
+    };
+
+    // About 1% of entities expire every frame and are replaced by new ones through the command buffer
+    class LifetimeSystem : public System
+    {
+    public:
+        LifetimeSystem() { Writes<Lifetime>(); }
+
+        void Update(Scene& scene, float) override
+        {
+            SceneCommandBuffer& commands = scene.GetCommandBuffer();
+            scene.ForEachParallel<Lifetime>([&commands](Entity entity, Lifetime& lifetime)
+            {
+                ++lifetime.age;
+                if (Hash(lifetime.seed + lifetime.age) % 100 != 0) return;
+
+                commands.RemoveEntity(entity);
+                const Entity spawned = commands.CreateEntity();
+                Position position;
+                position.x = float(Hash(lifetime.seed) % 1000);
+                Velocity velocity;
+                velocity.y = 1.0f;
+                Lifetime child;
+                child.seed = Hash(lifetime.seed ^ lifetime.age);
+                commands.AddComponent<Position>(spawned, position);
+                commands.AddComponent<Velocity>(spawned, velocity);
+                commands.AddComponent<Lifetime>(spawned, child);
+            });
+        }
+    };
+
+    // Independent of the other two, so the wave has three systems
+    class IdleSystem : public System
+    {
+    public:
+        IdleSystem() { Reads<Velocity>(); }
+
+        void Update(Scene& scene, float) override
+        {
+            float sum = 0.0f;
+            scene.ForEach<Velocity>([&sum](Entity, Velocity& velocity) { sum += velocity.x; });
+            m_sum = sum;
+        }
+
+    private:
+        float m_sum = 0.0f;
+    };
+
+    uint64_t HashScene(Scene& scene)
+    {
+        uint64_t hash = 1469598103934665603ull;
+        auto mix = [&hash](uint64_t value)
+        {
+            hash ^= value;
+            hash *= 1099511628211ull;
+        };
+        scene.ForEach<Position, Lifetime>([&](Entity entity, Position& position, Lifetime& lifetime)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &position.x, sizeof(bits));
+            mix((uint64_t(entity.index) << 32) | entity.generation);
+            mix((uint64_t(bits) << 32) | lifetime.seed);
+        });
+        return hash;
+    }
+
+    void RunWithThreads(unsigned threadCount)
+    {
+        JobSystem::SetDefaultThreadCount(threadCount);
+        Scene scene;
+        scene.AddEntities<Position, Velocity, Lifetime>(EntityCount, [](size_t i, Position& position, Velocity& velocity, Lifetime& lifetime)
+        {
+            position.x = float(i % 1000);
+            position.z = float(i / 1000);
+            velocity.x = 1.0f;
+            lifetime.seed = Hash(uint32_t(i));
+        });
+        scene.AddSystem(std::make_unique<MoveSystem>());
+        scene.AddSystem(std::make_unique<LifetimeSystem>());
+        scene.AddSystem(std::make_unique<IdleSystem>());
+
+        FrameArena::Get().BeginFrame();
+        scene.Update(1.0f / 60.0f);
+        const double start = Bench::NowMs();
+        for (int frame = 0; frame < FrameCount; ++frame)
+        {
+            FrameArena::Get().BeginFrame();
+            scene.Update(1.0f / 60.0f);
+        }
+        const double frameMs = (Bench::NowMs() - start) / FrameCount;
+
+        std::printf("%8u %12.2f %18llx\n", threadCount, frameMs, static_cast<unsigned long long>(HashScene(scene)));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && std::strcmp(argv[1], "--threads") == 0)
+    {
+        RunWithThreads(static_cast<unsigned>(std::atoi(argv[2])));
+        return 0;
+    }
+
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("%zu entities, %d frames, %u hardware threads\n", EntityCount, FrameCount, hardwareThreads);
+    std::printf("%8s %12s %18s\n", "threads", "ms/frame", "state hash");
+    std::fflush(stdout);
+    for (unsigned threadCount : Bench::ThreadCounts(hardwareThreads))
+    {
+        const std::string command = "\"" + std::string(argv[0]) + "\" --threads " + std::to_string(threadCount);
+        if (std::system(command.c_str()) != 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "BenchTimer.h"
+#include "Core/Common/GeometryGenerator.h"
+#include "Core/Mesh/TangentSpace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using MeshData = GeometryGenerator::MeshData;
+
+// GenerateTangents over a Sponza-sized set of meshes (about 300k triangles in 100 meshes): spheres,
+// cylinders, and grids whose UVs are mirrored about their middle column, so the vertices of that column split.
+// Tangents are cleared first, as an importer would leave them. Two runs must give identical vertices.
+namespace
+{
+    MeshData MirrorU(MeshData mesh)
+    {
+        for (GeometryGenerator::Vertex& vertex : mesh.Vertices)
+        {
+            if (vertex.TexC.x > 0.5f) vertex.TexC.x = 1.0f - vertex.TexC.x;
+        }
+        return mesh;
+    }
+
+    std::vector<MeshData> MakeMeshes()
+    {
+        GeometryGenerator generator;
+        std::vector<MeshData> meshes;
+        for (int i = 0; i < 40; ++i) meshes.push_back(generator.CreateSphere(1.0f + float(i) * 0.05f, 64, 32));
+        for (int i = 0; i < 40; ++i) meshes.push_back(generator.CreateCylinder(1.0f, 0.5f, 3.0f, 32, 16));
+        for (int i = 0; i < 20; ++i) meshes.push_back(MirrorU(generator.CreateGrid(20.0f, 20.0f, 51, 51)));
+        for (MeshData& mesh : meshes)
+        {
+            for (GeometryGenerator::Vertex& vertex : mesh.Vertices) vertex.TangentU = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+        return meshes;
+    }
+
+    bool SameVertices(const std::vector<MeshData>& a, const std::vector<MeshData>& b)
+    {
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (a[i].Vertices.size() != b[i].Vertices.size() || a[i].Indices32 != b[i].Indices32 ||
+                std::memcmp(a[i].Vertices.data(), b[i].Vertices.data(), a[i].Vertices.size() * sizeof(GeometryGenerator::Vertex)) != 0)
+                return false;
+        }
+        return true;
+    }
+}
+
+int main()
+{
+    const std::vector<MeshData> source = MakeMeshes();
+    size_t triangleCount = 0, vertexCount = 0;
+    for (const MeshData& mesh : source)
+    {
+        triangleCount += mesh.Indices32.size() / 3;
+        vertexCount += mesh.Vertices.size();
+    }
+
+    // Each repetition starts from the untouched meshes; copying is not timed
+    std::vector<MeshData> meshes, first;
+    std::vector<double> times;
+    for (int repetition = 0; repetition < 6; ++repetition)
+    {
+        meshes = source;
+        const double start = Bench::NowMs();
+        for (MeshData& mesh : meshes) GenerateTangents(mesh);
+        if (repetition > 0) times.push_back(Bench::NowMs() - start);
+        if (repetition == 0) first = meshes;
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    const bool same = SameVertices(first, meshes);
+
+    size_t splitCount = 0;
+    for (const MeshData& mesh : meshes) splitCount += mesh.Vertices.size();
+    splitCount -= vertexCount;
+
+    std::printf("%zu meshes, %zu triangles, %zu vertices\n", source.size(), triangleCount, vertexCount);
+    std::printf("%-24s %10.3f ms (%zu vertices split)\n", "GenerateTangents", times[times.size() / 2], splitCount);
+    std::printf("repeated runs %s\n", same ? "match" : "DIFFER");
+    return same ? 0 : 1;
+}
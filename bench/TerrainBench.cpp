@@ -0,0 +1,106 @@
+#include "BenchTimer.h"
+#include "Core/Terrain/HeightField.h"
+#include "Core/Terrain/Terrain.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+// Chunked LOD terrain from one of the shipped heightmaps: loading the DDS, building the quadtree,
+// the first view until every chunk it needs is generated, then a 600-frame flight across the terrain
+// with chunks requested by Select, generated on the job system while the frame would be rendered
+// and released after a second unused. Triangles drawn per frame are compared with the single
+// CreateGrid mesh at the finest level's resolution.
+// Run from the repository root or pass the heightmap path.
+namespace
+{
+    constexpr int FrameCount = 600;
+    constexpr uint32_t ReleaseAfterFrames = 60;
+
+    Frustum MakeFrustum(const XMFLOAT3& eye, const XMFLOAT3& direction, float fovY)
+    {
+        const XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), XMLoadFloat3(&direction), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return Frustum::FromViewProj(XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(fovY, 16.0f / 9.0f, 0.5f, 2000.0f)));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "assets/textures/sponza_textures/HeightMap.dds";
+    HeightField heightField;
+    const double loadStart = Bench::NowMs();
+    if (!heightField.LoadDds(path))
+    {
+        std::fprintf(stderr, "cannot load %s\n", path);
+        return 1;
+    }
+    const double loadMs = Bench::NowMs() - loadStart;
+
+    const TerrainSettings settings;
+    Terrain terrain;
+    const double buildMs = Bench::MedianMs([&] { terrain.Build(heightField, settings); }, 5);
+
+    const float fovY = 0.25f * XM_PI;
+    LodSelector selector;
+    selector.Setup(LodSettings(), fovY);
+    const uint32_t chunkTriangles = uint32_t(terrain.GetChunkIndices().size() / 3);
+    std::vector<uint32_t> nodes;
+
+    // Flying along the x axis a few meters above the ground, looking ahead and slightly down
+    auto cameraAt = [&](int frame, XMFLOAT3& eye, XMFLOAT3& direction)
+    {
+        const float t = float(frame) / float(FrameCount);
+        const float x = (t - 0.5f) * settings.size * 0.9f;
+        const float z = std::sin(t * XM_2PI) * settings.size * 0.25f;
+        eye = XMFLOAT3(x, terrain.GetHeight(x, z) + 10.0f, z);
+        direction = XMFLOAT3(1.0f, -0.15f, std::cos(t * XM_2PI) * 0.5f);
+    };
+
+    XMFLOAT3 eye, direction;
+    cameraAt(0, eye, direction);
+    const double firstStart = Bench::NowMs();
+    int firstFrames = 0;
+    for (std::vector<uint32_t> previous;; previous = nodes)
+    {
+        nodes.clear();
+        terrain.Select(MakeFrustum(eye, direction, fovY), eye, selector, nodes);
+        terrain.WaitForChunks();
+        ++firstFrames;
+        if (!nodes.empty() && nodes == previous) break;
+    }
+    const double firstMs = Bench::NowMs() - firstStart;
+
+    std::vector<double> selectMs, generateMs;
+    size_t drawnChunks = 0, mostChunks = 0;
+    for (int frame = 0; frame < FrameCount; ++frame)
+    {
+        cameraAt(frame, eye, direction);
+        nodes.clear();
+        const double start = Bench::NowMs();
+        terrain.Select(MakeFrustum(eye, direction, fovY), eye, selector, nodes);
+        terrain.ReleaseChunks(ReleaseAfterFrames);
+        selectMs.push_back(Bench::NowMs() - start);
+        drawnChunks += nodes.size();
+        mostChunks = std::max(mostChunks, nodes.size());
+
+        const double generateStart = Bench::NowMs();
+        terrain.WaitForChunks();
+        generateMs.push_back(Bench::NowMs() - generateStart);
+    }
+    std::sort(selectMs.begin(), selectMs.end());
+    std::sort(generateMs.begin(), generateMs.end());
+
+    const uint32_t finestQuads = settings.chunkQuads << (settings.levelCount - 1);
+    std::printf("%s: %ux%u samples, %u nodes\n", path, heightField.GetWidth(), heightField.GetHeight(), terrain.GetNodeCount());
+    std::printf("%-36s %10.3f ms\n", "LoadDds", loadMs);
+    std::printf("%-36s %10.3f ms\n", "Build", buildMs);
+    std::printf("%-36s %10.3f ms (%d Select calls)\n", "first view, all chunks generated", firstMs, firstFrames);
+    std::printf("%-36s %10.3f ms median, %.3f ms max\n", "Select + ReleaseChunks per frame", selectMs[selectMs.size() / 2], selectMs.back());
+    std::printf("%-36s %10.3f ms median, %.3f ms max\n", "chunk generation per frame", generateMs[generateMs.size() / 2], generateMs.back());
+    std::printf("chunks drawn: %.1f on average, %zu at most, %u triangles each with skirts\n", double(drawnChunks) / FrameCount, mostChunks, chunkTriangles);
+    std::printf("triangles drawn: %.0f on average against %u for one %ux%u grid\n", double(drawnChunks) / FrameCount * chunkTriangles,
+                finestQuads * finestQuads * 2, finestQuads, finestQuads);
+    return 0;
+}
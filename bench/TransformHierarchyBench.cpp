@@ -0,0 +1,146 @@
+#include "BenchTimer.h"
+#include "FrameworkObjects/Component.h"
+#include "FrameworkObjects/IUpdatable.h"
+#include "FrameworkObjects/TransformHierarchy.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace DirectX;
+
+// World matrices of 100k transforms in a three-level hierarchy (1000 roots, 9 children each, 10
+// grandchildren per child): TransformHierarchy::Update when every root moved, when 1% of the roots
+// moved and when nothing moved, against a heap-allocated transform component per entity that
+// recomputes its world matrix from its parent's in a virtual Update every frame.
+namespace
+{
+    constexpr uint32_t RootCount = 1000;
+    constexpr uint32_t ChildCount = 9;
+    constexpr uint32_t GrandchildCount = 10;
+
+    // Per-entity transform as a component: no dirty tracking, every frame recomputes everything
+    class LegacyTransform : public Component, public IUpdatable
+    {
+    public:
+        LegacyTransform(const LegacyTransform* parent, const LocalTransform& local) : parent(parent), local(local) {}
+
+        void Update(float) override
+        {
+            XMMATRIX matrix = XMMatrixAffineTransformation(XMLoadFloat3(&local.scale), XMVectorZero(), XMLoadFloat4(&local.rotation), XMLoadFloat3(&local.position));
+            if (parent) matrix = XMMatrixMultiply(matrix, XMLoadFloat4x4(&parent->world));
+            XMStoreFloat4x4(&world, matrix);
+        }
+
+        const LegacyTransform* parent;
+        LocalTransform local;
+        XMFLOAT4X4 world;
+    };
+
+    LocalTransform MakeLocal(uint32_t i)
+    {
+        LocalTransform local;
+        local.position = XMFLOAT3(float(i % 97), float(i % 13) * 0.5f, float(i % 89));
+        XMStoreFloat4(&local.rotation, XMQuaternionRotationRollPitchYaw(0.0f, float(i % 360) * XM_PI / 180.0f, 0.0f));
+        local.scale = XMFLOAT3(1.0f, 1.0f + float(i % 3) * 0.1f, 1.0f);
+        return local;
+    }
+
+    XMFLOAT3 RootPosition(uint32_t root, uint32_t frame)
+    {
+        return XMFLOAT3(float(root) * 10.0f, std::sin(float(frame) * 0.1f), float(frame % 100));
+    }
+}
+
+int main()
+{
+    // Created depth first, so every parent precedes its children in both representations
+    TransformHierarchy hierarchy;
+    std::vector<std::unique_ptr<LegacyTransform>> legacy;
+    std::vector<uint32_t> nodes; // Node of legacy[i]
+    std::vector<uint32_t> rootNodes;
+    std::vector<LegacyTransform*> legacyRoots;
+    uint32_t index = 0;
+    auto add = [&](uint32_t parentNode, const LegacyTransform* parent)
+    {
+        const LocalTransform local = MakeLocal(index++);
+        const uint32_t node = hierarchy.Create(local);
+        if (parentNode != TransformHierarchy::InvalidNode) hierarchy.SetParent(node, parentNode);
+        legacy.push_back(std::make_unique<LegacyTransform>(parent, local));
+        nodes.push_back(node);
+        return node;
+    };
+    for (uint32_t root = 0; root < RootCount; ++root)
+    {
+        const uint32_t rootNode = add(TransformHierarchy::InvalidNode, nullptr);
+        LegacyTransform* rootTransform = legacy.back().get();
+        rootNodes.push_back(rootNode);
+        legacyRoots.push_back(rootTransform);
+        for (uint32_t child = 0; child < ChildCount; ++child)
+        {
+            const uint32_t childNode = add(rootNode, rootTransform);
+            const LegacyTransform* childTransform = legacy.back().get();
+            for (uint32_t grandchild = 0; grandchild < GrandchildCount; ++grandchild) add(childNode, childTransform);
+        }
+    }
+    hierarchy.Update();
+
+    uint32_t frame = 0;
+    const double legacyMs = Bench::MedianMs([&]
+    {
+        ++frame;
+        for (uint32_t root = 0; root < RootCount; ++root) legacyRoots[root]->local.position = RootPosition(root, frame);
+        for (auto& transform : legacy)
+        {
+            IUpdatable* updatable = transform.get();
+            updatable->Update(0.0f);
+        }
+    });
+
+    const double allMs = Bench::MedianMs([&]
+    {
+        ++frame;
+        for (uint32_t root = 0; root < RootCount; ++root) hierarchy.SetPosition(rootNodes[root], RootPosition(root, frame));
+        hierarchy.Update();
+    });
+
+    size_t someUpdated = 0;
+    const double someMs = Bench::MedianMs([&]
+    {
+        ++frame;
+        for (uint32_t root = frame % 100; root < RootCount; root += 100) hierarchy.SetPosition(rootNodes[root], RootPosition(root, frame));
+        hierarchy.Update();
+        someUpdated = hierarchy.GetUpdatedNodeCount();
+    });
+
+    const double idleMs = Bench::MedianMs([&] { hierarchy.Update(); });
+
+    // Same root positions on both sides, then every world matrix must agree
+    ++frame;
+    for (uint32_t root = 0; root < RootCount; ++root)
+    {
+        hierarchy.SetPosition(rootNodes[root], RootPosition(root, frame));
+        legacyRoots[root]->local.position = RootPosition(root, frame);
+    }
+    hierarchy.Update();
+    for (auto& transform : legacy) transform->Update(0.0f);
+    float maxError = 0.0f;
+    for (size_t i = 0; i < legacy.size(); ++i)
+    {
+        const XMFLOAT4X4& a = hierarchy.GetWorldMatrix(nodes[i]);
+        const XMFLOAT4X4& b = legacy[i]->world;
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int column = 0; column < 4; ++column) maxError = std::max(maxError, std::fabs(a.m[row][column] - b.m[row][column]));
+        }
+    }
+
+    std::printf("%zu transforms, %zu levels\n", hierarchy.GetNodeCount(), hierarchy.GetLevelCount());
+    std::printf("%-42s %10.3f ms\n", "per-entity virtual Update, all recomputed", legacyMs);
+    std::printf("%-42s %10.3f ms (%.1fx)\n", "hierarchy, every root moved", allMs, legacyMs / allMs);
+    std::printf("%-42s %10.3f ms (%zu nodes updated)\n", "hierarchy, 1% of the roots moved", someMs, someUpdated);
+    std::printf("%-42s %10.3f ms\n", "hierarchy, nothing moved", idleMs);
+    std::printf("largest world matrix difference: %g\n", maxError);
+    return 0;
+}
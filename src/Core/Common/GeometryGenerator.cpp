@@ -3,10 +3,314 @@
 //***************************************************************************************
 
 #include "GeometryGenerator.h"
+#include "MappedFile.h"
+#include "../Jobs/JobSystem.h"
+#include "../Mesh/MeshOptimizer.h"
+#include "../Mesh/TangentSpace.h"
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <type_traits>
 using namespace DirectX;
 
+namespace
+{
+	using Vertex = GeometryGenerator::Vertex;
+	using MeshData = GeometryGenerator::MeshData;
+
+	static_assert(std::is_trivially_copyable_v<Vertex>, "the mesh cache stores vertices as raw bytes");
+
+	// Binary cache written next to a model as "<model>.meshcache": MeshCacheHeader, one
+	// MeshCacheEntry per mesh, then the arrays and strings of every mesh at the offsets given by
+	// its entry, each 4-byte aligned. The cache is rebuilt when the model's size or modification
+	// time, the format version or the vertex layout change.
+	const uint32_t MeshCacheMagic = 0x48534D4E; // "NMSH"
+	const uint32_t MeshCacheVersion = 5; // 2: meshes are stored optimized, 3: meshlets, 4: 16-bit indices, 5: MikkTSpace tangents
+
+	struct MeshCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertexSize;
+		uint32_t meshCount;
+		uint64_t sourceSize;
+		int64_t sourceTime;
+	};
+
+	struct MeshCacheEntry
+	{
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+		uint64_t meshletOffset;
+		uint64_t meshletBoundsOffset;
+		uint64_t meshletVertexOffset;
+		uint64_t meshletTriangleOffset;
+		uint64_t stringOffset; // matName immediately followed by texfile
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t meshletCount;
+		uint32_t meshletVertexCount;
+		uint32_t meshletTriangleCount; // In bytes, like MeshletData::triangles
+		uint32_t matNameLength;
+		uint32_t texfileLength;
+		uint32_t indexSize; // 2 or 4 bytes, as chosen by MeshData::PackIndices
+	};
+
+	static_assert(std::is_trivially_copyable_v<Meshlet> && std::is_trivially_copyable_v<MeshletBounds>, "meshlets are cached as raw bytes");
+
+	bool GetSourceStamp(const std::string& filename, uint64_t& size, int64_t& time)
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(filename, error);
+		if(error)
+			return false;
+		time = static_cast<int64_t>(std::filesystem::last_write_time(filename, error).time_since_epoch().count());
+		return !error;
+	}
+
+	bool FitsIn(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+	{
+		return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+
+	template<typename T>
+	void CopyFromCache(std::vector<T>& destination, const uint8_t* data, uint64_t offset, uint32_t count)
+	{
+		destination.resize(count);
+		std::memcpy(destination.data(), data + offset, size_t(count) * sizeof(T));
+	}
+
+	// The cache is trusted no more than the model: an index past the end of its array would make
+	// the renderer or the meshlet culling read outside a buffer, so such a cache is rejected.
+	template<typename T>
+	bool IndicesInRange(const std::vector<T>& indices, uint32_t count)
+	{
+		for(T index : indices)
+		{
+			if(index >= count)
+				return false;
+		}
+		return true;
+	}
+
+	bool MeshletsInRange(const MeshletData& data, uint32_t vertexCount)
+	{
+		if(!IndicesInRange(data.vertices, vertexCount))
+			return false;
+		for(const Meshlet& meshlet : data.meshlets)
+		{
+			if(uint64_t(meshlet.vertexOffset) + meshlet.vertexCount > data.vertices.size() ||
+			   uint64_t(meshlet.triangleOffset) + uint64_t(meshlet.triangleCount) * 3 > data.triangles.size())
+				return false;
+			const uint8_t* triangles = data.triangles.data() + meshlet.triangleOffset;
+			for(size_t i = 0; i < size_t(meshlet.triangleCount) * 3; ++i)
+			{
+				if(triangles[i] >= meshlet.vertexCount)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool ReadMeshCache(const std::filesystem::path& cachePath, uint64_t sourceSize, int64_t sourceTime, std::vector<MeshData>& meshes)
+	{
+		MappedFile file;
+		if(!file.Open(cachePath) || file.GetSize() < sizeof(MeshCacheHeader))
+			return false;
+
+		const uint8_t* data = file.GetData();
+		const uint64_t fileSize = file.GetSize();
+		MeshCacheHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		if(header.magic != MeshCacheMagic || header.version != MeshCacheVersion || header.vertexSize != sizeof(Vertex) ||
+		   header.sourceSize != sourceSize || header.sourceTime != sourceTime ||
+		   !FitsIn(sizeof(header), header.meshCount, sizeof(MeshCacheEntry), fileSize))
+			return false;
+
+		std::vector<MeshCacheEntry> entries(header.meshCount);
+		std::memcpy(entries.data(), data + sizeof(header), entries.size() * sizeof(MeshCacheEntry));
+		for(const MeshCacheEntry& entry : entries)
+		{
+			if(entry.indexSize != sizeof(uint16_t) && entry.indexSize != sizeof(uint32_t))
+				return false;
+			if(!FitsIn(entry.vertexOffset, entry.vertexCount, sizeof(Vertex), fileSize) ||
+			   !FitsIn(entry.indexOffset, entry.indexCount, entry.indexSize, fileSize) ||
+			   !FitsIn(entry.meshletOffset, entry.meshletCount, sizeof(Meshlet), fileSize) ||
+			   !FitsIn(entry.meshletBoundsOffset, entry.meshletCount, sizeof(MeshletBounds), fileSize) ||
+			   !FitsIn(entry.meshletVertexOffset, entry.meshletVertexCount, sizeof(uint32_t), fileSize) ||
+			   !FitsIn(entry.meshletTriangleOffset, entry.meshletTriangleCount, 1, fileSize) ||
+			   !FitsIn(entry.stringOffset, uint64_t(entry.matNameLength) + entry.texfileLength, 1, fileSize))
+				return false;
+		}
+
+		// Pages of the view are faulted in by the copying jobs in parallel; each job also checks
+		// the indices of its meshes while they are hot in cache
+		meshes.resize(entries.size());
+		std::atomic<bool> valid{ true };
+		JobSystem::Get().ParallelFor(entries.size(), [&](size_t first, size_t last)
+		{
+			for(size_t i = first; i < last && valid.load(std::memory_order_relaxed); ++i)
+			{
+				const MeshCacheEntry& entry = entries[i];
+				MeshData& meshData = meshes[i];
+				CopyFromCache(meshData.Vertices, data, entry.vertexOffset, entry.vertexCount);
+				if(entry.indexSize == sizeof(uint16_t))
+					CopyFromCache(meshData.Indices16, data, entry.indexOffset, entry.indexCount);
+				else
+					CopyFromCache(meshData.Indices32, data, entry.indexOffset, entry.indexCount);
+				CopyFromCache(meshData.Meshlets.meshlets, data, entry.meshletOffset, entry.meshletCount);
+				CopyFromCache(meshData.Meshlets.bounds, data, entry.meshletBoundsOffset, entry.meshletCount);
+				CopyFromCache(meshData.Meshlets.vertices, data, entry.meshletVertexOffset, entry.meshletVertexCount);
+				CopyFromCache(meshData.Meshlets.triangles, data, entry.meshletTriangleOffset, entry.meshletTriangleCount);
+				const char* strings = reinterpret_cast<const char*>(data + entry.stringOffset);
+				meshData.matName.assign(strings, entry.matNameLength);
+				meshData.texfile.assign(strings + entry.matNameLength, entry.texfileLength);
+
+				const bool indicesValid = entry.indexSize == sizeof(uint16_t) ? IndicesInRange(meshData.Indices16, entry.vertexCount)
+				                                                                : IndicesInRange(meshData.Indices32, entry.vertexCount);
+				if(!indicesValid || !MeshletsInRange(meshData.Meshlets, entry.vertexCount))
+					valid.store(false, std::memory_order_relaxed);
+			}
+		}, 1);
+
+		// A corrupt cache is treated like a missing one and the model is imported again
+		if(!valid.load(std::memory_order_relaxed))
+		{
+			meshes.clear();
+			return false;
+		}
+		return true;
+	}
+
+	void WriteMeshCache(const std::filesystem::path& cachePath, uint64_t sourceSize, int64_t sourceTime, const std::vector<MeshData>& meshes)
+	{
+		const MeshCacheHeader header = { MeshCacheMagic, MeshCacheVersion, uint32_t(sizeof(Vertex)), uint32_t(meshes.size()), sourceSize, sourceTime };
+
+		std::vector<MeshCacheEntry> entries(meshes.size());
+		uint64_t offset = sizeof(header) + entries.size() * sizeof(MeshCacheEntry);
+		auto place = [&offset](uint64_t byteCount)
+		{
+			const uint64_t placed = offset;
+			offset = (offset + byteCount + 3) & ~uint64_t(3);
+			return placed;
+		};
+		for(size_t i = 0; i < meshes.size(); ++i)
+		{
+			const MeshData& meshData = meshes[i];
+			MeshCacheEntry& entry = entries[i];
+			entry = {};
+			entry.vertexCount = uint32_t(meshData.Vertices.size());
+			entry.indexCount = uint32_t(meshData.GetIndexCount());
+			entry.indexSize = meshData.Uses16BitIndices() ? uint32_t(sizeof(uint16_t)) : uint32_t(sizeof(uint32_t));
+			entry.meshletCount = uint32_t(meshData.Meshlets.meshlets.size());
+			entry.meshletVertexCount = uint32_t(meshData.Meshlets.vertices.size());
+			entry.meshletTriangleCount = uint32_t(meshData.Meshlets.triangles.size());
+			entry.matNameLength = uint32_t(meshData.matName.size());
+			entry.texfileLength = uint32_t(meshData.texfile.size());
+			entry.vertexOffset = place(uint64_t(entry.vertexCount) * sizeof(Vertex));
+			entry.indexOffset = place(meshData.GetIndexDataSize());
+			entry.meshletOffset = place(uint64_t(entry.meshletCount) * sizeof(Meshlet));
+			entry.meshletBoundsOffset = place(uint64_t(entry.meshletCount) * sizeof(MeshletBounds));
+			entry.meshletVertexOffset = place(uint64_t(entry.meshletVertexCount) * sizeof(uint32_t));
+			entry.meshletTriangleOffset = place(entry.meshletTriangleCount);
+			entry.stringOffset = place(uint64_t(entry.matNameLength) + entry.texfileLength);
+		}
+
+		// Written under a temporary name so that an interrupted write never leaves a valid-looking cache
+		std::filesystem::path tempPath = cachePath;
+		tempPath += ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			uint64_t written = 0;
+			auto write = [&out, &written](uint64_t at, const void* bytes, uint64_t byteCount)
+			{
+				const char padding[4] = {};
+				out.write(padding, std::streamsize(at - written));
+				out.write(static_cast<const char*>(bytes), std::streamsize(byteCount));
+				written = at + byteCount;
+			};
+			write(0, &header, sizeof(header));
+			write(sizeof(header), entries.data(), entries.size() * sizeof(MeshCacheEntry));
+			for(size_t i = 0; i < meshes.size(); ++i)
+			{
+				const MeshData& meshData = meshes[i];
+				const MeshCacheEntry& entry = entries[i];
+				write(entry.vertexOffset, meshData.Vertices.data(), uint64_t(entry.vertexCount) * sizeof(Vertex));
+				write(entry.indexOffset, meshData.GetIndexData(), meshData.GetIndexDataSize());
+				write(entry.meshletOffset, meshData.Meshlets.meshlets.data(), uint64_t(entry.meshletCount) * sizeof(Meshlet));
+				write(entry.meshletBoundsOffset, meshData.Meshlets.bounds.data(), uint64_t(entry.meshletCount) * sizeof(MeshletBounds));
+				write(entry.meshletVertexOffset, meshData.Meshlets.vertices.data(), uint64_t(entry.meshletVertexCount) * sizeof(uint32_t));
+				write(entry.meshletTriangleOffset, meshData.Meshlets.triangles.data(), entry.meshletTriangleCount);
+				write(entry.stringOffset, meshData.matName.data(), entry.matNameLength);
+				write(entry.stringOffset + entry.matNameLength, meshData.texfile.data(), entry.texfileLength);
+			}
+			write(offset, nullptr, 0);
+			if(!out)
+			{
+				out.close();
+				std::error_code error;
+				std::filesystem::remove(tempPath, error);
+				std::cerr << "LoadCustomMesh: cannot write mesh cache " << cachePath.string() << std::endl;
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+		if(error)
+			std::filesystem::remove(tempPath, error);
+	}
+
+	void ConvertMesh(const aiScene& scene, const aiMesh& mesh, MeshData& meshData)
+	{
+		meshData.Vertices.resize(mesh.mNumVertices);
+		for(uint32_t i = 0; i < mesh.mNumVertices; ++i)
+		{
+			Vertex& v = meshData.Vertices[i];
+			v.Position = XMFLOAT3(mesh.mVertices[i].x, mesh.mVertices[i].y, mesh.mVertices[i].z);
+			v.Normal = mesh.HasNormals() ? XMFLOAT3(mesh.mNormals[i].x, mesh.mNormals[i].y, mesh.mNormals[i].z) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+			v.TangentU = mesh.HasTangentsAndBitangents() ? XMFLOAT3(mesh.mTangents[i].x, mesh.mTangents[i].y, mesh.mTangents[i].z) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+			v.TexC = mesh.HasTextureCoords(0) ? XMFLOAT2(mesh.mTextureCoords[0][i].x, mesh.mTextureCoords[0][i].y) : XMFLOAT2(0.0f, 0.0f);
+		}
+
+		// aiProcess_SortByPType leaves points and lines in meshes of their own; only triangles are kept
+		meshData.Indices32.reserve(size_t(mesh.mNumFaces) * 3);
+		for(uint32_t i = 0; i < mesh.mNumFaces; ++i)
+		{
+			const aiFace& face = mesh.mFaces[i];
+			if(face.mNumIndices == 3)
+				meshData.Indices32.insert(meshData.Indices32.end(), face.mIndices, face.mIndices + 3);
+		}
+
+		if(mesh.mMaterialIndex < scene.mNumMaterials)
+		{
+			const aiMaterial* material = scene.mMaterials[mesh.mMaterialIndex];
+			aiString name;
+			if(material->Get(AI_MATKEY_NAME, name) == AI_SUCCESS)
+				meshData.matName.assign(name.data, name.length);
+			aiString texture;
+			if(material->GetTexture(aiTextureType_DIFFUSE, 0, &texture) == AI_SUCCESS)
+				meshData.texfile.assign(texture.data, texture.length);
+		}
+
+		if(meshData.Indices32.empty())
+			return;
+
+		// Tangents authored in the file are kept; may split vertices, so it comes before reordering
+		if(!mesh.HasTangentsAndBitangents())
+			GenerateTangents(meshData);
+
+		// Imported index order is whatever the exporter produced
+		OptimizeMesh(meshData);
+		meshData.Meshlets = BuildMeshlets(&meshData.Vertices[0].Position.x, sizeof(Vertex), meshData.Vertices.size(),
+		                                  meshData.Indices32.data(), meshData.Indices32.size());
+		meshData.PackIndices();
+	}
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
     MeshData meshData;
@@ -213,13 +517,6 @@ GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32
  
 void GeometryGenerator::Subdivide(MeshData& meshData)
 {
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
-
-
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
-
 	//       v1
 	//       *
 	//      / \
@@ -230,47 +527,69 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size()/3;
-	for(uint32 i = 0; i < numTris; ++i)
+	// The input vertices stay in place and each edge midpoint is appended once, shared by
+	// both triangles of the edge. Only the index list is replaced.
+	std::vector<uint32> inputIndices;
+	inputIndices.swap(meshData.Indices32);
+
+	const size_t numTris = inputIndices.size()/3;
+
+	// A closed mesh has 3/2 edges per triangle; open ones grow past the reservation.
+	meshData.Vertices.reserve(meshData.Vertices.size() + numTris*3/2 + 3);
+	meshData.Indices32.reserve(numTris*12);
+
+	// Edge (lower index, higher index) -> midpoint index, open addressing with linear probing.
+	size_t tableSize = 16;
+	while(tableSize < numTris*4)
+		tableSize *= 2;
+	const uint64_t emptyKey = ~0ull;
+	std::vector<uint64_t> edgeKeys(tableSize, emptyKey);
+	std::vector<uint32> edgeMidpoints(tableSize);
+
+	auto midpointIndex = [&](uint32 a, uint32 b)
 	{
-		Vertex v0 = inputCopy.Vertices[ inputCopy.Indices32[i*3+0] ];
-		Vertex v1 = inputCopy.Vertices[ inputCopy.Indices32[i*3+1] ];
-		Vertex v2 = inputCopy.Vertices[ inputCopy.Indices32[i*3+2] ];
+		const uint64_t key = a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+		size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (tableSize - 1);
+		while(edgeKeys[slot] != emptyKey)
+		{
+			if(edgeKeys[slot] == key)
+				return edgeMidpoints[slot];
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		const uint32 index = (uint32)meshData.Vertices.size();
+		meshData.Vertices.push_back(MidPoint(meshData.Vertices[a], meshData.Vertices[b]));
+		edgeKeys[slot] = key;
+		edgeMidpoints[slot] = index;
+		return index;
+	};
+
+	for(size_t i = 0; i < numTris; ++i)
+	{
+		const uint32 v0 = inputIndices[i*3+0];
+		const uint32 v1 = inputIndices[i*3+1];
+		const uint32 v2 = inputIndices[i*3+2];
 
 		//
 		// Generate the midpoints.
 		//
 
-        Vertex m0 = MidPoint(v0, v1);
-        Vertex m1 = MidPoint(v1, v2);
-        Vertex m2 = MidPoint(v0, v2);
+		const uint32 m0 = midpointIndex(v0, v1);
+		const uint32 m1 = midpointIndex(v1, v2);
+		const uint32 m2 = midpointIndex(v0, v2);
 
 		//
 		// Add new geometry.
 		//
 
-		meshData.Vertices.push_back(v0); // 0
-		meshData.Vertices.push_back(v1); // 1
-		meshData.Vertices.push_back(v2); // 2
-		meshData.Vertices.push_back(m0); // 3
-		meshData.Vertices.push_back(m1); // 4
-		meshData.Vertices.push_back(m2); // 5
- 
-		meshData.Indices32.push_back(i*6+0);
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+5);
-
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+5);
-
-		meshData.Indices32.push_back(i*6+5);
-		meshData.Indices32.push_back(i*6+4);
-		meshData.Indices32.push_back(i*6+2);
-
-		meshData.Indices32.push_back(i*6+3);
-		meshData.Indices32.push_back(i*6+1);
-		meshData.Indices32.push_back(i*6+4);
+		const uint32 triangles[12] =
+		{
+			v0, m0, m2,
+			m0, m1, m2,
+			m2, m1, v2,
+			m0, v1, m1
+		};
+		meshData.Indices32.insert(meshData.Indices32.end(), triangles, triangles + 12);
 	}
 }
 
@@ -656,3 +975,58 @@ GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, floa
     return meshData;
 }
 
+void GeometryGenerator::MeshData::PackIndices()
+{
+	if(Indices32.empty() || Vertices.size() > (size_t(1) << 16))
+		return;
+
+	Indices16.resize(Indices32.size());
+	for(size_t i = 0; i < Indices32.size(); ++i)
+		Indices16[i] = static_cast<uint16>(Indices32[i]);
+	std::vector<uint32>().swap(Indices32);
+}
+
+std::vector<GeometryGenerator::MeshData> GeometryGenerator::LoadCustomMesh(const std::string& filename, unsigned int& nMeshes)
+{
+	std::vector<MeshData> meshes;
+	nMeshes = 0;
+
+	uint64_t sourceSize = 0;
+	int64_t sourceTime = 0;
+	if(!GetSourceStamp(filename, sourceSize, sourceTime))
+	{
+		std::cerr << "LoadCustomMesh: cannot open " << filename << std::endl;
+		return meshes;
+	}
+
+	const std::filesystem::path cachePath = filename + ".meshcache";
+	if(ReadMeshCache(cachePath, sourceSize, sourceTime, meshes))
+	{
+		nMeshes = (unsigned int)meshes.size();
+		return meshes;
+	}
+
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(filename,
+		aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals |
+		aiProcess_SortByPType | aiProcess_ConvertToLeftHanded);
+	if(!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE))
+	{
+		std::cerr << "LoadCustomMesh: " << importer.GetErrorString() << std::endl;
+		return meshes;
+	}
+
+	// One job per aiMesh; the scene is only read
+	meshes.resize(scene->mNumMeshes);
+	JobSystem::Get().ParallelFor(scene->mNumMeshes, [&](size_t first, size_t last)
+	{
+		for(size_t i = first; i < last; ++i)
+			ConvertMesh(*scene, *scene->mMeshes[i], meshes[i]);
+	}, 1);
+
+	meshes.erase(std::remove_if(meshes.begin(), meshes.end(), [](const MeshData& meshData) { return meshData.GetIndexCount() == 0; }), meshes.end());
+
+	WriteMeshCache(cachePath, sourceSize, sourceTime, meshes);
+	nMeshes = (unsigned int)meshes.size();
+	return meshes;
+}
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <DirectXMath.h>
 #include <vector>
+#include "../Mesh/Meshlets.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -63,23 +64,29 @@ public:
 	struct MeshData
 	{
 		std::vector<Vertex> Vertices;
-        std::vector<uint32> Indices32;
+        std::vector<uint32> Indices32; // Filled while building; PackIndices may move them to Indices16
+        std::vector<uint16> Indices16;
 		std::string matName;
 		std::string texfile;
-        std::vector<uint16>& GetIndices16()
-        {
-			if(mIndices16.empty())
-			{
-				mIndices16.resize(Indices32.size());
-				for(size_t i = 0; i < Indices32.size(); ++i)
-					mIndices16[i] = static_cast<uint16>(Indices32[i]);
-			}
-
-			return mIndices16;
-        }
-
-	private:
-		std::vector<uint16> mIndices16;
+		MeshletData Meshlets; // Built on import by LoadCustomMesh; empty for generated meshes
+
+		///<summary>
+		/// Picks the index width once the mesh is final (after OptimizeMesh and BuildMeshlets, which
+		/// read Indices32): moves the indices to Indices16 if every vertex is addressable with 16 bits
+		/// and keeps Indices32 otherwise.
+		///</summary>
+		void PackIndices();
+
+		bool Uses16BitIndices() const { return !Indices16.empty(); }
+		size_t GetIndexCount() const { return Uses16BitIndices() ? Indices16.size() : Indices32.size(); }
+		const void* GetIndexData() const
+		{
+			return Uses16BitIndices() ? static_cast<const void*>(Indices16.data()) : static_cast<const void*>(Indices32.data());
+		}
+		size_t GetIndexDataSize() const
+		{
+			return Uses16BitIndices() ? Indices16.size() * sizeof(uint16) : Indices32.size() * sizeof(uint32);
+		}
 	};
 
 	///<summary>
@@ -119,6 +126,13 @@ public:
     MeshData CreateQuad(float x, float y, float w, float h, float depth);
 
 
+	///<summary>
+	/// Loads every triangle mesh of a model file (in mesh space, node transforms are not applied)
+	/// with its material name and diffuse texture. The first load imports through assimp, one job
+	/// per mesh, and writes "<filename>.meshcache"; later loads map that cache and skip assimp.
+	/// Indices are packed with MeshData::PackIndices, so they are 16-bit wherever they fit.
+	/// Returns an empty vector if the file cannot be loaded.
+	///</summary>
 	std::vector<GeometryGenerator::MeshData> LoadCustomMesh(const std::string& filename, unsigned int& nMeshes);
 
 private:
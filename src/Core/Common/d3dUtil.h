@@ -186,6 +186,13 @@ struct MeshGeometry
 	std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
 	std::unordered_map<std::string, std::vector<std::pair<GeometryGenerator::MeshData,SubmeshGeometry>>> MultiDrawArgs;
 
+	// Index format and size for a buffer holding mesh's indices as MeshData::PackIndices stored them
+	void SetIndexBufferDesc(const GeometryGenerator::MeshData& mesh)
+	{
+		IndexFormat = mesh.Uses16BitIndices() ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		IndexBufferByteSize = static_cast<UINT>(mesh.GetIndexDataSize());
+	}
+
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
 	{
 		D3D12_VERTEX_BUFFER_VIEW vbv;
@@ -214,6 +221,14 @@ struct MeshGeometry
 	}
 };
 
+// Values of Light::type
+enum LightType
+{
+    LightTypeDirectional = 0,
+    LightTypePoint = 1,
+    LightTypeSpot = 2
+};
+
 struct Light
 {
     DirectX::XMFLOAT3 Color = { 0.5f, 0.5f, 0.5f };
@@ -222,7 +237,7 @@ struct Light
     float FalloffEnd = 10.0f;                           // point/spot light only
     DirectX::XMFLOAT3 Position = { 0.0f, 0.0f, 0.0f };  // point/spot light only
     float SpotPower = 64.0f;                            // spot light only
-    int type = 0;
+    int type = 0;                                       // LightType
     float Strength = 1;
     int CastsShadows = true;
     int isDebugOn = 0;
@@ -0,0 +1,283 @@
+#include "JobSystem.h"
+
+namespace
+{
+    // Index of the calling thread inside the owning JobSystem, or -1 for foreign threads
+    thread_local const JobSystem* t_owner = nullptr;
+    thread_local int32_t t_workerIndex = -1;
+    thread_local uint32_t t_randomState = 0x9E3779B9u;
+
+    std::atomic<uint32_t> g_defaultThreadCount{ 0 };
+
+    uint32_t NextRandom()
+    {
+        // xorshift32; only used to pick steal victims
+        uint32_t x = t_randomState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        t_randomState = x;
+        return x;
+    }
+}
+
+JobSystem::WorkStealingQueue::WorkStealingQueue()
+    : m_buffer(new std::atomic<Job*>[Capacity])
+{
+}
+
+bool JobSystem::WorkStealingQueue::Push(Job* job)
+{
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    if (bottom - top >= Capacity) return false;
+
+    // Release on the slot itself (not only the fence) publishes the job data to thieves
+    m_buffer[bottom & Mask].store(job, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job* JobSystem::WorkStealingQueue::Pop()
+{
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        // Empty
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = m_buffer[bottom & Mask].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // Last element: race against thieves for it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            job = nullptr;
+        }
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::WorkStealingQueue::Steal()
+{
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+
+    Job* job = m_buffer[top & Mask].load(std::memory_order_acquire);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_queues.push_back(std::make_unique<WorkStealingQueue>());
+    }
+
+    t_owner = this;
+    t_workerIndex = 0;
+    for (uint32_t i = 1; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_running.store(false);
+    }
+    m_wakeCondition.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+    if (t_owner == this)
+    {
+        t_owner = nullptr;
+        t_workerIndex = -1;
+    }
+}
+
+JobSystem& JobSystem::Get()
+{
+    static JobSystem instance(g_defaultThreadCount.load());
+    return instance;
+}
+
+void JobSystem::SetDefaultThreadCount(uint32_t threadCount)
+{
+    g_defaultThreadCount.store(threadCount);
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    uint32_t idleSpins = 0;
+    while (!counter.IsDone())
+    {
+        if (Job* job = FindJob())
+        {
+            if (TryExecute(job))
+            {
+                idleSpins = 0;
+                continue;
+            }
+        }
+        if (++idleSpins > 64) std::this_thread::yield();
+    }
+}
+
+JobSystem::Job* JobSystem::AllocateJob()
+{
+    // Ring buffer per thread; a slot comes up for reuse after MaxJobsPerThread further submissions from the same thread
+    thread_local std::unique_ptr<Job[]> t_jobs;
+    thread_local uint32_t t_nextJob = 0;
+    if (!t_jobs) t_jobs.reset(new Job[MaxJobsPerThread]);
+
+    Job* job = &t_jobs[t_nextJob++ & (MaxJobsPerThread - 1)];
+    if (job->pending.load(std::memory_order_acquire))
+    {
+        // The job in this slot has not run yet. Waiting for it could deadlock if it depends on work
+        // this thread has still to submit, so this job lives on the heap and is freed after running.
+        job = new Job;
+        job->heapAllocated = true;
+    }
+    job->pending.store(true, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::Submit(Job* job)
+{
+    bool queued = false;
+    if (t_owner == this && t_workerIndex >= 0)
+    {
+        queued = m_queues[t_workerIndex]->Push(job);
+    }
+    if (!queued)
+    {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        m_sharedQueue.push_back(job);
+    }
+
+    m_queuedJobs.fetch_add(1);
+    if (m_sleepingWorkers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wakeCondition.notify_one();
+    }
+}
+
+JobSystem::Job* JobSystem::FindJob()
+{
+    Job* job = nullptr;
+    const int32_t self = (t_owner == this) ? t_workerIndex : -1;
+
+    if (self >= 0)
+    {
+        job = m_queues[self]->Pop();
+    }
+    if (!job && m_queuedJobs.load(std::memory_order_relaxed) > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sharedMutex);
+            if (!m_sharedQueue.empty())
+            {
+                job = m_sharedQueue.front();
+                m_sharedQueue.pop_front();
+            }
+        }
+
+        const uint32_t queueCount = static_cast<uint32_t>(m_queues.size());
+        const uint32_t start = NextRandom() % queueCount;
+        for (uint32_t i = 0; i < queueCount && !job; ++i)
+        {
+            const uint32_t victim = (start + i) % queueCount;
+            if (static_cast<int32_t>(victim) != self) job = m_queues[victim]->Steal();
+        }
+    }
+
+    if (job) m_queuedJobs.fetch_sub(1);
+    return job;
+}
+
+bool JobSystem::TryExecute(Job* job)
+{
+    if (job->dependency && !job->dependency->IsDone())
+    {
+        // Not ready yet: move it to the back of the shared queue so the jobs it depends on
+        // (possibly sitting below it in the local deque) get picked first
+        {
+            std::lock_guard<std::mutex> lock(m_sharedMutex);
+            m_sharedQueue.push_back(job);
+        }
+        m_queuedJobs.fetch_add(1);
+        return false;
+    }
+
+    JobCounter* counter = job->counter;
+    job->function(*job);
+    if (job->heapAllocated)
+    {
+        delete job;
+    }
+    else
+    {
+        // Hands the ring slot back to the submitting thread; the job must not be touched after this
+        job->pending.store(false, std::memory_order_release);
+    }
+    counter->m_pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::WorkerLoop(uint32_t index)
+{
+    t_owner = this;
+    t_workerIndex = static_cast<int32_t>(index);
+    t_randomState = 0x9E3779B9u * (index + 1);
+
+    uint32_t idleSpins = 0;
+    while (m_running.load(std::memory_order_relaxed))
+    {
+        if (Job* job = FindJob())
+        {
+            if (TryExecute(job))
+            {
+                idleSpins = 0;
+                continue;
+            }
+        }
+
+        if (++idleSpins < 64)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Nothing to do for a while: sleep until a job is submitted
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepingWorkers.fetch_add(1);
+        m_wakeCondition.wait(lock, [this] { return m_queuedJobs.load() > 0 || !m_running.load(); });
+        m_sleepingWorkers.fetch_sub(1);
+        idleSpins = 0;
+    }
+}
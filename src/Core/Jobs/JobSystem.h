@@ -0,0 +1,166 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Counts outstanding jobs. A job started with a counter increments it and decrements it
+// when finished; JobSystem::Wait blocks (while executing other jobs) until it reaches zero.
+// A counter can also be passed as a dependency so a job only starts once it is done.
+class JobCounter
+{
+public:
+    bool IsDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<uint32_t> m_pending{ 0 };
+};
+
+// Work-stealing job system.
+//   - One worker thread per extra hardware thread; the thread that constructs the system
+//     becomes worker 0 and executes jobs while it waits.
+//   - Every worker owns a fixed-size Chase-Lev deque: the owner pushes/pops at the bottom,
+//     idle workers steal from the top. Threads that are not workers submit into a shared queue.
+//   - Jobs are stored in per-thread ring buffers with inline storage for the callable, so
+//     submitting a job does not allocate. If the slot due for reuse still holds a job that is
+//     queued or running (more than MaxJobsPerThread jobs in flight from one thread), the new
+//     job is allocated on the heap instead.
+class JobSystem
+{
+public:
+    static constexpr size_t JobDataSize = 64;
+    static constexpr uint32_t MaxJobsPerThread = 4096; // Ring size; also the per-worker deque capacity
+
+    explicit JobSystem(uint32_t workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Engine-wide instance, created on first use.
+    static JobSystem& Get();
+    // Thread count of the engine-wide instance (0: one per hardware thread). Only takes effect before the first Get().
+    static void SetDefaultThreadCount(uint32_t threadCount);
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_queues.size()); }
+
+    // Schedules fn() to run on any worker. counter is incremented now and decremented when fn returns.
+    // If dependency is set, the job does not start before dependency->IsDone().
+    template<typename Fn>
+    void Run(Fn&& fn, JobCounter& counter, const JobCounter* dependency = nullptr);
+
+    // Waits for the counter to reach zero, executing pending jobs on the calling thread meanwhile.
+    void Wait(const JobCounter& counter);
+
+    // Calls fn(begin, end) over [0, count) split into ranges and waits for all of them.
+    // When grainSize is 0 it is chosen so that every thread gets several ranges to balance load.
+    template<typename Fn>
+    void ParallelFor(size_t count, Fn&& fn, size_t grainSize = 0);
+
+private:
+    struct Job
+    {
+        void (*function)(Job& job);
+        JobCounter* counter;
+        const JobCounter* dependency;
+        std::atomic<bool> pending{ false }; // Set from submission until the job has run; the ring slot is free once it is cleared
+        bool heapAllocated = false;
+        alignas(std::max_align_t) std::byte data[JobDataSize];
+    };
+
+    // Chase-Lev work-stealing deque with a fixed power-of-two capacity.
+    class WorkStealingQueue
+    {
+    public:
+        WorkStealingQueue();
+        bool Push(Job* job);
+        Job* Pop();
+        Job* Steal();
+
+    private:
+        static constexpr int64_t Capacity = MaxJobsPerThread;
+        static constexpr int64_t Mask = Capacity - 1;
+
+        alignas(64) std::atomic<int64_t> m_top{ 0 };
+        alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+        std::unique_ptr<std::atomic<Job*>[]> m_buffer;
+    };
+
+    Job* AllocateJob();
+    void Submit(Job* job);
+    Job* FindJob();
+    bool TryExecute(Job* job);
+    void WorkerLoop(uint32_t index);
+
+    std::vector<std::unique_ptr<WorkStealingQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    // Jobs submitted from threads that are not workers of this system
+    std::mutex m_sharedMutex;
+    std::deque<Job*> m_sharedQueue;
+
+    // Sleeping workers are woken when new jobs arrive
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<int32_t> m_queuedJobs{ 0 };
+    std::atomic<int32_t> m_sleepingWorkers{ 0 };
+    std::atomic<bool> m_running{ true };
+};
+
+template<typename Fn>
+void JobSystem::Run(Fn&& fn, JobCounter& counter, const JobCounter* dependency)
+{
+    using Callable = std::decay_t<Fn>;
+    static_assert(sizeof(Callable) <= JobDataSize, "Job callable is too large; capture by reference or pointer");
+    static_assert(alignof(Callable) <= alignof(std::max_align_t), "Job callable is over-aligned");
+
+    Job* job = AllocateJob();
+    new (job->data) Callable(std::forward<Fn>(fn));
+    job->function = [](Job& self)
+    {
+        Callable* callable = std::launder(reinterpret_cast<Callable*>(self.data));
+        (*callable)();
+        callable->~Callable();
+    };
+    job->counter = &counter;
+    job->dependency = dependency;
+
+    counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+    Submit(job);
+}
+
+template<typename Fn>
+void JobSystem::ParallelFor(size_t count, Fn&& fn, size_t grainSize)
+{
+    if (count == 0) return;
+    if (grainSize == 0)
+    {
+        const size_t targetRanges = static_cast<size_t>(GetThreadCount()) * 4;
+        grainSize = std::max<size_t>(1, (count + targetRanges - 1) / targetRanges);
+    }
+    if (count <= grainSize || GetThreadCount() == 1)
+    {
+        fn(size_t(0), count);
+        return;
+    }
+
+    // The calling thread takes the first range itself instead of waiting idle
+    JobCounter counter;
+    for (size_t begin = grainSize; begin < count; begin += grainSize)
+    {
+        const size_t end = std::min(begin + grainSize, count);
+        Run([&fn, begin, end]() { fn(begin, end); }, counter);
+    }
+    fn(size_t(0), grainSize);
+    Wait(counter);
+}
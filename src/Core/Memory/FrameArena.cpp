@@ -0,0 +1,86 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <new>
+
+namespace
+{
+    constexpr size_t BlockAlignment = 64;
+}
+
+LinearArena::LinearArena(size_t capacity)
+    : m_buffer(static_cast<std::byte*>(::operator new(capacity, std::align_val_t{ BlockAlignment })))
+    , m_capacity(capacity)
+{
+}
+
+LinearArena::~LinearArena()
+{
+    Reset();
+    ::operator delete(m_buffer, std::align_val_t{ BlockAlignment });
+}
+
+void* LinearArena::Allocate(size_t size, size_t alignment)
+{
+    const uintptr_t base = reinterpret_cast<uintptr_t>(m_buffer);
+    size_t offset = m_offset.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        const uintptr_t aligned = (base + offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        const size_t end = static_cast<size_t>(aligned - base) + size;
+        if (end > m_capacity) return AllocateOverflow(size, alignment);
+
+        if (m_offset.compare_exchange_weak(offset, end, std::memory_order_relaxed))
+        {
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+}
+
+void* LinearArena::AllocateOverflow(size_t size, size_t alignment)
+{
+    alignment = std::max(alignment, alignof(std::max_align_t));
+    void* memory = ::operator new(size, std::align_val_t{ alignment });
+
+    std::lock_guard<std::mutex> lock(m_overflowMutex);
+    m_overflowBlocks.push_back({ memory, size, alignment });
+    m_overflowBytes += size;
+    return memory;
+}
+
+void LinearArena::Reset()
+{
+    // Overflow blocks only exist in frames that exceeded the capacity
+    for (const auto& block : m_overflowBlocks)
+    {
+        ::operator delete(block.memory, block.size, std::align_val_t{ block.alignment });
+    }
+    m_overflowBlocks.clear();
+    m_overflowBytes = 0;
+    m_offset.store(0, std::memory_order_relaxed);
+}
+
+FrameArena::FrameArena(size_t capacityPerFrame)
+{
+    for (auto& arena : m_arenas)
+    {
+        arena = std::make_unique<LinearArena>(capacityPerFrame);
+    }
+}
+
+FrameArena& FrameArena::Get()
+{
+    static FrameArena instance;
+    return instance;
+}
+
+void FrameArena::BeginFrame()
+{
+    const LinearArena& finished = *m_arenas[m_frameIndex];
+    m_stats.lastOverflowBytes = finished.GetOverflowBytes();
+    m_stats.lastFrameBytes = finished.GetUsedBytes() + m_stats.lastOverflowBytes;
+    m_stats.peakFrameBytes = std::max(m_stats.peakFrameBytes, m_stats.lastFrameBytes);
+
+    m_frameIndex = (m_frameIndex + 1) % FrameCount;
+    m_arenas[m_frameIndex]->Reset();
+    m_frameOpen = true;
+}
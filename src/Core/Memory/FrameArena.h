@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator over one fixed block. Deallocation is a no-op and Reset() frees everything at once.
+// Allocation is lock-free, so jobs can allocate from the same arena concurrently.
+// When the block runs out, allocations fall back to the heap and are released on the next Reset();
+// the overflow is reported so the block size can be tuned.
+class LinearArena : public std::pmr::memory_resource
+{
+public:
+    explicit LinearArena(size_t capacity);
+    ~LinearArena() override;
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void Reset();
+
+    size_t GetCapacity() const { return m_capacity; }
+    size_t GetUsedBytes() const { return m_offset.load(std::memory_order_relaxed); }
+    size_t GetOverflowBytes() const { return m_overflowBytes; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override { return Allocate(bytes, alignment); }
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+    struct OverflowBlock
+    {
+        void* memory;
+        size_t size;
+        size_t alignment;
+    };
+
+    void* AllocateOverflow(size_t size, size_t alignment);
+
+    std::byte* m_buffer;
+    size_t m_capacity;
+    std::atomic<size_t> m_offset{ 0 };
+
+    std::mutex m_overflowMutex;
+    std::vector<OverflowBlock> m_overflowBlocks;
+    size_t m_overflowBytes = 0;
+};
+
+struct FrameArenaStats
+{
+    size_t lastFrameBytes = 0;     // Used by the most recently finished frame, overflow included
+    size_t lastOverflowBytes = 0;  // Part of lastFrameBytes that did not fit into the arena
+    size_t peakFrameBytes = 0;     // Maximum of lastFrameBytes over all frames
+};
+
+// Per-frame temporary memory. There are FrameCount arenas used round-robin: BeginFrame() moves to
+// the next one and resets it in O(1), so anything allocated during a frame stays valid for the
+// following FrameCount - 1 frames (e.g. while the GPU still reads data recorded from it).
+// Use it through Allocate/AllocateArray or as a std::pmr resource:
+//     std::pmr::vector<Packet> packets(FrameArena::Get().GetResource());
+class FrameArena
+{
+public:
+    static constexpr uint32_t FrameCount = 3;
+    static constexpr size_t DefaultCapacity = 4 * 1024 * 1024;
+
+    explicit FrameArena(size_t capacityPerFrame = DefaultCapacity);
+
+    // Engine-wide instance; NeneEngine opens the first frame in Initialize and calls BeginFrame once
+    // per main loop iteration. Anything else that drives frames (tests, benchmarks, tools) must call
+    // BeginFrame itself, or the arena is never reset and its overflow blocks pile up.
+    static FrameArena& Get();
+
+    void BeginFrame();
+
+    std::pmr::memory_resource* GetResource()
+    {
+        assert(m_frameOpen && "FrameArena used before the first BeginFrame");
+        return m_arenas[m_frameIndex].get();
+    }
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        assert(m_frameOpen && "FrameArena used before the first BeginFrame");
+        return m_arenas[m_frameIndex]->Allocate(size, alignment);
+    }
+
+    // Uninitialized storage for count objects; no destructors are run at reset.
+    template<typename T>
+    T* AllocateArray(size_t count);
+
+    size_t GetCapacity() const { return m_arenas[m_frameIndex]->GetCapacity(); }
+    size_t GetUsedBytes() const { return m_arenas[m_frameIndex]->GetUsedBytes(); }
+    const FrameArenaStats& GetStats() const { return m_stats; }
+
+private:
+    std::array<std::unique_ptr<LinearArena>, FrameCount> m_arenas;
+    uint32_t m_frameIndex = 0;
+    bool m_frameOpen = false;
+    FrameArenaStats m_stats;
+};
+
+template<typename T>
+T* FrameArena::AllocateArray(size_t count)
+{
+    static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+    return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+}
@@ -0,0 +1,310 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    // FIFO post-transform cache. A vertex is cached while fewer than cacheSize misses happened after
+    // its own; timestamps start past cacheSize so that nothing is cached initially.
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t vertexCount, uint32_t cacheSize)
+            : m_times(vertexCount, 0), m_cacheSize(cacheSize), m_time(cacheSize + 1)
+        {}
+
+        // Returns true on a miss
+        bool Access(uint32_t vertex)
+        {
+            if (m_time - m_times[vertex] <= m_cacheSize) return false;
+            m_times[vertex] = m_time++;
+            return true;
+        }
+
+        // Empties the cache without touching every entry
+        void Flush() { m_time += m_cacheSize + 1; }
+
+    private:
+        std::vector<uint32_t> m_times;
+        uint32_t m_cacheSize;
+        uint32_t m_time;
+    };
+
+    uint32_t CountMisses(FifoCache& cache, const uint32_t* triangle)
+    {
+        return uint32_t(cache.Access(triangle[0])) + uint32_t(cache.Access(triangle[1])) + uint32_t(cache.Access(triangle[2]));
+    }
+}
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3) return stats;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> used(vertexCount, 0);
+    size_t misses = 0, usedCount = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        misses += cache.Access(indices[i]);
+        usedCount += used[indices[i]] == 0;
+        used[indices[i]] = 1;
+    }
+
+    stats.acmr = float(misses) / float(indexCount / 3);
+    stats.atvr = float(misses) / float(usedCount);
+    return stats;
+}
+
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                         uint32_t cacheSize, std::vector<uint32_t>* clusterStarts)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (clusterStarts) clusterStarts->assign(triangleCount > 0 ? 1 : 0, 0);
+    if (triangleCount == 0) return;
+
+    // Triangles around every vertex (CSR) and how many of them are not emitted yet
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) ++live[indices[i]];
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) adjacency[cursor[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    // Same timestamps as FifoCache: a vertex is cached while time - cacheTime <= cacheSize
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    deadEnd.reserve(triangleCount * 3);
+    std::vector<uint32_t> candidates;
+    size_t written = 0;
+    size_t scan = 0; // Next vertex to try once the dead-end stack is exhausted
+
+    int64_t fanning = indices[0];
+    while (fanning >= 0)
+    {
+        // Emit all remaining triangles around the fanning vertex
+        candidates.clear();
+        for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+        {
+            const uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = 1;
+
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t vertex = indices[triangle * 3 + corner];
+                destination[written++] = vertex;
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if (time - cacheTime[vertex] > cacheSize) cacheTime[vertex] = time++;
+            }
+        }
+
+        // Next fan: the oldest candidate that is still cached after its remaining triangles are emitted
+        int64_t next = -1;
+        uint32_t bestPriority = 0;
+        for (uint32_t vertex : candidates)
+        {
+            if (live[vertex] == 0) continue;
+            const uint32_t age = time - cacheTime[vertex];
+            const uint32_t priority = age + 2 * live[vertex] <= cacheSize ? age : 0;
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next < 0)
+        {
+            // Dead end: fall back to recently used vertices, then to any vertex with triangles left.
+            // The cache is cold from here on, so this is a boundary the overdraw pass may reorder at.
+            while (!deadEnd.empty() && next < 0)
+            {
+                const uint32_t vertex = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[vertex] > 0) next = vertex;
+            }
+            while (next < 0 && scan < vertexCount)
+            {
+                if (live[scan] > 0) next = int64_t(scan);
+                ++scan;
+            }
+            if (next >= 0 && clusterStarts) clusterStarts->push_back(uint32_t(written / 3));
+        }
+        fanning = next;
+    }
+}
+
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+                      const std::vector<uint32_t>& clusterStarts, uint32_t cacheSize, float threshold)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || clusterStarts.empty()) return;
+
+    // Soft boundaries: split a hard cluster wherever the part so far is already about as cache
+    // friendly as the whole cluster, so that sorting the pieces costs at most threshold in ACMR
+    std::vector<uint32_t> starts;
+    FifoCache cache(vertexCount, cacheSize);
+    for (size_t c = 0; c < clusterStarts.size(); ++c)
+    {
+        const size_t begin = clusterStarts[c];
+        const size_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+
+        cache.Flush();
+        uint32_t clusterMisses = 0;
+        for (size_t t = begin; t < end; ++t) clusterMisses += CountMisses(cache, indices + t * 3);
+        const float limit = threshold * float(clusterMisses) / float(end - begin);
+
+        cache.Flush();
+        starts.push_back(uint32_t(begin));
+        size_t start = begin;
+        uint32_t misses = 0;
+        for (size_t t = begin; t + 1 < end; ++t)
+        {
+            misses += CountMisses(cache, indices + t * 3);
+            if (float(misses) <= limit * float(t + 1 - start))
+            {
+                start = t + 1;
+                starts.push_back(uint32_t(start));
+                misses = 0;
+                cache.Flush();
+            }
+        }
+    }
+
+    auto position = [positions, positionStride](uint32_t vertex)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + size_t(vertex) * positionStride);
+        return DirectX::XMFLOAT3(p[0], p[1], p[2]);
+    };
+
+    // Area-weighted centroid and normal of every cluster and of the whole mesh
+    struct Cluster
+    {
+        float centroid[3];
+        float normal[3];
+        float area;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters(starts.size());
+    float meshCentroid[3] = {};
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < starts.size(); ++c)
+    {
+        Cluster& cluster = clusters[c];
+        cluster = {};
+        const size_t end = c + 1 < starts.size() ? starts[c + 1] : triangleCount;
+        for (size_t t = starts[c]; t < end; ++t)
+        {
+            const DirectX::XMFLOAT3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), d = position(indices[t * 3 + 2]);
+            const float e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+            const float e2[3] = { d.x - a.x, d.y - a.y, d.z - a.z };
+            const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            const float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            const float center[3] = { (a.x + b.x + d.x) / 3.0f, (a.y + b.y + d.y) / 3.0f, (a.z + b.z + d.z) / 3.0f };
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                cluster.centroid[axis] += center[axis] * area;
+                cluster.normal[axis] += n[axis];
+            }
+            cluster.area += area;
+        }
+        for (int axis = 0; axis < 3; ++axis) meshCentroid[axis] += cluster.centroid[axis];
+        meshArea += cluster.area;
+    }
+    if (meshArea > 0.0f)
+    {
+        for (float& value : meshCentroid) value /= meshArea;
+    }
+
+    // Clusters facing away from the center are likely to occlude the others, so they go first
+    for (Cluster& cluster : clusters)
+    {
+        const float normalLength = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+        cluster.sortKey = 0.0f;
+        if (cluster.area > 0.0f && normalLength > 0.0f)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                cluster.sortKey += (cluster.centroid[axis] / cluster.area - meshCentroid[axis]) * cluster.normal[axis] / normalLength;
+            }
+        }
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&clusters](uint32_t a, uint32_t b) { return clusters[a].sortKey > clusters[b].sortKey; });
+
+    const std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+    size_t written = 0;
+    for (uint32_t c : order)
+    {
+        const size_t begin = starts[c] * size_t(3);
+        const size_t end = (c + 1 < starts.size() ? starts[c + 1] : triangleCount) * size_t(3);
+        std::copy(source.begin() + begin, source.begin() + end, indices + written);
+        written += end - begin;
+    }
+}
+
+size_t BuildVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+    std::fill(remap, remap + vertexCount, ~0u);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        if (remap[indices[i]] == ~0u) remap[indices[i]] = next++;
+    }
+    return next;
+}
+
+MeshOptimizationStats OptimizeMesh(GeometryGenerator::MeshData& mesh, const MeshOptimizerSettings& settings)
+{
+    MeshOptimizationStats stats;
+    const size_t indexCount = mesh.Indices32.size() / 3 * 3;
+    const size_t vertexCount = mesh.Vertices.size();
+    stats.before = AnalyzeVertexCache(mesh.Indices32.data(), indexCount, vertexCount, settings.cacheSize);
+    if (indexCount == 0)
+    {
+        stats.after = stats.before;
+        return stats;
+    }
+
+    std::vector<uint32_t> indices(indexCount);
+    std::vector<uint32_t> clusterStarts;
+    OptimizeVertexCache(indices.data(), mesh.Indices32.data(), indexCount, vertexCount, settings.cacheSize, &clusterStarts);
+    if (settings.overdrawThreshold >= 1.0f)
+    {
+        OptimizeOverdraw(indices.data(), indexCount, &mesh.Vertices[0].Position.x, sizeof(GeometryGenerator::Vertex), vertexCount,
+                         clusterStarts, settings.cacheSize, settings.overdrawThreshold);
+    }
+
+    // Vertices in first-use order; unused ones are dropped or kept at the end
+    std::vector<uint32_t> remap(vertexCount);
+    size_t usedCount = BuildVertexFetchRemap(remap.data(), indices.data(), indexCount, vertexCount);
+    const size_t newCount = settings.removeUnusedVertices ? usedCount : vertexCount;
+    std::vector<GeometryGenerator::Vertex> vertices(newCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        if (remap[v] == ~0u)
+        {
+            if (settings.removeUnusedVertices) continue;
+            remap[v] = uint32_t(usedCount++);
+        }
+        vertices[remap[v]] = mesh.Vertices[v];
+    }
+    for (uint32_t& index : indices) index = remap[index];
+
+    stats.removedVertices = vertexCount - newCount;
+    mesh.Vertices.swap(vertices);
+    mesh.Indices32.swap(indices);
+    stats.after = AnalyzeVertexCache(mesh.Indices32.data(), indexCount, newCount, settings.cacheSize);
+    return stats;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Common/GeometryGenerator.h"
+
+// Post-transform cache behaviour of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats
+{
+    float acmr = 0.0f; // Average cache miss ratio: transformed vertices per triangle, 0.5 is the ideal for large meshes
+    float atvr = 0.0f; // Average transform to vertex ratio: transformed vertices per referenced vertex, 1 is ideal
+};
+
+struct MeshOptimizerSettings
+{
+    uint32_t cacheSize = 16;        // Vertex cache size Tipsify optimizes for
+    float overdrawThreshold = 1.05f; // Allowed ACMR growth from splitting clusters for the overdraw sort; below 1 skips the sort
+    bool removeUnusedVertices = true;
+};
+
+struct MeshOptimizationStats
+{
+    VertexCacheStats before;
+    VertexCacheStats after;
+    size_t removedVertices = 0;
+};
+
+// The stages below follow Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality
+// and Reduced Overdraw" (2007). All of them work on triangle lists with 32-bit indices.
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16);
+
+// Tipsify: reorders triangles for the vertex cache. destination may not alias indices.
+// If clusterStarts is given, it receives the first triangle of every cluster that begins at a
+// cache flush, which is where the overdraw pass may move triangles without hurting the cache.
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                         uint32_t cacheSize, std::vector<uint32_t>* clusterStarts = nullptr);
+
+// Splits the clusters further while their ACMR stays within threshold of the whole cluster and sorts
+// them so that the ones facing away from the mesh center, which tend to occlude the rest, come first.
+// positions points at the first vertex's float3 position, positionStride is the vertex size in bytes.
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t positionStride, size_t vertexCount,
+                      const std::vector<uint32_t>& clusterStarts, uint32_t cacheSize, float threshold);
+
+// Numbers vertices in the order the index buffer first uses them, so vertex fetch streams through
+// memory. Fills remap (old index -> new index, ~0u for unused vertices) and returns the used count.
+size_t BuildVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// All three stages in place; usable on imported meshes and from offline cooking. Call it before
+// MeshData::PackIndices, which may move the indices out of Indices32.
+MeshOptimizationStats OptimizeMesh(GeometryGenerator::MeshData& mesh, const MeshOptimizerSettings& settings = {});
@@ -0,0 +1,534 @@
+#include "MeshSimplifier.h"
+#include "../Jobs/JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    enum VertexKind : uint8_t
+    {
+        Manifold,   // Interior vertex with one set of attributes
+        Border,     // On one open border loop
+        Seam,       // Two attribute sets split along one seam
+        Locked      // Anything else: never moves
+    };
+
+    // Whether a vertex of the first kind may collapse onto a vertex of the second kind
+    const bool CanCollapse[4][4] =
+    {
+        { true, true, true, true },
+        { false, true, false, false },
+        { false, false, true, false },
+        { false, false, false, false },
+    };
+
+    // Open border edges weigh more than faces so that borders keep their shape
+    const double BorderEdgeWeight = 10.0;
+    const double SeamEdgeWeight = 1.0;
+
+    struct Vector3
+    {
+        double x, y, z;
+    };
+
+    Vector3 Sub(const Vector3& a, const Vector3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    double Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vector3 Cross(const Vector3& a, const Vector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+    // Sum of squared distances to weighted planes as a symmetric 4x4 matrix, plus the total weight
+    struct Quadric
+    {
+        double a00, a11, a22, a10, a20, a21;
+        double b0, b1, b2;
+        double c;
+        double w;
+    };
+
+    Quadric FromPlane(const Vector3& n, double d, double w)
+    {
+        return { w * n.x * n.x, w * n.y * n.y, w * n.z * n.z, w * n.y * n.x, w * n.z * n.x, w * n.z * n.y,
+                 w * n.x * d, w * n.y * d, w * n.z * d, w * d * d, w };
+    }
+
+    void Add(Quadric& q, const Quadric& r)
+    {
+        q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+        q.a10 += r.a10; q.a20 += r.a20; q.a21 += r.a21;
+        q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+        q.c += r.c;
+        q.w += r.w;
+    }
+
+    // Weighted mean of the squared distances from p to the planes of q
+    double Error(const Quadric& q, const Vector3& p)
+    {
+        const double rx = 2.0 * (q.b0 + q.a10 * p.y) + q.a00 * p.x;
+        const double ry = 2.0 * (q.b1 + q.a21 * p.z) + q.a11 * p.y;
+        const double rz = 2.0 * (q.b2 + q.a20 * p.x) + q.a22 * p.z;
+        const double r = q.c + rx * p.x + ry * p.y + rz * p.z;
+        return q.w > 0.0 ? std::fabs(r) / q.w : 0.0;
+    }
+
+    // Triangles around every vertex in compressed rows
+    struct Adjacency
+    {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+
+        void Build(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+        {
+            offsets.assign(vertexCount + 1, 0);
+            for (size_t i = 0; i < indexCount; ++i) ++offsets[indices[i] + 1];
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+            triangles.resize(indexCount);
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexCount; ++i) triangles[fill[indices[i]]++] = uint32_t(i / 3);
+        }
+
+        // Whether some triangle has the directed edge a -> b
+        bool HasEdge(const uint32_t* indices, uint32_t a, uint32_t b) const
+        {
+            for (uint32_t k = offsets[a]; k < offsets[a + 1]; ++k)
+            {
+                const uint32_t* triangle = indices + size_t(triangles[k]) * 3;
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    if (triangle[corner] == a && triangle[(corner + 1) % 3] == b) return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        bool bidirectional;
+        double error;
+    };
+
+    class Simplifier
+    {
+    public:
+        Simplifier(const float* positions, size_t positionStride, size_t vertexCount)
+            : m_vertexCount(vertexCount)
+        {
+            m_positions.resize(vertexCount);
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+                m_positions[v] = { p[0], p[1], p[2] };
+            }
+        }
+
+        size_t Run(std::vector<uint32_t>& indices, const SimplifySettings& settings, float* outError)
+        {
+            BuildPositionGroups();
+            m_adjacency.Build(indices.data(), indices.size(), m_vertexCount);
+            ClassifyVertices(indices);
+            BuildQuadrics(indices);
+
+            m_collapseRemap.resize(m_vertexCount);
+            std::iota(m_collapseRemap.begin(), m_collapseRemap.end(), 0u);
+            const double errorLimit = double(settings.targetError) * double(settings.targetError);
+            double maxError = 0.0;
+
+            for (bool firstPass = true; indices.size() > settings.targetIndexCount; firstPass = false)
+            {
+                if (!firstPass) m_adjacency.Build(indices.data(), indices.size(), m_vertexCount);
+                PickCollapses(indices);
+                if (m_collapses.empty()) break;
+                RankCollapses();
+
+                const size_t triangleGoal = (indices.size() - settings.targetIndexCount) / 3;
+                if (PerformCollapses(indices, triangleGoal, errorLimit, maxError) == 0) break;
+                RemapTriangles(indices);
+            }
+
+            if (outError) *outError = float(std::sqrt(maxError));
+            return indices.size();
+        }
+
+    private:
+        // Vertices at the same position: m_remap is the lowest index of the group, m_wedge links a
+        // group into a circular list
+        void BuildPositionGroups()
+        {
+            std::vector<uint32_t> order(m_vertexCount);
+            std::iota(order.begin(), order.end(), 0u);
+            std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+            {
+                const Vector3& p = m_positions[a];
+                const Vector3& q = m_positions[b];
+                if (p.x != q.x) return p.x < q.x;
+                if (p.y != q.y) return p.y < q.y;
+                if (p.z != q.z) return p.z < q.z;
+                return a < b;
+            });
+
+            m_remap.resize(m_vertexCount);
+            m_wedge.resize(m_vertexCount);
+            for (size_t first = 0, last; first < order.size(); first = last)
+            {
+                const Vector3& p = m_positions[order[first]];
+                for (last = first + 1; last < order.size(); ++last)
+                {
+                    const Vector3& q = m_positions[order[last]];
+                    if (p.x != q.x || p.y != q.y || p.z != q.z) break;
+                }
+                for (size_t k = first; k < last; ++k)
+                {
+                    m_remap[order[k]] = order[first];
+                    m_wedge[order[k]] = order[k + 1 < last ? k + 1 : first];
+                }
+            }
+        }
+
+        // A directed edge without its reverse is open. Border and seam vertices have exactly one open
+        // edge in and one out per wedge; those of a seam's two wedges must run along the same positions.
+        void ClassifyVertices(const std::vector<uint32_t>& indices)
+        {
+            m_openIn.assign(m_vertexCount, ~0u);
+            m_openOut.assign(m_vertexCount, ~0u);
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    const uint32_t a = indices[i + corner], b = indices[i + (corner + 1) % 3];
+                    if (m_adjacency.HasEdge(indices.data(), b, a)) continue;
+                    // A second open edge marks the vertex itself, which locks it
+                    m_openIn[b] = m_openIn[b] == ~0u ? a : b;
+                    m_openOut[a] = m_openOut[a] == ~0u ? b : a;
+                }
+            }
+
+            auto hasOneOpenLoop = [this](uint32_t v)
+            {
+                return m_openIn[v] != ~0u && m_openIn[v] != v && m_openOut[v] != ~0u && m_openOut[v] != v;
+            };
+
+            m_kind.resize(m_vertexCount);
+            for (uint32_t v = 0; v < m_vertexCount; ++v)
+            {
+                if (m_remap[v] != v) continue;
+                VertexKind kind = Locked;
+                if (m_wedge[v] == v)
+                {
+                    if (m_openIn[v] == ~0u && m_openOut[v] == ~0u) kind = Manifold;
+                    else if (hasOneOpenLoop(v)) kind = Border;
+                }
+                else if (m_wedge[m_wedge[v]] == v)
+                {
+                    const uint32_t w = m_wedge[v];
+                    if (hasOneOpenLoop(v) && hasOneOpenLoop(w) &&
+                        m_remap[m_openIn[v]] == m_remap[m_openOut[w]] && m_remap[m_openOut[v]] == m_remap[m_openIn[w]])
+                        kind = Seam;
+                }
+                m_kind[v] = kind;
+            }
+            for (uint32_t v = 0; v < m_vertexCount; ++v) m_kind[v] = m_kind[m_remap[v]];
+        }
+
+        // One quadric per position group: the triangle planes weighted by area, plus planes through
+        // the open edges perpendicular to their triangle
+        void BuildQuadrics(const std::vector<uint32_t>& indices)
+        {
+            m_quadrics.assign(m_vertexCount, Quadric{});
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                const Vector3& p0 = m_positions[indices[i]];
+                Vector3 normal = Cross(Sub(m_positions[indices[i + 1]], p0), Sub(m_positions[indices[i + 2]], p0));
+                const double length = std::sqrt(Dot(normal, normal));
+                if (length == 0.0) continue;
+                normal = { normal.x / length, normal.y / length, normal.z / length };
+
+                const Quadric face = FromPlane(normal, -Dot(normal, p0), length * 0.5);
+                for (int corner = 0; corner < 3; ++corner) Add(m_quadrics[m_remap[indices[i + corner]]], face);
+
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    const uint32_t a = indices[i + corner], b = indices[i + (corner + 1) % 3];
+                    if (m_adjacency.HasEdge(indices.data(), b, a)) continue;
+
+                    // A seam edge is open on both sides of the seam; count it once
+                    const bool seam = HasPositionEdge(indices, b, a);
+                    if (seam && m_remap[a] > m_remap[b]) continue;
+
+                    const Vector3 edge = Sub(m_positions[b], m_positions[a]);
+                    Vector3 edgeNormal = Cross(edge, normal);
+                    const double edgeLength = std::sqrt(Dot(edgeNormal, edgeNormal));
+                    if (edgeLength == 0.0) continue;
+                    edgeNormal = { edgeNormal.x / edgeLength, edgeNormal.y / edgeLength, edgeNormal.z / edgeLength };
+                    const Quadric border = FromPlane(edgeNormal, -Dot(edgeNormal, m_positions[a]),
+                                                     Dot(edge, edge) * (seam ? SeamEdgeWeight : BorderEdgeWeight));
+                    Add(m_quadrics[m_remap[a]], border);
+                    Add(m_quadrics[m_remap[b]], border);
+                }
+            }
+        }
+
+        // Whether any wedge of a has an edge to any wedge at b's position
+        bool HasPositionEdge(const std::vector<uint32_t>& indices, uint32_t a, uint32_t b) const
+        {
+            uint32_t wa = a;
+            do
+            {
+                for (uint32_t k = m_adjacency.offsets[wa]; k < m_adjacency.offsets[wa + 1]; ++k)
+                {
+                    const uint32_t* triangle = indices.data() + size_t(m_adjacency.triangles[k]) * 3;
+                    for (int corner = 0; corner < 3; ++corner)
+                    {
+                        if (triangle[corner] == wa && m_remap[triangle[(corner + 1) % 3]] == m_remap[b]) return true;
+                    }
+                }
+                wa = m_wedge[wa];
+            } while (wa != a);
+            return false;
+        }
+
+        // One candidate per edge in position space
+        void PickCollapses(const std::vector<uint32_t>& indices)
+        {
+            m_collapses.clear();
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    const uint32_t i0 = indices[i + corner], i1 = indices[i + (corner + 1) % 3];
+                    const uint32_t r0 = m_remap[i0], r1 = m_remap[i1];
+                    if (r0 == r1) continue;
+
+                    const VertexKind k0 = m_kind[i0], k1 = m_kind[i1];
+                    const bool forward = CanCollapse[k0][k1], backward = CanCollapse[k1][k0];
+                    if (!forward && !backward) continue;
+
+                    if (k0 == k1 && (k0 == Border || k0 == Seam))
+                    {
+                        // Only along the loop itself, not across to another part of it or another loop
+                        if (m_openOut[i0] != i1 && m_openOut[i1] != i0) continue;
+                        // Seam edges occur once per side, border edges once
+                        if (k0 == Seam && r0 > r1) continue;
+                    }
+                    else if (i0 > i1)
+                    {
+                        // Interior edges occur in both directions
+                        continue;
+                    }
+
+                    if (forward && backward) m_collapses.push_back({ i0, i1, true, 0.0 });
+                    else if (forward) m_collapses.push_back({ i0, i1, false, 0.0 });
+                    else m_collapses.push_back({ i1, i0, false, 0.0 });
+                }
+            }
+        }
+
+        // The merged vertex keeps the quadrics of both ends; bidirectional edges collapse the cheaper way
+        void RankCollapses()
+        {
+            for (Collapse& collapse : m_collapses)
+            {
+                Quadric q = m_quadrics[m_remap[collapse.from]];
+                Add(q, m_quadrics[m_remap[collapse.to]]);
+                collapse.error = Error(q, m_positions[collapse.to]);
+                if (collapse.bidirectional)
+                {
+                    const double reverse = Error(q, m_positions[collapse.from]);
+                    if (reverse < collapse.error)
+                    {
+                        std::swap(collapse.from, collapse.to);
+                        collapse.error = reverse;
+                    }
+                }
+            }
+
+            // Sorting 64-bit keys is much cheaper than sorting the candidates; the bits of a
+            // non-negative float order like the float, the low half keeps the order deterministic
+            m_order.resize(m_collapses.size());
+            for (size_t i = 0; i < m_collapses.size(); ++i)
+            {
+                const float error = float(m_collapses[i].error);
+                uint32_t bits;
+                std::memcpy(&bits, &error, sizeof(bits));
+                m_order[i] = uint64_t(bits) << 32 | i;
+            }
+            std::sort(m_order.begin(), m_order.end());
+        }
+
+        // Moving from onto to must not flip any remaining triangle around from. Turning one by more
+        // than ~75 degrees counts as well, which also rejects slivers that would fold up on edge.
+        bool FlipsTriangles(const std::vector<uint32_t>& indices, uint32_t from, uint32_t to) const
+        {
+            const Vector3& target = m_positions[to];
+            uint32_t w = from;
+            do
+            {
+                for (uint32_t k = m_adjacency.offsets[w]; k < m_adjacency.offsets[w + 1]; ++k)
+                {
+                    const uint32_t* triangle = indices.data() + size_t(m_adjacency.triangles[k]) * 3;
+                    const int corner = triangle[0] == w ? 0 : triangle[1] == w ? 1 : 2;
+                    const uint32_t a = m_collapseRemap[triangle[(corner + 1) % 3]];
+                    const uint32_t b = m_collapseRemap[triangle[(corner + 2) % 3]];
+                    if (m_remap[a] == m_remap[to] || m_remap[b] == m_remap[to]) continue;
+
+                    const Vector3& pa = m_positions[a];
+                    const Vector3& pb = m_positions[b];
+                    const Vector3 before = Cross(Sub(pa, m_positions[w]), Sub(pb, m_positions[w]));
+                    const Vector3 after = Cross(Sub(pa, target), Sub(pb, target));
+                    const double dot = Dot(before, after);
+                    if (Dot(before, before) > 0.0 && (dot <= 0.0 || dot * dot <= 0.0625 * Dot(before, before) * Dot(after, after))) return true;
+                }
+                w = m_wedge[w];
+            } while (w != from);
+            return false;
+        }
+
+        // Keeps the open loop consistent when from collapses onto its neighbour to along it
+        void UpdateLoop(uint32_t from, uint32_t to)
+        {
+            if (m_openOut[from] == to)
+            {
+                const uint32_t previous = m_openIn[from];
+                m_openOut[previous] = to;
+                m_openIn[to] = previous;
+            }
+            else
+            {
+                const uint32_t next = m_openOut[from];
+                m_openOut[to] = next;
+                m_openIn[next] = to;
+            }
+        }
+
+        // Collapses are independent within a pass: every position group takes part in at most one
+        size_t PerformCollapses(const std::vector<uint32_t>& indices, size_t triangleGoal, double errorLimit, double& maxError)
+        {
+            m_locked.assign(m_vertexCount, 0);
+            size_t removedTriangles = 0;
+            size_t collapseCount = 0;
+            for (uint64_t key : m_order)
+            {
+                const Collapse& collapse = m_collapses[uint32_t(key)];
+                if (removedTriangles >= triangleGoal || collapse.error > errorLimit) break;
+
+                const uint32_t i0 = collapse.from, i1 = collapse.to;
+                const uint32_t r0 = m_remap[i0], r1 = m_remap[i1];
+                if (m_locked[r0] || m_locked[r1]) continue;
+                if (FlipsTriangles(indices, i0, i1)) continue;
+
+                const VertexKind kind = m_kind[i0];
+                m_collapseRemap[i0] = i1;
+                if (kind == Seam)
+                {
+                    // The other wedges lie on the other side of the same seam edge
+                    const uint32_t s0 = m_wedge[i0], s1 = m_wedge[i1];
+                    m_collapseRemap[s0] = s1;
+                    UpdateLoop(i0, i1);
+                    UpdateLoop(s0, s1);
+                }
+                else if (kind == Border)
+                {
+                    UpdateLoop(i0, i1);
+                }
+
+                Add(m_quadrics[r1], m_quadrics[r0]);
+                m_locked[r0] = m_locked[r1] = 1;
+                removedTriangles += kind == Border ? 1 : 2;
+                maxError = std::max(maxError, collapse.error);
+                ++collapseCount;
+            }
+            return collapseCount;
+        }
+
+        void RemapTriangles(std::vector<uint32_t>& indices) const
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                const uint32_t a = m_collapseRemap[indices[i]], b = m_collapseRemap[indices[i + 1]], c = m_collapseRemap[indices[i + 2]];
+                if (m_remap[a] == m_remap[b] || m_remap[b] == m_remap[c] || m_remap[c] == m_remap[a]) continue;
+                indices[count++] = a;
+                indices[count++] = b;
+                indices[count++] = c;
+            }
+            indices.resize(count);
+        }
+
+        size_t m_vertexCount;
+        std::vector<Vector3> m_positions;
+        std::vector<uint32_t> m_remap;
+        std::vector<uint32_t> m_wedge;
+        std::vector<uint32_t> m_openIn;
+        std::vector<uint32_t> m_openOut;
+        std::vector<VertexKind> m_kind;
+        std::vector<Quadric> m_quadrics;
+        std::vector<uint32_t> m_collapseRemap;
+        std::vector<uint8_t> m_locked;
+        std::vector<Collapse> m_collapses;
+        std::vector<uint64_t> m_order;
+        Adjacency m_adjacency;
+    };
+}
+
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                    const float* positions, size_t positionStride, size_t vertexCount,
+                    const SimplifySettings& settings, float* outError)
+{
+    std::vector<uint32_t> result(indices, indices + indexCount / 3 * 3);
+    if (outError) *outError = 0.0f;
+    if (result.size() > settings.targetIndexCount)
+    {
+        Simplifier simplifier(positions, positionStride, vertexCount);
+        simplifier.Run(result, settings, outError);
+    }
+    std::copy(result.begin(), result.end(), destination);
+    return result.size();
+}
+
+MeshLodChain BuildLodChain(const GeometryGenerator::MeshData& mesh, const LodChainSettings& settings)
+{
+    MeshLodChain chain;
+    const size_t indexCount = mesh.Indices32.size() / 3 * 3;
+    chain.indices.assign(mesh.Indices32.begin(), mesh.Indices32.begin() + indexCount);
+    chain.levels.push_back({ 0, uint32_t(indexCount), 0.0f });
+    if (indexCount == 0 || mesh.Vertices.empty()) return chain;
+
+    std::vector<uint32_t> current(chain.indices);
+    std::vector<uint32_t> next;
+    float error = 0.0f;
+    for (uint32_t level = 1; level < settings.maxLevels && error < settings.maxError; ++level)
+    {
+        const size_t targetTriangles = size_t(double(current.size() / 3) * settings.reduction);
+        if (targetTriangles < settings.minTriangles) break;
+
+        // Every level is measured against the one before it, so the errors add up
+        SimplifySettings simplify;
+        simplify.targetIndexCount = targetTriangles * 3;
+        simplify.targetError = settings.maxError - error;
+        next.resize(current.size());
+        float levelError = 0.0f;
+        const size_t count = SimplifyMesh(next.data(), current.data(), current.size(), &mesh.Vertices[0].Position.x,
+                                          sizeof(GeometryGenerator::Vertex), mesh.Vertices.size(), simplify, &levelError);
+
+        // Less than a tenth fewer triangles: what remains is locked or over the error budget
+        if (count * 10 > current.size() * 9) break;
+
+        next.resize(count);
+        error += levelError;
+        chain.levels.push_back({ uint32_t(chain.indices.size()), uint32_t(count), error });
+        chain.indices.insert(chain.indices.end(), next.begin(), next.end());
+        current.swap(next);
+    }
+    return chain;
+}
+
+void BuildLodChains(const GeometryGenerator::MeshData* meshes, size_t meshCount, MeshLodChain* chains,
+                    const LodChainSettings& settings)
+{
+    JobSystem::Get().ParallelFor(meshCount, [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i) chains[i] = BuildLodChain(meshes[i], settings);
+    }, 1);
+}
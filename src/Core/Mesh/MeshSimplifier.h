@@ -0,0 +1,56 @@
+#pragma once
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Common/GeometryGenerator.h"
+
+struct SimplifySettings
+{
+    size_t targetIndexCount = 0;    // Stop once at most this many indices remain...
+    float targetError = FLT_MAX;    // ...or before a collapse would exceed this error, in model units
+};
+
+// Edge-collapse simplification with quadric error metrics (Garland, Heckbert, "Surface
+// Simplification Using Quadric Error Metrics", 1997). Vertices only ever collapse onto existing
+// vertices, so the result indexes the same vertex buffer. Vertices at the same position with
+// different attributes form attribute seams, which only collapse along themselves, both sides at
+// once; open borders only collapse along the border. Anything more complex stays in place.
+// positions points at the first vertex's float3 position, positionStride is the vertex size in bytes.
+// Writes at most indexCount indices to destination (which may alias indices) and returns their
+// count; outError receives the resulting error in model units (RMS distance to the source planes).
+size_t SimplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+                    const float* positions, size_t positionStride, size_t vertexCount,
+                    const SimplifySettings& settings, float* outError = nullptr);
+
+struct LodChainSettings
+{
+    uint32_t maxLevels = 5;          // Including the source mesh
+    float reduction = 0.5f;          // Triangle count of a level relative to the previous one
+    float maxError = FLT_MAX;        // No level goes past this error, in model units
+    size_t minTriangles = 32;        // Levels stop before getting smaller than this
+};
+
+// Index buffers of all levels one after another, level 0 being the source indices. Every level
+// indexes the source vertices, so one MeshGeometry holds the chain and each level is a submesh;
+// error matches MeshLod::error and is non-decreasing.
+struct MeshLodChain
+{
+    struct Level
+    {
+        uint32_t startIndex;
+        uint32_t indexCount;
+        float error;
+    };
+
+    std::vector<uint32_t> indices;
+    std::vector<Level> levels;
+};
+
+// Each level is simplified from the previous one and stops early once a level barely shrinks.
+// Reads Indices32, so call it before MeshData::PackIndices.
+MeshLodChain BuildLodChain(const GeometryGenerator::MeshData& mesh, const LodChainSettings& settings = {});
+
+// BuildLodChain for many meshes, one job per mesh
+void BuildLodChains(const GeometryGenerator::MeshData* meshes, size_t meshCount, MeshLodChain* chains,
+                    const LodChainSettings& settings = {});
@@ -0,0 +1,255 @@
+#include "Meshlets.h"
+#include "../Rendering/FrustumCulling.h"
+#include "../Rendering/OcclusionCulling.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+using namespace DirectX;
+
+namespace
+{
+    XMFLOAT3 LoadPosition(const float* positions, size_t positionStride, uint32_t vertex)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + size_t(vertex) * positionStride);
+        return XMFLOAT3(p[0], p[1], p[2]);
+    }
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+    MeshletBounds ComputeBounds(const MeshletData& data, const Meshlet& meshlet, const float* positions, size_t positionStride)
+    {
+        MeshletBounds bounds = {};
+
+        // Sphere around the center of the meshlet's AABB
+        XMFLOAT3 low(FLT_MAX, FLT_MAX, FLT_MAX), high(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+        {
+            const XMFLOAT3 p = LoadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + i]);
+            low = XMFLOAT3(std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z));
+            high = XMFLOAT3(std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z));
+        }
+        bounds.center = XMFLOAT3((low.x + high.x) * 0.5f, (low.y + high.y) * 0.5f, (low.z + high.z) * 0.5f);
+        float radiusSquared = 0.0f;
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+        {
+            const XMFLOAT3 d = Sub(LoadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + i]), bounds.center);
+            radiusSquared = std::max(radiusSquared, Dot(d, d));
+        }
+        bounds.radius = std::sqrt(radiusSquared);
+
+        // Normal cone (as in meshoptimizer): the axis is the mean triangle normal, the apex is pulled
+        // back along it until every triangle plane lies in front of the apex
+        std::vector<XMFLOAT3> corners(size_t(meshlet.triangleCount) * 3);
+        std::vector<XMFLOAT3> normals;
+        normals.reserve(meshlet.triangleCount);
+        XMFLOAT3 axis(0.0f, 0.0f, 0.0f);
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+        {
+            const uint8_t* local = &data.triangles[meshlet.triangleOffset + t * 3];
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                corners[t * 3 + corner] = LoadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + local[corner]]);
+            }
+            const XMFLOAT3 e1 = Sub(corners[t * 3 + 1], corners[t * 3]), e2 = Sub(corners[t * 3 + 2], corners[t * 3]);
+            XMFLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+            const float length = std::sqrt(Dot(n, n));
+            n = length > 0.0f ? XMFLOAT3(n.x / length, n.y / length, n.z / length) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+            normals.push_back(n);
+            axis = XMFLOAT3(axis.x + n.x, axis.y + n.y, axis.z + n.z);
+        }
+
+        bounds.coneApex = bounds.center;
+        bounds.coneCutoff = 1.0f;
+        const float axisLength = std::sqrt(Dot(axis, axis));
+        if (axisLength <= 0.0f) return bounds;
+        axis = XMFLOAT3(axis.x / axisLength, axis.y / axisLength, axis.z / axisLength);
+        bounds.coneAxis = axis;
+
+        float minDot = 1.0f;
+        for (const XMFLOAT3& n : normals)
+        {
+            if (Dot(n, n) > 0.0f) minDot = std::min(minDot, Dot(n, axis));
+        }
+        // Cones wider than ~84 degrees almost never cull and make the apex unstable
+        if (minDot <= 0.1f) return bounds;
+
+        float maxOffset = 0.0f;
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+        {
+            const XMFLOAT3& n = normals[t];
+            if (Dot(n, n) == 0.0f) continue;
+            maxOffset = std::max(maxOffset, Dot(Sub(bounds.center, corners[t * 3]), n) / Dot(axis, n));
+        }
+        bounds.coneApex = Sub(bounds.center, XMFLOAT3(axis.x * maxOffset, axis.y * maxOffset, axis.z * maxOffset));
+        bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        return bounds;
+    }
+}
+
+MeshletData BuildMeshlets(const float* positions, size_t positionStride, size_t vertexCount,
+                          const uint32_t* indices, size_t indexCount, const MeshletSettings& settings)
+{
+    MeshletData data;
+    const uint32_t maxVertices = std::clamp<uint32_t>(settings.maxVertices, 3, 256);
+    const uint32_t maxTriangles = std::max<uint32_t>(settings.maxTriangles, 1);
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) return data;
+
+    // Triangles around every vertex (CSR)
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) ++offsets[indices[i] + 1];
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) adjacency[cursor[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    // Per-vertex and per-triangle markers hold the id of the meshlet being built, so nothing is cleared between meshlets
+    std::vector<uint8_t> used(triangleCount, 0);
+    std::vector<uint32_t> vertexMeshlet(vertexCount, ~0u);
+    std::vector<uint8_t> vertexLocal(vertexCount, 0);
+    std::vector<uint32_t> candidateMeshlet(triangleCount, ~0u);
+    std::vector<uint32_t> candidates;
+
+    data.meshlets.reserve(triangleCount / maxTriangles + 1);
+    data.triangles.reserve(triangleCount * 3);
+    size_t seed = 0;
+    for (;;)
+    {
+        while (seed < triangleCount && used[seed]) ++seed;
+        if (seed == triangleCount) break;
+
+        const uint32_t id = uint32_t(data.meshlets.size());
+        Meshlet meshlet = { uint32_t(data.vertices.size()), uint32_t(data.triangles.size()), 0, 0 };
+        candidates.clear();
+
+        auto newVertexCount = [&](uint32_t triangle)
+        {
+            const uint32_t a = indices[triangle * 3], b = indices[triangle * 3 + 1], c = indices[triangle * 3 + 2];
+            return uint32_t(vertexMeshlet[a] != id) + uint32_t(b != a && vertexMeshlet[b] != id) + uint32_t(c != a && c != b && vertexMeshlet[c] != id);
+        };
+
+        auto addTriangle = [&](uint32_t triangle)
+        {
+            used[triangle] = 1;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const uint32_t vertex = indices[triangle * 3 + corner];
+                if (vertexMeshlet[vertex] != id)
+                {
+                    vertexMeshlet[vertex] = id;
+                    vertexLocal[vertex] = uint8_t(meshlet.vertexCount++);
+                    data.vertices.push_back(vertex);
+                    for (uint32_t a = offsets[vertex]; a < offsets[vertex + 1]; ++a)
+                    {
+                        const uint32_t neighbour = adjacency[a];
+                        if (used[neighbour] || candidateMeshlet[neighbour] == id) continue;
+                        candidateMeshlet[neighbour] = id;
+                        candidates.push_back(neighbour);
+                    }
+                }
+                data.triangles.push_back(vertexLocal[vertex]);
+            }
+            ++meshlet.triangleCount;
+        };
+
+        addTriangle(uint32_t(seed));
+        while (meshlet.triangleCount < maxTriangles)
+        {
+            // Fewest new vertices first, then the lowest triangle index; used candidates are dropped
+            uint32_t best = ~0u, bestNew = 4;
+            size_t kept = 0;
+            for (uint32_t triangle : candidates)
+            {
+                if (used[triangle]) continue;
+                candidates[kept++] = triangle;
+                const uint32_t added = newVertexCount(triangle);
+                if (meshlet.vertexCount + added > maxVertices) continue;
+                if (added < bestNew || (added == bestNew && triangle < best))
+                {
+                    best = triangle;
+                    bestNew = added;
+                }
+            }
+            candidates.resize(kept);
+            if (best == ~0u) break;
+            addTriangle(best);
+        }
+        data.meshlets.push_back(meshlet);
+    }
+
+    data.bounds.reserve(data.meshlets.size());
+    for (const Meshlet& meshlet : data.meshlets) data.bounds.push_back(ComputeBounds(data, meshlet, positions, positionStride));
+    return data;
+}
+
+size_t CullMeshlets(const MeshletData& data, const XMFLOAT4X4& world, const Frustum& frustum,
+                    const XMFLOAT3& cameraPosition, const OcclusionCuller* occlusion,
+                    uint32_t* outVisible, MeshletCullStats* stats)
+{
+    const float (&m)[4][4] = world.m;
+    const float scaleX = std::sqrt(m[0][0] * m[0][0] + m[0][1] * m[0][1] + m[0][2] * m[0][2]);
+    const float scaleY = std::sqrt(m[1][0] * m[1][0] + m[1][1] * m[1][1] + m[1][2] * m[1][2]);
+    const float scaleZ = std::sqrt(m[2][0] * m[2][0] + m[2][1] * m[2][1] + m[2][2] * m[2][2]);
+    const float maxScale = std::max({ scaleX, scaleY, scaleZ });
+    const float minScale = std::min({ scaleX, scaleY, scaleZ });
+    const float determinant = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    // Cones survive rotation and uniform scale only; a mirrored transform also flips the facing
+    const bool coneTest = maxScale > 0.0f && maxScale - minScale <= maxScale * 0.01f && determinant > 0.0f;
+
+    auto transformPoint = [&m](const XMFLOAT3& p)
+    {
+        return XMFLOAT3(p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0],
+                        p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1],
+                        p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2]);
+    };
+
+    MeshletCullStats counts;
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < data.bounds.size(); ++i)
+    {
+        const MeshletBounds& bounds = data.bounds[i];
+        const XMFLOAT3 center = transformPoint(bounds.center);
+        const float radius = bounds.radius * maxScale;
+
+        bool inside = true;
+        for (const XMFLOAT4& plane : frustum.planes)
+        {
+            inside &= plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w >= -radius;
+        }
+        if (!inside)
+        {
+            ++counts.frustumCulled;
+            continue;
+        }
+
+        if (coneTest && bounds.coneCutoff < 1.0f)
+        {
+            const XMFLOAT3 apex = transformPoint(bounds.coneApex);
+            const XMFLOAT3 axis((bounds.coneAxis.x * m[0][0] + bounds.coneAxis.y * m[1][0] + bounds.coneAxis.z * m[2][0]) / maxScale,
+                                (bounds.coneAxis.x * m[0][1] + bounds.coneAxis.y * m[1][1] + bounds.coneAxis.z * m[2][1]) / maxScale,
+                                (bounds.coneAxis.x * m[0][2] + bounds.coneAxis.y * m[1][2] + bounds.coneAxis.z * m[2][2]) / maxScale);
+            const XMFLOAT3 view = Sub(apex, cameraPosition);
+            if (Dot(view, axis) >= bounds.coneCutoff * std::sqrt(Dot(view, view)))
+            {
+                ++counts.backfaceCulled;
+                continue;
+            }
+        }
+
+        if (occlusion && !occlusion->IsVisible(center, XMFLOAT3(radius, radius, radius)))
+        {
+            ++counts.occlusionCulled;
+            continue;
+        }
+
+        outVisible[visibleCount++] = uint32_t(i);
+    }
+
+    if (stats) *stats = counts;
+    return visibleCount;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+struct Frustum;
+class OcclusionCuller;
+
+struct MeshletSettings
+{
+    uint32_t maxVertices = 64;   // At most 256: triangles use 8-bit meshlet-local indices
+    uint32_t maxTriangles = 124;
+};
+
+// Ranges of one meshlet in MeshletData::vertices and MeshletData::triangles
+struct Meshlet
+{
+    uint32_t vertexOffset;
+    uint32_t triangleOffset; // In bytes: three local indices per triangle
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+
+// Mesh-space bounds of a meshlet. The meshlet faces away from a viewer at p (all its triangles are
+// back faces) when dot(normalize(coneApex - p), coneAxis) >= coneCutoff; a cutoff of 1 never culls.
+struct MeshletBounds
+{
+    DirectX::XMFLOAT3 center;
+    float radius;
+    DirectX::XMFLOAT3 coneApex;
+    float coneCutoff;
+    DirectX::XMFLOAT3 coneAxis;
+};
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;   // One per meshlet
+    std::vector<uint32_t> vertices;      // Mesh vertex indices, referenced by Meshlet::vertexOffset
+    std::vector<uint8_t> triangles;      // Meshlet-local indices, referenced by Meshlet::triangleOffset
+};
+
+// Greedy meshlet builder: every meshlet grows from the first unassigned triangle in index order by
+// adding the adjacent triangle that brings the fewest new vertices, until a limit is reached.
+// Run it on index buffers optimized with OptimizeMesh so that meshlets also follow cache order.
+// positions points at the first vertex's float3 position, positionStride is the vertex size in bytes.
+MeshletData BuildMeshlets(const float* positions, size_t positionStride, size_t vertexCount,
+                          const uint32_t* indices, size_t indexCount, const MeshletSettings& settings = {});
+
+struct MeshletCullStats
+{
+    uint32_t frustumCulled = 0;
+    uint32_t backfaceCulled = 0;
+    uint32_t occlusionCulled = 0;
+};
+
+// Writes indices of the meshlets of one instance that may be visible, in ascending order, and returns
+// their count. world may contain non-uniform scale, in which case the cone test is skipped.
+// occlusion is optional and must have been rasterized for the same frame.
+size_t CullMeshlets(const MeshletData& data, const DirectX::XMFLOAT4X4& world, const Frustum& frustum,
+                    const DirectX::XMFLOAT3& cameraPosition, const OcclusionCuller* occlusion,
+                    uint32_t* outVisible, MeshletCullStats* stats = nullptr);
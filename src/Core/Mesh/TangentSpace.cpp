@@ -0,0 +1,341 @@
+#include "TangentSpace.h"
+#include "../Jobs/JobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+using namespace DirectX;
+using Vertex = GeometryGenerator::Vertex;
+
+namespace
+{
+    constexpr uint32_t NoVertex = ~0u;
+
+    enum FaceFlags : uint8_t
+    {
+        FaceOrientPreserving = 1, // Positive UV area; the bitangent sign is +1
+        FaceDegenerate = 2,       // No UV area or collapsed corners; groups with any neighbour
+    };
+
+    // mikktspace.c treats anything at or below FLT_MIN as zero
+    bool NotZero(float value) { return std::fabs(value) > FLT_MIN; }
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b) { return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z); }
+
+    // v minus its component along the unit normal n, normalized when not zero
+    XMFLOAT3 ProjectOntoPlane(const XMFLOAT3& v, const XMFLOAT3& n)
+    {
+        const float d = Dot(n, v);
+        XMFLOAT3 result(v.x - n.x * d, v.y - n.y * d, v.z - n.z * d);
+        const float length = std::sqrt(Dot(result, result));
+        if (NotZero(length))
+            result = XMFLOAT3(result.x / length, result.y / length, result.z / length);
+        return result;
+    }
+
+    // Any unit vector perpendicular to n, for vertices whose triangles give no UV direction
+    XMFLOAT3 AnyPerpendicular(const XMFLOAT3& n)
+    {
+        const XMFLOAT3 axis = std::fabs(n.x) < 0.9f ? XMFLOAT3(1.0f, 0.0f, 0.0f) : XMFLOAT3(0.0f, 1.0f, 0.0f);
+        const XMFLOAT3 result = ProjectOntoPlane(axis, n);
+        return Dot(result, result) > 0.5f ? result : axis;
+    }
+
+    // Position, normal and UV; +0.0f folds -0 into 0 so that equal keys hash alike
+    void GetWeldKey(const Vertex& v, float key[8])
+    {
+        const float values[8] = { v.Position.x, v.Position.y, v.Position.z, v.Normal.x, v.Normal.y, v.Normal.z, v.TexC.x, v.TexC.y };
+        for (int i = 0; i < 8; ++i)
+            key[i] = values[i] + 0.0f;
+    }
+
+    // Every vertex mapped to the lowest index with the same position, normal and UV
+    std::vector<uint32_t> WeldVertices(const std::vector<Vertex>& vertices)
+    {
+        size_t capacity = 16;
+        while (capacity < vertices.size() * 2) capacity *= 2;
+        std::vector<uint32_t> table(capacity, NoVertex);
+        std::vector<uint32_t> welded(vertices.size());
+
+        for (uint32_t i = 0; i < vertices.size(); ++i)
+        {
+            float key[8];
+            GetWeldKey(vertices[i], key);
+            uint64_t hash = 14695981039346656037ull;
+            for (float value : key)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                hash = (hash ^ bits) * 1099511628211ull;
+            }
+
+            for (size_t slot = (hash ^ (hash >> 32)) & (capacity - 1);; slot = (slot + 1) & (capacity - 1))
+            {
+                if (table[slot] == NoVertex)
+                {
+                    table[slot] = i;
+                    welded[i] = i;
+                    break;
+                }
+                float other[8];
+                GetWeldKey(vertices[table[slot]], other);
+                if (std::equal(key, key + 8, other))
+                {
+                    welded[i] = table[slot];
+                    break;
+                }
+            }
+        }
+        return welded;
+    }
+
+    // Lowest member of each set is its root, so roots follow corner order
+    uint32_t FindRoot(std::vector<uint32_t>& parent, uint32_t a)
+    {
+        while (parent[a] != a)
+        {
+            parent[a] = parent[parent[a]];
+            a = parent[a];
+        }
+        return a;
+    }
+
+    void Unite(std::vector<uint32_t>& parent, uint32_t a, uint32_t b)
+    {
+        a = FindRoot(parent, a);
+        b = FindRoot(parent, b);
+        if (a < b) parent[b] = a;
+        else if (b < a) parent[a] = b;
+    }
+
+    struct CornerResult
+    {
+        XMFLOAT3 tangent;
+        float sign;
+        uint32_t extra;   // NoVertex: stays on its vertex, otherwise index among the vertex's new copies
+        bool writer;      // First corner of its vertex and group; stores the vertex
+    };
+}
+
+void GenerateTangents(GeometryGenerator::MeshData& mesh, std::vector<float>* outSigns)
+{
+    std::vector<Vertex>& vertices = mesh.Vertices;
+    std::vector<uint32_t>& indices = mesh.Indices32;
+    const uint32_t vertexCount = uint32_t(vertices.size());
+    const size_t faceCount = indices.size() / 3;
+    const size_t cornerCount = faceCount * 3;
+    if (outSigns) outSigns->assign(vertexCount, 1.0f);
+    if (faceCount == 0) return;
+
+    JobSystem& jobs = JobSystem::Get();
+    const std::vector<uint32_t> welded = WeldVertices(vertices);
+
+    // Streaming pass over the triangles that does all of the per-corner math, so the gathers per
+    // vertex below only add up results. Per corner: its welded neighbours along the triangle and
+    // its contribution, the triangle's UV gradient along u (flipped for mirrored triangles, as in
+    // mikktspace.c) projected into the corner's tangent plane and weighted by the corner angle.
+    std::vector<uint8_t> faceFlags(faceCount);
+    std::vector<uint32_t> cornerNext(cornerCount), cornerPrev(cornerCount);
+    std::vector<float> weightedX(cornerCount), weightedY(cornerCount), weightedZ(cornerCount);
+    jobs.ParallelFor(faceCount, [&](size_t first, size_t last)
+    {
+        for (size_t f = first; f < last; ++f)
+        {
+            const uint32_t* face = &indices[f * 3];
+            const Vertex* v[3] = { &vertices[face[0]], &vertices[face[1]], &vertices[face[2]] };
+            const XMFLOAT3 d1 = Sub(v[1]->Position, v[0]->Position), d2 = Sub(v[2]->Position, v[0]->Position);
+            const float t21x = v[1]->TexC.x - v[0]->TexC.x, t21y = v[1]->TexC.y - v[0]->TexC.y;
+            const float t31x = v[2]->TexC.x - v[0]->TexC.x, t31y = v[2]->TexC.y - v[0]->TexC.y;
+            const float signedArea = t21x * t31y - t21y * t31x;
+            const XMFLOAT3 tangent(t31y * d1.x - t21y * d2.x, t31y * d1.y - t21y * d2.y, t31y * d1.z - t21y * d2.z);
+
+            const uint32_t w[3] = { welded[face[0]], welded[face[1]], welded[face[2]] };
+            const bool degenerate = !NotZero(signedArea) || w[0] == w[1] || w[1] == w[2] || w[2] == w[0];
+            faceFlags[f] = uint8_t((signedArea > 0.0f ? FaceOrientPreserving : 0) | (degenerate ? FaceDegenerate : 0));
+
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                const size_t c = f * 3 + i;
+                const uint32_t i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+                cornerNext[c] = w[i1];
+                cornerPrev[c] = w[i2];
+
+                const XMFLOAT3& normal = v[i]->Normal;
+                const XMFLOAT3 e0 = ProjectOntoPlane(Sub(v[i2]->Position, v[i]->Position), normal);
+                const XMFLOAT3 e1 = ProjectOntoPlane(Sub(v[i1]->Position, v[i]->Position), normal);
+                const XMFLOAT3 projected = ProjectOntoPlane(tangent, normal);
+                const float angle = degenerate ? 0.0f : std::acos(std::clamp(Dot(e0, e1), -1.0f, 1.0f));
+                const float weight = signedArea > 0.0f ? angle : -angle;
+                weightedX[c] = projected.x * weight;
+                weightedY[c] = projected.y * weight;
+                weightedZ[c] = projected.z * weight;
+            }
+        }
+    });
+
+    // Corners of every welded vertex, in index order
+    std::vector<uint32_t> cornerStart(size_t(vertexCount) + 1, 0);
+    for (size_t c = 0; c < cornerCount; ++c)
+        ++cornerStart[welded[indices[c]] + 1];
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        cornerStart[v + 1] += cornerStart[v];
+    std::vector<uint32_t> corners(cornerCount);
+    {
+        std::vector<uint32_t> cursor(cornerStart.begin(), cornerStart.end() - 1);
+        for (size_t c = 0; c < cornerCount; ++c)
+            corners[cursor[welded[indices[c]]]++] = uint32_t(c);
+    }
+
+    // Groups of corners around each welded vertex, their tangents, and the copies needed where one
+    // vertex ends up in more than one group
+    std::vector<CornerResult> results(cornerCount);
+    std::vector<uint32_t> extraStart(size_t(vertexCount) + 1, 0);
+    jobs.ParallelFor(vertexCount, [&](size_t first, size_t last)
+    {
+        std::vector<uint32_t> next, prev, parent;
+        std::vector<std::pair<uint32_t, uint32_t>> byPrev;
+        std::vector<XMFLOAT3> sums;
+        std::vector<float> signs;
+        std::vector<std::pair<uint32_t, uint32_t>> pairs, order;
+        std::vector<uint32_t> extraOf, target;
+        std::vector<uint8_t> written;
+
+        for (size_t w = first; w < last; ++w)
+        {
+            const uint32_t begin = cornerStart[w], count = cornerStart[w + 1] - begin;
+            if (count == 0) continue;
+            const uint32_t* local = &corners[begin];
+            const XMFLOAT3& normal = vertices[w].Normal;
+
+            next.resize(count);
+            prev.resize(count);
+            parent.resize(count);
+            byPrev.resize(count);
+            bool anyDegenerate = false;
+            for (uint32_t a = 0; a < count; ++a)
+            {
+                const uint32_t c = local[a];
+                next[a] = cornerNext[c];
+                prev[a] = cornerPrev[c];
+                parent[a] = a;
+                byPrev[a] = { prev[a], a };
+                anyDegenerate |= (faceFlags[c / 3] & FaceDegenerate) != 0;
+            }
+            std::sort(byPrev.begin(), byPrev.end());
+
+            // Corners a and b share the edge w -> next[a] when next[a] == prev[b]. Same-orientation
+            // neighbours join, and degenerate triangles join each other.
+            for (uint32_t a = 0; a < count; ++a)
+            {
+                const uint8_t flagsA = faceFlags[local[a] / 3];
+                auto range = std::equal_range(byPrev.begin(), byPrev.end(), std::make_pair(next[a], 0u),
+                    [](const auto& x, const auto& y) { return x.first < y.first; });
+                for (auto it = range.first; it != range.second; ++it)
+                {
+                    const uint8_t flagsB = faceFlags[local[it->second] / 3];
+                    if ((flagsA & FaceDegenerate) ? (flagsB & FaceDegenerate) != 0 : flagsA == flagsB)
+                        Unite(parent, a, it->second);
+                }
+            }
+
+            // Each run of degenerate triangles then joins the lowest group next to it, or the vertex's
+            // first group when none is; deciding all of them first keeps one run from bridging two groups
+            if (anyDegenerate)
+            {
+                uint32_t firstGroup = NoVertex;
+                for (uint32_t a = 0; a < count && firstGroup == NoVertex; ++a)
+                {
+                    if (!(faceFlags[local[a] / 3] & FaceDegenerate)) firstGroup = FindRoot(parent, a);
+                }
+
+                target.assign(count, NoVertex);
+                for (uint32_t a = 0; a < count; ++a)
+                {
+                    if (!(faceFlags[local[a] / 3] & FaceDegenerate)) continue;
+                    const uint32_t run = FindRoot(parent, a);
+                    for (uint32_t b = 0; b < count; ++b)
+                    {
+                        if ((faceFlags[local[b] / 3] & FaceDegenerate) || (next[a] != prev[b] && next[b] != prev[a])) continue;
+                        target[run] = std::min(target[run], FindRoot(parent, b));
+                    }
+                }
+                for (uint32_t a = 0; a < count; ++a)
+                {
+                    if (!(faceFlags[local[a] / 3] & FaceDegenerate) || FindRoot(parent, a) != a) continue;
+                    const uint32_t group = target[a] != NoVertex ? target[a] : firstGroup;
+                    if (group != NoVertex) Unite(parent, a, group);
+                }
+            }
+
+            // Sums run in corner order, whichever thread gets the vertex
+            sums.assign(count, XMFLOAT3(0.0f, 0.0f, 0.0f));
+            signs.assign(count, 1.0f);
+            for (uint32_t a = 0; a < count; ++a)
+            {
+                const uint32_t c = local[a];
+                if (faceFlags[c / 3] & FaceDegenerate) continue;
+                const uint32_t group = FindRoot(parent, a);
+                sums[group].x += weightedX[c];
+                sums[group].y += weightedY[c];
+                sums[group].z += weightedZ[c];
+                signs[group] = (faceFlags[c / 3] & FaceOrientPreserving) ? 1.0f : -1.0f;
+            }
+
+            // One copy per (vertex, group) beyond the first group of each vertex, numbered in
+            // (vertex, group) order
+            pairs.resize(count);
+            for (uint32_t a = 0; a < count; ++a)
+                pairs[a] = { indices[local[a]], FindRoot(parent, a) };
+            order.assign(pairs.begin(), pairs.end());
+            std::sort(order.begin(), order.end());
+            order.erase(std::unique(order.begin(), order.end()), order.end());
+
+            extraOf.resize(order.size());
+            uint32_t extras = 0;
+            for (size_t p = 0; p < order.size(); ++p)
+                extraOf[p] = p > 0 && order[p].first == order[p - 1].first ? extras++ : NoVertex;
+            extraStart[w + 1] = extras;
+
+            written.assign(order.size(), 0);
+            for (uint32_t a = 0; a < count; ++a)
+            {
+                const size_t p = std::lower_bound(order.begin(), order.end(), pairs[a]) - order.begin();
+                const uint32_t group = pairs[a].second;
+                XMFLOAT3 tangent = sums[group];
+                const float length = std::sqrt(Dot(tangent, tangent));
+                tangent = NotZero(length) ? XMFLOAT3(tangent.x / length, tangent.y / length, tangent.z / length) : AnyPerpendicular(normal);
+                results[local[a]] = { tangent, signs[group], extraOf[p], !written[p] };
+                written[p] = 1;
+            }
+        }
+    });
+
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        extraStart[v + 1] += extraStart[v];
+    vertices.resize(size_t(vertexCount) + extraStart[vertexCount]);
+    if (outSigns) outSigns->resize(vertices.size(), 1.0f);
+
+    jobs.ParallelFor(vertexCount, [&](size_t first, size_t last)
+    {
+        for (size_t w = first; w < last; ++w)
+        {
+            for (uint32_t k = cornerStart[w]; k < cornerStart[w + 1]; ++k)
+            {
+                const uint32_t c = corners[k];
+                const CornerResult& result = results[c];
+                const uint32_t source = indices[c];
+                const uint32_t target = result.extra == NoVertex ? source : vertexCount + extraStart[w] + result.extra;
+                if (result.writer)
+                {
+                    if (target != source) vertices[target] = vertices[source];
+                    vertices[target].TangentU = result.tangent;
+                    if (outSigns) (*outSigns)[target] = result.sign;
+                }
+                indices[c] = target;
+            }
+        }
+    });
+}
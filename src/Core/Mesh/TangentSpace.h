@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+#include "../Common/GeometryGenerator.h"
+
+// Per-vertex tangents matching MikkTSpace (Mikkelsen, "Simulation of Wrinkled Surfaces Revisited",
+// 2008; mikktspace.c at its default angular threshold), so normal maps baked against it light correctly.
+//   - Each triangle's tangent follows its UV gradient and is projected into the tangent plane of every
+//     corner's normal; corners average these weighted by the corner angle.
+//   - Vertices with the same position, normal and UV are treated as one, as the reference does. Around
+//     such a vertex, corners average together only while they stay connected through shared edges of
+//     triangles with the same UV orientation, so mirrored UVs get their own tangent and bitangent sign.
+//   - Triangles with no UV area take the tangent of a neighbour and do not contribute their own.
+// The work is split per triangle and per vertex, and every sum runs in index order, so the result
+// does not depend on the number of threads.
+// Reads Indices32 and may append vertices: a vertex whose corners end up with different tangents
+// is split and Indices32 is updated. Call it before OptimizeMesh, BuildMeshlets and PackIndices.
+// outSigns receives one bitangent sign per vertex for EncodeVertices; the bitangent is
+// sign * cross(Normal, TangentU). GeometryGenerator primitives already come with exact tangents.
+void GenerateTangents(GeometryGenerator::MeshData& mesh, std::vector<float>* outSigns = nullptr);
@@ -0,0 +1,137 @@
+#include "VertexCompression.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+using Vertex = GeometryGenerator::Vertex;
+
+const D3D12_INPUT_ELEMENT_DESC PackedVertexInputLayout[4] =
+{
+    { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(PackedVertex, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(PackedVertex, normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(PackedVertex, tangent), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, offsetof(PackedVertex, texC), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+};
+
+namespace
+{
+    uint16_t EncodeUnorm(float value)
+    {
+        return uint16_t(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+
+    int16_t EncodeSnorm(float value)
+    {
+        return int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    // D3D maps -32768 to -1 as well
+    float DecodeSnorm(int16_t value)
+    {
+        return std::max(float(value) / 32767.0f, -1.0f);
+    }
+
+    // Octahedral mapping (Meyer et al., "On Floating-Point Normal Vectors", 2010): the direction is
+    // projected onto the octahedron |x| + |y| + |z| = 1 and the lower half is folded over the upper.
+    void EncodeOctahedral(const XMFLOAT3& v, int16_t out[2])
+    {
+        const float l1 = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+        if (l1 <= 0.0f)
+        {
+            out[0] = out[1] = 0;
+            return;
+        }
+        float x = v.x / l1, y = v.y / l1;
+        if (v.z < 0.0f)
+        {
+            const float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        out[0] = EncodeSnorm(x);
+        out[1] = EncodeSnorm(y);
+    }
+
+    XMFLOAT3 DecodeOctahedral(const int16_t in[2])
+    {
+        float x = DecodeSnorm(in[0]), y = DecodeSnorm(in[1]);
+        const float z = 1.0f - std::fabs(x) - std::fabs(y);
+        const float fold = std::max(-z, 0.0f);
+        x += x >= 0.0f ? -fold : fold;
+        y += y >= 0.0f ? -fold : fold;
+        const float length = std::sqrt(x * x + y * y + z * z);
+        return XMFLOAT3(x / length, y / length, z / length);
+    }
+}
+
+VertexQuantization ComputeVertexQuantization(const Vertex* vertices, size_t count)
+{
+    VertexQuantization quantization;
+    if (count == 0) return quantization;
+
+    XMFLOAT3 low(FLT_MAX, FLT_MAX, FLT_MAX), high(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const XMFLOAT3& p = vertices[i].Position;
+        low = XMFLOAT3(std::min(low.x, p.x), std::min(low.y, p.y), std::min(low.z, p.z));
+        high = XMFLOAT3(std::max(high.x, p.x), std::max(high.y, p.y), std::max(high.z, p.z));
+    }
+    quantization.origin = low;
+    quantization.size = XMFLOAT3(high.x - low.x, high.y - low.y, high.z - low.z);
+    return quantization;
+}
+
+XMFLOAT4X4 GetDequantizationTransform(const VertexQuantization& quantization)
+{
+    const XMFLOAT3& s = quantization.size;
+    const XMFLOAT3& o = quantization.origin;
+    return XMFLOAT4X4(s.x, 0.0f, 0.0f, 0.0f,
+                      0.0f, s.y, 0.0f, 0.0f,
+                      0.0f, 0.0f, s.z, 0.0f,
+                      o.x, o.y, o.z, 1.0f);
+}
+
+void EncodeVertices(PackedVertex* destination, const Vertex* vertices, size_t count,
+                    const VertexQuantization& quantization, const float* tangentSigns)
+{
+    // Flat axes quantize to 0 and decode to the origin
+    const XMFLOAT3& size = quantization.size;
+    const XMFLOAT3 inverseSize(size.x > 0.0f ? 1.0f / size.x : 0.0f,
+                               size.y > 0.0f ? 1.0f / size.y : 0.0f,
+                               size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Vertex& vertex = vertices[i];
+        PackedVertex& packed = destination[i];
+        packed.position[0] = EncodeUnorm((vertex.Position.x - quantization.origin.x) * inverseSize.x);
+        packed.position[1] = EncodeUnorm((vertex.Position.y - quantization.origin.y) * inverseSize.y);
+        packed.position[2] = EncodeUnorm((vertex.Position.z - quantization.origin.z) * inverseSize.z);
+        packed.position[3] = tangentSigns && tangentSigns[i] < 0.0f ? 0 : 65535;
+        EncodeOctahedral(vertex.Normal, packed.normal);
+        EncodeOctahedral(vertex.TangentU, packed.tangent);
+        packed.texC[0] = PackedVector::XMConvertFloatToHalf(vertex.TexC.x);
+        packed.texC[1] = PackedVector::XMConvertFloatToHalf(vertex.TexC.y);
+    }
+}
+
+void DecodeVertices(Vertex* destination, const PackedVertex* vertices, size_t count,
+                    const VertexQuantization& quantization, float* tangentSigns)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const PackedVertex& packed = vertices[i];
+        Vertex& vertex = destination[i];
+        vertex.Position = XMFLOAT3(quantization.origin.x + packed.position[0] / 65535.0f * quantization.size.x,
+                                   quantization.origin.y + packed.position[1] / 65535.0f * quantization.size.y,
+                                   quantization.origin.z + packed.position[2] / 65535.0f * quantization.size.z);
+        vertex.Normal = DecodeOctahedral(packed.normal);
+        vertex.TangentU = DecodeOctahedral(packed.tangent);
+        vertex.TexC = XMFLOAT2(PackedVector::XMConvertHalfToFloat(packed.texC[0]),
+                               PackedVector::XMConvertHalfToFloat(packed.texC[1]));
+        if (tangentSigns) tangentSigns[i] = packed.position[3] >= 32768 ? 1.0f : -1.0f;
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <d3d12.h>
+#include <DirectXMath.h>
+#include "../Common/GeometryGenerator.h"
+
+// 20-byte replacement for GeometryGenerator::Vertex (44 bytes) for vertex buffers
+struct PackedVertex
+{
+    uint16_t position[4]; // xyz: UNORM within VertexQuantization, w: bitangent sign (0 is -1, 65535 is +1)
+    int16_t normal[2];    // Octahedral, SNORM
+    int16_t tangent[2];   // Octahedral, SNORM
+    uint16_t texC[2];     // Half floats
+};
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex must match PackedVertexInputLayout");
+
+// Maps UNORM positions back to the bounds they were quantized in: origin + position * size
+struct VertexQuantization
+{
+    DirectX::XMFLOAT3 origin = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT3 size = { 0.0f, 0.0f, 0.0f };
+};
+
+// Input layout for PackedVertex. The shader sees the position in [0, 1] and maps it back with
+// DequantizePosition before the world matrix; normal and tangent go through OctDecode and then the
+// world matrix as usual (Shaders/PackedVertex.hlsli). The dequantization scale differs per axis,
+// so it must not end up in the matrix that transforms normals and tangents: that would skew them.
+extern const D3D12_INPUT_ELEMENT_DESC PackedVertexInputLayout[4];
+
+// Worst-case decoding errors: position per axis as a fraction of VertexQuantization::size (half a
+// step plus float rounding), normal and tangent as an angle in radians, UV relative to the magnitude
+// of the coordinate (half floats, so |UV| must stay below 65504)
+constexpr float PackedVertexPositionError = 0.52f / 65535.0f;
+constexpr float PackedVertexDirectionError = 0.0001f;
+constexpr float PackedVertexTexCError = 1.0f / 2048.0f;
+
+// Bounds of the vertices of one submesh; quantizing each submesh separately keeps the step small
+VertexQuantization ComputeVertexQuantization(const GeometryGenerator::Vertex* vertices, size_t count);
+
+// Row-vector scale and translation from quantized positions to mesh space (DequantizePosition as a
+// matrix). Multiplied in front of world it may replace that step for positions only; normals and
+// tangents still take world itself.
+DirectX::XMFLOAT4X4 GetDequantizationTransform(const VertexQuantization& quantization);
+
+// Vertex has no bitangent sign; tangentSigns gives one per vertex (negative for mirrored UVs),
+// otherwise +1 is stored. Directions need not be normalized; zero vectors decode to +z.
+void EncodeVertices(PackedVertex* destination, const GeometryGenerator::Vertex* vertices, size_t count,
+                    const VertexQuantization& quantization, const float* tangentSigns = nullptr);
+
+// Inverse of EncodeVertices within the errors above, for tools and validation. tangentSigns is optional.
+void DecodeVertices(GeometryGenerator::Vertex* destination, const PackedVertex* vertices, size_t count,
+                    const VertexQuantization& quantization, float* tangentSigns = nullptr);
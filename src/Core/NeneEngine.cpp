@@ -1,5 +1,8 @@
 #include "NeneEngine.h"
+#include "Jobs/JobSystem.h"
+#include "Memory/FrameArena.h"
 
+#include <cwchar>
 #include <iomanip>
 #include <iostream>
 
@@ -108,10 +111,10 @@ int NeneEngine::OnWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, nullptr, &size, sizeof(RAWINPUTHEADER));
         if (size == 0) break;
 
-        // Allocate buffer and receive data
-        std::vector<BYTE> buffer(size);
-        if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, buffer.data(), &size, sizeof(RAWINPUTHEADER)) == size) {
-            RAWINPUT* raw = reinterpret_cast<RAWINPUT*>(buffer.data());
+        // Receive data into per-frame memory instead of a heap buffer per message
+        BYTE* buffer = static_cast<BYTE*>(FrameArena::Get().Allocate(size, alignof(RAWINPUT)));
+        if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, buffer, &size, sizeof(RAWINPUTHEADER)) == size) {
+            RAWINPUT* raw = reinterpret_cast<RAWINPUT*>(buffer);
 
             if (raw->header.dwType == RIM_TYPEKEYBOARD) {
                 // Process keyboard
@@ -151,6 +154,11 @@ int NeneEngine::OnWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 
 
 void NeneEngine::Initialize() {
+    // Start worker threads up front; the main thread becomes job worker 0
+    JobSystem::Get();
+    // Window messages and loading allocate from the frame arena before the main loop starts
+    FrameArena::Get().BeginFrame();
+
     if (!m_window->Create(m_title, 800, 800))
     {
         throw std::runtime_error("Failed to create window");
@@ -201,20 +209,14 @@ void NeneEngine::CalculateFrameStats()
         float fps = (float)frameCnt; // fps = frameCnt / 1
         float mspf = 1000.0f / fps;
         
-        std::wstringstream wss;
-        wss << std::fixed << std::setprecision(0);
-        wss << fps;
-        wstring fpsStr = wss.str();
-        wss.str(L""); // Reset wstringstream
-        wss << std::setprecision(6);
-        wss << mspf;
-        wstring mspfStr = wss.str();
-
-        wstring windowText = AnsiToWString(m_title) +
-            L"   fps: " + fpsStr +
-            L"   mspf: " + mspfStr;
+        // Format straight into frame memory: no stream or string temporaries
+        const FrameArenaStats& memory = FrameArena::Get().GetStats();
+        const size_t textLength = m_title.size() + 128;
+        wchar_t* windowText = FrameArena::Get().AllocateArray<wchar_t>(textLength);
+        swprintf(windowText, textLength, L"%hs   fps: %.0f   mspf: %.6f   frame memory peak: %zu KB",
+                 m_title.c_str(), fps, mspf, memory.peakFrameBytes / 1024);
 
-        SetWindowText(m_hWnd, windowText.c_str());
+        SetWindowText(m_hWnd, windowText);
 		
         // Reset for next average.
         frameCnt = 0;
@@ -239,6 +241,7 @@ int NeneEngine::Run() {
         else
         {
             m_timer.Tick();
+            FrameArena::Get().BeginFrame();
 
             if (!m_isPaused)
             {
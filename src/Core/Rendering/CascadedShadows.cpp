@@ -0,0 +1,268 @@
+#include "CascadedShadows.h"
+#include "FrustumCulling.h"
+#include "../Common/Camera.h"
+#include "../Common/d3dUtil.h"
+#include "../Jobs/JobSystem.h"
+#include "../Memory/FrameArena.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define NENE_SHADOW_SSE 1
+#endif
+
+using namespace DirectX;
+
+void CascadedShadows::Update(const Camera& camera, const XMFLOAT3& lightDirection, const CascadeSettings& settings)
+{
+    m_cascadeCount = std::clamp<uint32_t>(settings.cascadeCount, 1, MaxCascades);
+
+    // The light-space basis depends only on the light direction, so snapping in it is stable
+    const XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&lightDirection));
+    const XMVECTOR up = std::fabs(XMVectorGetY(direction)) > 0.99f ? XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+    const XMMATRIX lightView = XMMatrixLookToLH(XMVectorZero(), direction, up);
+    XMStoreFloat4x4(&m_lightView, lightView);
+
+    const float nearZ = camera.GetNearZ();
+    const float farZ = std::max(nearZ * 1.001f, std::min(camera.GetFarZ(), settings.maxDistance));
+    const float tanY = std::tan(camera.GetFovY() * 0.5f);
+    const float tanX = tanY * camera.GetAspect();
+    const XMFLOAT3 position = camera.GetPosition3f(), rightAxis = camera.GetRight3f(), upAxis = camera.GetUp3f(), lookAxis = camera.GetLook3f();
+    const XMVECTOR eye = XMLoadFloat3(&position);
+    const XMVECTOR right = XMLoadFloat3(&rightAxis);
+    const XMVECTOR cameraUp = XMLoadFloat3(&upAxis);
+    const XMVECTOR look = XMLoadFloat3(&lookAxis);
+
+    const float resolution = static_cast<float>(std::max<uint32_t>(settings.resolution, 4));
+    float splitNear = nearZ;
+    for (uint32_t i = 0; i < m_cascadeCount; ++i)
+    {
+        // Practical split scheme: blend of the logarithmic and the uniform split
+        const float t = static_cast<float>(i + 1) / m_cascadeCount;
+        const float logSplit = nearZ * std::pow(farZ / nearZ, t);
+        const float uniformSplit = nearZ + (farZ - nearZ) * t;
+        const float splitFar = i + 1 == m_cascadeCount ? farZ : settings.splitLambda * logSplit + (1.0f - settings.splitLambda) * uniformSplit;
+
+        XMVECTOR corners[8];
+        XMVECTOR center = XMVectorZero();
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const float depth = (corner & 4) ? splitFar : splitNear;
+            const float x = ((corner & 1) ? 1.0f : -1.0f) * tanX * depth;
+            const float y = ((corner & 2) ? 1.0f : -1.0f) * tanY * depth;
+            corners[corner] = XMVectorAdd(eye, XMVectorAdd(XMVectorScale(right, x), XMVectorAdd(XMVectorScale(cameraUp, y), XMVectorScale(look, depth))));
+            center = XMVectorAdd(center, corners[corner]);
+        }
+        center = XMVectorScale(center, 1.0f / 8.0f);
+
+        float radius = 0.0f;
+        for (const XMVECTOR& corner : corners)
+        {
+            radius = std::max(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(corner, center))));
+        }
+        // Rounding removes float noise, so the size stays bit-exact while the camera turns
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // One texel of slack on each side keeps the sphere inside after snapping the center
+        const float texelSize = 2.0f * radius / (resolution - 2.0f);
+        const float halfSize = radius + texelSize;
+
+        XMFLOAT3 lightCenter;
+        XMStoreFloat3(&lightCenter, XMVector3Transform(center, lightView));
+        const float snappedX = std::floor(lightCenter.x / texelSize) * texelSize;
+        const float snappedY = std::floor(lightCenter.y / texelSize) * texelSize;
+
+        ShadowCascade& cascade = m_cascades[i];
+        cascade.splitNear = splitNear;
+        cascade.splitFar = splitFar;
+        cascade.texelSize = texelSize;
+        XMStoreFloat3(&cascade.center, center);
+        cascade.radius = radius;
+        cascade.view = m_lightView;
+        cascade.casters.clear();
+
+        CasterVolume& volume = m_volumes[i];
+        volume = { snappedX - halfSize, snappedX + halfSize, snappedY - halfSize, snappedY + halfSize, lightCenter.z + radius, lightCenter.z - radius };
+
+        const XMMATRIX proj = XMMatrixOrthographicOffCenterLH(volume.minX, volume.maxX, volume.minY, volume.maxY, volume.sphereMinZ, volume.maxZ);
+        XMStoreFloat4x4(&cascade.proj, proj);
+        XMStoreFloat4x4(&cascade.viewProj, XMMatrixMultiply(lightView, proj));
+
+        splitNear = splitFar;
+    }
+}
+
+void CascadedShadows::CullCasters(const FrustumCuller& boxes)
+{
+    const size_t count = boxes.GetCount();
+    uint32_t* outIndices[MaxCascades];
+    for (uint32_t k = 0; k < m_cascadeCount; ++k)
+    {
+        m_cascades[k].casters.resize(count);
+        outIndices[k] = m_cascades[k].casters.data();
+    }
+
+    size_t written[MaxCascades] = {};
+    float minZ[MaxCascades];
+    std::fill(minZ, minZ + MaxCascades, FLT_MAX);
+
+    if (count <= BlockSize)
+    {
+        CullRange(boxes, 0, count, outIndices, written, minZ);
+    }
+    else
+    {
+        // Same scheme as FrustumCuller::Cull: blocks write into their own slices, then slices are packed
+        const size_t blockCount = (count + BlockSize - 1) / BlockSize;
+        size_t* blockCounts = FrameArena::Get().AllocateArray<size_t>(blockCount * MaxCascades);
+        float* blockMinZ = FrameArena::Get().AllocateArray<float>(blockCount * MaxCascades);
+        JobSystem::Get().ParallelFor(blockCount, [&](size_t first, size_t last)
+        {
+            for (size_t block = first; block < last; ++block)
+            {
+                const size_t begin = block * BlockSize;
+                uint32_t* slices[MaxCascades];
+                for (uint32_t k = 0; k < m_cascadeCount; ++k) slices[k] = outIndices[k] + begin;
+                std::fill(blockMinZ + block * MaxCascades, blockMinZ + (block + 1) * MaxCascades, FLT_MAX);
+                std::fill(blockCounts + block * MaxCascades, blockCounts + (block + 1) * MaxCascades, size_t(0));
+                CullRange(boxes, begin, std::min(begin + BlockSize, count), slices, blockCounts + block * MaxCascades, blockMinZ + block * MaxCascades);
+            }
+        }, 1);
+
+        for (uint32_t k = 0; k < m_cascadeCount; ++k)
+        {
+            for (size_t block = 0; block < blockCount; ++block)
+            {
+                const size_t blockWritten = blockCounts[block * MaxCascades + k];
+                std::memmove(outIndices[k] + written[k], outIndices[k] + block * BlockSize, blockWritten * sizeof(uint32_t));
+                written[k] += blockWritten;
+                minZ[k] = std::min(minZ[k], blockMinZ[block * MaxCascades + k]);
+            }
+        }
+    }
+
+    // Pull each near plane back to the nearest caster so that off-screen casters land in the depth range
+    const XMMATRIX lightView = XMLoadFloat4x4(&m_lightView);
+    for (uint32_t k = 0; k < m_cascadeCount; ++k)
+    {
+        ShadowCascade& cascade = m_cascades[k];
+        const CasterVolume& volume = m_volumes[k];
+        cascade.casters.resize(written[k]);
+
+        const float nearZ = std::min(minZ[k], volume.sphereMinZ);
+        const XMMATRIX proj = XMMatrixOrthographicOffCenterLH(volume.minX, volume.maxX, volume.minY, volume.maxY, nearZ, volume.maxZ);
+        XMStoreFloat4x4(&cascade.proj, proj);
+        XMStoreFloat4x4(&cascade.viewProj, XMMatrixMultiply(lightView, proj));
+    }
+}
+
+void CascadedShadows::CullRange(const FrustumCuller& boxes, size_t begin, size_t end, uint32_t* const* outIndices, size_t* outCounts, float* outMinZ) const
+{
+    const float* cx = boxes.GetCenterData(0);
+    const float* cy = boxes.GetCenterData(1);
+    const float* cz = boxes.GetCenterData(2);
+    const float* ex = boxes.GetExtentData(0);
+    const float* ey = boxes.GetExtentData(1);
+    const float* ez = boxes.GetExtentData(2);
+
+    // Light space: p' = p * R, extents' = extents * |R| (the light view has no translation)
+    const float (&m)[4][4] = m_lightView.m;
+    size_t i = begin;
+
+#if defined(NENE_SHADOW_SSE)
+    __m128 r[3][3], a[3][3];
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int column = 0; column < 3; ++column)
+        {
+            r[row][column] = _mm_set1_ps(m[row][column]);
+            a[row][column] = _mm_set1_ps(std::fabs(m[row][column]));
+        }
+    }
+
+    __m128 minX[MaxCascades], maxX[MaxCascades], minY[MaxCascades], maxY[MaxCascades], maxZ[MaxCascades], nearest[MaxCascades];
+    for (uint32_t k = 0; k < m_cascadeCount; ++k)
+    {
+        minX[k] = _mm_set1_ps(m_volumes[k].minX);
+        maxX[k] = _mm_set1_ps(m_volumes[k].maxX);
+        minY[k] = _mm_set1_ps(m_volumes[k].minY);
+        maxY[k] = _mm_set1_ps(m_volumes[k].maxY);
+        maxZ[k] = _mm_set1_ps(m_volumes[k].maxZ);
+        nearest[k] = _mm_set1_ps(outMinZ[k]);
+    }
+
+    constexpr size_t Width = 4;
+    for (; i + Width <= end; i += Width)
+    {
+        const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+        const __m128 sx = _mm_loadu_ps(ex + i), sy = _mm_loadu_ps(ey + i), sz = _mm_loadu_ps(ez + i);
+
+        __m128 lightCenter[3], lightExtent[3];
+        for (int column = 0; column < 3; ++column)
+        {
+            lightCenter[column] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r[0][column]), _mm_mul_ps(y, r[1][column])), _mm_mul_ps(z, r[2][column]));
+            lightExtent[column] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, a[0][column]), _mm_mul_ps(sy, a[1][column])), _mm_mul_ps(sz, a[2][column]));
+        }
+        const __m128 low[3] = { _mm_sub_ps(lightCenter[0], lightExtent[0]), _mm_sub_ps(lightCenter[1], lightExtent[1]), _mm_sub_ps(lightCenter[2], lightExtent[2]) };
+        const __m128 high[2] = { _mm_add_ps(lightCenter[0], lightExtent[0]), _mm_add_ps(lightCenter[1], lightExtent[1]) };
+
+        for (uint32_t k = 0; k < m_cascadeCount; ++k)
+        {
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(high[0], minX[k]), _mm_cmple_ps(low[0], maxX[k]));
+            inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(high[1], minY[k]), _mm_cmple_ps(low[1], maxY[k])));
+            inside = _mm_and_ps(inside, _mm_cmple_ps(low[2], maxZ[k]));
+
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+            if (mask == 0) continue;
+            nearest[k] = _mm_min_ps(nearest[k], _mm_or_ps(_mm_and_ps(inside, low[2]), _mm_andnot_ps(inside, _mm_set1_ps(FLT_MAX))));
+
+            uint32_t* out = outIndices[k];
+            size_t& written = outCounts[k];
+            for (uint32_t lane = 0; lane < Width; ++lane)
+            {
+                out[written] = static_cast<uint32_t>(i + lane);
+                written += (mask >> lane) & 1u;
+            }
+        }
+    }
+
+    for (uint32_t k = 0; k < m_cascadeCount; ++k)
+    {
+        float lanes[4];
+        _mm_storeu_ps(lanes, nearest[k]);
+        outMinZ[k] = std::min({ lanes[0], lanes[1], lanes[2], lanes[3] });
+    }
+#endif
+
+    // Tail (and the whole range on targets without SSE)
+    for (; i < end; ++i)
+    {
+        float center[3], extent[3];
+        for (int column = 0; column < 3; ++column)
+        {
+            center[column] = cx[i] * m[0][column] + cy[i] * m[1][column] + cz[i] * m[2][column];
+            extent[column] = ex[i] * std::fabs(m[0][column]) + ey[i] * std::fabs(m[1][column]) + ez[i] * std::fabs(m[2][column]);
+        }
+
+        for (uint32_t k = 0; k < m_cascadeCount; ++k)
+        {
+            const CasterVolume& volume = m_volumes[k];
+            if (center[0] + extent[0] < volume.minX || center[0] - extent[0] > volume.maxX ||
+                center[1] + extent[1] < volume.minY || center[1] - extent[1] > volume.maxY ||
+                center[2] - extent[2] > volume.maxZ) continue;
+
+            outIndices[k][outCounts[k]++] = static_cast<uint32_t>(i);
+            outMinZ[k] = std::min(outMinZ[k], center[2] - extent[2]);
+        }
+    }
+}
+
+void CascadedShadows::ApplyTo(Light& light, uint32_t cascade) const
+{
+    light.LightView = m_cascades[cascade].view;
+    light.LightProj = m_cascades[cascade].proj;
+    light.LightViewProj = m_cascades[cascade].viewProj;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+class Camera;
+class FrustumCuller;
+struct Light;
+
+struct CascadeSettings
+{
+    uint32_t cascadeCount = 4;    // Up to CascadedShadows::MaxCascades
+    float splitLambda = 0.75f;    // Practical split scheme: 0 = uniform, 1 = logarithmic
+    float maxDistance = 200.0f;   // Shadows end here even if the camera far plane is further
+    uint32_t resolution = 2048;   // Shadow map size of one cascade, used for texel snapping
+};
+
+struct ShadowCascade
+{
+    float splitNear = 0.0f;       // View-space depth range covered by this cascade
+    float splitFar = 0.0f;
+    float texelSize = 0.0f;       // World units per shadow map texel
+    DirectX::XMFLOAT3 center;     // Bounding sphere of the camera frustum slice
+    float radius = 0.0f;
+    DirectX::XMFLOAT4X4 view;     // Shared by all cascades of a light
+    DirectX::XMFLOAT4X4 proj;     // Orthographic; the near plane is pulled back to the nearest caster
+    DirectX::XMFLOAT4X4 viewProj;
+    std::vector<uint32_t> casters; // Indices of boxes that can cast into the slice, ascending
+};
+
+// Cascaded shadow maps for a directional light.
+// Update() splits the camera frustum with the practical split scheme and fits every slice with a
+// bounding sphere: its radius does not change when the camera turns, and its center is snapped to
+// whole shadow map texels in a light space whose basis depends only on the light direction, so the
+// shadow map does not shimmer under camera motion.
+// CullCasters() then tests all caster boxes against all cascades in one SIMD pass. A cascade's
+// caster volume is its orthographic box extruded towards the light, so objects outside the view
+// frustum that throw shadows into it are kept; the near plane is then moved to the nearest caster.
+class CascadedShadows
+{
+public:
+    static constexpr uint32_t MaxCascades = 4;
+
+    void Update(const Camera& camera, const DirectX::XMFLOAT3& lightDirection, const CascadeSettings& settings);
+
+    // boxes are world-space caster AABBs; fills ShadowCascade::casters and finalizes the projections
+    void CullCasters(const FrustumCuller& boxes);
+
+    uint32_t GetCascadeCount() const { return m_cascadeCount; }
+    const ShadowCascade& GetCascade(uint32_t index) const { return m_cascades[index]; }
+
+    // Writes LightView/LightProj/LightViewProj of one cascade into the light constants
+    void ApplyTo(Light& light, uint32_t cascade) const;
+
+private:
+    static constexpr size_t BlockSize = 16 * 1024;
+
+    // Light-space bounds of one cascade's caster volume; z has no lower bound
+    struct CasterVolume
+    {
+        float minX, maxX, minY, maxY, maxZ;
+        float sphereMinZ; // Near side of the slice's bounding sphere
+    };
+
+    void CullRange(const FrustumCuller& boxes, size_t begin, size_t end, uint32_t* const* outIndices, size_t* outCounts, float* outMinZ) const;
+
+    ShadowCascade m_cascades[MaxCascades];
+    CasterVolume m_volumes[MaxCascades];
+    uint32_t m_cascadeCount = 0;
+    DirectX::XMFLOAT4X4 m_lightView;
+};
@@ -0,0 +1,357 @@
+#include "ClusteredLights.h"
+#include "../Common/Camera.h"
+#include "../Common/d3dUtil.h"
+#include "../Jobs/JobSystem.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NENE_CLUSTER_SSE 1
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    // Slopes (x/z) of the two lines through the eye that touch a circle of radius r around (c, z).
+    // Returns false when the circle reaches the eye plane, in which case it covers all slopes.
+    bool ProjectedSlopes(float c, float z, float r, float& low, float& high)
+    {
+        if (z <= r) return false;
+        const float slope = c / z;
+        const float spread = r / std::sqrt(c * c + z * z - r * r);
+        low = (slope - spread) / (1.0f + slope * spread);
+        high = (slope + spread) / (1.0f - slope * spread);
+        return true;
+    }
+
+    // Tile under a slope: tile = (slope / tan + 1) / 2 * tiles, clamped to [-1, tiles] before flooring
+    float SlopeToTile(float slope, float invTan, float tiles)
+    {
+        return std::clamp((slope * invTan + 1.0f) * 0.5f * tiles, -1.0f, tiles);
+    }
+}
+
+void ClusteredLights::Build(const Camera& camera, const Light* lights, size_t lightCount, const ClusterSettings& settings)
+{
+    m_tilesX = std::max<uint32_t>(settings.tilesX, 1);
+    m_tilesY = std::max<uint32_t>(settings.tilesY, 1);
+    m_slicesZ = std::max<uint32_t>(settings.slicesZ, 1);
+    m_rowStride = (m_tilesX + 3) & ~3u;
+
+    m_nearZ = camera.GetNearZ();
+    m_farZ = std::max(camera.GetFarZ(), m_nearZ * 1.001f);
+    m_tanY = std::tan(camera.GetFovY() * 0.5f);
+    m_tanX = m_tanY * camera.GetAspect();
+    m_sliceScale = m_slicesZ / std::log(m_farZ / m_nearZ);
+    m_sliceBias = -std::log(m_nearZ) * m_sliceScale;
+
+    XMFLOAT4X4 view;
+    XMStoreFloat4x4(&view, camera.GetView());
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 4; ++row) m_view[column][row] = view.m[row][column];
+    }
+
+    // Cluster boxes: the part of a tile's frustum between two slice depths, bounded by its corners
+    m_sliceNear.resize(m_slicesZ + 1);
+    for (uint32_t z = 0; z <= m_slicesZ; ++z)
+    {
+        m_sliceNear[z] = z == m_slicesZ ? m_farZ : m_nearZ * std::pow(m_farZ / m_nearZ, static_cast<float>(z) / m_slicesZ);
+    }
+    m_boxMinX.assign(m_slicesZ * m_rowStride, FLT_MAX);
+    m_boxMaxX.assign(m_slicesZ * m_rowStride, -FLT_MAX);
+    m_boxMinY.resize(m_slicesZ * m_tilesY);
+    m_boxMaxY.resize(m_slicesZ * m_tilesY);
+    for (uint32_t z = 0; z < m_slicesZ; ++z)
+    {
+        const float nearDepth = m_sliceNear[z], farDepth = m_sliceNear[z + 1];
+        for (uint32_t x = 0; x < m_tilesX; ++x)
+        {
+            const float left = (2.0f * x / m_tilesX - 1.0f) * m_tanX;
+            const float right = (2.0f * (x + 1) / m_tilesX - 1.0f) * m_tanX;
+            m_boxMinX[z * m_rowStride + x] = std::min(left * nearDepth, left * farDepth);
+            m_boxMaxX[z * m_rowStride + x] = std::max(right * nearDepth, right * farDepth);
+        }
+        for (uint32_t y = 0; y < m_tilesY; ++y)
+        {
+            const float top = (1.0f - 2.0f * y / m_tilesY) * m_tanY;
+            const float bottom = (1.0f - 2.0f * (y + 1) / m_tilesY) * m_tanY;
+            m_boxMinY[z * m_tilesY + y] = std::min(bottom * nearDepth, bottom * farDepth);
+            m_boxMaxY[z * m_tilesY + y] = std::max(top * nearDepth, top * farDepth);
+        }
+    }
+
+    // World-space bounding spheres; a spot is bounded by the sphere around its cone
+    m_sphereLights.clear();
+    m_sphereX.clear();
+    m_sphereY.clear();
+    m_sphereZ.clear();
+    m_sphereRadius.clear();
+    m_globalLights.clear();
+    for (size_t i = 0; i < lightCount; ++i)
+    {
+        const Light& light = lights[i];
+        if (light.type != LightTypePoint && light.type != LightTypeSpot)
+        {
+            m_globalLights.push_back(static_cast<uint32_t>(i));
+            continue;
+        }
+
+        const float range = light.FalloffEnd;
+        XMFLOAT3 center = light.Position;
+        float radius = range;
+        if (light.type == LightTypeSpot && light.SpotPower > 0.0f)
+        {
+            const float cosAngle = std::pow(SpotCutoffIntensity, 1.0f / light.SpotPower);
+            const float length = std::sqrt(light.Direction.x * light.Direction.x + light.Direction.y * light.Direction.y + light.Direction.z * light.Direction.z);
+            if (cosAngle > 0.0f && length > 0.0f)
+            {
+                // Wide cones are bounded around their base disk, narrow ones by the sphere through apex and rim
+                float distance;
+                if (cosAngle <= 0.70710678f)
+                {
+                    distance = range * cosAngle;
+                    radius = range * std::sqrt(1.0f - cosAngle * cosAngle);
+                }
+                else
+                {
+                    distance = radius = range / (2.0f * cosAngle);
+                }
+                const float scale = distance / length;
+                center = XMFLOAT3(center.x + light.Direction.x * scale, center.y + light.Direction.y * scale, center.z + light.Direction.z * scale);
+            }
+        }
+
+        m_sphereLights.push_back(static_cast<uint32_t>(i));
+        m_sphereX.push_back(center.x);
+        m_sphereY.push_back(center.y);
+        m_sphereZ.push_back(center.z);
+        m_sphereRadius.push_back(radius);
+    }
+
+    const size_t sphereCount = m_sphereLights.size();
+    m_viewX.resize(sphereCount);
+    m_viewY.resize(sphereCount);
+    m_viewZ.resize(sphereCount);
+    m_ranges.resize(sphereCount);
+    JobSystem::Get().ParallelFor(sphereCount, [this](size_t begin, size_t end) { BoundLights(begin, end); }, 512);
+
+    // Bucket lights by slice in ascending order, which FillSlice keeps per cluster
+    m_sliceLights.resize(m_slicesZ);
+    m_sliceItems.resize(m_slicesZ);
+    m_sliceIndices.resize(m_slicesZ);
+    for (auto& bucket : m_sliceLights) bucket.clear();
+    for (size_t i = 0; i < sphereCount; ++i)
+    {
+        const LightRange& range = m_ranges[i];
+        if (range.lastX < range.firstX || range.lastY < range.firstY) continue;
+        for (int32_t z = range.firstZ; z <= range.lastZ; ++z) m_sliceLights[z].push_back(static_cast<uint32_t>(i));
+    }
+
+    m_clusters.resize(static_cast<size_t>(m_tilesX) * m_tilesY * m_slicesZ);
+    JobSystem::Get().ParallelFor(m_slicesZ, [this](size_t first, size_t last)
+    {
+        for (size_t slice = first; slice < last; ++slice) FillSlice(static_cast<uint32_t>(slice));
+    }, 1);
+
+    // Concatenate the slices; cluster offsets are relative to their slice until now
+    size_t total = 0;
+    for (const auto& indices : m_sliceIndices) total += indices.size();
+    m_lightIndices.resize(total);
+    const size_t clustersPerSlice = static_cast<size_t>(m_tilesX) * m_tilesY;
+    uint32_t sliceOffset = 0;
+    for (uint32_t z = 0; z < m_slicesZ; ++z)
+    {
+        std::copy(m_sliceIndices[z].begin(), m_sliceIndices[z].end(), m_lightIndices.begin() + sliceOffset);
+        for (size_t c = 0; c < clustersPerSlice; ++c) m_clusters[z * clustersPerSlice + c].offset += sliceOffset;
+        sliceOffset += static_cast<uint32_t>(m_sliceIndices[z].size());
+    }
+}
+
+void ClusteredLights::BoundLights(size_t begin, size_t end)
+{
+    const float tilesX = static_cast<float>(m_tilesX), tilesY = static_cast<float>(m_tilesY);
+    const float invTanX = 1.0f / m_tanX, invTanY = 1.0f / m_tanY;
+    float firstX[4], lastX[4], firstY[4], lastY[4];
+
+    // Writes the cluster range of light i from its view-space sphere and the floored tile bounds
+    auto storeRange = [this](size_t i, float tileFirstX, float tileLastX, float tileFirstY, float tileLastY)
+    {
+        const float depth = m_viewZ[i], radius = m_sphereRadius[i];
+        LightRange& range = m_ranges[i];
+        range.firstX = std::max(static_cast<int32_t>(tileFirstX), 0);
+        range.lastX = std::min(static_cast<int32_t>(tileLastX), static_cast<int32_t>(m_tilesX) - 1);
+        range.firstY = std::max(static_cast<int32_t>(tileFirstY), 0);
+        range.lastY = std::min(static_cast<int32_t>(tileLastY), static_cast<int32_t>(m_tilesY) - 1);
+        if (depth + radius < m_nearZ || depth - radius > m_farZ)
+        {
+            range.firstZ = 0;
+            range.lastZ = -1;
+        }
+        else
+        {
+            range.firstZ = GetSlice(depth - radius);
+            range.lastZ = GetSlice(depth + radius);
+        }
+    };
+
+    size_t i = begin;
+
+#if defined(NENE_CLUSTER_SSE)
+    __m128 m[3][4];
+    for (int column = 0; column < 3; ++column)
+    {
+        for (int row = 0; row < 4; ++row) m[column][row] = _mm_set1_ps(m_view[column][row]);
+    }
+    const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), half = _mm_set1_ps(0.5f);
+    const __m128 scaleX = _mm_set1_ps(invTanX), scaleY = _mm_set1_ps(invTanY);
+    const __m128 countX = _mm_set1_ps(tilesX), countY = _mm_set1_ps(tilesY);
+
+    // floor(clamp(v, -1, tiles)) for the tile under a slope; truncation of v + 1 >= 0 is the floor
+    auto tileOf = [&](__m128 slope, __m128 scale, __m128 tiles, __m128 sign)
+    {
+        const __m128 tile = _mm_mul_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(slope, scale), sign), one), half), tiles);
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(tile, minusOne), tiles);
+        return _mm_sub_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_add_ps(clamped, one))), one);
+    };
+
+    // Slopes of the tangent lines; lanes whose sphere reaches the eye plane cover all slopes
+    auto slopes = [&](__m128 c, __m128 z, __m128 r, __m128& low, __m128& high)
+    {
+        const __m128 valid = _mm_cmpgt_ps(z, r);
+        const __m128 slope = _mm_div_ps(c, z);
+        const __m128 spread = _mm_div_ps(r, _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(c, c), _mm_mul_ps(z, z)), _mm_mul_ps(r, r)), _mm_set1_ps(FLT_MIN))));
+        const __m128 product = _mm_mul_ps(slope, spread);
+        const __m128 lowSlope = _mm_div_ps(_mm_sub_ps(slope, spread), _mm_add_ps(one, product));
+        const __m128 highSlope = _mm_div_ps(_mm_add_ps(slope, spread), _mm_max_ps(_mm_sub_ps(one, product), _mm_set1_ps(FLT_MIN)));
+        low = _mm_or_ps(_mm_and_ps(valid, lowSlope), _mm_andnot_ps(valid, _mm_set1_ps(-FLT_MAX)));
+        high = _mm_or_ps(_mm_and_ps(valid, highSlope), _mm_andnot_ps(valid, _mm_set1_ps(FLT_MAX)));
+    };
+
+    for (; i + 4 <= end; i += 4)
+    {
+        const __m128 x = _mm_loadu_ps(m_sphereX.data() + i), y = _mm_loadu_ps(m_sphereY.data() + i), z = _mm_loadu_ps(m_sphereZ.data() + i);
+        const __m128 r = _mm_loadu_ps(m_sphereRadius.data() + i);
+        __m128 viewPosition[3];
+        for (int column = 0; column < 3; ++column)
+        {
+            viewPosition[column] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[column][0]), _mm_mul_ps(y, m[column][1])), _mm_add_ps(_mm_mul_ps(z, m[column][2]), m[column][3]));
+        }
+        _mm_storeu_ps(m_viewX.data() + i, viewPosition[0]);
+        _mm_storeu_ps(m_viewY.data() + i, viewPosition[1]);
+        _mm_storeu_ps(m_viewZ.data() + i, viewPosition[2]);
+
+        // Tile rows grow downwards, so the highest y slope gives the first row
+        __m128 lowX, highX, lowY, highY;
+        slopes(viewPosition[0], viewPosition[2], r, lowX, highX);
+        slopes(viewPosition[1], viewPosition[2], r, lowY, highY);
+        _mm_storeu_ps(firstX, tileOf(lowX, scaleX, countX, one));
+        _mm_storeu_ps(lastX, tileOf(highX, scaleX, countX, one));
+        _mm_storeu_ps(firstY, tileOf(highY, scaleY, countY, minusOne));
+        _mm_storeu_ps(lastY, tileOf(lowY, scaleY, countY, minusOne));
+        for (int lane = 0; lane < 4; ++lane) storeRange(i + lane, firstX[lane], lastX[lane], firstY[lane], lastY[lane]);
+    }
+#endif
+
+    // Tail (and the whole range on targets without SSE)
+    for (; i < end; ++i)
+    {
+        const float x = m_sphereX[i], y = m_sphereY[i], z = m_sphereZ[i], r = m_sphereRadius[i];
+        m_viewX[i] = x * m_view[0][0] + y * m_view[0][1] + z * m_view[0][2] + m_view[0][3];
+        m_viewY[i] = x * m_view[1][0] + y * m_view[1][1] + z * m_view[1][2] + m_view[1][3];
+        m_viewZ[i] = x * m_view[2][0] + y * m_view[2][1] + z * m_view[2][2] + m_view[2][3];
+
+        float lowX = -FLT_MAX, highX = FLT_MAX, lowY = -FLT_MAX, highY = FLT_MAX;
+        ProjectedSlopes(m_viewX[i], m_viewZ[i], r, lowX, highX);
+        ProjectedSlopes(m_viewY[i], m_viewZ[i], r, lowY, highY);
+        storeRange(i,
+                   std::floor(SlopeToTile(lowX, invTanX, tilesX)), std::floor(SlopeToTile(highX, invTanX, tilesX)),
+                   std::floor(SlopeToTile(-highY, invTanY, tilesY)), std::floor(SlopeToTile(-lowY, invTanY, tilesY)));
+    }
+}
+
+void ClusteredLights::FillSlice(uint32_t slice)
+{
+    const uint32_t clustersPerSlice = m_tilesX * m_tilesY;
+    const float sliceNear = m_sliceNear[slice], sliceFar = m_sliceNear[slice + 1];
+    const float* minX = m_boxMinX.data() + slice * m_rowStride;
+    const float* maxX = m_boxMaxX.data() + slice * m_rowStride;
+    std::vector<uint64_t>& items = m_sliceItems[slice];
+    items.clear();
+
+    // Sphere against box: the squared distance from the center to the box must not exceed r^2
+    for (uint32_t light : m_sliceLights[slice])
+    {
+        const LightRange& range = m_ranges[light];
+        const float cx = m_viewX[light], cy = m_viewY[light], cz = m_viewZ[light];
+        const float radius = m_sphereRadius[light];
+        const float dz = std::max({ sliceNear - cz, cz - sliceFar, 0.0f });
+        const float restZ = radius * radius - dz * dz;
+        if (restZ < 0.0f) continue;
+
+        for (int32_t y = range.firstY; y <= range.lastY; ++y)
+        {
+            const float dy = std::max({ m_boxMinY[slice * m_tilesY + y] - cy, cy - m_boxMaxY[slice * m_tilesY + y], 0.0f });
+            const float rest = restZ - dy * dy;
+            if (rest < 0.0f) continue;
+            const uint64_t rowItem = (static_cast<uint64_t>(y * m_tilesX) << 32) | light;
+
+            int32_t x = range.firstX;
+#if defined(NENE_CLUSTER_SSE)
+            const __m128 center = _mm_set1_ps(cx), limit = _mm_set1_ps(rest), zero = _mm_setzero_ps();
+            for (x &= ~3; x <= range.lastX; x += 4)
+            {
+                const __m128 distance = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minX + x), center), _mm_sub_ps(center, _mm_loadu_ps(maxX + x))), zero);
+                uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(_mm_mul_ps(distance, distance), limit)));
+                // Drop lanes outside [firstX, lastX]
+                mask &= (0xFu << std::max(range.firstX - x, 0)) & (0xFu >> std::max(x + 3 - range.lastX, 0));
+                for (uint32_t lane = 0; lane < 4; ++lane)
+                {
+                    if ((mask >> lane) & 1u) items.push_back(rowItem + (static_cast<uint64_t>(x + lane) << 32));
+                }
+            }
+#else
+            for (; x <= range.lastX; ++x)
+            {
+                const float distance = std::max({ minX[x] - cx, cx - maxX[x], 0.0f });
+                if (distance * distance <= rest) items.push_back(rowItem + (static_cast<uint64_t>(x) << 32));
+            }
+#endif
+        }
+    }
+
+    // Counting sort by cluster; lights were visited in ascending order, so each cluster stays sorted
+    ClusterRange* clusters = m_clusters.data() + static_cast<size_t>(slice) * clustersPerSlice;
+    for (uint32_t c = 0; c < clustersPerSlice; ++c) clusters[c] = { 0, 0 };
+    for (uint64_t item : items) ++clusters[item >> 32].count;
+    uint32_t offset = 0;
+    for (uint32_t c = 0; c < clustersPerSlice; ++c)
+    {
+        clusters[c].offset = offset;
+        offset += clusters[c].count;
+    }
+
+    std::vector<uint32_t>& indices = m_sliceIndices[slice];
+    indices.resize(items.size());
+    for (uint32_t c = 0; c < clustersPerSlice; ++c) clusters[c].count = 0;
+    for (uint64_t item : items)
+    {
+        ClusterRange& cluster = clusters[item >> 32];
+        indices[cluster.offset + cluster.count++] = m_sphereLights[static_cast<uint32_t>(item)];
+    }
+}
+
+int32_t ClusteredLights::GetSlice(float viewDepth) const
+{
+    if (viewDepth <= m_nearZ) return 0;
+    const float slice = std::floor(std::log(viewDepth) * m_sliceScale + m_sliceBias);
+    return static_cast<int32_t>(std::clamp(slice, 0.0f, static_cast<float>(m_slicesZ - 1)));
+}
+
+ClusterGridParams ClusteredLights::GetGridParams() const
+{
+    return { m_tilesX, m_tilesY, m_slicesZ, m_sliceScale, m_sliceBias };
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Camera;
+struct Light;
+
+struct ClusterSettings
+{
+    uint32_t tilesX = 16;  // Screen tiles across
+    uint32_t tilesY = 9;   // Screen tiles down
+    uint32_t slicesZ = 24; // Exponential depth slices between the camera near and far planes
+};
+
+// Range of one cluster in ClusteredLights::GetLightIndices()
+struct ClusterRange
+{
+    uint32_t offset;
+    uint32_t count;
+};
+
+// What the shader needs to find the cluster of a pixel:
+//   x = pixel.x * tilesX / width, y = pixel.y * tilesY / height (y grows downwards, as SV_Position),
+//   z = floor(log(viewDepth) * sliceScale + sliceBias), clamped to [0, slicesZ).
+// The cluster index is (z * tilesY + y) * tilesX + x.
+struct ClusterGridParams
+{
+    uint32_t tilesX;
+    uint32_t tilesY;
+    uint32_t slicesZ;
+    float sliceScale;
+    float sliceBias;
+};
+
+// Clustered (froxel) light assignment. The view frustum is divided into screen tiles and exponential
+// depth slices; every point and spot light is bounded by a sphere (a spot by the sphere around its
+// cone) and added to each cluster whose view-space box it touches. Directional lights affect every
+// cluster and are listed separately.
+// Build() runs in three passes: lights are transformed to view space and bounded by a cluster range
+// four at a time, then every depth slice is filled in parallel by testing the sphere against four
+// cluster boxes at once. Light indices within a cluster are ascending, so the output does not depend
+// on thread timing.
+class ClusteredLights
+{
+public:
+    // A spot light contributes pow(cos, SpotPower); below this intensity the cone is considered to end
+    static constexpr float SpotCutoffIntensity = 1.0f / 256.0f;
+
+    void Build(const Camera& camera, const Light* lights, size_t lightCount, const ClusterSettings& settings = {});
+
+    size_t GetClusterCount() const { return m_clusters.size(); }
+    uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * m_tilesY + y) * m_tilesX + x; }
+
+    // Buffers to upload as they are: one range per cluster and the light indices they point into
+    const std::vector<ClusterRange>& GetClusters() const { return m_clusters; }
+    const std::vector<uint32_t>& GetLightIndices() const { return m_lightIndices; }
+    // Indices of directional lights, which are not clustered
+    const std::vector<uint32_t>& GetGlobalLights() const { return m_globalLights; }
+
+    ClusterGridParams GetGridParams() const;
+
+private:
+    // Cluster range of one light; empty (last < first) when the light is outside the frustum
+    struct LightRange
+    {
+        int32_t firstX, lastX, firstY, lastY, firstZ, lastZ;
+    };
+
+    void BoundLights(size_t begin, size_t end);
+    void FillSlice(uint32_t slice);
+    int32_t GetSlice(float viewDepth) const;
+
+    uint32_t m_tilesX = 0, m_tilesY = 0, m_slicesZ = 0;
+    float m_nearZ = 1.0f, m_farZ = 1.0f;
+    float m_tanX = 1.0f, m_tanY = 1.0f; // Half extents of the frustum at depth 1
+    float m_sliceScale = 0.0f, m_sliceBias = 0.0f;
+    float m_view[3][4];                 // Rotation and translation columns of the camera view matrix
+
+    // View-space cluster boxes. x bounds depend on (slice, tile x) and are padded to whole SIMD
+    // rows, y bounds on (slice, tile y), z bounds on the slice alone.
+    uint32_t m_rowStride = 0;
+    std::vector<float> m_boxMinX, m_boxMaxX, m_boxMinY, m_boxMaxY;
+    std::vector<float> m_sliceNear; // slicesZ + 1 depth boundaries
+
+    // Bounding spheres of the clustered lights, world space and then view space, SoA
+    std::vector<uint32_t> m_sphereLights; // Index into the Light array
+    std::vector<float> m_sphereX, m_sphereY, m_sphereZ, m_sphereRadius;
+    std::vector<float> m_viewX, m_viewY, m_viewZ;
+    std::vector<LightRange> m_ranges;
+
+    // Per slice: lights overlapping it, (cluster, light) pairs found by FillSlice and the light
+    // indices of its clusters, grouped by cluster
+    std::vector<std::vector<uint32_t>> m_sliceLights;
+    std::vector<std::vector<uint64_t>> m_sliceItems;
+    std::vector<std::vector<uint32_t>> m_sliceIndices;
+
+    std::vector<ClusterRange> m_clusters;
+    std::vector<uint32_t> m_lightIndices;
+    std::vector<uint32_t> m_globalLights;
+};
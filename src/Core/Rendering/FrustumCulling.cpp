@@ -0,0 +1,239 @@
+#include "FrustumCulling.h"
+#include "../Common/Camera.h"
+#include "../Jobs/JobSystem.h"
+#include "../Memory/FrameArena.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NENE_CULL_AVX2 1
+#elif defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define NENE_CULL_SSE 1
+#endif
+
+using namespace DirectX;
+
+Frustum Frustum::FromViewProj(FXMMATRIX viewProj)
+{
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, viewProj);
+
+    // clip = [x y z 1] * M, so each clip coordinate is a dot product with a column of M
+    auto column = [&m](int j) { return XMFLOAT4(m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j]); };
+    auto add = [](const XMFLOAT4& a, const XMFLOAT4& b, float sign) { return XMFLOAT4(a.x + sign * b.x, a.y + sign * b.y, a.z + sign * b.z, a.w + sign * b.w); };
+
+    const XMFLOAT4 x = column(0), y = column(1), z = column(2), w = column(3);
+    Frustum frustum;
+    frustum.planes[Left] = add(w, x, 1.0f);
+    frustum.planes[Right] = add(w, x, -1.0f);
+    frustum.planes[Bottom] = add(w, y, 1.0f);
+    frustum.planes[Top] = add(w, y, -1.0f);
+    frustum.planes[Near] = z;
+    frustum.planes[Far] = add(w, z, -1.0f);
+
+    for (XMFLOAT4& plane : frustum.planes)
+    {
+        const float invLength = 1.0f / std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        plane = XMFLOAT4(plane.x * invLength, plane.y * invLength, plane.z * invLength, plane.w * invLength);
+    }
+    return frustum;
+}
+
+Frustum Frustum::FromCamera(const Camera& camera)
+{
+    return FromViewProj(XMMatrixMultiply(camera.GetView(), camera.GetProj()));
+}
+
+bool Frustum::Intersects(const XMFLOAT3& center, const XMFLOAT3& extents) const
+{
+    for (const XMFLOAT4& plane : planes)
+    {
+        const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        const float radius = std::fabs(plane.x) * extents.x + std::fabs(plane.y) * extents.y + std::fabs(plane.z) * extents.z;
+        if (distance + radius < 0.0f) return false;
+    }
+    return true;
+}
+
+void TransformBounds(const BoundingBox& localBounds, const XMFLOAT4X4& world, XMFLOAT3& outCenter, XMFLOAT3& outExtents)
+{
+    // Arvo: the new center is the transformed center, each new extent is the extents
+    // projected onto the absolute values of the matrix rows
+    const XMFLOAT3& c = localBounds.Center;
+    const XMFLOAT3& e = localBounds.Extents;
+    const float (&m)[4][4] = world.m;
+
+    float* center = &outCenter.x;
+    float* extents = &outExtents.x;
+    for (int j = 0; j < 3; ++j)
+    {
+        center[j] = c.x * m[0][j] + c.y * m[1][j] + c.z * m[2][j] + m[3][j];
+        extents[j] = e.x * std::fabs(m[0][j]) + e.y * std::fabs(m[1][j]) + e.z * std::fabs(m[2][j]);
+    }
+}
+
+void FrustumCuller::Clear()
+{
+    for (auto* values : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+    {
+        values->clear();
+    }
+}
+
+void FrustumCuller::Reserve(size_t count)
+{
+    for (auto* values : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ })
+    {
+        values->reserve(count);
+    }
+}
+
+uint32_t FrustumCuller::Add(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+    const uint32_t index = static_cast<uint32_t>(m_centerX.size());
+    m_centerX.push_back(center.x);
+    m_centerY.push_back(center.y);
+    m_centerZ.push_back(center.z);
+    m_extentX.push_back(extents.x);
+    m_extentY.push_back(extents.y);
+    m_extentZ.push_back(extents.z);
+    return index;
+}
+
+uint32_t FrustumCuller::Add(const BoundingBox& localBounds, const XMFLOAT4X4& world)
+{
+    XMFLOAT3 center, extents;
+    TransformBounds(localBounds, world, center, extents);
+    return Add(center, extents);
+}
+
+void FrustumCuller::Set(uint32_t index, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+    m_centerX[index] = center.x;
+    m_centerY[index] = center.y;
+    m_centerZ[index] = center.z;
+    m_extentX[index] = extents.x;
+    m_extentY[index] = extents.y;
+    m_extentZ[index] = extents.z;
+}
+
+size_t FrustumCuller::Cull(const Frustum& frustum, uint32_t* outIndices) const
+{
+    const size_t count = GetCount();
+    if (count <= BlockSize) return CullRange(frustum, 0, count, outIndices);
+
+    // Every block writes into its own slice of the output, then the slices are packed in order
+    const size_t blockCount = (count + BlockSize - 1) / BlockSize;
+    size_t* visibleInBlock = FrameArena::Get().AllocateArray<size_t>(blockCount);
+    JobSystem::Get().ParallelFor(blockCount, [&](size_t first, size_t last)
+    {
+        for (size_t block = first; block < last; ++block)
+        {
+            const size_t begin = block * BlockSize;
+            visibleInBlock[block] = CullRange(frustum, begin, std::min(begin + BlockSize, count), outIndices + begin);
+        }
+    }, 1);
+
+    size_t written = visibleInBlock[0];
+    for (size_t block = 1; block < blockCount; ++block)
+    {
+        std::memmove(outIndices + written, outIndices + block * BlockSize, visibleInBlock[block] * sizeof(uint32_t));
+        written += visibleInBlock[block];
+    }
+    return written;
+}
+
+size_t FrustumCuller::CullRange(const Frustum& frustum, size_t begin, size_t end, uint32_t* outIndices) const
+{
+    const float* cx = m_centerX.data();
+    const float* cy = m_centerY.data();
+    const float* cz = m_centerZ.data();
+    const float* ex = m_extentX.data();
+    const float* ey = m_extentY.data();
+    const float* ez = m_extentZ.data();
+
+    size_t written = 0;
+    size_t i = begin;
+
+#if defined(NENE_CULL_AVX2)
+    constexpr size_t Width = 8;
+    __m256 nx[Frustum::PlaneCount], ny[Frustum::PlaneCount], nz[Frustum::PlaneCount], nd[Frustum::PlaneCount];
+    __m256 ax[Frustum::PlaneCount], ay[Frustum::PlaneCount], az[Frustum::PlaneCount];
+    for (int p = 0; p < Frustum::PlaneCount; ++p)
+    {
+        const XMFLOAT4& plane = frustum.planes[p];
+        nx[p] = _mm256_set1_ps(plane.x); ny[p] = _mm256_set1_ps(plane.y); nz[p] = _mm256_set1_ps(plane.z); nd[p] = _mm256_set1_ps(plane.w);
+        ax[p] = _mm256_set1_ps(std::fabs(plane.x)); ay[p] = _mm256_set1_ps(std::fabs(plane.y)); az[p] = _mm256_set1_ps(std::fabs(plane.z));
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + Width <= end; i += Width)
+    {
+        const __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+        const __m256 sx = _mm256_loadu_ps(ex + i), sy = _mm256_loadu_ps(ey + i), sz = _mm256_loadu_ps(ez + i);
+
+        __m256 outside = zero;
+        for (int p = 0; p < Frustum::PlaneCount; ++p)
+        {
+            const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, nx[p]), _mm256_mul_ps(y, ny[p])),
+                                                  _mm256_add_ps(_mm256_mul_ps(z, nz[p]), nd[p]));
+            const __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, ax[p]), _mm256_mul_ps(sy, ay[p])), _mm256_mul_ps(sz, az[p]));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+        }
+
+        // Branch-free compaction: always store, advance only for visible lanes
+        const uint32_t visible = ~static_cast<uint32_t>(_mm256_movemask_ps(outside));
+        for (uint32_t lane = 0; lane < Width; ++lane)
+        {
+            outIndices[written] = static_cast<uint32_t>(i + lane);
+            written += (visible >> lane) & 1u;
+        }
+    }
+#elif defined(NENE_CULL_SSE)
+    constexpr size_t Width = 4;
+    __m128 nx[Frustum::PlaneCount], ny[Frustum::PlaneCount], nz[Frustum::PlaneCount], nd[Frustum::PlaneCount];
+    __m128 ax[Frustum::PlaneCount], ay[Frustum::PlaneCount], az[Frustum::PlaneCount];
+    for (int p = 0; p < Frustum::PlaneCount; ++p)
+    {
+        const XMFLOAT4& plane = frustum.planes[p];
+        nx[p] = _mm_set1_ps(plane.x); ny[p] = _mm_set1_ps(plane.y); nz[p] = _mm_set1_ps(plane.z); nd[p] = _mm_set1_ps(plane.w);
+        ax[p] = _mm_set1_ps(std::fabs(plane.x)); ay[p] = _mm_set1_ps(std::fabs(plane.y)); az[p] = _mm_set1_ps(std::fabs(plane.z));
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + Width <= end; i += Width)
+    {
+        const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+        const __m128 sx = _mm_loadu_ps(ex + i), sy = _mm_loadu_ps(ey + i), sz = _mm_loadu_ps(ez + i);
+
+        __m128 outside = zero;
+        for (int p = 0; p < Frustum::PlaneCount; ++p)
+        {
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx[p]), _mm_mul_ps(y, ny[p])),
+                                               _mm_add_ps(_mm_mul_ps(z, nz[p]), nd[p]));
+            const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, ax[p]), _mm_mul_ps(sy, ay[p])), _mm_mul_ps(sz, az[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        const uint32_t visible = ~static_cast<uint32_t>(_mm_movemask_ps(outside));
+        for (uint32_t lane = 0; lane < Width; ++lane)
+        {
+            outIndices[written] = static_cast<uint32_t>(i + lane);
+            written += (visible >> lane) & 1u;
+        }
+    }
+#endif
+
+    // Tail (and the whole range on targets without SSE)
+    for (; i < end; ++i)
+    {
+        if (frustum.Intersects(XMFLOAT3(cx[i], cy[i], cz[i]), XMFLOAT3(ex[i], ey[i], ez[i])))
+        {
+            outIndices[written++] = static_cast<uint32_t>(i);
+        }
+    }
+    return written;
+}
@@ -0,0 +1,24 @@
+#include "LodSelection.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void LodSelector::Setup(const LodSettings& settings, float fovY)
+{
+    m_pixelsPerUnit = settings.viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+
+    const float threshold = settings.pixelThreshold * std::exp2(settings.bias);
+    m_refineThreshold = threshold;
+    m_coarsenThreshold = threshold * (1.0f - std::clamp(settings.hysteresis, 0.0f, 0.99f));
+}
+
+float LodSelector::GetProjectedError(float error, float distance) const
+{
+    // Inside the bounds the error is unbounded on screen; keep the most detailed level
+    return distance > 0.0f ? error * m_pixelsPerUnit / distance : (error > 0.0f ? FLT_MAX : 0.0f);
+}
+
+float ArcTessellationError(float radius, float segmentAngle)
+{
+    return radius * (1.0f - std::cos(segmentAngle * 0.5f));
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+
+struct LodSettings
+{
+    float viewportHeight = 1080.0f; // Render target height in pixels
+    float pixelThreshold = 1.0f;    // Largest acceptable projected error
+    float hysteresis = 0.25f;       // A coarser level is taken only below threshold * (1 - hysteresis)
+    float bias = 0.0f;              // log2 of a threshold multiplier: +1 doubles it (coarser), -1 halves it
+};
+
+// Screen-space error LOD selection. Every level of a chain carries a geometric error: the largest
+// distance between its surface and the most detailed level, in mesh units. Projected to the screen
+// it becomes error * viewportHeight / (2 * distance * tan(fovY / 2)) pixels, and the selector picks
+// the coarsest level that stays under the threshold. The hysteresis band keeps objects near a switch
+// distance from flipping between two levels every frame.
+class LodSelector
+{
+public:
+    void Setup(const LodSettings& settings, float fovY);
+
+    float GetProjectedError(float error, float distance) const;
+    // Projected errors above this need a finer level; a coarser one is taken at or below the coarsen threshold
+    float GetRefineThreshold() const { return m_refineThreshold; }
+    float GetCoarsenThreshold() const { return m_coarsenThreshold; }
+
+    // errorOf(level) -> float must not decrease with the level, level 0 being the most detailed.
+    // distance is measured in the same units as the errors (divide world distance by the world scale).
+    template<typename ErrorFn>
+    uint32_t Select(uint32_t levelCount, uint32_t currentLevel, float distance, ErrorFn&& errorOf) const;
+
+private:
+    float m_pixelsPerUnit = 1.0f; // Projected size of one unit at distance 1
+    float m_refineThreshold = 1.0f;
+    float m_coarsenThreshold = 1.0f;
+};
+
+template<typename ErrorFn>
+uint32_t LodSelector::Select(uint32_t levelCount, uint32_t currentLevel, float distance, ErrorFn&& errorOf) const
+{
+    if (levelCount == 0) return 0;
+    uint32_t level = currentLevel < levelCount ? currentLevel : levelCount - 1;
+
+    // Refine immediately when the current level is visibly wrong, coarsen only with margin
+    while (level > 0 && GetProjectedError(errorOf(level), distance) > m_refineThreshold) --level;
+    while (level + 1 < levelCount && GetProjectedError(errorOf(level + 1), distance) <= m_coarsenThreshold) ++level;
+    return level;
+}
+
+// Geometric error of approximating an arc of the given radius with chords spanning segmentAngle radians:
+// the sagitta r * (1 - cos(angle / 2)). For GeometryGenerator::CreateSphere/CreateCylinder the angle is
+// 2 * pi / sliceCount; for CreateGeosphere it is about 1.107 / 2^numSubdivisions.
+float ArcTessellationError(float radius, float segmentAngle);
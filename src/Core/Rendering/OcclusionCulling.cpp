@@ -0,0 +1,334 @@
+#include "OcclusionCulling.h"
+#include "FrustumCulling.h"
+#include "../Jobs/JobSystem.h"
+#include "../Memory/FrameArena.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NENE_OCCLUSION_SSE 1
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    // Sutherland-Hodgman against the D3D near plane z >= 0; a triangle becomes at most a quad
+    int ClipNear(const XMFLOAT4* in, XMFLOAT4* out)
+    {
+        int count = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            const XMFLOAT4& a = in[i];
+            const XMFLOAT4& b = in[(i + 1) % 3];
+            if (a.z >= 0.0f) out[count++] = a;
+            if ((a.z >= 0.0f) != (b.z >= 0.0f))
+            {
+                const float t = a.z / (a.z - b.z);
+                out[count++] = XMFLOAT4(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0f, a.w + (b.w - a.w) * t);
+            }
+        }
+        return count;
+    }
+
+    // Every vertex outside the same clip plane
+    bool IsTriviallyOutside(const XMFLOAT4& a, const XMFLOAT4& b, const XMFLOAT4& c)
+    {
+        auto allOutside = [&](auto&& outside) { return outside(a) && outside(b) && outside(c); };
+        return allOutside([](const XMFLOAT4& v) { return v.x > v.w; }) ||
+               allOutside([](const XMFLOAT4& v) { return v.x < -v.w; }) ||
+               allOutside([](const XMFLOAT4& v) { return v.y > v.w; }) ||
+               allOutside([](const XMFLOAT4& v) { return v.y < -v.w; }) ||
+               allOutside([](const XMFLOAT4& v) { return v.z > v.w; }) ||
+               allOutside([](const XMFLOAT4& v) { return v.z < 0.0f; });
+    }
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+    : m_width((std::max(width, TileSize) + TileSize - 1) / TileSize * TileSize)
+    , m_height((std::max(height, TileSize) + TileSize - 1) / TileSize * TileSize)
+{
+    XMStoreFloat4x4(&m_viewProj, XMMatrixIdentity());
+
+    uint32_t levelWidth = m_width;
+    uint32_t levelHeight = m_height;
+    while (true)
+    {
+        m_levels.emplace_back(size_t(levelWidth) * levelHeight, 1.0f);
+        m_levelWidths.push_back(levelWidth);
+        m_levelHeights.push_back(levelHeight);
+        if (levelWidth == 1 && levelHeight == 1) break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+void OcclusionCuller::BeginFrame(FXMMATRIX viewProj)
+{
+    XMStoreFloat4x4(&m_viewProj, viewProj);
+    if (m_depthWritten) std::fill(m_levels[0].begin(), m_levels[0].end(), 1.0f);
+    m_triangles.clear();
+    m_stats.occluderTriangles = 0;
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const XMFLOAT4X4& world)
+{
+    const XMMATRIX worldViewProj = XMMatrixMultiply(XMLoadFloat4x4(&world), XMLoadFloat4x4(&m_viewProj));
+    m_clipVertices.resize(mesh.positions.size());
+    for (size_t i = 0; i < mesh.positions.size(); ++i)
+    {
+        XMStoreFloat4(&m_clipVertices[i], XMVector3Transform(XMLoadFloat3(&mesh.positions[i]), worldViewProj));
+    }
+
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        const XMFLOAT4 triangle[3] = { m_clipVertices[mesh.indices[i]], m_clipVertices[mesh.indices[i + 1]], m_clipVertices[mesh.indices[i + 2]] };
+        if (IsTriviallyOutside(triangle[0], triangle[1], triangle[2])) continue;
+
+        if (triangle[0].z >= 0.0f && triangle[1].z >= 0.0f && triangle[2].z >= 0.0f)
+        {
+            AddClippedTriangle(triangle);
+            continue;
+        }
+
+        XMFLOAT4 polygon[4];
+        const int count = ClipNear(triangle, polygon);
+        for (int v = 2; v < count; ++v)
+        {
+            const XMFLOAT4 fan[3] = { polygon[0], polygon[v - 1], polygon[v] };
+            AddClippedTriangle(fan);
+        }
+    }
+}
+
+void OcclusionCuller::AddClippedTriangle(const XMFLOAT4* clip)
+{
+    ScreenTriangle triangle;
+    for (int v = 0; v < 3; ++v)
+    {
+        const float invW = 1.0f / clip[v].w;
+        triangle.x[v] = (clip[v].x * invW * 0.5f + 0.5f) * m_width;
+        triangle.y[v] = (0.5f - clip[v].y * invW * 0.5f) * m_height;
+        triangle.z[v] = clip[v].z * invW;
+    }
+
+    // Screen y points down; make the winding consistent so all edge functions are positive inside.
+    // Occluders are rasterized double-sided.
+    const float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+                       (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+    if (std::fabs(area) < 1e-6f) return;
+    if (area < 0.0f)
+    {
+        std::swap(triangle.x[1], triangle.x[2]);
+        std::swap(triangle.y[1], triangle.y[2]);
+        std::swap(triangle.z[1], triangle.z[2]);
+    }
+
+    triangle.minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+    triangle.maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+    m_triangles.push_back(triangle);
+    ++m_stats.occluderTriangles;
+}
+
+void OcclusionCuller::Rasterize()
+{
+    // Level 0 is already clear; the coarser levels still need it if the last frame had occluders
+    if (m_triangles.empty())
+    {
+        if (m_depthWritten) BuildPyramid();
+        m_depthWritten = false;
+        return;
+    }
+
+    // Bands share no pixels, so each job owns its rows of the depth buffer
+    const uint32_t bandCount = m_height / TileSize;
+    JobSystem::Get().ParallelFor(bandCount, [this](size_t first, size_t last)
+    {
+        for (size_t band = first; band < last; ++band) RasterizeBand(static_cast<uint32_t>(band));
+    }, 1);
+    BuildPyramid();
+    m_depthWritten = true;
+}
+
+void OcclusionCuller::RasterizeBand(uint32_t band)
+{
+    const int bandTop = static_cast<int>(band * TileSize);
+    const int bandBottom = bandTop + static_cast<int>(TileSize) - 1;
+    float* depth = m_levels[0].data();
+
+    for (const ScreenTriangle& t : m_triangles)
+    {
+        if (t.maxY < bandTop || t.minY > bandBottom + 1) continue;
+
+        // Edge function of edge a->b is A*x + B*y + C, positive on the inner side.
+        // Edge 12 weights vertex 0, edge 20 vertex 1, edge 01 vertex 2.
+        float edgeA[3], edgeB[3], edgeC[3];
+        for (int e = 0; e < 3; ++e)
+        {
+            const int a = (e + 1) % 3;
+            const int b = (e + 2) % 3;
+            edgeA[e] = t.y[a] - t.y[b];
+            edgeB[e] = t.x[b] - t.x[a];
+            edgeC[e] = t.x[a] * t.y[b] - t.x[b] * t.y[a];
+        }
+        const float invArea = 1.0f / (edgeC[0] + edgeC[1] + edgeC[2]);
+        const float depthA = (edgeA[0] * t.z[0] + edgeA[1] * t.z[1] + edgeA[2] * t.z[2]) * invArea;
+        const float depthB = (edgeB[0] * t.z[0] + edgeB[1] * t.z[1] + edgeB[2] * t.z[2]) * invArea;
+        const float depthC = (edgeC[0] * t.z[0] + edgeC[1] * t.z[1] + edgeC[2] * t.z[2]) * invArea;
+
+        const float minX = std::min({ t.x[0], t.x[1], t.x[2] });
+        const float maxX = std::max({ t.x[0], t.x[1], t.x[2] });
+        if (maxX < 0.0f || minX > static_cast<float>(m_width)) continue;
+
+        // Whole 4-pixel groups; the width is a multiple of TileSize, so a group never crosses a row
+        // Clamp in float first: vertices near the near plane project far outside the screen
+        const int xBegin = static_cast<int>(std::floor(std::max(minX, 0.0f))) & ~3;
+        const int xEnd = static_cast<int>(std::ceil(std::min(maxX, m_width - 1.0f)));
+        const int yBegin = static_cast<int>(std::floor(std::max(t.minY, static_cast<float>(bandTop))));
+        const int yEnd = static_cast<int>(std::ceil(std::min(t.maxY, static_cast<float>(bandBottom))));
+
+        for (int y = yBegin; y <= yEnd; ++y)
+        {
+            const float py = y + 0.5f;
+            float* row = depth + size_t(y) * m_width;
+
+#if defined(NENE_OCCLUSION_SSE)
+            const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 zero = _mm_setzero_ps();
+            __m128 rowEdge[3], stepA[3];
+            for (int e = 0; e < 3; ++e)
+            {
+                rowEdge[e] = _mm_set1_ps(edgeB[e] * py + edgeC[e]);
+                stepA[e] = _mm_set1_ps(edgeA[e]);
+            }
+            const __m128 rowDepth = _mm_set1_ps(depthB * py + depthC);
+            const __m128 depthStep = _mm_set1_ps(depthA);
+
+            for (int x = xBegin; x <= xEnd; x += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[0], px), rowEdge[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[1], px), rowEdge[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepA[2], px), rowEdge[2]), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                const __m128 current = _mm_loadu_ps(row + x);
+                const __m128 nearest = _mm_min_ps(current, _mm_add_ps(_mm_mul_ps(depthStep, px), rowDepth));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+#else
+            for (int x = xBegin; x <= xEnd; ++x)
+            {
+                const float px = x + 0.5f;
+                if (edgeA[0] * px + edgeB[0] * py + edgeC[0] < 0.0f ||
+                    edgeA[1] * px + edgeB[1] * py + edgeC[1] < 0.0f ||
+                    edgeA[2] * px + edgeB[2] * py + edgeC[2] < 0.0f) continue;
+                row[x] = std::min(row[x], depthA * px + depthB * py + depthC);
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionCuller::BuildPyramid()
+{
+    for (size_t level = 1; level < m_levels.size(); ++level)
+    {
+        const float* source = m_levels[level - 1].data();
+        const uint32_t sourceWidth = m_levelWidths[level - 1];
+        const uint32_t sourceHeight = m_levelHeights[level - 1];
+        float* target = m_levels[level].data();
+
+        for (uint32_t y = 0; y < m_levelHeights[level]; ++y)
+        {
+            const uint32_t y0 = y * 2;
+            const uint32_t y1 = std::min(y0 + 1, sourceHeight - 1);
+            for (uint32_t x = 0; x < m_levelWidths[level]; ++x)
+            {
+                const uint32_t x0 = x * 2;
+                const uint32_t x1 = std::min(x0 + 1, sourceWidth - 1);
+                target[size_t(y) * m_levelWidths[level] + x] = std::max(
+                    std::max(source[size_t(y0) * sourceWidth + x0], source[size_t(y0) * sourceWidth + x1]),
+                    std::max(source[size_t(y1) * sourceWidth + x0], source[size_t(y1) * sourceWidth + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::IsVisible(const XMFLOAT3& center, const XMFLOAT3& extents) const
+{
+    const XMMATRIX viewProj = XMLoadFloat4x4(&m_viewProj);
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const XMVECTOR position = XMVectorSet(center.x + ((corner & 1) ? extents.x : -extents.x),
+                                              center.y + ((corner & 2) ? extents.y : -extents.y),
+                                              center.z + ((corner & 4) ? extents.z : -extents.z), 1.0f);
+        XMFLOAT4 clip;
+        XMStoreFloat4(&clip, XMVector3Transform(position, viewProj));
+
+        // Crosses the near plane: the projected rectangle is unbounded, keep the box
+        if (clip.z < 0.0f || clip.w <= 1e-6f) return true;
+
+        const float invW = 1.0f / clip.w;
+        const float x = (clip.x * invW * 0.5f + 0.5f) * m_width;
+        const float y = (0.5f - clip.y * invW * 0.5f) * m_height;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip.z * invW);
+    }
+
+    // Off screen: frustum culling is the place to reject it
+    if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height) return true;
+    const int x0 = static_cast<int>(std::max(minX, 0.0f));
+    const int x1 = static_cast<int>(std::min(maxX, m_width - 1.0f));
+    const int y0 = static_cast<int>(std::max(minY, 0.0f));
+    const int y1 = static_cast<int>(std::min(maxY, m_height - 1.0f));
+
+    // Coarsest level at which the rectangle spans at most 4x4 texels
+    size_t level = 0;
+    while (level + 1 < m_levels.size() && ((x1 >> level) - (x0 >> level) >= 4 || (y1 >> level) - (y0 >> level) >= 4))
+    {
+        ++level;
+    }
+
+    const float* depth = m_levels[level].data();
+    const uint32_t levelWidth = m_levelWidths[level];
+    for (int y = y0 >> level; y <= (y1 >> level); ++y)
+    {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x)
+        {
+            if (minZ <= depth[size_t(y) * levelWidth + x]) return true;
+        }
+    }
+    return false;
+}
+
+size_t OcclusionCuller::Cull(const FrustumCuller& boxes, uint32_t* indices, size_t count)
+{
+    m_stats.testedCount = count;
+    m_stats.culledCount = 0;
+    if (m_triangles.empty() || count == 0) return count;
+
+    uint8_t* visible = FrameArena::Get().AllocateArray<uint8_t>(count);
+    JobSystem::Get().ParallelFor(count, [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            visible[i] = IsVisible(boxes.GetCenter(indices[i]), boxes.GetExtents(indices[i])) ? 1 : 0;
+        }
+    }, 256);
+
+    size_t written = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        indices[written] = indices[i];
+        written += visible[i];
+    }
+    m_stats.culledCount = count - written;
+    return written;
+}
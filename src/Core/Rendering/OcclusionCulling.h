@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+class FrustumCuller;
+
+// Simplified occluder geometry: a few large closed pieces (walls, floors, pillars), not the render mesh.
+struct OccluderMesh
+{
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<uint32_t> indices; // Triangle list
+};
+
+struct OcclusionStats
+{
+    size_t occluderTriangles = 0; // Triangles that reached the rasterizer after clipping
+    size_t testedCount = 0;       // Boxes tested in the last Cull
+    size_t culledCount = 0;       // Of those, hidden behind occluders
+};
+
+// Software occlusion culling against a low-resolution depth buffer rendered on the CPU.
+//   1. BeginFrame(viewProj) clears the buffer if the last frame drew into it.
+//   2. AddOccluder() transforms, near-clips and projects occluder triangles.
+//   3. Rasterize() fills the depth buffer in horizontal bands of tiles in parallel, 4 pixels per
+//      SSE instruction, then builds a max-depth pyramid. Without occluder triangles it does nothing
+//      (the pyramid is rebuilt once after the last frame with occluders), so a scene without
+//      occluders pays only for the projection of its occluder meshes.
+//   4. Cull() tests boxes against the pyramid in parallel: a box is hidden when its nearest depth is
+//      farther than the farthest occluder depth everywhere under its screen rectangle.
+// Depth is D3D clip space z/w in [0, 1]; the test is conservative except for the sub-pixel coverage
+// of occluder edges, which are sampled at pixel centers. Does not depend on D3D, so it runs headless.
+class OcclusionCuller
+{
+public:
+    static constexpr uint32_t TileSize = 8;
+
+    // Width and height are rounded up to a multiple of TileSize
+    explicit OcclusionCuller(uint32_t width = 256, uint32_t height = 128);
+
+    void BeginFrame(DirectX::FXMMATRIX viewProj);
+    void AddOccluder(const OccluderMesh& mesh, const DirectX::XMFLOAT4X4& world);
+    void Rasterize();
+
+    // True if a world-space box may be visible. Valid after Rasterize.
+    bool IsVisible(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) const;
+
+    // Drops the hidden boxes of culler from indices (keeping order) and returns the new count
+    size_t Cull(const FrustumCuller& boxes, uint32_t* indices, size_t count);
+
+    bool HasOccluders() const { return !m_triangles.empty(); }
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+    // Level 0 is the full-resolution depth buffer, row-major
+    const float* GetDepth(uint32_t level = 0) const { return m_levels[level].data(); }
+    const OcclusionStats& GetStats() const { return m_stats; }
+
+private:
+    struct ScreenTriangle
+    {
+        float x[3];
+        float y[3];
+        float z[3];
+        float minY;
+        float maxY;
+    };
+
+    void AddClippedTriangle(const DirectX::XMFLOAT4* clip);
+    void RasterizeBand(uint32_t band);
+    void BuildPyramid();
+
+    uint32_t m_width;
+    uint32_t m_height;
+    DirectX::XMFLOAT4X4 m_viewProj;
+    std::vector<ScreenTriangle> m_triangles;
+    std::vector<DirectX::XMFLOAT4> m_clipVertices; // Scratch for AddOccluder
+    std::vector<std::vector<float>> m_levels;      // Depth pyramid, each level the max of 2x2 texels below
+    std::vector<uint32_t> m_levelWidths;
+    std::vector<uint32_t> m_levelHeights;
+    bool m_depthWritten = false; // Some level holds occluder depth, i.e. is not all 1.0
+    OcclusionStats m_stats;
+};
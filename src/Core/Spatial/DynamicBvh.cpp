@@ -0,0 +1,537 @@
+#include "DynamicBvh.h"
+#include <cassert>
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr int BinCount = 12;
+
+    float Component(const XMFLOAT3& value, int axis)
+    {
+        return (&value.x)[axis];
+    }
+}
+
+Aabb Aabb::FromCenterExtents(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+    return { XMFLOAT3(center.x - extents.x, center.y - extents.y, center.z - extents.z),
+             XMFLOAT3(center.x + extents.x, center.y + extents.y, center.z + extents.z) };
+}
+
+Aabb Aabb::Union(const Aabb& a, const Aabb& b)
+{
+    return { XMFLOAT3(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)),
+             XMFLOAT3(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)) };
+}
+
+bool Aabb::Contains(const Aabb& other) const
+{
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+           other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+}
+
+bool Aabb::Overlaps(const Aabb& other) const
+{
+    return min.x <= other.max.x && other.min.x <= max.x &&
+           min.y <= other.max.y && other.min.y <= max.y &&
+           min.z <= other.max.z && other.min.z <= max.z;
+}
+
+float Aabb::SurfaceArea() const
+{
+    const float dx = max.x - min.x;
+    const float dy = max.y - min.y;
+    const float dz = max.z - min.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+DynamicBvh::DynamicBvh(float margin)
+    : m_margin(margin)
+{
+}
+
+int32_t DynamicBvh::AllocateNode()
+{
+    int32_t index;
+    if (m_freeList != NullNode)
+    {
+        index = m_freeList;
+        m_freeList = m_nodes[index].parent;
+    }
+    else
+    {
+        index = static_cast<int32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+        m_tightBounds.emplace_back();
+    }
+
+    Node& node = m_nodes[index];
+    node.parent = NullNode;
+    node.child1 = NullNode;
+    node.child2 = NullNode;
+    node.height = 0;
+    node.enlarged = false;
+    node.userData = 0;
+    return index;
+}
+
+void DynamicBvh::FreeNode(int32_t index)
+{
+    m_nodes[index].parent = m_freeList;
+    m_nodes[index].height = -1;
+    m_freeList = index;
+}
+
+Aabb DynamicBvh::Fatten(const Aabb& bounds) const
+{
+    return { XMFLOAT3(bounds.min.x - m_margin, bounds.min.y - m_margin, bounds.min.z - m_margin),
+             XMFLOAT3(bounds.max.x + m_margin, bounds.max.y + m_margin, bounds.max.z + m_margin) };
+}
+
+int32_t DynamicBvh::CreateProxy(const Aabb& bounds, uint64_t userData)
+{
+    const int32_t leaf = AllocateNode();
+    m_nodes[leaf].box = Fatten(bounds);
+    m_nodes[leaf].userData = userData;
+    m_tightBounds[leaf] = bounds;
+
+    InsertLeaf(leaf);
+    ++m_proxyCount;
+    return leaf;
+}
+
+void DynamicBvh::DestroyProxy(int32_t proxy)
+{
+    assert(m_nodes[proxy].IsLeaf());
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --m_proxyCount;
+}
+
+bool DynamicBvh::MoveProxy(int32_t proxy, const Aabb& bounds)
+{
+    m_tightBounds[proxy] = bounds;
+    if (m_nodes[proxy].box.Contains(bounds)) return false;
+
+    RemoveLeaf(proxy);
+    m_nodes[proxy].box = Fatten(bounds);
+    InsertLeaf(proxy);
+    return true;
+}
+
+bool DynamicBvh::SetProxyBounds(int32_t proxy, const Aabb& bounds)
+{
+    m_tightBounds[proxy] = bounds;
+    if (m_nodes[proxy].box.Contains(bounds)) return false;
+
+    m_nodes[proxy].box = Fatten(bounds);
+
+    // Flags stop at the first flagged ancestor: everything above it is flagged already
+    for (int32_t index = m_nodes[proxy].parent; index != NullNode && !m_nodes[index].enlarged; index = m_nodes[index].parent)
+    {
+        m_nodes[index].enlarged = true;
+    }
+    return true;
+}
+
+void DynamicBvh::Refit()
+{
+    if (m_root == NullNode || !m_nodes[m_root].enlarged) return;
+
+    // Pre-order collection of flagged nodes, then reverse order so children are refit before parents
+    m_buildLeaves.clear();
+    NodeStack stack;
+    stack.Push(m_root);
+    while (!stack.IsEmpty())
+    {
+        const int32_t index = stack.Pop();
+        const Node& node = m_nodes[index];
+        if (node.IsLeaf() || !node.enlarged) continue;
+
+        m_buildLeaves.push_back(index);
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+    }
+
+    for (auto it = m_buildLeaves.rbegin(); it != m_buildLeaves.rend(); ++it)
+    {
+        UpdateNode(*it);
+        m_nodes[*it].enlarged = false;
+    }
+}
+
+void DynamicBvh::InsertLeaf(int32_t leaf)
+{
+    if (m_root == NullNode)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = NullNode;
+        return;
+    }
+
+    const int32_t sibling = FindBestSibling(m_nodes[leaf].box);
+    const int32_t oldParent = m_nodes[sibling].parent;
+    const int32_t newParent = AllocateNode();
+
+    Node& parent = m_nodes[newParent];
+    parent.parent = oldParent;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    parent.box = Aabb::Union(m_nodes[leaf].box, m_nodes[sibling].box);
+    parent.height = static_cast<int16_t>(m_nodes[sibling].height + 1);
+    // A sibling subtree that still waits for Refit keeps its new parent on the refit path
+    parent.enlarged = m_nodes[sibling].enlarged;
+
+    if (oldParent == NullNode)
+    {
+        m_root = newParent;
+    }
+    else if (m_nodes[oldParent].child1 == sibling)
+    {
+        m_nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        m_nodes[oldParent].child2 = newParent;
+    }
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    RefitAncestors(newParent, true);
+}
+
+void DynamicBvh::RemoveLeaf(int32_t leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NullNode;
+        return;
+    }
+
+    const int32_t parent = m_nodes[leaf].parent;
+    const int32_t grandParent = m_nodes[parent].parent;
+    const int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    m_nodes[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    if (grandParent == NullNode)
+    {
+        m_root = sibling;
+        return;
+    }
+
+    if (m_nodes[grandParent].child1 == parent) m_nodes[grandParent].child1 = sibling;
+    else m_nodes[grandParent].child2 = sibling;
+    RefitAncestors(grandParent, false);
+}
+
+int32_t DynamicBvh::FindBestSibling(const Aabb& box) const
+{
+    // Greedy descent by the surface area heuristic: stop when pairing with the current node
+    // is cheaper than pushing the new leaf further down either child
+    int32_t index = m_root;
+    while (!m_nodes[index].IsLeaf())
+    {
+        const Node& node = m_nodes[index];
+        const float area = node.box.SurfaceArea();
+        const float combinedArea = Aabb::Union(node.box, box).SurfaceArea();
+
+        const float cost = 2.0f * combinedArea;
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int32_t child)
+        {
+            const Node& childNode = m_nodes[child];
+            const float unionArea = Aabb::Union(box, childNode.box).SurfaceArea();
+            return (childNode.IsLeaf() ? unionArea : unionArea - childNode.box.SurfaceArea()) + inheritanceCost;
+        };
+        const float cost1 = descendCost(node.child1);
+        const float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+    return index;
+}
+
+void DynamicBvh::UpdateNode(int32_t index)
+{
+    Node& node = m_nodes[index];
+    const Node& child1 = m_nodes[node.child1];
+    const Node& child2 = m_nodes[node.child2];
+    node.box = Aabb::Union(child1.box, child2.box);
+    node.height = static_cast<int16_t>(1 + std::max(child1.height, child2.height));
+}
+
+void DynamicBvh::RefitAncestors(int32_t index, bool rotate)
+{
+    while (index != NullNode)
+    {
+        UpdateNode(index);
+        if (rotate) Rotate(index);
+        index = m_nodes[index].parent;
+    }
+}
+
+void DynamicBvh::Rotate(int32_t index)
+{
+    // Consider swapping a child of A with a grandchild under its sibling. The box of A does not
+    // change, but the box of the sibling that receives the child may shrink.
+    const Node& a = m_nodes[index];
+    if (a.height < 2) return;
+
+    const int32_t b = a.child1;
+    const int32_t c = a.child2;
+
+    int32_t bestUpper = NullNode;
+    int32_t bestLower = NullNode;
+    float bestGain = 0.0f;
+
+    // upper stays, its sibling 'other' gets upper in place of one of its children
+    auto consider = [&](int32_t upper, int32_t other)
+    {
+        const Node& otherNode = m_nodes[other];
+        if (otherNode.IsLeaf()) return;
+
+        const float baseline = otherNode.box.SurfaceArea();
+        const Aabb& upperBox = m_nodes[upper].box;
+        const float swapFirst = Aabb::Union(upperBox, m_nodes[otherNode.child2].box).SurfaceArea();
+        const float swapSecond = Aabb::Union(upperBox, m_nodes[otherNode.child1].box).SurfaceArea();
+
+        if (baseline - swapFirst > bestGain)
+        {
+            bestGain = baseline - swapFirst;
+            bestUpper = upper;
+            bestLower = otherNode.child1;
+        }
+        if (baseline - swapSecond > bestGain)
+        {
+            bestGain = baseline - swapSecond;
+            bestUpper = upper;
+            bestLower = otherNode.child2;
+        }
+    };
+    consider(b, c);
+    consider(c, b);
+    if (bestUpper == NullNode) return;
+
+    const int32_t other = m_nodes[bestLower].parent;
+    Node& parentNode = m_nodes[index];
+    if (parentNode.child1 == bestUpper) parentNode.child1 = bestLower;
+    else parentNode.child2 = bestLower;
+
+    Node& otherNode = m_nodes[other];
+    if (otherNode.child1 == bestLower) otherNode.child1 = bestUpper;
+    else otherNode.child2 = bestUpper;
+
+    m_nodes[bestLower].parent = index;
+    m_nodes[bestUpper].parent = other;
+    // A moved subtree that still waits for Refit keeps its new parent on the refit path
+    if (m_nodes[bestUpper].enlarged) m_nodes[other].enlarged = true;
+
+    UpdateNode(other);
+    UpdateNode(index);
+}
+
+void DynamicBvh::Rebuild()
+{
+    m_buildLeaves.clear();
+    for (int32_t index = 0; index < static_cast<int32_t>(m_nodes.size()); ++index)
+    {
+        Node& node = m_nodes[index];
+        if (node.height < 0) continue;
+
+        if (node.IsLeaf())
+        {
+            m_buildLeaves.push_back(index);
+        }
+        else
+        {
+            FreeNode(index);
+        }
+    }
+
+    m_root = m_buildLeaves.empty() ? NullNode : BuildRange(m_buildLeaves.data(), static_cast<int32_t>(m_buildLeaves.size()));
+}
+
+int32_t DynamicBvh::BuildRange(int32_t* leaves, int32_t count)
+{
+    struct Task
+    {
+        int32_t begin;
+        int32_t count;
+        int32_t parent;
+        bool isChild1;
+    };
+
+    std::vector<Task> tasks;
+    std::vector<int32_t> internalNodes; // In allocation order: every parent precedes its children
+    tasks.push_back({ 0, count, NullNode, true });
+    int32_t root = NullNode;
+
+    while (!tasks.empty())
+    {
+        const Task task = tasks.back();
+        tasks.pop_back();
+
+        int32_t index;
+        int32_t split = 0;
+        if (task.count == 1)
+        {
+            index = leaves[task.begin];
+        }
+        else
+        {
+            int32_t* first = leaves + task.begin;
+            int32_t* last = first + task.count;
+
+            // Bin centroids along the widest centroid axis and pick the cheapest SAH split
+            XMFLOAT3 centroidMin(FLT_MAX, FLT_MAX, FLT_MAX), centroidMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            for (int32_t* it = first; it != last; ++it)
+            {
+                const XMFLOAT3 center = m_nodes[*it].box.GetCenter();
+                centroidMin = XMFLOAT3(std::min(centroidMin.x, center.x), std::min(centroidMin.y, center.y), std::min(centroidMin.z, center.z));
+                centroidMax = XMFLOAT3(std::max(centroidMax.x, center.x), std::max(centroidMax.y, center.y), std::max(centroidMax.z, center.z));
+            }
+            const XMFLOAT3 spread(centroidMax.x - centroidMin.x, centroidMax.y - centroidMin.y, centroidMax.z - centroidMin.z);
+            const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+            const float axisMin = Component(centroidMin, axis);
+            const float axisSpread = Component(spread, axis);
+
+            if (axisSpread > 0.0f)
+            {
+                const float scale = BinCount / axisSpread;
+                auto binOf = [&](int32_t leaf)
+                {
+                    const int bin = static_cast<int>((Component(m_nodes[leaf].box.GetCenter(), axis) - axisMin) * scale);
+                    return std::min(bin, BinCount - 1);
+                };
+
+                int binCounts[BinCount] = {};
+                Aabb binBoxes[BinCount];
+                for (int32_t* it = first; it != last; ++it)
+                {
+                    const int bin = binOf(*it);
+                    binBoxes[bin] = binCounts[bin]++ == 0 ? m_nodes[*it].box : Aabb::Union(binBoxes[bin], m_nodes[*it].box);
+                }
+
+                // Sweep from the right to get area * count of every suffix, then from the left
+                float rightCost[BinCount];
+                Aabb accumulated{};
+                int accumulatedCount = 0;
+                for (int bin = BinCount - 1; bin > 0; --bin)
+                {
+                    if (binCounts[bin] > 0)
+                    {
+                        accumulated = accumulatedCount == 0 ? binBoxes[bin] : Aabb::Union(accumulated, binBoxes[bin]);
+                        accumulatedCount += binCounts[bin];
+                    }
+                    rightCost[bin] = accumulatedCount > 0 ? accumulated.SurfaceArea() * accumulatedCount : 0.0f;
+                }
+
+                float bestCost = FLT_MAX;
+                int bestBin = -1;
+                accumulatedCount = 0;
+                for (int bin = 0; bin < BinCount - 1; ++bin)
+                {
+                    if (binCounts[bin] > 0)
+                    {
+                        accumulated = accumulatedCount == 0 ? binBoxes[bin] : Aabb::Union(accumulated, binBoxes[bin]);
+                        accumulatedCount += binCounts[bin];
+                    }
+                    if (accumulatedCount == 0 || accumulatedCount == task.count) continue;
+
+                    const float cost = accumulated.SurfaceArea() * accumulatedCount + rightCost[bin + 1];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestBin = bin;
+                    }
+                }
+
+                if (bestBin >= 0)
+                {
+                    split = static_cast<int32_t>(std::partition(first, last, [&](int32_t leaf) { return binOf(leaf) <= bestBin; }) - first);
+                }
+            }
+
+            // Identical centroids or a degenerate split: halve by position instead
+            if (split <= 0 || split >= task.count)
+            {
+                split = task.count / 2;
+                std::nth_element(first, first + split, last, [&](int32_t l, int32_t r)
+                {
+                    return Component(m_nodes[l].box.GetCenter(), axis) < Component(m_nodes[r].box.GetCenter(), axis);
+                });
+            }
+
+            index = AllocateNode();
+            internalNodes.push_back(index);
+        }
+
+        m_nodes[index].parent = task.parent;
+        if (task.parent == NullNode) root = index;
+        else if (task.isChild1) m_nodes[task.parent].child1 = index;
+        else m_nodes[task.parent].child2 = index;
+
+        if (task.count > 1)
+        {
+            tasks.push_back({ task.begin + split, task.count - split, index, false });
+            tasks.push_back({ task.begin, split, index, true });
+        }
+    }
+
+    for (auto it = internalNodes.rbegin(); it != internalNodes.rend(); ++it)
+    {
+        UpdateNode(*it);
+    }
+    return root;
+}
+
+float DynamicBvh::GetAreaRatio() const
+{
+    if (m_root == NullNode) return 0.0f;
+    const float rootArea = m_nodes[m_root].box.SurfaceArea();
+    if (rootArea <= 0.0f) return 0.0f;
+
+    float totalArea = 0.0f;
+    for (const Node& node : m_nodes)
+    {
+        if (node.height > 0) totalArea += node.box.SurfaceArea();
+    }
+    return totalArea / rootArea;
+}
+
+bool DynamicBvh::RayHitsBox(const XMFLOAT3& origin, const XMFLOAT3& inverseDirection, const Aabb& box, float maxDistance, float& outDistance)
+{
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float o = Component(origin, axis);
+        const float inverse = Component(inverseDirection, axis);
+        float t1 = (Component(box.min, axis) - o) * inverse;
+        float t2 = (Component(box.max, axis) - o) * inverse;
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return false;
+    }
+    outDistance = tMin;
+    return true;
+}
+
+float DynamicBvh::DistanceSquared(const XMFLOAT3& point, const Aabb& box)
+{
+    float distance = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const float p = Component(point, axis);
+        const float excess = std::max({ Component(box.min, axis) - p, 0.0f, p - Component(box.max, axis) });
+        distance += excess * excess;
+    }
+    return distance;
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include "../Rendering/FrustumCulling.h"
+
+struct Aabb
+{
+    DirectX::XMFLOAT3 min;
+    DirectX::XMFLOAT3 max;
+
+    static Aabb FromCenterExtents(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+    static Aabb FromBoundingBox(const DirectX::BoundingBox& box) { return FromCenterExtents(box.Center, box.Extents); }
+    static Aabb Union(const Aabb& a, const Aabb& b);
+
+    bool Contains(const Aabb& other) const;
+    bool Overlaps(const Aabb& other) const;
+    float SurfaceArea() const;
+    DirectX::XMFLOAT3 GetCenter() const { return { (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f }; }
+    DirectX::XMFLOAT3 GetExtents() const { return { (max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f }; }
+};
+
+// Incrementally maintained AABB tree (dynamic BVH) for spatial queries.
+//   - Leaves store a "fat" box enlarged by a margin, so small movements do not touch the tree,
+//     plus the exact box used for final query tests.
+//   - Insertion descends by the surface area heuristic; on the way back up, tree rotations
+//     swap a child with a grandchild when that shrinks the surface area.
+//   - Many movers per frame: SetProxyBounds for each, then one Refit() pass over the changed paths.
+//   - Rebuild() rebuilds the whole tree top-down with binned SAH; call it when GetAreaRatio()
+//     has degraded noticeably since the last rebuild.
+// Queries take a callback; returning false from it stops the query early.
+class DynamicBvh
+{
+public:
+    static constexpr int32_t NullNode = -1;
+
+    explicit DynamicBvh(float margin = 0.1f);
+
+    int32_t CreateProxy(const Aabb& bounds, uint64_t userData);
+    void DestroyProxy(int32_t proxy);
+
+    // Reinserts the proxy only if bounds left its fat box. Returns true if the tree changed.
+    bool MoveProxy(int32_t proxy, const Aabb& bounds);
+
+    // Batch update: refreshes the leaf in place and marks its ancestors for the next Refit().
+    // Returns true if the fat box had to grow or move.
+    bool SetProxyBounds(int32_t proxy, const Aabb& bounds);
+    void Refit();
+
+    void Rebuild();
+
+    uint64_t GetUserData(int32_t proxy) const { return m_nodes[proxy].userData; }
+    const Aabb& GetBounds(int32_t proxy) const { return m_tightBounds[proxy]; }
+    const Aabb& GetFatBounds(int32_t proxy) const { return m_nodes[proxy].box; }
+
+    size_t GetProxyCount() const { return m_proxyCount; }
+    int32_t GetHeight() const { return m_root == NullNode ? 0 : m_nodes[m_root].height; }
+    // Sum of internal node surface areas divided by the root area; grows as the tree degrades
+    float GetAreaRatio() const;
+
+    // fn(int32_t proxy) -> bool
+    template<typename Fn>
+    void QueryAabb(const Aabb& bounds, Fn&& fn) const;
+
+    template<typename Fn>
+    void QuerySphere(const DirectX::XMFLOAT3& center, float radius, Fn&& fn) const;
+
+    template<typename Fn>
+    void QueryFrustum(const Frustum& frustum, Fn&& fn) const;
+
+    // fn(int32_t proxy, float distance) -> float; called for every proxy whose exact box is hit
+    // closer than the current maximum, in traversal order. Return the new maximum distance
+    // (e.g. the distance for a closest-hit search, or 0 to stop).
+    template<typename Fn>
+    void RayCast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance, Fn&& fn) const;
+
+private:
+    struct Node
+    {
+        Aabb box;
+        int32_t parent;    // Next free node while on the free list
+        int32_t child1;
+        int32_t child2;
+        int16_t height;    // 0 for leaves
+        bool enlarged;     // Box must be recomputed by Refit
+        uint64_t userData;
+
+        bool IsLeaf() const { return child1 == NullNode; }
+    };
+
+    // Traversal stack that only touches the heap for unusually deep trees
+    class NodeStack
+    {
+    public:
+        void Push(int32_t node)
+        {
+            if (m_count < InlineCapacity) m_inline[m_count] = node;
+            else m_overflow.push_back(node);
+            ++m_count;
+        }
+        int32_t Pop()
+        {
+            --m_count;
+            if (m_count < InlineCapacity) return m_inline[m_count];
+            const int32_t node = m_overflow.back();
+            m_overflow.pop_back();
+            return node;
+        }
+        bool IsEmpty() const { return m_count == 0; }
+
+    private:
+        static constexpr size_t InlineCapacity = 128;
+        int32_t m_inline[InlineCapacity];
+        std::vector<int32_t> m_overflow;
+        size_t m_count = 0;
+    };
+
+    int32_t AllocateNode();
+    void FreeNode(int32_t node);
+    Aabb Fatten(const Aabb& bounds) const;
+
+    void InsertLeaf(int32_t leaf);
+    void RemoveLeaf(int32_t leaf);
+    int32_t FindBestSibling(const Aabb& box) const;
+    void RefitAncestors(int32_t node, bool rotate);
+    void Rotate(int32_t node);
+    void UpdateNode(int32_t node);
+    int32_t BuildRange(int32_t* leaves, int32_t count);
+
+    static bool RayHitsBox(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& inverseDirection, const Aabb& box, float maxDistance, float& outDistance);
+    static float DistanceSquared(const DirectX::XMFLOAT3& point, const Aabb& box);
+
+    std::vector<Node> m_nodes;
+    std::vector<Aabb> m_tightBounds; // Exact boxes of leaves, indexed like m_nodes
+    std::vector<int32_t> m_buildLeaves; // Scratch for Rebuild and Refit
+    int32_t m_root = NullNode;
+    int32_t m_freeList = NullNode;
+    size_t m_proxyCount = 0;
+    float m_margin;
+};
+
+template<typename Fn>
+void DynamicBvh::QueryAabb(const Aabb& bounds, Fn&& fn) const
+{
+    NodeStack stack;
+    if (m_root != NullNode) stack.Push(m_root);
+    while (!stack.IsEmpty())
+    {
+        const int32_t index = stack.Pop();
+        const Node& node = m_nodes[index];
+        if (!node.box.Overlaps(bounds)) continue;
+
+        if (node.IsLeaf())
+        {
+            if (m_tightBounds[index].Overlaps(bounds) && !fn(index)) return;
+            continue;
+        }
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+    }
+}
+
+template<typename Fn>
+void DynamicBvh::QuerySphere(const DirectX::XMFLOAT3& center, float radius, Fn&& fn) const
+{
+    const float radiusSquared = radius * radius;
+    NodeStack stack;
+    if (m_root != NullNode) stack.Push(m_root);
+    while (!stack.IsEmpty())
+    {
+        const int32_t index = stack.Pop();
+        const Node& node = m_nodes[index];
+        if (DistanceSquared(center, node.box) > radiusSquared) continue;
+
+        if (node.IsLeaf())
+        {
+            if (DistanceSquared(center, m_tightBounds[index]) <= radiusSquared && !fn(index)) return;
+            continue;
+        }
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+    }
+}
+
+template<typename Fn>
+void DynamicBvh::QueryFrustum(const Frustum& frustum, Fn&& fn) const
+{
+    NodeStack stack;
+    if (m_root != NullNode) stack.Push(m_root);
+    while (!stack.IsEmpty())
+    {
+        const int32_t index = stack.Pop();
+        const Node& node = m_nodes[index];
+        if (!frustum.Intersects(node.box.GetCenter(), node.box.GetExtents())) continue;
+
+        if (node.IsLeaf())
+        {
+            const Aabb& tight = m_tightBounds[index];
+            if (frustum.Intersects(tight.GetCenter(), tight.GetExtents()) && !fn(index)) return;
+            continue;
+        }
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+    }
+}
+
+template<typename Fn>
+void DynamicBvh::RayCast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance, Fn&& fn) const
+{
+    // Division by zero gives +-inf, which the slab test handles
+    const DirectX::XMFLOAT3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    NodeStack stack;
+    if (m_root != NullNode) stack.Push(m_root);
+    while (!stack.IsEmpty() && maxDistance > 0.0f)
+    {
+        const int32_t index = stack.Pop();
+        const Node& node = m_nodes[index];
+        float distance;
+        if (!RayHitsBox(origin, inverseDirection, node.box, maxDistance, distance)) continue;
+
+        if (node.IsLeaf())
+        {
+            if (RayHitsBox(origin, inverseDirection, m_tightBounds[index], maxDistance, distance))
+            {
+                maxDistance = fn(index, distance);
+            }
+            continue;
+        }
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+    }
+}
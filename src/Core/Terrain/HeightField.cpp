@@ -0,0 +1,299 @@
+#include "HeightField.h"
+#include "../Common/MappedFile.h"
+#include "../Jobs/JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+    {
+        return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+    }
+
+    // Offsets into a DDS file: magic, DDS_HEADER, then DDS_HEADER_DXT10 when the FourCC is 'DX10'
+    constexpr size_t DdsHeightOffset = 12;
+    constexpr size_t DdsWidthOffset = 16;
+    constexpr size_t DdsPixelFlagsOffset = 80;
+    constexpr size_t DdsFourCCOffset = 84;
+    constexpr size_t DdsBitCountOffset = 88;
+    constexpr size_t DdsMaskOffset = 92;  // R, G, B, A
+    constexpr size_t DdsDataOffset = 128;
+    constexpr size_t DdsDx10HeaderSize = 20;
+
+    constexpr uint32_t DdpfFourCC = 0x4;
+    constexpr uint32_t DdpfRgb = 0x40;
+    constexpr uint32_t DdpfLuminance = 0x20000;
+
+    // DXGI_FORMAT values of the DX10 extension that have a height channel
+    enum : uint32_t
+    {
+        DxgiR8G8B8A8Unorm = 28, DxgiR8G8B8A8UnormSrgb = 29, DxgiR32Float = 41, DxgiR16Unorm = 56, DxgiR8Unorm = 61,
+        DxgiBC1Unorm = 71, DxgiBC1UnormSrgb = 72, DxgiBC2Unorm = 74, DxgiBC2UnormSrgb = 75,
+        DxgiBC3Unorm = 77, DxgiBC3UnormSrgb = 78, DxgiBC4Unorm = 80,
+        DxgiB8G8R8A8Unorm = 87, DxgiB8G8R8A8UnormSrgb = 91,
+    };
+
+    enum class Encoding { Unknown, BC1, BC2, BC3, BC4, Masked, Float32 };
+
+    struct PixelFormat
+    {
+        Encoding encoding = Encoding::Unknown;
+        uint32_t bytesPerPixel = 0;     // Masked only
+        uint32_t masks[3] = {};         // Masked only; channels with a zero mask are skipped
+    };
+
+    uint32_t ReadU32(const uint8_t* data, size_t offset)
+    {
+        uint32_t value;
+        std::memcpy(&value, data + offset, sizeof(value));
+        return value;
+    }
+
+    PixelFormat FromDxgiFormat(uint32_t format)
+    {
+        PixelFormat result;
+        switch (format)
+        {
+        case DxgiBC1Unorm: case DxgiBC1UnormSrgb: result.encoding = Encoding::BC1; break;
+        case DxgiBC2Unorm: case DxgiBC2UnormSrgb: result.encoding = Encoding::BC2; break;
+        case DxgiBC3Unorm: case DxgiBC3UnormSrgb: result.encoding = Encoding::BC3; break;
+        case DxgiBC4Unorm: result.encoding = Encoding::BC4; break;
+        case DxgiR32Float: result.encoding = Encoding::Float32; break;
+        case DxgiR8Unorm: result = { Encoding::Masked, 1, { 0xff, 0, 0 } }; break;
+        case DxgiR16Unorm: result = { Encoding::Masked, 2, { 0xffff, 0, 0 } }; break;
+        case DxgiR8G8B8A8Unorm: case DxgiR8G8B8A8UnormSrgb: result = { Encoding::Masked, 4, { 0xff, 0xff00, 0xff0000 } }; break;
+        case DxgiB8G8R8A8Unorm: case DxgiB8G8R8A8UnormSrgb: result = { Encoding::Masked, 4, { 0xff0000, 0xff00, 0xff } }; break;
+        default: break;
+        }
+        return result;
+    }
+
+    PixelFormat FromLegacyHeader(const uint8_t* file)
+    {
+        PixelFormat result;
+        const uint32_t flags = ReadU32(file, DdsPixelFlagsOffset);
+        if (flags & DdpfFourCC)
+        {
+            switch (ReadU32(file, DdsFourCCOffset))
+            {
+            case MakeFourCC('D', 'X', 'T', '1'): result.encoding = Encoding::BC1; break;
+            case MakeFourCC('D', 'X', 'T', '2'): case MakeFourCC('D', 'X', 'T', '3'): result.encoding = Encoding::BC2; break;
+            case MakeFourCC('D', 'X', 'T', '4'): case MakeFourCC('D', 'X', 'T', '5'): result.encoding = Encoding::BC3; break;
+            case MakeFourCC('A', 'T', 'I', '1'): case MakeFourCC('B', 'C', '4', 'U'): result.encoding = Encoding::BC4; break;
+            case 114: result.encoding = Encoding::Float32; break; // D3DFMT_R32F
+            default: break;
+            }
+            return result;
+        }
+
+        const uint32_t bitCount = ReadU32(file, DdsBitCountOffset);
+        if (!(flags & (DdpfRgb | DdpfLuminance)) || bitCount % 8 != 0 || bitCount == 0 || bitCount > 32) return result;
+        result.encoding = Encoding::Masked;
+        result.bytesPerPixel = bitCount / 8;
+        result.masks[0] = ReadU32(file, DdsMaskOffset);
+        if (!(flags & DdpfLuminance))
+        {
+            result.masks[1] = ReadU32(file, DdsMaskOffset + 4);
+            result.masks[2] = ReadU32(file, DdsMaskOffset + 8);
+        }
+        if (result.masks[0] == 0 && result.masks[1] == 0 && result.masks[2] == 0) result.encoding = Encoding::Unknown;
+        return result;
+    }
+
+    // Colour endpoints become grey levels right away: interpolating them and then averaging the
+    // channels is the same as averaging first.
+    float Rgb565ToGrey(uint32_t color)
+    {
+        return ((color >> 11) / 31.0f + ((color >> 5) & 63) / 63.0f + (color & 31) / 31.0f) / 3.0f;
+    }
+
+    void DecodeColorBlock(const uint8_t* block, bool alwaysFourColors, float out[16])
+    {
+        const uint32_t c0 = block[0] | block[1] << 8;
+        const uint32_t c1 = block[2] | block[3] << 8;
+        float palette[4] = { Rgb565ToGrey(c0), Rgb565ToGrey(c1) };
+        if (c0 > c1 || alwaysFourColors)
+        {
+            palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+            palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+        }
+        else
+        {
+            // Three colours and transparent black
+            palette[2] = (palette[0] + palette[1]) * 0.5f;
+            palette[3] = 0.0f;
+        }
+
+        const uint32_t bits = ReadU32(block, 4);
+        for (uint32_t i = 0; i < 16; ++i)
+            out[i] = palette[(bits >> (2 * i)) & 3];
+    }
+
+    void DecodeBC4Block(const uint8_t* block, float out[16])
+    {
+        const float a0 = block[0] / 255.0f, a1 = block[1] / 255.0f;
+        float palette[8] = { a0, a1 };
+        if (block[0] > block[1])
+        {
+            for (uint32_t i = 1; i < 7; ++i)
+                palette[i + 1] = ((7 - i) * a0 + i * a1) / 7.0f;
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; ++i)
+                palette[i + 1] = ((5 - i) * a0 + i * a1) / 5.0f;
+            palette[6] = 0.0f;
+            palette[7] = 1.0f;
+        }
+
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 6; ++i)
+            bits |= uint64_t(block[2 + i]) << (8 * i);
+        for (uint32_t i = 0; i < 16; ++i)
+            out[i] = palette[(bits >> (3 * i)) & 7];
+    }
+
+    float DecodeMaskedPixel(const uint8_t* pixel, const PixelFormat& format)
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < format.bytesPerPixel; ++i)
+            value |= uint32_t(pixel[i]) << (8 * i);
+
+        float sum = 0.0f;
+        uint32_t channels = 0;
+        for (uint32_t mask : format.masks)
+        {
+            if (mask == 0) continue;
+            uint32_t shift = 0;
+            while (!((mask >> shift) & 1)) ++shift;
+            sum += float((value & mask) >> shift) / float(mask >> shift);
+            ++channels;
+        }
+        return sum / float(channels);
+    }
+
+    size_t GetImageSize(const PixelFormat& format, uint32_t width, uint32_t height)
+    {
+        const size_t blocks = size_t((width + 3) / 4) * ((height + 3) / 4);
+        switch (format.encoding)
+        {
+        case Encoding::BC1: case Encoding::BC4: return blocks * 8;
+        case Encoding::BC2: case Encoding::BC3: return blocks * 16;
+        case Encoding::Masked: return size_t(width) * height * format.bytesPerPixel;
+        case Encoding::Float32: return size_t(width) * height * sizeof(float);
+        default: return 0;
+        }
+    }
+}
+
+bool HeightField::LoadDds(const std::filesystem::path& path)
+{
+    MappedFile file;
+    if (!file.Open(path) || file.GetSize() < DdsDataOffset) return false;
+    const uint8_t* data = file.GetData();
+    if (ReadU32(data, 0) != MakeFourCC('D', 'D', 'S', ' ')) return false;
+
+    const uint32_t width = ReadU32(data, DdsWidthOffset);
+    const uint32_t height = ReadU32(data, DdsHeightOffset);
+    if (width == 0 || height == 0) return false;
+
+    PixelFormat format;
+    size_t dataOffset = DdsDataOffset;
+    if ((ReadU32(data, DdsPixelFlagsOffset) & DdpfFourCC) && ReadU32(data, DdsFourCCOffset) == MakeFourCC('D', 'X', '1', '0'))
+    {
+        if (file.GetSize() < DdsDataOffset + DdsDx10HeaderSize) return false;
+        format = FromDxgiFormat(ReadU32(data, DdsDataOffset));
+        dataOffset += DdsDx10HeaderSize;
+    }
+    else
+    {
+        format = FromLegacyHeader(data);
+    }
+
+    const size_t imageSize = GetImageSize(format, width, height);
+    if (imageSize == 0 || file.GetSize() - dataOffset < imageSize) return false;
+    const uint8_t* image = data + dataOffset;
+
+    std::vector<float> samples(size_t(width) * height);
+    float* out = samples.data();
+    if (format.encoding == Encoding::Masked || format.encoding == Encoding::Float32)
+    {
+        JobSystem::Get().ParallelFor(height, [&](size_t first, size_t last)
+        {
+            for (size_t y = first; y < last; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const size_t i = y * width + x;
+                    if (format.encoding == Encoding::Float32)
+                        std::memcpy(&out[i], image + i * sizeof(float), sizeof(float));
+                    else
+                        out[i] = DecodeMaskedPixel(image + i * format.bytesPerPixel, format);
+                }
+            }
+        });
+    }
+    else
+    {
+        // BC2 and BC3 keep alpha in the first 8 bytes and always use four colours
+        const uint32_t blockSize = format.encoding == Encoding::BC1 || format.encoding == Encoding::BC4 ? 8 : 16;
+        const uint32_t colorOffset = blockSize - 8;
+        const uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        JobSystem::Get().ParallelFor(blocksY, [&](size_t first, size_t last)
+        {
+            float texels[16];
+            for (size_t by = first; by < last; ++by)
+            {
+                for (uint32_t bx = 0; bx < blocksX; ++bx)
+                {
+                    const uint8_t* block = image + (by * blocksX + bx) * blockSize;
+                    if (format.encoding == Encoding::BC4)
+                        DecodeBC4Block(block, texels);
+                    else
+                        DecodeColorBlock(block + colorOffset, format.encoding != Encoding::BC1, texels);
+
+                    // Blocks on the right and bottom edges may hang over the image
+                    const uint32_t columns = std::min(4u, width - bx * 4);
+                    const uint32_t rows = std::min(4u, height - uint32_t(by) * 4);
+                    for (uint32_t row = 0; row < rows; ++row)
+                        std::memcpy(&out[(by * 4 + row) * width + bx * 4], &texels[row * 4], columns * sizeof(float));
+                }
+            }
+        });
+    }
+
+    SetSamples(width, height, std::move(samples));
+    return true;
+}
+
+void HeightField::SetSamples(uint32_t width, uint32_t height, std::vector<float> samples)
+{
+    m_width = width;
+    m_height = height;
+    m_samples = std::move(samples);
+    m_samples.resize(size_t(width) * height, 0.0f);
+}
+
+float HeightField::GetSample(int32_t x, int32_t y) const
+{
+    if (m_samples.empty()) return 0.0f;
+    x = std::clamp(x, 0, int32_t(m_width) - 1);
+    y = std::clamp(y, 0, int32_t(m_height) - 1);
+    return m_samples[size_t(y) * m_width + x];
+}
+
+float HeightField::Sample(float u, float v) const
+{
+    if (m_samples.empty()) return 0.0f;
+    const float x = std::clamp(u, 0.0f, 1.0f) * float(m_width - 1);
+    const float y = std::clamp(v, 0.0f, 1.0f) * float(m_height - 1);
+    const float x0 = std::floor(x), y0 = std::floor(y);
+    const float fx = x - x0, fy = y - y0;
+    const int32_t ix = int32_t(x0), iy = int32_t(y0);
+
+    const float top = GetSample(ix, iy) + (GetSample(ix + 1, iy) - GetSample(ix, iy)) * fx;
+    const float bottom = GetSample(ix, iy + 1) + (GetSample(ix + 1, iy + 1) - GetSample(ix, iy + 1)) * fx;
+    return top + (bottom - top) * fy;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Grid of heights in [0, 1] read from a heightmap texture on the CPU.
+class HeightField
+{
+public:
+    // Decodes the top mip of a 2D DDS file: BC1, BC2, BC3 and BC4 blocks, 8/16-bit luminance,
+    // 32-bit RGB(A) and the DX10 R8/R16/R32_FLOAT formats. Colour texels become the mean of
+    // their channels, so grey heightmaps keep all the precision the format has.
+    // false if the file cannot be read or the format is not one of the above.
+    bool LoadDds(const std::filesystem::path& path);
+
+    // Takes width * height samples, row by row, for generated terrain
+    void SetSamples(uint32_t width, uint32_t height, std::vector<float> samples);
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+    const std::vector<float>& GetSamples() const { return m_samples; }
+
+    // Texel lookup with coordinates clamped to the edges
+    float GetSample(int32_t x, int32_t y) const;
+    // Bilinear sample; (0, 0) is the center of the first texel and (1, 1) the center of the last
+    float Sample(float u, float v) const;
+
+private:
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    std::vector<float> m_samples;
+};
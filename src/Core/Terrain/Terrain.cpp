@@ -0,0 +1,343 @@
+#include "Terrain.h"
+#include "HeightField.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+using Vertex = GeometryGenerator::Vertex;
+
+namespace
+{
+    constexpr uint32_t MaxChunkQuads = 128; // (128 + 1)^2 grid vertices plus skirts fit 16-bit indices
+    constexpr uint32_t MaxLevelCount = 10;
+
+    float DistanceToBounds(const Aabb& bounds, const XMFLOAT3& point)
+    {
+        const float dx = std::max({ bounds.min.x - point.x, 0.0f, point.x - bounds.max.x });
+        const float dy = std::max({ bounds.min.y - point.y, 0.0f, point.y - bounds.max.y });
+        const float dz = std::max({ bounds.min.z - point.z, 0.0f, point.z - bounds.max.z });
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    XMFLOAT3 Normalize(float x, float y, float z)
+    {
+        const float length = std::sqrt(x * x + y * y + z * z);
+        return XMFLOAT3(x / length, y / length, z / length);
+    }
+}
+
+Terrain::~Terrain()
+{
+    WaitForChunks();
+}
+
+void Terrain::Build(const HeightField& heightField, const TerrainSettings& settings)
+{
+    WaitForChunks();
+
+    // Children only line up with their parent's vertices for power-of-two chunk sizes
+    m_settings = settings;
+    m_settings.chunkQuads = 2;
+    while (m_settings.chunkQuads < std::min(settings.chunkQuads, MaxChunkQuads)) m_settings.chunkQuads *= 2;
+    m_settings.levelCount = std::clamp(settings.levelCount, 1u, MaxLevelCount);
+    m_gridQuads = m_settings.chunkQuads << (m_settings.levelCount - 1);
+    m_cellSize = m_settings.size / float(m_gridQuads);
+
+    const uint32_t side = m_gridQuads + 1;
+    const float step = 1.0f / float(m_gridQuads);
+    m_heights.resize(size_t(side) * side);
+    JobSystem::Get().ParallelFor(side, [&](size_t first, size_t last)
+    {
+        for (size_t row = first; row < last; ++row)
+        {
+            for (uint32_t column = 0; column < side; ++column)
+                m_heights[row * side + column] = heightField.Sample(column * step, row * step) * m_settings.heightScale;
+        }
+    });
+
+    ComputeNodes();
+    BuildIndices();
+    m_chunks = std::make_unique<Chunk[]>(m_nodes.size());
+    m_frame = 0;
+}
+
+float Terrain::GetHeight(float x, float z) const
+{
+    if (m_heights.empty()) return 0.0f;
+    const float half = m_settings.size * 0.5f;
+    const float column = std::clamp((x + half) / m_cellSize, 0.0f, float(m_gridQuads));
+    const float row = std::clamp((half - z) / m_cellSize, 0.0f, float(m_gridQuads));
+    return InterpolateHeight(column, row, 1);
+}
+
+uint32_t Terrain::GetChild(uint32_t node, uint32_t i) const
+{
+    const Node& parent = m_nodes[node];
+    const uint32_t level = parent.level + 1;
+    const uint32_t x = parent.x * 2 + (i & 1);
+    const uint32_t z = parent.z * 2 + (i >> 1);
+    return GetLevelOffset(level) + (z << level) + x;
+}
+
+float Terrain::InterpolateHeight(float column, float row, uint32_t stride) const
+{
+    const float lastCell = float(m_gridQuads / stride - 1);
+    const float x = column / float(stride), z = row / float(stride);
+    const float cellX = std::clamp(std::floor(x), 0.0f, lastCell);
+    const float cellZ = std::clamp(std::floor(z), 0.0f, lastCell);
+    const float fx = x - cellX, fz = z - cellZ;
+
+    const uint32_t c0 = uint32_t(cellX) * stride, r0 = uint32_t(cellZ) * stride;
+    const float h00 = GetGridHeight(c0, r0);
+    const float h10 = GetGridHeight(c0 + stride, r0);
+    const float h01 = GetGridHeight(c0, r0 + stride);
+    const float h11 = GetGridHeight(c0 + stride, r0 + stride);
+
+    // Split along the same diagonal as the index buffer, from (c0 + stride, r0) to (c0, r0 + stride)
+    if (fx + fz <= 1.0f) return h00 + (h10 - h00) * fx + (h01 - h00) * fz;
+    return h11 + (h01 - h11) * (1.0f - fx) + (h10 - h11) * (1.0f - fz);
+}
+
+void Terrain::ComputeNodes()
+{
+    const uint32_t levelCount = m_settings.levelCount;
+    m_nodes.assign(GetLevelOffset(levelCount), Node());
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        const uint32_t count = 1u << level;
+        for (uint32_t z = 0; z < count; ++z)
+        {
+            for (uint32_t x = 0; x < count; ++x)
+            {
+                Node& node = m_nodes[GetLevelOffset(level) + (z << level) + x];
+                node.level = level;
+                node.x = x;
+                node.z = z;
+            }
+        }
+    }
+
+    // Height range and error against every fine sample under the node. Each level reads the whole
+    // grid once; the finest level samples it exactly and has no error.
+    const float half = m_settings.size * 0.5f;
+    JobSystem::Get().ParallelFor(m_nodes.size(), [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            Node& node = m_nodes[i];
+            const uint32_t span = m_gridQuads >> node.level;
+            const uint32_t stride = span / m_settings.chunkQuads;
+            const uint32_t c0 = node.x * span, r0 = node.z * span;
+
+            float low = FLT_MAX, high = -FLT_MAX, error = 0.0f;
+            for (uint32_t row = r0; row <= r0 + span; ++row)
+            {
+                for (uint32_t column = c0; column <= c0 + span; ++column)
+                {
+                    const float height = GetGridHeight(column, row);
+                    low = std::min(low, height);
+                    high = std::max(high, height);
+                    if (stride > 1)
+                        error = std::max(error, std::fabs(height - InterpolateHeight(float(column), float(row), stride)));
+                }
+            }
+
+            node.error = error;
+            node.bounds.min = XMFLOAT3(-half + c0 * m_cellSize, low, half - (r0 + span) * m_cellSize);
+            node.bounds.max = XMFLOAT3(-half + (c0 + span) * m_cellSize, high, half - r0 * m_cellSize);
+        }
+    }, 1);
+
+    // The selector expects errors that never shrink towards the root
+    std::vector<float> levelErrors(levelCount, 0.0f);
+    for (uint32_t level = levelCount; level-- > 0;)
+    {
+        const uint32_t begin = GetLevelOffset(level), end = GetLevelOffset(level + 1);
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            Node& node = m_nodes[i];
+            if (level + 1 < levelCount)
+            {
+                for (uint32_t child = 0; child < 4; ++child)
+                    node.error = std::max(node.error, m_nodes[GetChild(i, child)].error);
+            }
+            levelErrors[level] = std::max(levelErrors[level], node.error);
+        }
+    }
+
+    // Neighbours one level apart leave gaps of at most the sum of their errors. At least one fine
+    // cell deep so that T-junctions between levels never show through.
+    for (Node& node : m_nodes)
+    {
+        const float coarserError = levelErrors[node.level > 0 ? node.level - 1 : 0];
+        node.skirtDepth = std::max(levelErrors[node.level] + coarserError, m_cellSize);
+        node.bounds.min.y -= node.skirtDepth;
+    }
+}
+
+void Terrain::BuildIndices()
+{
+    const uint32_t quads = m_settings.chunkQuads, side = quads + 1;
+    m_indices.clear();
+    m_indices.reserve(6 * quads * quads + 4 * 6 * quads);
+
+    // Same triangulation as GeometryGenerator::CreateGrid and InterpolateHeight
+    for (uint32_t i = 0; i < quads; ++i)
+    {
+        for (uint32_t j = 0; j < quads; ++j)
+        {
+            const uint16_t a = uint16_t(i * side + j), b = uint16_t(a + 1);
+            const uint16_t c = uint16_t(a + side), d = uint16_t(c + 1);
+            m_indices.insert(m_indices.end(), { a, b, c, c, b, d });
+        }
+    }
+
+    // Skirts face away from the chunk, so the top edge runs -x on the north side, +x on the south,
+    // -z on the west and +z on the east
+    const auto addQuad = [&](uint32_t top0, uint32_t top1, uint32_t bottom0, uint32_t bottom1)
+    {
+        m_indices.insert(m_indices.end(), { uint16_t(top0), uint16_t(top1), uint16_t(bottom0),
+                                            uint16_t(bottom0), uint16_t(top1), uint16_t(bottom1) });
+    };
+    const uint32_t north = side * side, south = north + side, west = south + side, east = west + side;
+    for (uint32_t t = 0; t < quads; ++t)
+    {
+        addQuad(t + 1, t, north + t + 1, north + t);
+        addQuad(quads * side + t, quads * side + t + 1, south + t, south + t + 1);
+        addQuad(t * side, (t + 1) * side, west + t, west + t + 1);
+        addQuad((t + 1) * side + quads, t * side + quads, east + t + 1, east + t);
+    }
+}
+
+void Terrain::BuildChunk(uint32_t index, std::vector<Vertex>& vertices) const
+{
+    const Node& node = m_nodes[index];
+    const uint32_t quads = m_settings.chunkQuads, side = quads + 1;
+    const uint32_t span = m_gridQuads >> node.level, stride = span / quads;
+    const uint32_t c0 = node.x * span, r0 = node.z * span;
+    const float half = m_settings.size * 0.5f;
+    const float step = 1.0f / float(m_gridQuads);
+
+    vertices.resize(size_t(side) * side + 4 * side);
+    for (uint32_t i = 0; i < side; ++i)
+    {
+        const uint32_t row = r0 + i * stride;
+        const uint32_t up = row >= stride ? row - stride : row;
+        const uint32_t down = std::min(row + stride, m_gridQuads);
+        for (uint32_t j = 0; j < side; ++j)
+        {
+            const uint32_t column = c0 + j * stride;
+            const uint32_t left = column >= stride ? column - stride : column;
+            const uint32_t right = std::min(column + stride, m_gridQuads);
+
+            // Slopes over the chunk's own spacing, so coarse chunks are lit like the surface they show
+            const float slopeX = (GetGridHeight(right, row) - GetGridHeight(left, row)) / ((right - left) * m_cellSize);
+            const float slopeZ = (GetGridHeight(column, up) - GetGridHeight(column, down)) / ((down - up) * m_cellSize);
+
+            Vertex& vertex = vertices[i * side + j];
+            vertex.Position = XMFLOAT3(-half + column * m_cellSize, GetGridHeight(column, row), half - row * m_cellSize);
+            vertex.Normal = Normalize(-slopeX, 1.0f, -slopeZ);
+            vertex.TangentU = Normalize(1.0f, slopeX, 0.0f);
+            vertex.TexC = XMFLOAT2(column * step, row * step);
+        }
+    }
+
+    // North, south, west and east edges, each dropped by the skirt depth
+    Vertex* skirt = vertices.data() + size_t(side) * side;
+    for (uint32_t t = 0; t < side; ++t)
+    {
+        skirt[t] = vertices[t];
+        skirt[side + t] = vertices[quads * side + t];
+        skirt[2 * side + t] = vertices[t * side];
+        skirt[3 * side + t] = vertices[t * side + quads];
+    }
+    for (uint32_t i = 0; i < 4 * side; ++i)
+        skirt[i].Position.y -= node.skirtDepth;
+}
+
+bool Terrain::IsChunkReady(uint32_t node) const
+{
+    return m_chunks[node].state.load(std::memory_order_acquire) == ChunkReady;
+}
+
+bool Terrain::RequestChunk(uint32_t node)
+{
+    Chunk& chunk = m_chunks[node];
+    const uint8_t state = chunk.state.load(std::memory_order_acquire);
+    if (state == ChunkReady) return true;
+    if (state == ChunkEmpty)
+    {
+        // Only Select moves chunks out of ChunkEmpty, so no other thread races this
+        chunk.state.store(ChunkPending, std::memory_order_relaxed);
+        JobSystem::Get().Run([this, node]()
+        {
+            Chunk& target = m_chunks[node];
+            BuildChunk(node, target.vertices);
+            target.state.store(ChunkReady, std::memory_order_release);
+        }, m_jobs);
+    }
+    return false;
+}
+
+void Terrain::Select(const Frustum& frustum, const XMFLOAT3& eye, const LodSelector& selector, std::vector<uint32_t>& outNodes)
+{
+    ++m_frame;
+    if (!m_nodes.empty()) SelectNode(0, frustum, eye, selector, outNodes);
+}
+
+void Terrain::SelectNode(uint32_t node, const Frustum& frustum, const XMFLOAT3& eye,
+                         const LodSelector& selector, std::vector<uint32_t>& outNodes)
+{
+    const Node& info = m_nodes[node];
+    if (!frustum.Intersects(info.bounds.GetCenter(), info.bounds.GetExtents())) return;
+
+    // The node stays resident while its children draw, as the fallback when one of them is released
+    Chunk& chunk = m_chunks[node];
+    chunk.lastUsedFrame = m_frame;
+    const bool ready = RequestChunk(node);
+
+    if (info.level + 1 < m_settings.levelCount)
+    {
+        const float error = selector.GetProjectedError(info.error, DistanceToBounds(info.bounds, eye));
+        const float threshold = chunk.split ? selector.GetCoarsenThreshold() : selector.GetRefineThreshold();
+        if (error > threshold)
+        {
+            bool childrenReady = true;
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                const uint32_t child = GetChild(node, i);
+                m_chunks[child].lastUsedFrame = m_frame;
+                childrenReady &= RequestChunk(child);
+            }
+
+            if (childrenReady)
+            {
+                chunk.split = true;
+                for (uint32_t i = 0; i < 4; ++i)
+                    SelectNode(GetChild(node, i), frustum, eye, selector, outNodes);
+                return;
+            }
+        }
+    }
+
+    chunk.split = false;
+    if (ready) outNodes.push_back(node);
+}
+
+void Terrain::ReleaseChunks(uint32_t unusedFrames)
+{
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+        Chunk& chunk = m_chunks[i];
+        if (chunk.state.load(std::memory_order_acquire) != ChunkReady || m_frame - chunk.lastUsedFrame <= unusedFrames) continue;
+        std::vector<Vertex>().swap(chunk.vertices);
+        chunk.split = false;
+        chunk.state.store(ChunkEmpty, std::memory_order_relaxed);
+    }
+}
+
+void Terrain::WaitForChunks()
+{
+    if (!m_jobs.IsDone()) JobSystem::Get().Wait(m_jobs);
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <DirectXMath.h>
+#include "../Common/GeometryGenerator.h"
+#include "../Jobs/JobSystem.h"
+#include "../Rendering/FrustumCulling.h"
+#include "../Rendering/LodSelection.h"
+#include "../Spatial/DynamicBvh.h"
+
+class HeightField;
+
+struct TerrainSettings
+{
+    float size = 512.0f;        // Extent along x and z; the terrain is centered on the origin
+    float heightScale = 64.0f;  // World height of a height field sample of 1
+    uint32_t chunkQuads = 32;   // Quads along a chunk edge at every level, a power of two up to 128
+    uint32_t levelCount = 5;    // Quadtree depth; the finest level has chunkQuads << (levelCount - 1) quads along an edge
+};
+
+// Heightmap terrain drawn as a quadtree of chunks (chunked LOD, Ulrich, "Rendering Massive Terrains
+// using Chunked Level of Detail Control", 2002).
+//   - Every node is a grid of the same (chunkQuads + 1)^2 vertices, so all chunks share one 16-bit
+//     index buffer; a child covers a quarter of its parent at twice the density.
+//   - A node's error is the largest vertical distance between its surface and the finest level, so
+//     nodes are refined through the same LodSelector as meshes, with the same hysteresis.
+//   - Cracks where neighbours differ in level are covered by skirts, vertical strips hanging below the
+//     chunk edges. They are deep enough for neighbours one level apart, which distance-based selection
+//     almost always produces.
+//   - Chunk vertices are generated by jobs the first time a node is needed. A node keeps drawing
+//     itself until all four children are ready, and nodes on the path to drawn chunks stay resident,
+//     so the terrain never has holes while streaming.
+// Rows of the grid run from +z to -z and columns from -x to +x, matching GeometryGenerator::CreateGrid;
+// texture coordinates span [0, 1] over the whole terrain.
+class Terrain
+{
+public:
+    Terrain() = default;
+    ~Terrain();
+
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    // Samples the height field onto the finest grid and computes the bounds and errors of every
+    // node. Chunk geometry from an earlier build is dropped.
+    void Build(const HeightField& heightField, const TerrainSettings& settings);
+
+    const TerrainSettings& GetSettings() const { return m_settings; }
+    // Height of the finest level's surface at a world position, clamped to the terrain
+    float GetHeight(float x, float z) const;
+
+    // Nodes are stored level by level, root first; the children of node (level, x, z) are
+    // (level + 1, 2x + i, 2z + j).
+    uint32_t GetNodeCount() const { return uint32_t(m_nodes.size()); }
+    uint32_t GetNodeLevel(uint32_t node) const { return m_nodes[node].level; }
+    // Includes the skirts; use its center and extents with Frustum::Intersects or FrustumCuller
+    const Aabb& GetNodeBounds(uint32_t node) const { return m_nodes[node].bounds; }
+    float GetNodeError(uint32_t node) const { return m_nodes[node].error; }
+
+    // Appends the nodes to draw this frame to outNodes: visible in the frustum, with ready geometry,
+    // and refined until their projected error is under the selector's threshold. Requests missing
+    // chunks on the way.
+    void Select(const Frustum& frustum, const DirectX::XMFLOAT3& eye, const LodSelector& selector,
+                std::vector<uint32_t>& outNodes);
+
+    // Chunks drawn by Select are always ready; their vertices do not change until ReleaseChunks.
+    bool IsChunkReady(uint32_t node) const;
+    const std::vector<GeometryGenerator::Vertex>& GetChunkVertices(uint32_t node) const { return m_chunks[node].vertices; }
+    // Vertices are the grid row by row, then one row per skirt. The index buffer is shared by every
+    // chunk: two triangles per quad, then the skirts.
+    const std::vector<uint16_t>& GetChunkIndices() const { return m_indices; }
+
+    // Frees the vertices of chunks Select has not touched for more than unusedFrames calls
+    void ReleaseChunks(uint32_t unusedFrames);
+    // Blocks until every requested chunk is ready
+    void WaitForChunks();
+
+private:
+    struct Node
+    {
+        Aabb bounds;
+        float error = 0.0f;
+        float skirtDepth = 0.0f;
+        uint32_t level = 0;
+        uint32_t x = 0; // Position among the nodes of its level
+        uint32_t z = 0;
+    };
+
+    enum ChunkState : uint8_t { ChunkEmpty, ChunkPending, ChunkReady };
+
+    struct Chunk
+    {
+        std::vector<GeometryGenerator::Vertex> vertices;
+        std::atomic<uint8_t> state{ ChunkEmpty };
+        uint32_t lastUsedFrame = 0;
+        bool split = false; // Drawn through its children last frame; refines with hysteresis
+    };
+
+    static uint32_t GetLevelOffset(uint32_t level) { return ((1u << (2 * level)) - 1) / 3; }
+    uint32_t GetChild(uint32_t node, uint32_t i) const;
+
+    float GetGridHeight(uint32_t column, uint32_t row) const { return m_heights[size_t(row) * (m_gridQuads + 1) + column]; }
+    // Height of the triangulated grid with vertices every stride samples, at fine grid coordinates
+    float InterpolateHeight(float column, float row, uint32_t stride) const;
+
+    void ComputeNodes();
+    void BuildIndices();
+    void BuildChunk(uint32_t node, std::vector<GeometryGenerator::Vertex>& vertices) const;
+    // true if the chunk is ready, otherwise starts generating it
+    bool RequestChunk(uint32_t node);
+    void SelectNode(uint32_t node, const Frustum& frustum, const DirectX::XMFLOAT3& eye,
+                    const LodSelector& selector, std::vector<uint32_t>& outNodes);
+
+    TerrainSettings m_settings;
+    uint32_t m_gridQuads = 0; // Quads along an edge of the finest level
+    float m_cellSize = 0.0f;  // World size of one of those quads
+    std::vector<float> m_heights; // (m_gridQuads + 1)^2 world heights, row by row
+    std::vector<Node> m_nodes;
+    std::unique_ptr<Chunk[]> m_chunks;
+    std::vector<uint16_t> m_indices;
+    uint32_t m_frame = 0;
+    JobCounter m_jobs;
+};
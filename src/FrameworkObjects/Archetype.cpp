@@ -0,0 +1,149 @@
+#include "Archetype.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+Archetype::Archetype(std::vector<const ComponentTypeInfo*> componentTypes)
+    : types(std::move(componentTypes))
+{
+    std::sort(types.begin(), types.end(),
+              [](const ComponentTypeInfo* a, const ComponentTypeInfo* b) { return a->id < b->id; });
+    columnByType.fill(-1);
+    for (size_t column = 0; column < types.size(); ++column)
+    {
+        assert(types[column]->alignment <= ChunkAlignment);
+        mask.set(types[column]->id);
+        columnByType[types[column]->id] = static_cast<int16_t>(column);
+    }
+
+    // Подбираем максимальную ёмкость чанка, при которой все колонки с выравниванием влезают в ChunkByteSize.
+    // Строка больше ChunkByteSize получает чанк на одну строку увеличенного размера.
+    size_t bytesPerRow = sizeof(Entity);
+    for (const auto* info : types) bytesPerRow += info->size;
+
+    chunkCapacity = static_cast<uint32_t>(std::max<size_t>(ChunkByteSize / bytesPerRow, 1));
+    columnOffsets.resize(types.size());
+    for (;;)
+    {
+        size_t offset = sizeof(Entity) * chunkCapacity;
+        for (size_t i = 0; i < types.size(); ++i)
+        {
+            offset = AlignUp(offset, types[i]->alignment);
+            columnOffsets[i] = offset;
+            offset += types[i]->size * chunkCapacity;
+        }
+        if (offset <= ChunkByteSize || chunkCapacity == 1)
+        {
+            chunkByteSize = std::max(ChunkByteSize, AlignUp(offset, ChunkAlignment));
+            break;
+        }
+        --chunkCapacity;
+    }
+}
+
+Archetype::~Archetype()
+{
+    for (uint32_t row = 0; row < size; ++row)
+    {
+        for (size_t column = 0; column < types.size(); ++column)
+        {
+            types[column]->destroy(GetComponent(row, column));
+        }
+    }
+    for (auto* chunk : chunks)
+    {
+        ::operator delete(chunk, std::align_val_t{ ChunkAlignment });
+    }
+}
+
+uint32_t Archetype::GetChunkSize(size_t chunk) const
+{
+    uint32_t first = static_cast<uint32_t>(chunk) * chunkCapacity;
+    return std::min(size - first, chunkCapacity);
+}
+
+void* Archetype::GetComponent(uint32_t row, size_t column) const
+{
+    return chunks[row / chunkCapacity] + columnOffsets[column] + types[column]->size * (row % chunkCapacity);
+}
+
+Entity Archetype::GetEntity(uint32_t row) const
+{
+    return GetEntities(row / chunkCapacity)[row % chunkCapacity];
+}
+
+uint32_t Archetype::Allocate(Entity entity)
+{
+    if (size == chunks.size() * chunkCapacity)
+    {
+        chunks.push_back(AllocateChunk());
+    }
+    uint32_t row = size++;
+    reinterpret_cast<Entity*>(chunks[row / chunkCapacity])[row % chunkCapacity] = entity;
+    return row;
+}
+
+Entity Archetype::Remove(uint32_t row)
+{
+    assert(row < size);
+    for (size_t column = 0; column < types.size(); ++column)
+    {
+        types[column]->destroy(GetComponent(row, column));
+    }
+    return FillHole(row);
+}
+
+Entity Archetype::MoveTo(uint32_t row, Archetype& target, uint32_t& targetRow)
+{
+    assert(row < size);
+    targetRow = target.Allocate(GetEntity(row));
+    for (size_t column = 0; column < types.size(); ++column)
+    {
+        int targetColumn = target.GetColumnIndex(types[column]->id);
+        if (targetColumn >= 0)
+        {
+            types[column]->moveConstruct(target.GetComponent(targetRow, targetColumn), GetComponent(row, column));
+        }
+        else
+        {
+            types[column]->destroy(GetComponent(row, column));
+        }
+    }
+    return FillHole(row);
+}
+
+Entity Archetype::FillHole(uint32_t row)
+{
+    // Компоненты строки row уже разрушены или перенесены; переносим на их место последнюю строку
+    uint32_t last = size - 1;
+    Entity moved;
+    if (row != last)
+    {
+        for (size_t column = 0; column < types.size(); ++column)
+        {
+            types[column]->moveConstruct(GetComponent(row, column), GetComponent(last, column));
+        }
+        moved = GetEntity(last);
+        reinterpret_cast<Entity*>(chunks[row / chunkCapacity])[row % chunkCapacity] = moved;
+    }
+    --size;
+
+    if (size == (chunks.size() - 1) * chunkCapacity)
+    {
+        ::operator delete(chunks.back(), std::align_val_t{ ChunkAlignment });
+        chunks.pop_back();
+    }
+    return moved;
+}
+
+std::byte* Archetype::AllocateChunk()
+{
+    return static_cast<std::byte*>(::operator new(chunkByteSize, std::align_val_t{ ChunkAlignment }));
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ComponentType.h"
+#include "Entity.h"
+
+// Архетип - хранилище всех сущностей с одинаковым набором типов компонентов.
+// Данные лежат в чанках фиксированного размера в виде SoA: в начале чанка массив Entity,
+// затем по одному плотному массиву на каждый тип компонента.
+// Строки нумеруются сквозным образом: row / capacity - номер чанка, row % capacity - слот в нём.
+class Archetype
+{
+public:
+    static constexpr size_t ChunkByteSize = 16 * 1024;
+    static constexpr size_t ChunkAlignment = 64;
+
+    explicit Archetype(std::vector<const ComponentTypeInfo*> componentTypes);
+    ~Archetype();
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    const std::vector<const ComponentTypeInfo*>& GetTypes() const { return types; }
+    const ComponentMask& GetMask() const { return mask; }
+    int GetColumnIndex(ComponentTypeId type) const { return columnByType[type]; }
+    bool HasType(ComponentTypeId type) const { return mask.test(type); }
+
+    uint32_t GetSize() const { return size; }
+    uint32_t GetChunkCapacity() const { return chunkCapacity; }
+    // ChunkByteSize, либо больше, если одна строка в него не влезает
+    size_t GetChunkByteSize() const { return chunkByteSize; }
+    size_t GetChunkCount() const { return chunks.size(); }
+    uint32_t GetChunkSize(size_t chunk) const;
+
+    const Entity* GetEntities(size_t chunk) const { return reinterpret_cast<const Entity*>(chunks[chunk]); }
+    void* GetColumn(size_t chunk, size_t column) const { return chunks[chunk] + columnOffsets[column]; }
+    void* GetComponent(uint32_t row, size_t column) const;
+    Entity GetEntity(uint32_t row) const;
+
+    // Выделяет строку в конце хранилища. Память компонентов не инициализирована.
+    uint32_t Allocate(Entity entity);
+    // Разрушает компоненты строки и закрывает дыру последней строкой.
+    // Возвращает сущность, переехавшую в row (или пустую, если row была последней).
+    Entity Remove(uint32_t row);
+    // Переносит общие компоненты строки в target, остальные разрушает.
+    Entity MoveTo(uint32_t row, Archetype& target, uint32_t& targetRow);
+
+    // Кэш переходов между архетипами при добавлении/удалении одного компонента
+    std::array<Archetype*, MaxComponentTypes> addEdges{};
+    std::array<Archetype*, MaxComponentTypes> removeEdges{};
+
+private:
+    Entity FillHole(uint32_t row);
+    std::byte* AllocateChunk();
+
+    std::vector<const ComponentTypeInfo*> types;
+    ComponentMask mask;
+    std::array<int16_t, MaxComponentTypes> columnByType;
+    std::vector<size_t> columnOffsets;
+    std::vector<std::byte*> chunks;
+    uint32_t chunkCapacity = 0;
+    size_t chunkByteSize = ChunkByteSize;
+    uint32_t size = 0;
+};
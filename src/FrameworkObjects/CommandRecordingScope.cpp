@@ -0,0 +1,40 @@
+#include "CommandRecordingScope.h"
+
+namespace
+{
+    // system == 0 - поток вне систем
+    thread_local CommandOrigin t_origin;
+}
+
+CommandRecordingScope::CommandRecordingScope(uint32_t systemIndex)
+    : savedOrigin(t_origin)
+{
+    t_origin = CommandOrigin{ systemIndex + 1, 0, 0, 0 };
+}
+
+CommandRecordingScope::CommandRecordingScope(const CommandOrigin& parallel, uint32_t chunkIndex)
+    : savedOrigin(t_origin)
+{
+    // Обход вне систем: команды чанков идут в порядке записи, как и остальные команды вне систем
+    t_origin = parallel.system != 0 ? CommandOrigin{ parallel.system, parallel.step, chunkIndex + 1, 0 } : CommandOrigin{};
+}
+
+CommandRecordingScope::~CommandRecordingScope()
+{
+    t_origin = savedOrigin;
+}
+
+CommandOrigin CommandRecordingScope::Next()
+{
+    const CommandOrigin origin = t_origin;
+    if (origin.system == 0) return origin;
+
+    if (origin.chunk == 0) ++t_origin.step;
+    else ++t_origin.sequence;
+    return origin;
+}
+
+bool CommandRecordingScope::IsInChunk()
+{
+    return t_origin.chunk != 0;
+}
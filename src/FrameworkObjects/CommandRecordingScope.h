@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+// Место записи команды SceneCommandBuffer. Playback применяет команды в порядке мест записи, а не
+// в порядке прихода, поэтому команды параллельно работающих систем применяются одинаково при любом
+// числе потоков: по номеру системы в планировщике, затем по шагам внутри системы (каждая команда
+// самой системы и каждый ForEachParallel - отдельный шаг), затем по чанкам обхода и по порядку
+// записи внутри чанка.
+struct CommandOrigin
+{
+    uint32_t system = 0;   // Номер системы + 1; 0 - команда записана вне систем
+    uint32_t step = 0;     // Для команд вне систем - порядковый номер в буфере
+    uint32_t chunk = 0;    // Номер чанка ForEachParallel + 1; 0 - вне обхода
+    uint32_t sequence = 0; // Порядок записи внутри чанка
+
+    bool operator<(const CommandOrigin& other) const
+    {
+        if (system != other.system) return system < other.system;
+        if (step != other.step) return step < other.step;
+        if (chunk != other.chunk) return chunk < other.chunk;
+        return sequence < other.sequence;
+    }
+};
+
+// Задаёт место записи команд текущего потока до конца области видимости. Области ставят
+// SystemScheduler на время System::Update и Scene::ForEachParallel на время обработки чанка.
+// Задачи, которые система запускает через JobSystem сама, должны открыть область чанка
+// (BeginParallel + номер задачи), иначе их команды попадут в место записи выполнившего их потока.
+class CommandRecordingScope
+{
+public:
+    // Команды системы с номером systemIndex в планировщике
+    explicit CommandRecordingScope(uint32_t systemIndex);
+    // Команды чанка chunkIndex обхода, для которого BeginParallel вернул parallel
+    CommandRecordingScope(const CommandOrigin& parallel, uint32_t chunkIndex);
+    ~CommandRecordingScope();
+
+    CommandRecordingScope(const CommandRecordingScope&) = delete;
+    CommandRecordingScope& operator=(const CommandRecordingScope&) = delete;
+
+    // Место очередной команды текущего потока; system == 0, если поток вне систем
+    static CommandOrigin Next();
+    // Отводит шаг под параллельный обход; его чанки открывают области с полученным местом
+    static CommandOrigin BeginParallel() { return Next(); }
+    // Поток обрабатывает чанк обхода: вложенный обход не может получить свои шаги
+    static bool IsInChunk();
+
+private:
+    CommandOrigin savedOrigin;
+};
@@ -1,12 +1,11 @@
 #pragma once
-#include <string>
 
 // Абстрактный базовый класс Component
 class Component
 {
 public:
     virtual ~Component() = default;
-    virtual std::string GetType() const { return "Component"; }
+    virtual const char* GetType() const { return "Component"; }
     bool IsEnabled() const { return enabled; }
     void SetEnabled(bool value) { enabled = value; }
 
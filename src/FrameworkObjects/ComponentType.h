@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Component.h"
+#include "IUpdatable.h"
+#include "RendererComponent.h"
+
+// Плотный целочисленный идентификатор типа компонента: индекс в массивах и бит в ComponentMask
+using ComponentTypeId = uint32_t;
+constexpr size_t MaxComponentTypes = 64;
+using ComponentMask = std::bitset<MaxComponentTypes>;
+
+inline ComponentTypeId NextComponentTypeId()
+{
+    static std::atomic<ComponentTypeId> counter{ 0 };
+    ComponentTypeId id = counter.fetch_add(1, std::memory_order_relaxed);
+    assert(id < MaxComponentTypes && "Increase MaxComponentTypes");
+    return id;
+}
+
+// Идентификатор выдаётся один раз при первом обращении к типу, без RTTI и строк
+template<typename T>
+ComponentTypeId GetComponentTypeId()
+{
+    static const ComponentTypeId id = NextComponentTypeId();
+    return id;
+}
+
+// Описание типа компонента для хранилища архетипов: размер, выравнивание
+// и набор функций для работы с компонентом без знания его типа.
+struct ComponentTypeInfo
+{
+    ComponentTypeId id;
+    size_t size;
+    size_t alignment;
+
+    // Перемещает компонент из src в неинициализированную память dst и разрушает src
+    void (*moveConstruct)(void* dst, void* src);
+    void (*destroy)(void* component);
+    // Обновляет count подряд лежащих компонентов; nullptr, если тип не IUpdatable
+    void (*update)(void* components, size_t count, float deltaTime);
+    // nullptr, если тип не RendererComponent
+    RendererComponent* (*asRenderer)(void* component);
+
+    template<typename T>
+    static const ComponentTypeInfo& Get();
+};
+
+template<typename T>
+const ComponentTypeInfo& ComponentTypeInfo::Get()
+{
+    static_assert(std::is_base_of_v<Component, T>, "T must derive from Component");
+
+    static const ComponentTypeInfo info = []
+    {
+        ComponentTypeInfo result{ GetComponentTypeId<T>(), sizeof(T), alignof(T), nullptr, nullptr, nullptr, nullptr };
+        result.moveConstruct = [](void* dst, void* src)
+        {
+            T* source = static_cast<T*>(src);
+            new (dst) T(std::move(*source));
+            source->~T();
+        };
+        result.destroy = [](void* component) { static_cast<T*>(component)->~T(); };
+
+        if constexpr (std::is_base_of_v<IUpdatable, T>)
+        {
+            result.update = [](void* components, size_t count, float deltaTime)
+            {
+                T* begin = static_cast<T*>(components);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    // Квалифицированный вызов: тип известен, виртуальная диспетчеризация не нужна
+                    if (begin[i].IsEnabled()) begin[i].T::Update(deltaTime);
+                }
+            };
+        }
+        if constexpr (std::is_base_of_v<RendererComponent, T>)
+        {
+            result.asRenderer = [](void* component) -> RendererComponent* { return static_cast<T*>(component); };
+        }
+        return result;
+    }();
+    return info;
+}
@@ -1,23 +1,17 @@
 #pragma once
-#include <memory>
-#include <vector>
+#include <cstdint>
 
-#include "Component.h"
-#include "RendererComponent.h"
-#include "IUpdatable.h"
-
-class Entity
+// Легковесный идентификатор сущности: индекс слота в сцене + поколение слота.
+// Сами компоненты хранятся в чанках архетипов внутри Scene.
+struct Entity
 {
-private:
-	std::vector<std::unique_ptr<Component>> components;
-	std::vector<std::pair<Component*, IUpdatable*>> updatables;
-	std::vector<RendererComponent*> renderables; // Кэш с Component*
-	bool hidden = false;
-public:
-	void AddComponent(std::unique_ptr<Component> component);
-	void Update(float deltaTime);
-	void setHidden(bool newHiddenflag) { hidden = newHiddenflag; }
-	bool isHidden() const { return hidden; }
-	const std::vector<RendererComponent*>& GetRenderables() const { return renderables; }
-};
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	uint32_t index = InvalidIndex;
+	uint32_t generation = 0;
 
+	bool IsNull() const { return index == InvalidIndex; }
+
+	bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Entity& other) const { return !(*this == other); }
+};
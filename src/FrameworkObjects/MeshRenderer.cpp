@@ -1 +1,35 @@
 #include "MeshRenderer.h"
+#include <algorithm>
+
+void MeshRenderer::Render(ComPtr<ID3D12GraphicsCommandList>& commandList)
+{
+    const MeshLod* mesh = GetCurrentMesh();
+    if (!mesh || !mesh->geometry) return;
+
+    const D3D12_VERTEX_BUFFER_VIEW vertexBuffer = mesh->geometry->VertexBufferView();
+    const D3D12_INDEX_BUFFER_VIEW indexBuffer = mesh->geometry->IndexBufferView();
+    commandList->IASetVertexBuffers(0, 1, &vertexBuffer);
+    commandList->IASetIndexBuffer(&indexBuffer);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->DrawIndexedInstanced(mesh->submesh.IndexCount, 1, mesh->submesh.StartIndexLocation, mesh->submesh.BaseVertexLocation, 0);
+}
+
+void MeshRenderer::SetMesh(MeshGeometry* geometry, const SubmeshGeometry& submesh)
+{
+    auto group = std::make_shared<LodGroup>();
+    group->levels.push_back({ geometry, submesh, 0.0f });
+    SetLodGroup(std::move(group));
+}
+
+void MeshRenderer::SetLodGroup(std::shared_ptr<const LodGroup> group)
+{
+    lodGroup = std::move(group);
+    lod = 0;
+    if (lodGroup && !lodGroup->levels.empty()) SetBounds(lodGroup->levels[0].submesh.Bounds);
+}
+
+const MeshLod* MeshRenderer::GetCurrentMesh() const
+{
+    if (!lodGroup || lodGroup->levels.empty()) return nullptr;
+    return &lodGroup->levels[std::min<size_t>(lod, lodGroup->levels.size() - 1)];
+}
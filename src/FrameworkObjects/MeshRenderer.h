@@ -1,10 +1,41 @@
 #pragma once
+#include <memory>
+#include <vector>
 #include "RendererComponent.h"
+#include "../Core/Common/d3dUtil.h"
+
+// Один уровень детализации: часть общего буфера геометрии и её геометрическая ошибка
+struct MeshLod
+{
+    MeshGeometry* geometry = nullptr;
+    SubmeshGeometry submesh;
+    float error = 0.0f; // Наибольшее отклонение от самого детального уровня, в единицах модели
+};
+
+// Уровни от самого детального к самому грубому, ошибки не убывают.
+// Группа неизменяема и может быть общей у многих рендереров.
+struct LodGroup
+{
+    std::vector<MeshLod> levels;
+};
 
 class MeshRenderer : public RendererComponent
 {
 public:
     MeshRenderer(int order = 0, bool isTransparent = false) : RendererComponent(order, isTransparent) {}
-    void Render(ComPtr<ID3D12GraphicsCommandList>& commandList) override {}
-};
+    void Render(ComPtr<ID3D12GraphicsCommandList>& commandList) override;
+
+    // Одна сетка без уровней детализации; границы берутся из submesh
+    void SetMesh(MeshGeometry* geometry, const SubmeshGeometry& submesh);
+    // Границы берутся из самого детального уровня. Текущий уровень выбирает Scene перед отрисовкой.
+    void SetLodGroup(std::shared_ptr<const LodGroup> group);
+    const LodGroup* GetLodGroup() const { return lodGroup.get(); }
 
+    uint32_t GetLod() const { return lod; }
+    void SetLod(uint32_t value) { lod = value; }
+    const MeshLod* GetCurrentMesh() const;
+
+private:
+    std::shared_ptr<const LodGroup> lodGroup;
+    uint32_t lod = 0;
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <memory>
+#include "Component.h"
+#include "../Core/Rendering/OcclusionCulling.h"
+
+// Помечает сущность как перекрывающую: её упрощённая геометрия растеризуется в буфер глубины
+// OcclusionCuller, и рендереры за ней не отправляются на отрисовку.
+// Сетка задаётся в локальных координатах и может быть общей у многих сущностей.
+class OccluderComponent : public Component
+{
+public:
+    OccluderComponent() = default;
+    explicit OccluderComponent(std::shared_ptr<const OccluderMesh> mesh) : mesh(std::move(mesh)) {}
+
+    const char* GetType() const override { return "Occluder"; }
+
+    const OccluderMesh* GetMesh() const { return mesh.get(); }
+    void SetMesh(std::shared_ptr<const OccluderMesh> value) { mesh = std::move(value); }
+
+private:
+    std::shared_ptr<const OccluderMesh> mesh;
+};
@@ -0,0 +1,90 @@
+#include "RenderQueue.h"
+#include <algorithm>
+
+uint64_t RenderQueue::MakeKey(uint32_t layer, bool transparent, int order, uint32_t materialId, float depth01)
+{
+    constexpr uint64_t layerMask = (1ull << LayerBits) - 1;
+    constexpr uint64_t materialMask = (1ull << MaterialBits) - 1;
+    constexpr uint64_t depthMask = (1ull << DepthBits) - 1;
+
+    // Переводим знаковый порядок в беззнаковый инверсией знакового бита (без переполнения int у краёв
+    // диапазона), затем насыщаем до OrderBits, чтобы отрицательные значения шли раньше
+    constexpr uint32_t signBit = 0x80000000u;
+    constexpr uint32_t orderBias = 1u << (OrderBits - 1);
+    const uint32_t unsignedOrder = static_cast<uint32_t>(order) ^ signBit;
+    const uint64_t biasedOrder = std::clamp(unsignedOrder, signBit - orderBias, signBit + (orderBias - 1)) - (signBit - orderBias);
+    const uint64_t depth = static_cast<uint64_t>(std::clamp(depth01, 0.0f, 1.0f) * static_cast<float>(depthMask)) & depthMask;
+
+    uint64_t key = (static_cast<uint64_t>(layer) & layerMask) << 60;
+    key |= (transparent ? 1ull : 0ull) << 59;
+    key |= biasedOrder << 43;
+    if (transparent)
+    {
+        key |= (depthMask - depth) << 19;
+        key |= (static_cast<uint64_t>(materialId) & materialMask) << 3;
+    }
+    else
+    {
+        key |= (static_cast<uint64_t>(materialId) & materialMask) << 27;
+        key |= depth << 3;
+    }
+    return key;
+}
+
+void RenderQueue::Reserve(size_t count)
+{
+    packets.reserve(count);
+    scratch.reserve(count);
+}
+
+void RenderQueue::Sort()
+{
+    const size_t count = packets.size();
+    if (count < 2) return;
+    scratch.resize(count);
+
+    // Гистограммы всех восьми байтов за один проход
+    uint32_t histograms[8][256] = {};
+    for (const auto& packet : packets)
+    {
+        for (uint32_t byte = 0; byte < 8; ++byte)
+        {
+            ++histograms[byte][(packet.key >> (byte * 8)) & 0xFF];
+        }
+    }
+
+    DrawPacket* source = packets.data();
+    DrawPacket* destination = scratch.data();
+    for (uint32_t byte = 0; byte < 8; ++byte)
+    {
+        uint32_t* histogram = histograms[byte];
+        const uint32_t shift = byte * 8;
+        if (histogram[(source[0].key >> shift) & 0xFF] == count) continue;
+
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < 256; ++digit)
+        {
+            uint32_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    if (source != packets.data())
+    {
+        packets.swap(scratch);
+    }
+}
+
+void RenderQueue::Submit(ComPtr<ID3D12GraphicsCommandList>& commandList) const
+{
+    for (const auto& packet : packets)
+    {
+        packet.renderer->Render(commandList);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <d3d12.h>
+#include <wrl.h>
+#include "RendererComponent.h"
+using Microsoft::WRL::ComPtr;
+
+// Очередь отрисовки кадра: компактные пакеты, упорядоченные по 64-битному ключу.
+// Раскладка ключа (от старших битов к младшим):
+//   [63..60] слой/проход
+//   [59]     прозрачность (непрозрачные идут первыми)
+//   [58..43] порядок (GetOrder со смещением)
+//   непрозрачные: [42..27] материал/PSO, [26..3] глубина - спереди назад, с группировкой по PSO
+//   прозрачные:   [42..19] инвертированная глубина, [18..3] материал - строго сзади вперёд
+// Буферы переиспользуются между кадрами, поэтому в установившемся режиме кадр не аллоцирует память.
+class RenderQueue
+{
+public:
+    struct DrawPacket
+    {
+        uint64_t key;
+        RendererComponent* renderer;
+    };
+
+    static constexpr uint32_t LayerBits = 4;
+    static constexpr uint32_t OrderBits = 16;
+    static constexpr uint32_t MaterialBits = 16;
+    static constexpr uint32_t DepthBits = 24;
+
+    // depth01 - глубина в пространстве вида, нормированная в [0, 1] между ближней и дальней плоскостью
+    static uint64_t MakeKey(uint32_t layer, bool transparent, int order, uint32_t materialId, float depth01);
+
+    void Clear() { packets.clear(); }
+    void Reserve(size_t count);
+    void Push(uint64_t key, RendererComponent* renderer) { packets.push_back({ key, renderer }); }
+
+    // Стабильная LSD радикс-сортировка по байтам ключа; байты, одинаковые у всех пакетов, пропускаются
+    void Sort();
+
+    void Submit(ComPtr<ID3D12GraphicsCommandList>& commandList) const;
+
+    const std::vector<DrawPacket>& GetPackets() const { return packets; }
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> scratch;
+};
@@ -1,9 +1,37 @@
 #pragma once
 #include "Component.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
 #include <d3d12.h>
+#include <DirectXCollision.h>
 #include <wrl.h>
 using Microsoft::WRL::ComPtr;
 
+// Сущности, у рендереров которых сменились границы. Пополняется из любого потока
+// (SetBounds можно вызывать из параллельных систем), разбирается сценой в Update.
+class BoundsChangeList
+{
+public:
+    void Push(uint32_t entityIndex)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entities.push_back(entityIndex);
+    }
+
+    // Дописывает накопленные индексы в конец out и очищает список
+    void MoveTo(std::vector<uint32_t>& out)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out.insert(out.end(), entities.begin(), entities.end());
+        entities.clear();
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<uint32_t> entities;
+};
+
 class RendererComponent : public Component
 {
 public:
@@ -11,11 +39,61 @@ public:
         : order(order), isTransparent(isTransparent)
     {}
 
+    // Копия не привязана к сцене; перемещение (в том числе между чанками) сохраняет привязку
+    RendererComponent(const RendererComponent& other)
+        : Component(other), order(other.order), isTransparent(other.isTransparent), layer(other.layer),
+          materialId(other.materialId), bounds(other.bounds), hasBounds(other.hasBounds), castsShadows(other.castsShadows)
+    {}
+    RendererComponent(RendererComponent&& other) noexcept = default;
+    // Присваивание меняет только значения, привязка к сущности остаётся прежней
+    RendererComponent& operator=(const RendererComponent& other)
+    {
+        if (this == &other) return *this;
+        Component::operator=(other);
+        order = other.order;
+        isTransparent = other.isTransparent;
+        layer = other.layer;
+        materialId = other.materialId;
+        castsShadows = other.castsShadows;
+        bounds = other.bounds;
+        hasBounds = other.hasBounds;
+        NotifyBoundsChanged();
+        return *this;
+    }
+
     virtual void Render(ComPtr<ID3D12GraphicsCommandList>& commandList) = 0;
     int GetOrder() const { return order; }
     bool IsTransparent() const { return isTransparent; }
 
+    // Слой/проход и идентификатор PSO/материала попадают в ключ сортировки RenderQueue
+    uint32_t GetLayer() const { return layer; }
+    void SetLayer(uint32_t value) { layer = value; }
+    uint32_t GetMaterialId() const { return materialId; }
+    void SetMaterialId(uint32_t value) { materialId = value; }
+
+    // Локальные границы геометрии (обычно SubmeshGeometry::Bounds) для отсечения по пирамиде видимости.
+    // Рендереры без границ не отсекаются. Пространственный индекс сцены подхватывает новые
+    // границы в следующем Scene::Update.
+    bool HasBounds() const { return hasBounds; }
+    const DirectX::BoundingBox& GetBounds() const { return bounds; }
+    void SetBounds(const DirectX::BoundingBox& value) { bounds = value; hasBounds = true; NotifyBoundsChanged(); }
+
+    // Попадает ли рендерер в карты теней (Scene::PrepareShadows); учитываются только рендереры с границами
+    bool CastsShadows() const { return castsShadows; }
+    void SetCastsShadows(bool value) { castsShadows = value; }
+
 private:
+    friend class Scene;
+
+    void NotifyBoundsChanged() { if (boundsChanges) boundsChanges->Push(entityIndex); }
+
     int order;
     bool isTransparent;
+    uint32_t layer = 0;
+    uint32_t materialId = 0;
+    DirectX::BoundingBox bounds;
+    bool hasBounds = false;
+    bool castsShadows = true;
+    BoundsChangeList* boundsChanges = nullptr; // Список сцены, в которой лежит компонент
+    uint32_t entityIndex = 0;
 };
\ No newline at end of file
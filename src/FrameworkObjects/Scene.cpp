@@ -1,79 +1,568 @@
 #include "Scene.h"
-#include "Entity.h"
-#include <algorithm>
+#include "SceneCommandBuffer.h"
+#include "OccluderComponent.h"
 #include "MeshRenderer.h"
+#include "../Core/Common/Camera.h"
+#include "../Core/Memory/FrameArena.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
 
-void Scene::AddEntity(std::shared_ptr<Entity> entity)
+Scene::Scene()
+    : commandBuffer(std::make_unique<SceneCommandBuffer>())
 {
-    entities.push_back(entity);
-    if (!entity->isHidden()) UpdateRenderCache(entity.get());
+    emptyArchetype = GetOrCreateArchetype({});
 }
 
-void Scene::RemoveEntity(const Entity* entity)
+Scene::~Scene() = default;
+
+Entity Scene::CreateEntity()
 {
-    auto it = std::find_if(entities.begin(), entities.end(),
-                            [entity](const auto& ptr) { return ptr.get() == entity; });
-    if (it != entities.end())
+    return AllocateEntity(emptyArchetype);
+}
+
+Entity Scene::AllocateEntity(Archetype* archetype)
+{
+    uint32_t index;
+    if (!freeEntityIndices.empty())
+    {
+        index = freeEntityIndices.back();
+        freeEntityIndices.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(entityRecords.size());
+        entityRecords.emplace_back();
+    }
+
+    EntityRecord& record = entityRecords[index];
+    Entity entity{ index, record.generation };
+    record.alive = true;
+    record.hidden = false;
+    record.archetype = archetype;
+    record.row = archetype->Allocate(entity);
+    return entity;
+}
+
+void Scene::RemoveEntity(Entity entity)
+{
+    if (!IsAlive(entity)) return;
+    EntityRecord& record = entityRecords[entity.index];
+
+    ClearRenderCache(entity);
+    DetachTransform(entity);
+    RemoveSpatialProxy(entity);
+    Entity moved = record.archetype->Remove(record.row);
+    if (!moved.IsNull()) entityRecords[moved.index].row = record.row;
+
+    record.alive = false;
+    record.archetype = nullptr;
+    ++record.generation; // Все старые копии Entity становятся недействительными
+
+    // Слот с исчерпанным поколением больше не выдаём, иначе старые Entity снова станут "живыми"
+    if (record.generation != UINT32_MAX) freeEntityIndices.push_back(entity.index);
+}
+
+bool Scene::IsAlive(Entity entity) const
+{
+    if (entity.index >= entityRecords.size()) return false;
+    const EntityRecord& record = entityRecords[entity.index];
+    return record.alive && record.generation == entity.generation;
+}
+
+void Scene::SetHidden(Entity entity, bool hidden)
+{
+    if (!IsAlive(entity)) return;
+    EntityRecord& record = entityRecords[entity.index];
+    if (record.hidden == hidden) return;
+
+    // Скрытая сущность уходит и из пространственного индекса, показанная возвращается в него
+    // в следующем Update (QueueRenderers)
+    if (hidden)
     {
         ClearRenderCache(entity);
-        entities.erase(it);
+        RemoveSpatialProxy(entity);
     }
+    record.hidden = hidden;
+    if (!hidden) UpdateRenderCache(entity);
+}
+
+bool Scene::IsHidden(Entity entity) const
+{
+    assert(IsAlive(entity));
+    return entityRecords[entity.index].hidden;
+}
+
+bool Scene::SetParent(Entity child, Entity parent)
+{
+    TransformComponent* childTransform = GetComponent<TransformComponent>(child);
+    if (!childTransform) return false;
+
+    uint32_t parentNode = TransformHierarchy::InvalidNode;
+    if (!parent.IsNull())
+    {
+        TransformComponent* parentTransform = GetComponent<TransformComponent>(parent);
+        if (!parentTransform) return false;
+        parentNode = parentTransform->node;
+    }
+    return transforms.SetParent(childTransform->node, parentNode);
 }
 
 void Scene::Update(float deltaTime)
 {
-    for (auto& entity : entities)
+    // Обновляем компоненты колонками: один косвенный вызов на чанк вместо виртуального вызова на компонент
+    for (auto& archetype : archetypes)
     {
-        entity->Update(deltaTime);
+        const auto& types = archetype->GetTypes();
+        for (size_t column = 0; column < types.size(); ++column)
+        {
+            if (!types[column]->update) continue;
+            for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+            {
+                types[column]->update(archetype->GetColumn(chunk, column), archetype->GetChunkSize(chunk), deltaTime);
+            }
+        }
     }
+
+    scheduler.Run(*this, deltaTime);
+
+    // Точка синхронизации: структурные изменения, записанные за кадр, применяются одной пачкой
+    commandBuffer->Playback(*this);
+
+    // Только изменившиеся поддеревья, уровень за уровнем
+    transforms.Update();
+    UpdateSpatialIndex();
 }
 
-void Scene::Render(ComPtr<ID3D12GraphicsCommandList> commandList)
+void Scene::UpdateSpatialIndex()
 {
-    // Разделяем на непрозрачные и прозрачные из кэша
-    std::vector<RendererComponent*> opaque, transparent;
-    for (const auto& [type, renders] : rendererCache)
+    // Пересчитываются только сущности, у которых что-то поменялось: трансформ, границы рендерера,
+    // состав компонентов или видимость. Повторы убираются сортировкой, заодно порядок вставки
+    // листьев не зависит от того, какие потоки пересчитывали трансформы.
+    boundsChanges.MoveTo(spatialDirty);
+    const uint32_t* updatedNodes = transforms.GetUpdatedNodes();
+    for (size_t i = 0, count = transforms.GetUpdatedNodeCount(); i < count; ++i)
+    {
+        spatialDirty.push_back(transformOwners[updatedNodes[i]]);
+    }
+    if (spatialDirty.empty()) return;
+    std::sort(spatialDirty.begin(), spatialDirty.end());
+    spatialDirty.erase(std::unique(spatialDirty.begin(), spatialDirty.end()), spatialDirty.end());
+
+    const ComponentTypeInfo& transformType = ComponentTypeInfo::Get<TransformComponent>();
+    size_t changedCount = 0;
+    for (uint32_t index : spatialDirty)
     {
-        for (auto* renderer : renders)
+        EntityRecord& record = entityRecords[index];
+        if (!record.alive) continue;
+        const Entity entity{ index, record.generation };
+
+        Aabb bounds{};
+        bool hasBounds = false;
+        if (!record.hidden)
         {
-            if (renderer->IsEnabled())
+            XMFLOAT4X4 world;
+            if (auto* transform = static_cast<const TransformComponent*>(GetComponentData(entity, transformType))) world = transform->GetWorldMatrix();
+            else XMStoreFloat4x4(&world, XMMatrixIdentity());
+
+            const auto& types = record.archetype->GetTypes();
+            for (size_t column = 0; column < types.size(); ++column)
             {
-                (renderer->IsTransparent() ? transparent : opaque).push_back(renderer);
+                if (!types[column]->asRenderer) continue;
+                const RendererComponent* renderer = types[column]->asRenderer(record.archetype->GetComponent(record.row, static_cast<int>(column)));
+                if (!renderer->HasBounds()) continue;
+
+                XMFLOAT3 center, extents;
+                TransformBounds(renderer->GetBounds(), world, center, extents);
+                const Aabb rendererBounds = Aabb::FromCenterExtents(center, extents);
+                bounds = hasBounds ? Aabb::Union(bounds, rendererBounds) : rendererBounds;
+                hasBounds = true;
             }
         }
+
+        if (!hasBounds)
+        {
+            if (record.spatialProxy == DynamicBvh::NullNode) continue;
+            spatialIndex.DestroyProxy(record.spatialProxy);
+            record.spatialProxy = DynamicBvh::NullNode;
+        }
+        else if (record.spatialProxy == DynamicBvh::NullNode)
+        {
+            record.spatialProxy = spatialIndex.CreateProxy(bounds, PackEntity(entity));
+            ++changedCount;
+        }
+        else if (spatialIndex.SetProxyBounds(record.spatialProxy, bounds))
+        {
+            ++changedCount;
+        }
     }
+    spatialDirty.clear();
 
-    // Рендеринг: сначала непрозрачные, затем прозрачные
-    for (auto* renderer : opaque)
+    if (changedCount == 0) return;
+
+    // Движущиеся листья обновлены на месте, один проход пересчитывает затронутые пути к корню.
+    // Когда суммарная площадь узлов заметно выросла с последней перестройки, дерево строится заново.
+    constexpr float RebuildAreaGrowth = 1.5f;
+    spatialIndex.Refit();
+    if (spatialIndex.GetAreaRatio() > spatialAreaRatio * RebuildAreaGrowth)
     {
-        renderer->Render(commandList);
+        spatialIndex.Rebuild();
+        spatialAreaRatio = spatialIndex.GetAreaRatio();
     }
-    for (auto* renderer : transparent)
+}
+
+void Scene::RemoveSpatialProxy(Entity entity)
+{
+    EntityRecord& record = entityRecords[entity.index];
+    if (record.spatialProxy == DynamicBvh::NullNode) return;
+
+    spatialIndex.DestroyProxy(record.spatialProxy);
+    record.spatialProxy = DynamicBvh::NullNode;
+    spatialDirty.push_back(entity.index);
+}
+
+Entity Scene::Raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, float* outDistance) const
+{
+    Entity closest;
+    float closestDistance = maxDistance;
+    spatialIndex.RayCast(origin, direction, maxDistance, [&](int32_t proxy, float distance)
+    {
+        closest = UnpackEntity(spatialIndex.GetUserData(proxy));
+        closestDistance = distance;
+        return distance;
+    });
+
+    if (outDistance && !closest.IsNull()) *outDistance = closestDistance;
+    return closest;
+}
+
+void Scene::SetDeferredRenderCacheSort(bool deferred)
+{
+    deferredRenderCacheSort = deferred;
+    if (!deferred) FlushRenderCache();
+}
+
+void Scene::FlushRenderCache()
+{
+    if (pendingRenderers.empty()) return;
+
+    // Сортируем только новую пачку и сливаем её с уже отсортированным кэшем: O(N + k log k) вместо сортировки на каждую вставку
+    auto byOrder = [](const RendererEntry& a, const RendererEntry& b) { return a.order < b.order; };
+    std::stable_sort(pendingRenderers.begin(), pendingRenderers.end(), byOrder);
+
+    const size_t oldSize = rendererCache.size();
+    rendererCache.insert(rendererCache.end(), pendingRenderers.begin(), pendingRenderers.end());
+    std::inplace_merge(rendererCache.begin(), rendererCache.begin() + oldSize, rendererCache.end(), byOrder);
+    pendingRenderers.clear();
+}
+
+void Scene::Render(ComPtr<ID3D12GraphicsCommandList> commandList, const Camera& camera)
+{
+    FlushRenderCache();
+    SelectLods(camera);
+
+    const XMFLOAT3 eye = camera.GetPosition3f();
+    const XMFLOAT3 look = camera.GetLook3f();
+    const float nearZ = camera.GetNearZ();
+    const float invDepthRange = 1.0f / (camera.GetFarZ() - nearZ);
+    const ComponentTypeInfo& transformType = ComponentTypeInfo::Get<TransformComponent>();
+
+    renderQueue.Clear();
+    renderQueue.Reserve(rendererCache.size());
+    frustumCuller.Clear();
+    cullCandidates.clear();
+    for (const auto& entry : rendererCache)
+    {
+        if (!IsRendererEntryValid(entry)) continue;
+        auto* renderer = entry.type->asRenderer(GetComponentData(entry.entity, *entry.type));
+        if (!renderer->IsEnabled()) continue;
+
+        float depth01 = 0.0f;
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, XMMatrixIdentity());
+        if (auto* transform = static_cast<const TransformComponent*>(GetComponentData(entry.entity, transformType)))
+        {
+            world = transform->GetWorldMatrix();
+            const XMFLOAT3 position(world._41, world._42, world._43);
+            const float viewDepth = (position.x - eye.x) * look.x + (position.y - eye.y) * look.y + (position.z - eye.z) * look.z;
+            depth01 = (viewDepth - nearZ) * invDepthRange;
+        }
+
+        const uint64_t key = RenderQueue::MakeKey(renderer->GetLayer(), renderer->IsTransparent(), renderer->GetOrder(),
+                                                  renderer->GetMaterialId(), depth01);
+        if (!renderer->HasBounds())
+        {
+            renderQueue.Push(key, renderer);
+            continue;
+        }
+        frustumCuller.Add(renderer->GetBounds(), world);
+        cullCandidates.push_back({ key, renderer });
+    }
+
+    // Границы проверяются пачкой, SIMD и параллельно; в очередь попадают только видимые
+    const XMMATRIX viewProj = XMMatrixMultiply(camera.GetView(), camera.GetProj());
+    uint32_t* visible = FrameArena::Get().AllocateArray<uint32_t>(frustumCuller.GetCount());
+    size_t visibleCount = frustumCuller.Cull(Frustum::FromViewProj(viewProj), visible);
+    if (occlusionCulling) visibleCount = CullOccluded(viewProj, visible, visibleCount);
+    for (size_t i = 0; i < visibleCount; ++i)
     {
-        renderer->Render(commandList);
+        const RenderQueue::DrawPacket& packet = cullCandidates[visible[i]];
+        renderQueue.Push(packet.key, packet.renderer);
     }
+
+    // Непрозрачные спереди назад, затем прозрачные сзади вперёд - всё определяется ключом
+    renderQueue.Sort();
+    renderQueue.Submit(commandList);
 }
 
-void Scene::UpdateRenderCache(Entity* entity)
+void Scene::PrepareShadows(CascadedShadows& shadows)
 {
-    const auto& renders = entity->GetRenderables();
-    for (auto* render : renders)
+    FlushRenderCache();
+    const ComponentTypeInfo& transformType = ComponentTypeInfo::Get<TransformComponent>();
+
+    shadowCasterBoxes.Clear();
+    shadowCasters.clear();
+    for (const auto& entry : rendererCache)
     {
-        std::string type = (dynamic_cast<MeshRenderer*>(render) ? "Mesh" : "Sprite");
-        rendererCache[type].push_back(render);
-        // Сортируем сразу при добавлении
-        std::sort(rendererCache[type].begin(), rendererCache[type].end(),
-                    [](const RendererComponent* a, const RendererComponent* b) { return a->GetOrder() < b->GetOrder(); });
+        if (!IsRendererEntryValid(entry)) continue;
+        auto* renderer = entry.type->asRenderer(GetComponentData(entry.entity, *entry.type));
+        if (!renderer->IsEnabled() || !renderer->CastsShadows() || !renderer->HasBounds()) continue;
+
+        XMFLOAT4X4 world;
+        if (auto* transform = static_cast<const TransformComponent*>(GetComponentData(entry.entity, transformType))) world = transform->GetWorldMatrix();
+        else XMStoreFloat4x4(&world, XMMatrixIdentity());
+
+        shadowCasterBoxes.Add(renderer->GetBounds(), world);
+        shadowCasters.push_back(entry);
     }
+
+    // Все каскады проверяются за один SIMD-проход по границам
+    shadows.CullCasters(shadowCasterBoxes);
 }
 
-void Scene::ClearRenderCache(const Entity* entity)
+void Scene::RenderShadowCascade(ComPtr<ID3D12GraphicsCommandList> commandList, const CascadedShadows& shadows, uint32_t cascade)
 {
-    const auto& renderers = entity->GetRenderables();
-    for (auto* renderer : renderers)
+    // Порядок кэша (по GetOrder) сохраняется: индексы в списке каскада возрастают
+    for (uint32_t index : shadows.GetCascade(cascade).casters)
     {
-        std::string type = (dynamic_cast<MeshRenderer*>(renderer) ? "Mesh" : "Sprite");
-        auto& cache = rendererCache[type];
-        cache.erase(std::remove(cache.begin(), cache.end(), renderer), cache.end());
+        const RendererEntry& entry = shadowCasters[index];
+        if (!IsRendererEntryValid(entry)) continue;
+        entry.type->asRenderer(GetComponentData(entry.entity, *entry.type))->Render(commandList);
     }
 }
+
+void Scene::SelectLods(const Camera& camera)
+{
+    LodSelector selector;
+    selector.Setup(lodSettings, camera.GetFovY());
+    const XMFLOAT3 eye = camera.GetPosition3f();
+    const ComponentTypeInfo& transformType = ComponentTypeInfo::Get<TransformComponent>();
+
+    ForEachParallel<MeshRenderer>([&](Entity entity, MeshRenderer& renderer)
+    {
+        const LodGroup* group = renderer.GetLodGroup();
+        if (!group || group->levels.size() < 2 || !renderer.IsEnabled()) return;
+
+        XMFLOAT4X4 world;
+        if (auto* transform = static_cast<const TransformComponent*>(GetComponentData(entity, transformType))) world = transform->GetWorldMatrix();
+        else XMStoreFloat4x4(&world, XMMatrixIdentity());
+
+        // Расстояние до ограничивающей сферы, переведённое в единицы модели самым сильным масштабом
+        XMFLOAT3 center, extents;
+        TransformBounds(renderer.GetBounds(), world, center, extents);
+        const float radius = std::sqrt(extents.x * extents.x + extents.y * extents.y + extents.z * extents.z);
+        const float dx = center.x - eye.x, dy = center.y - eye.y, dz = center.z - eye.z;
+        const float distance = std::sqrt(dx * dx + dy * dy + dz * dz) - radius;
+
+        float scaleSquared = 0.0f;
+        for (int row = 0; row < 3; ++row)
+        {
+            scaleSquared = std::max(scaleSquared, world.m[row][0] * world.m[row][0] + world.m[row][1] * world.m[row][1] + world.m[row][2] * world.m[row][2]);
+        }
+
+        const float localDistance = distance / std::sqrt(std::max(scaleSquared, 1e-12f));
+        renderer.SetLod(selector.Select(static_cast<uint32_t>(group->levels.size()), renderer.GetLod(), localDistance,
+                                        [group](uint32_t level) { return group->levels[level].error; }));
+    });
+}
+
+size_t Scene::CullOccluded(FXMMATRIX viewProj, uint32_t* visible, size_t count)
+{
+    const ComponentTypeInfo& transformType = ComponentTypeInfo::Get<TransformComponent>();
+    occlusionCuller.BeginFrame(viewProj);
+    ForEach<OccluderComponent>([&](Entity entity, OccluderComponent& occluder)
+    {
+        if (!occluder.IsEnabled() || !occluder.GetMesh() || entityRecords[entity.index].hidden) return;
+
+        XMFLOAT4X4 world;
+        if (auto* transform = static_cast<const TransformComponent*>(GetComponentData(entity, transformType))) world = transform->GetWorldMatrix();
+        else XMStoreFloat4x4(&world, XMMatrixIdentity());
+        occlusionCuller.AddOccluder(*occluder.GetMesh(), world);
+    });
+
+    occlusionCuller.Rasterize();
+    return occlusionCuller.Cull(frustumCuller, visible, count);
+}
+
+size_t Scene::CollectChunks(const ComponentMask& query, ChunkRef*& outChunks) const
+{
+    size_t count = 0;
+    for (const auto& archetype : archetypes)
+    {
+        if ((archetype->GetMask() & query) == query) count += archetype->GetChunkCount();
+    }
+
+    outChunks = FrameArena::Get().AllocateArray<ChunkRef>(count);
+    size_t index = 0;
+    for (const auto& archetype : archetypes)
+    {
+        if ((archetype->GetMask() & query) != query) continue;
+        for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+        {
+            new (&outChunks[index++]) ChunkRef(archetype.get(), chunk);
+        }
+    }
+    return count;
+}
+
+Archetype* Scene::GetOrCreateArchetype(std::vector<const ComponentTypeInfo*> types)
+{
+    ComponentMask mask;
+    for (const auto* info : types) mask.set(info->id);
+
+    auto it = archetypeLookup.find(mask);
+    if (it != archetypeLookup.end()) return it->second;
+
+    archetypes.push_back(std::make_unique<Archetype>(std::move(types)));
+    Archetype* archetype = archetypes.back().get();
+    archetypeLookup.emplace(mask, archetype);
+    return archetype;
+}
+
+Archetype* Scene::GetArchetypeWith(Archetype* source, const ComponentTypeInfo& type)
+{
+    if (Archetype* edge = source->addEdges[type.id]) return edge;
+
+    auto types = source->GetTypes();
+    types.push_back(&type);
+    Archetype* target = GetOrCreateArchetype(std::move(types));
+    source->addEdges[type.id] = target;
+    target->removeEdges[type.id] = source;
+    return target;
+}
+
+Archetype* Scene::GetArchetypeWithout(Archetype* source, const ComponentTypeInfo& type)
+{
+    if (Archetype* edge = source->removeEdges[type.id]) return edge;
+
+    auto types = source->GetTypes();
+    types.erase(std::remove(types.begin(), types.end(), &type), types.end());
+    Archetype* target = GetOrCreateArchetype(std::move(types));
+    source->removeEdges[type.id] = target;
+    target->addEdges[type.id] = source;
+    return target;
+}
+
+void Scene::MoveEntity(Entity entity, Archetype* target)
+{
+    EntityRecord& record = entityRecords[entity.index];
+    if (record.archetype == target) return;
+
+    uint32_t targetRow;
+    Entity moved = record.archetype->MoveTo(record.row, *target, targetRow);
+    if (!moved.IsNull()) entityRecords[moved.index].row = record.row;
+
+    record.archetype = target;
+    record.row = targetRow;
+}
+
+void* Scene::GetComponentData(Entity entity, const ComponentTypeInfo& type) const
+{
+    if (!IsAlive(entity)) return nullptr;
+    const EntityRecord& record = entityRecords[entity.index];
+
+    int column = record.archetype->GetColumnIndex(type.id);
+    return column >= 0 ? record.archetype->GetComponent(record.row, column) : nullptr;
+}
+
+void Scene::QueueRenderers(Entity entity)
+{
+    EntityRecord& record = entityRecords[entity.index];
+    bool hasRenderers = false;
+    for (const auto* type : record.archetype->GetTypes())
+    {
+        if (!type->asRenderer) continue;
+
+        // Привязка к сцене, чтобы SetBounds попадал в пространственный индекс
+        auto* render = type->asRenderer(GetComponentData(entity, *type));
+        render->boundsChanges = &boundsChanges;
+        render->entityIndex = entity.index;
+        hasRenderers = true;
+    }
+    if (!hasRenderers) return;
+
+    spatialDirty.push_back(entity.index);
+    if (record.hidden) return;
+
+    for (const auto* type : record.archetype->GetTypes())
+    {
+        if (!type->asRenderer) continue;
+
+        auto* render = type->asRenderer(GetComponentData(entity, *type));
+        pendingRenderers.push_back({ entity, type, render->GetOrder(), record.renderVersion });
+        ++record.cachedRenderers;
+        ++liveRendererCount;
+    }
+}
+
+void Scene::UpdateRenderCache(Entity entity)
+{
+    QueueRenderers(entity);
+    if (!deferredRenderCacheSort) FlushRenderCache();
+}
+
+void Scene::ClearRenderCache(Entity entity)
+{
+    // Записи не ищем: смена версии делает их все устаревшими, физически они удаляются при уплотнении
+    EntityRecord& record = entityRecords[entity.index];
+    ++record.renderVersion;
+    staleRendererCount += record.cachedRenderers;
+    liveRendererCount -= record.cachedRenderers;
+    record.cachedRenderers = 0;
+
+    if (staleRendererCount > liveRendererCount) CompactRenderCache();
+}
+
+bool Scene::IsRendererEntryValid(const RendererEntry& entry) const
+{
+    return IsAlive(entry.entity) && entityRecords[entry.entity.index].renderVersion == entry.renderVersion;
+}
+
+void Scene::CompactRenderCache()
+{
+    // Линейный проход, но не чаще чем раз на каждые liveRendererCount удалений - амортизированно O(1)
+    auto isStale = [this](const RendererEntry& entry) { return !IsRendererEntryValid(entry); };
+    rendererCache.erase(std::remove_if(rendererCache.begin(), rendererCache.end(), isStale), rendererCache.end());
+    pendingRenderers.erase(std::remove_if(pendingRenderers.begin(), pendingRenderers.end(), isStale), pendingRenderers.end());
+    staleRendererCount = 0;
+}
+
+void Scene::AttachTransform(Entity entity, TransformComponent& transform)
+{
+    transform.node = transforms.Create(transform.local);
+    transform.hierarchy = &transforms;
+    if (transformOwners.size() <= transform.node) transformOwners.resize(transform.node + 1);
+    transformOwners[transform.node] = entity.index;
+}
+
+void Scene::DetachTransform(Entity entity)
+{
+    auto* transform = static_cast<TransformComponent*>(GetComponentData(entity, ComponentTypeInfo::Get<TransformComponent>()));
+    if (!transform || !transform->hierarchy) return;
+
+    transform->local = transform->GetLocal();
+    transforms.Destroy(transform->node);
+    transform->hierarchy = nullptr;
+    transform->node = TransformHierarchy::InvalidNode;
+}
@@ -1,31 +1,403 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include <utility>
 #include <d3d12.h>
 #include <wrl.h>
-#include <unordered_map>
 #include "Entity.h"
+#include "Archetype.h"
+#include "ComponentType.h"
+#include "RenderQueue.h"
+#include "../Core/Rendering/FrustumCulling.h"
+#include "../Core/Rendering/OcclusionCulling.h"
+#include "../Core/Rendering/LodSelection.h"
+#include "../Core/Rendering/CascadedShadows.h"
+#include "../Core/Spatial/DynamicBvh.h"
+#include "SystemScheduler.h"
+#include "CommandRecordingScope.h"
+#include "TransformComponent.h"
+#include "TransformHierarchy.h"
+#include "../Core/Jobs/JobSystem.h"
 using Microsoft::WRL::ComPtr;
 
-class Entity;
+class Camera;
+class SceneCommandBuffer;
 
 class Scene
 {
 private:
-	std::vector<std::shared_ptr<Entity>> entities;
-    std::unordered_map<std::string, std::vector<RendererComponent*>> rendererCache; // Кэш для всех Renderer-компонентов, разделенный по типу
+    struct EntityRecord
+    {
+        Archetype* archetype = nullptr;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+        uint32_t renderVersion = 0; // Меняется при каждом сбросе записей сущности в rendererCache
+        uint32_t cachedRenderers = 0;
+        int32_t spatialProxy = DynamicBvh::NullNode; // Лист в spatialIndex, если у рендереров есть границы
+        bool alive = false;
+        bool hidden = false;
+    };
+
+    // Запись кэша считается удалённой, если сущность умерла или её renderVersion изменился
+    struct RendererEntry
+    {
+        Entity entity;
+        const ComponentTypeInfo* type;
+        int order;
+        uint32_t renderVersion;
+    };
+
+    std::vector<EntityRecord> entityRecords;
+    std::vector<uint32_t> freeEntityIndices;
+    std::vector<std::unique_ptr<Archetype>> archetypes; // Хранилище всех компонентов сцены
+    std::unordered_map<ComponentMask, Archetype*> archetypeLookup;
+    Archetype* emptyArchetype = nullptr;
+    std::vector<RendererEntry> rendererCache; // Кэш всех Renderer-компонентов, отсортированный по GetOrder
+    std::vector<RendererEntry> pendingRenderers; // Добавленные, но ещё не влитые в rendererCache
+    bool deferredRenderCacheSort = false;
+    std::unique_ptr<SceneCommandBuffer> commandBuffer;
+    SystemScheduler scheduler;
+    TransformHierarchy transforms; // Данные всех TransformComponent сцены
+    RenderQueue renderQueue;
+    FrustumCuller frustumCuller;
+    std::vector<RenderQueue::DrawPacket> cullCandidates; // Пакеты рендереров с границами, по индексам frustumCuller
+    OcclusionCuller occlusionCuller;
+    bool occlusionCulling = true;
+    LodSettings lodSettings;
+    FrustumCuller shadowCasterBoxes; // Мировые границы отбрасывающих тень рендереров, по индексам shadowCasters
+    // Копии записей кэша, а не указатели: между PrepareShadows и RenderShadowCascade компоненты
+    // могут переехать в другой чанк, а сущности - исчезнуть
+    std::vector<RendererEntry> shadowCasters;
+    DynamicBvh spatialIndex; // Мировые границы рендереров для пространственных запросов
+    BoundsChangeList boundsChanges; // Сущности, чьи рендереры сменили границы через SetBounds
+    std::vector<uint32_t> spatialDirty; // Сущности, чьи листья spatialIndex пересчитываются в следующем Update
+    std::vector<uint32_t> transformOwners; // Индекс сущности по узлу transforms
+    float spatialAreaRatio = 0.0f; // spatialIndex.GetAreaRatio() сразу после последней перестройки
+    size_t liveRendererCount = 0;
+    size_t staleRendererCount = 0;
 public:
-    void AddEntity(std::shared_ptr<Entity> entity);
+    Scene();
+    ~Scene();
+
+    Entity CreateEntity();
+
+    // Массовое создание: count сущностей сразу в архетипе <Ts...> без промежуточных переездов.
+    // init(i, Ts&...) заполняет компоненты i-й сущности, все рендереры попадают в кэш одной пачкой.
+    template<typename... Ts, typename Fn>
+    void AddEntities(size_t count, Fn&& init, std::vector<Entity>* outEntities = nullptr);
+
+    // O(1): слот освобождается, записи кэша рендера помечаются устаревшими
+    void RemoveEntity(Entity entity);
+
+    // false для удалённых сущностей и устаревших копий Entity
+    bool IsAlive(Entity entity) const;
+
+    template<typename T, typename... Args>
+    T& AddComponent(Entity entity, Args&&... args);
 
-    void RemoveEntity(const Entity* entity);
+    template<typename T>
+    void RemoveComponent(Entity entity);
 
+    template<typename T>
+    T* GetComponent(Entity entity);
+
+    // Вызывает fn(Entity, Ts&...) для каждой сущности, у которой есть все компоненты Ts
+    template<typename... Ts, typename Fn>
+    void ForEach(Fn&& fn);
+
+    // То же, но чанки обрабатываются параллельно. fn должна менять только компоненты своей сущности.
+    // Команды, записанные из fn внутри системы, применяются в порядке чанков (см. CommandOrigin);
+    // вложенный обход внутри чанка поэтому идёт последовательно.
+    template<typename... Ts, typename Fn>
+    void ForEachParallel(Fn&& fn);
+
+    void AddSystem(std::unique_ptr<System> system) { scheduler.AddSystem(std::move(system)); }
+
+    void SetHidden(Entity entity, bool hidden);
+    bool IsHidden(Entity entity) const;
+
+    // Обе сущности должны иметь TransformComponent; Entity{} делает child корнем.
+    // Мировые матрицы пересчитываются в конце Update. false - нет трансформа или получился бы цикл.
+    bool SetParent(Entity child, Entity parent);
+
+    // Обновляет компоненты, запускает системы, применяет команды, накопленные в GetCommandBuffer(),
+    // и в конце пересчитывает мировые матрицы изменившихся трансформов и пространственный индекс
     void Update(float deltaTime);
 
-    void Render(ComPtr<ID3D12GraphicsCommandList> commandList);
+    // Пространственные запросы по мировым границам рендереров (RendererComponent::SetBounds).
+    // Индекс актуален после Update, скрытые сущности в нём не участвуют; fn(Entity) вызывается
+    // для каждой найденной сущности.
+    template<typename Fn>
+    void QueryBox(const DirectX::BoundingBox& box, Fn&& fn) const;
+    template<typename Fn>
+    void QuerySphere(const DirectX::BoundingSphere& sphere, Fn&& fn) const;
+    template<typename Fn>
+    void QueryFrustum(const Frustum& frustum, Fn&& fn) const;
+
+    // Ближайшая сущность, чьи границы пересекает луч, или Entity{}. Расстояние - в длинах direction.
+    Entity Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance, float* outDistance = nullptr) const;
+
+    // Через этот буфер структурные изменения безопасно делать во время Update и из других потоков
+    SceneCommandBuffer& GetCommandBuffer() { return *commandBuffer; }
+
+    // В отложенном режиме новые рендереры копятся и сортируются один раз перед отрисовкой
+    // (или при явном FlushRenderCache), иначе вливаются в кэш сразу после добавления
+    void SetDeferredRenderCacheSort(bool deferred);
+    bool IsRenderCacheSortDeferred() const { return deferredRenderCacheSort; }
+    void FlushRenderCache();
+
+    // Собирает пакеты отрисовки из кэша, отбрасывает рендереры вне пирамиды видимости камеры,
+    // сортирует пакеты по ключу и отправляет в commandList
+    void Render(ComPtr<ID3D12GraphicsCommandList> commandList, const Camera& camera);
+
+    // Отсечение рендереров, перекрытых сущностями с OccluderComponent (включено по умолчанию).
+    // Пока на экран не попал ни один треугольник окклюдеров, буфер глубины не очищается и не
+    // растеризуется, а проверка пропускается. Статистика относится к последнему Render.
+    void SetOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+    bool IsOcclusionCullingEnabled() const { return occlusionCulling; }
+    const OcclusionStats& GetOcclusionStats() const { return occlusionCuller.GetStats(); }
+
+    // Выбор уровней детализации MeshRenderer по экранной ошибке; viewportHeight нужно обновлять
+    // при изменении размера окна, bias позволяет огрубить всю сцену при нехватке времени кадра
+    void SetLodSettings(const LodSettings& settings) { lodSettings = settings; }
+    const LodSettings& GetLodSettings() const { return lodSettings; }
+
+    // Отбирает для каждого каскада рендереры, тень которых может в него попасть (в том числе
+    // вне пирамиды видимости камеры), и подтягивает ближние плоскости каскадов. Вызывается после
+    // shadows.Update и до RenderShadowCascade; списки действительны до следующего вызова.
+    void PrepareShadows(CascadedShadows& shadows);
+    // Отрисовка отобранных для каскада рендереров; константы света выставляет вызывающий (ApplyTo).
+    // Удалённые, скрытые и лишившиеся рендерера с тех пор сущности пропускаются.
+    void RenderShadowCascade(ComPtr<ID3D12GraphicsCommandList> commandList, const CascadedShadows& shadows, uint32_t cascade);
 
 private:
-    void UpdateRenderCache(Entity* entity);
+    Entity AllocateEntity(Archetype* archetype);
+    Archetype* GetOrCreateArchetype(std::vector<const ComponentTypeInfo*> types);
+    Archetype* GetArchetypeWith(Archetype* source, const ComponentTypeInfo& type);
+    Archetype* GetArchetypeWithout(Archetype* source, const ComponentTypeInfo& type);
+    void MoveEntity(Entity entity, Archetype* target);
+    void* GetComponentData(Entity entity, const ComponentTypeInfo& type) const;
+
+    template<typename... Ts, size_t... I>
+    static std::tuple<Ts*...> ConstructComponents(Archetype& archetype, uint32_t row, const int* columns, std::index_sequence<I...>);
+
+    // Чанки (архетип, номер) для запроса с маской query. Массив берётся из FrameArena, поэтому
+    // обход не аллоцирует и его можно вызывать из нескольких систем одновременно
+    using ChunkRef = std::pair<Archetype*, size_t>;
+    size_t CollectChunks(const ComponentMask& query, ChunkRef*& outChunks) const;
+
+    template<typename... Ts, typename Fn, size_t... I>
+    static void ForEachInChunk(const Archetype& archetype, size_t chunk, const int* columns, Fn& fn, std::index_sequence<I...>);
+
+    // Ставит рендереры сущности в очередь на вставку в кэш; сортировка откладывается до FlushRenderCache
+    void QueueRenderers(Entity entity);
+
+    void UpdateRenderCache(Entity entity);
 
-    void ClearRenderCache(const Entity* entity);
+    void ClearRenderCache(Entity entity);
+
+    bool IsRendererEntryValid(const RendererEntry& entry) const;
+
+    void CompactRenderCache();
+
+    // Выставляет каждому MeshRenderer с цепочкой уровней самый грубый допустимый для камеры
+    void SelectLods(const Camera& camera);
+
+    // Растеризует окклюдеры и убирает из visible индексы перекрытых рендереров
+    size_t CullOccluded(DirectX::FXMMATRIX viewProj, uint32_t* visible, size_t count);
+
+    // Заводит, двигает и удаляет листья spatialIndex только для сущностей из spatialDirty,
+    // boundsChanges и с пересчитанными в этом Update трансформами
+    void UpdateSpatialIndex();
+    // Лист пересоздаётся в следующем Update, если у сущности останутся видимые рендереры с границами
+    void RemoveSpatialProxy(Entity entity);
+
+    static uint64_t PackEntity(Entity entity) { return (uint64_t(entity.generation) << 32) | entity.index; }
+    static Entity UnpackEntity(uint64_t value) { return Entity{ static_cast<uint32_t>(value), static_cast<uint32_t>(value >> 32) }; }
+
+    // Заводит узел иерархии для только что размещённого в чанке компонента
+    void AttachTransform(Entity entity, TransformComponent& transform);
+    void DetachTransform(Entity entity);
 };
 
+template<typename T, typename... Args>
+T& Scene::AddComponent(Entity entity, Args&&... args)
+{
+    const ComponentTypeInfo& info = ComponentTypeInfo::Get<T>();
+    assert(IsAlive(entity));
+    EntityRecord& record = entityRecords[entity.index];
+
+    T component(std::forward<Args>(args)...);
+    if (void* existing = GetComponentData(entity, info))
+    {
+        *static_cast<T*>(existing) = std::move(component);
+        return *static_cast<T*>(existing);
+    }
+
+    if constexpr (std::is_base_of_v<RendererComponent, T>) ClearRenderCache(entity);
+    if constexpr (std::is_base_of_v<RendererComponent, T> || std::is_same_v<T, TransformComponent>) RemoveSpatialProxy(entity);
+
+    MoveEntity(entity, GetArchetypeWith(record.archetype, info));
+    void* data = record.archetype->GetComponent(record.row, record.archetype->GetColumnIndex(info.id));
+    T* result = new (data) T(std::move(component));
+
+    if constexpr (std::is_same_v<T, TransformComponent>) AttachTransform(entity, *result);
+    if constexpr (std::is_base_of_v<RendererComponent, T>) UpdateRenderCache(entity);
+    return *result;
+}
+
+template<typename... Ts, typename Fn>
+void Scene::AddEntities(size_t count, Fn&& init, std::vector<Entity>* outEntities)
+{
+    static_assert((std::is_default_constructible_v<Ts> && ...), "AddEntities requires default-constructible components");
+
+    Archetype* archetype = GetOrCreateArchetype({ &ComponentTypeInfo::Get<Ts>()... });
+    const int columns[] = { archetype->GetColumnIndex(GetComponentTypeId<Ts>())... };
+    entityRecords.reserve(entityRecords.size() + count);
+    if (outEntities) outEntities->reserve(outEntities->size() + count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Entity entity = AllocateEntity(archetype);
+        const uint32_t row = entityRecords[entity.index].row;
+        auto components = ConstructComponents<Ts...>(*archetype, row, columns, std::index_sequence_for<Ts...>{});
+        std::apply([&](Ts*... component) { init(i, *component...); }, components);
+        if constexpr ((std::is_same_v<Ts, TransformComponent> || ...)) AttachTransform(entity, *std::get<TransformComponent*>(components));
+
+        QueueRenderers(entity);
+        if (outEntities) outEntities->push_back(entity);
+    }
+
+    if (!deferredRenderCacheSort) FlushRenderCache();
+}
+
+template<typename... Ts, size_t... I>
+std::tuple<Ts*...> Scene::ConstructComponents(Archetype& archetype, uint32_t row, const int* columns, std::index_sequence<I...>)
+{
+    return std::tuple<Ts*...>(new (archetype.GetComponent(row, columns[I])) Ts()...);
+}
+
+template<typename T>
+void Scene::RemoveComponent(Entity entity)
+{
+    const ComponentTypeInfo& info = ComponentTypeInfo::Get<T>();
+    if (!IsAlive(entity)) return;
+    EntityRecord& record = entityRecords[entity.index];
+    if (!record.archetype->HasType(info.id)) return;
+
+    if constexpr (std::is_base_of_v<RendererComponent, T>) ClearRenderCache(entity);
+    if constexpr (std::is_same_v<T, TransformComponent>) DetachTransform(entity);
+    if constexpr (std::is_base_of_v<RendererComponent, T> || std::is_same_v<T, TransformComponent>) RemoveSpatialProxy(entity);
+    MoveEntity(entity, GetArchetypeWithout(record.archetype, info));
+    if constexpr (std::is_base_of_v<RendererComponent, T>) UpdateRenderCache(entity);
+}
+
+template<typename Fn>
+void Scene::QueryBox(const DirectX::BoundingBox& box, Fn&& fn) const
+{
+    spatialIndex.QueryAabb(Aabb::FromBoundingBox(box), [&](int32_t proxy)
+    {
+        fn(UnpackEntity(spatialIndex.GetUserData(proxy)));
+        return true;
+    });
+}
+
+template<typename Fn>
+void Scene::QuerySphere(const DirectX::BoundingSphere& sphere, Fn&& fn) const
+{
+    spatialIndex.QuerySphere(sphere.Center, sphere.Radius, [&](int32_t proxy)
+    {
+        fn(UnpackEntity(spatialIndex.GetUserData(proxy)));
+        return true;
+    });
+}
+
+template<typename Fn>
+void Scene::QueryFrustum(const Frustum& frustum, Fn&& fn) const
+{
+    spatialIndex.QueryFrustum(frustum, [&](int32_t proxy)
+    {
+        fn(UnpackEntity(spatialIndex.GetUserData(proxy)));
+        return true;
+    });
+}
+
+template<typename T>
+T* Scene::GetComponent(Entity entity)
+{
+    return static_cast<T*>(GetComponentData(entity, ComponentTypeInfo::Get<T>()));
+}
+
+template<typename... Ts, typename Fn>
+void Scene::ForEach(Fn&& fn)
+{
+    static_assert(sizeof...(Ts) > 0, "ForEach requires at least one component type");
+    const ComponentTypeId queryTypes[] = { GetComponentTypeId<Ts>()... };
+    ComponentMask query;
+    for (ComponentTypeId type : queryTypes) query.set(type);
+
+    for (auto& archetype : archetypes)
+    {
+        if ((archetype->GetMask() & query) != query) continue;
+
+        int columns[sizeof...(Ts)];
+        for (size_t i = 0; i < sizeof...(Ts); ++i)
+        {
+            columns[i] = archetype->GetColumnIndex(queryTypes[i]);
+        }
+
+        for (size_t chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+        {
+            ForEachInChunk<Ts...>(*archetype, chunk, columns, fn, std::index_sequence_for<Ts...>{});
+        }
+    }
+}
+
+template<typename... Ts, typename Fn>
+void Scene::ForEachParallel(Fn&& fn)
+{
+    static_assert(sizeof...(Ts) > 0, "ForEachParallel requires at least one component type");
+    ComponentMask query;
+    (query.set(GetComponentTypeId<Ts>()), ...);
+
+    ChunkRef* chunks = nullptr;
+    const size_t chunkCount = CollectChunks(query, chunks);
+    if (CommandRecordingScope::IsInChunk())
+    {
+        for (size_t i = 0; i < chunkCount; ++i)
+        {
+            Archetype& archetype = *chunks[i].first;
+            const int columns[] = { archetype.GetColumnIndex(GetComponentTypeId<Ts>())... };
+            ForEachInChunk<Ts...>(archetype, chunks[i].second, columns, fn, std::index_sequence_for<Ts...>{});
+        }
+        return;
+    }
+
+    const CommandOrigin origin = CommandRecordingScope::BeginParallel();
+    JobSystem::Get().ParallelFor(chunkCount, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            CommandRecordingScope scope(origin, static_cast<uint32_t>(i));
+            Archetype& archetype = *chunks[i].first;
+            const int columns[] = { archetype.GetColumnIndex(GetComponentTypeId<Ts>())... };
+            ForEachInChunk<Ts...>(archetype, chunks[i].second, columns, fn, std::index_sequence_for<Ts...>{});
+        }
+    });
+}
+
+template<typename... Ts, typename Fn, size_t... I>
+void Scene::ForEachInChunk(const Archetype& archetype, size_t chunk, const int* columns, Fn& fn, std::index_sequence<I...>)
+{
+    const Entity* chunkEntities = archetype.GetEntities(chunk);
+    const uint32_t count = archetype.GetChunkSize(chunk);
+    std::tuple<Ts*...> arrays{ static_cast<Ts*>(archetype.GetColumn(chunk, columns[I]))... };
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        fn(chunkEntities[i], std::get<I>(arrays)[i]...);
+    }
+}
@@ -0,0 +1,168 @@
+#include "SceneCommandBuffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+SceneCommandBuffer::SceneCommandBuffer()
+{
+    recording.epoch = NextEpoch();
+}
+
+SceneCommandBuffer::~SceneCommandBuffer()
+{
+    for (Storage* storage : { &recording, &playing })
+    {
+        for (const auto& command : storage->commands)
+        {
+            if (command.destroyPayload) command.destroyPayload(command.payload);
+        }
+        storage->Release();
+    }
+}
+
+Entity SceneCommandBuffer::CreateEntity()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Entity entity{ PendingFlag | recording.pendingEntityCount++, recording.epoch };
+    Push({ CommandType::CreateEntity, false, entity, nullptr, nullptr, nullptr });
+    return entity;
+}
+
+void SceneCommandBuffer::RemoveEntity(Entity entity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Push({ CommandType::RemoveEntity, false, entity, nullptr, nullptr, nullptr });
+}
+
+void SceneCommandBuffer::SetHidden(Entity entity, bool hidden)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Push({ CommandType::SetHidden, hidden, entity, nullptr, nullptr, nullptr });
+}
+
+bool SceneCommandBuffer::IsEmpty() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return recording.commands.empty();
+}
+
+void SceneCommandBuffer::Playback(Scene& scene)
+{
+    {
+        // Забираем накопленное; команды, записанные во время воспроизведения, попадут в следующий Playback
+        std::lock_guard<std::mutex> lock(mutex);
+        if (recording.commands.empty()) return;
+        std::swap(recording, playing);
+        recording.epoch = NextEpoch();
+    }
+
+    // Системы записывают команды параллельно, и порядок прихода зависит от потоков
+    auto byOrigin = [](const Command& a, const Command& b) { return a.origin < b.origin; };
+    if (!std::is_sorted(playing.commands.begin(), playing.commands.end(), byOrigin))
+    {
+        std::stable_sort(playing.commands.begin(), playing.commands.end(), byOrigin);
+    }
+
+    resolvedEntities.assign(playing.pendingEntityCount, Entity{});
+    auto resolve = [this](Entity entity)
+    {
+        return IsPending(entity) ? ResolvePending(entity) : entity;
+    };
+
+    const bool wasDeferred = scene.IsRenderCacheSortDeferred();
+    scene.SetDeferredRenderCacheSort(true);
+
+    for (const auto& command : playing.commands)
+    {
+        switch (command.type)
+        {
+        case CommandType::CreateEntity:
+            resolvedEntities[command.entity.index & ~PendingFlag] = scene.CreateEntity();
+            break;
+        case CommandType::RemoveEntity:
+            scene.RemoveEntity(resolve(command.entity));
+            break;
+        case CommandType::SetHidden:
+            scene.SetHidden(resolve(command.entity), command.hidden);
+            break;
+        case CommandType::AddComponent:
+        case CommandType::RemoveComponent:
+        {
+            // Сущность могла быть удалена более ранней командой - такие команды пропускаем
+            Entity target = resolve(command.entity);
+            if (scene.IsAlive(target)) command.apply(scene, target, command.payload);
+            break;
+        }
+        }
+        if (command.destroyPayload) command.destroyPayload(command.payload);
+    }
+
+    // Все новые рендереры вливаются в кэш одной пачкой
+    scene.SetDeferredRenderCacheSort(wasDeferred);
+    scene.FlushRenderCache();
+    playing.Reset();
+}
+
+void SceneCommandBuffer::Push(const Command& command)
+{
+    recording.commands.push_back(command);
+    CommandOrigin& origin = recording.commands.back().origin;
+    origin = CommandRecordingScope::Next();
+    if (origin.system == 0) origin.step = static_cast<uint32_t>(recording.commands.size() - 1);
+}
+
+uint32_t SceneCommandBuffer::NextEpoch()
+{
+    // Общий счётчик для всех буферов: временные Entity разных буферов не совпадают. Ноль пропускаем,
+    // чтобы Entity с PendingFlag и нулевым поколением никогда не считалась своей.
+    static std::atomic<uint32_t> nextEpoch{ 1 };
+    uint32_t epoch = nextEpoch.fetch_add(1, std::memory_order_relaxed);
+    if (epoch == 0) epoch = nextEpoch.fetch_add(1, std::memory_order_relaxed);
+    return epoch;
+}
+
+Entity SceneCommandBuffer::ResolvePending(Entity entity) const
+{
+    const uint32_t slot = entity.index & ~PendingFlag;
+    if (entity.generation != playing.epoch || slot >= resolvedEntities.size()) return Entity{};
+    return resolvedEntities[slot];
+}
+
+void* SceneCommandBuffer::Storage::Allocate(size_t size, size_t alignment)
+{
+    assert(size <= PageSize && alignment <= PageAlignment);
+    for (;;)
+    {
+        if (pageIndex == pages.size())
+        {
+            pages.push_back(static_cast<std::byte*>(::operator new(PageSize, std::align_val_t{ PageAlignment })));
+        }
+
+        size_t offset = (pageOffset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= PageSize)
+        {
+            pageOffset = offset + size;
+            return pages[pageIndex] + offset;
+        }
+        ++pageIndex;
+        pageOffset = 0;
+    }
+}
+
+void SceneCommandBuffer::Storage::Reset()
+{
+    commands.clear();
+    pageIndex = 0;
+    pageOffset = 0;
+    pendingEntityCount = 0;
+}
+
+void SceneCommandBuffer::Storage::Release()
+{
+    for (auto* page : pages)
+    {
+        ::operator delete(page, std::align_val_t{ PageAlignment });
+    }
+    pages.clear();
+    Reset();
+}
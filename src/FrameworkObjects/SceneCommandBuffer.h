@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "CommandRecordingScope.h"
+#include "Scene.h"
+
+// Буфер отложенных структурных изменений сцены.
+// Создание/удаление сущностей, добавление/удаление компонентов и скрытие можно записывать
+// из любого потока, в том числе во время Scene::Update; применяются они одним проходом в Playback.
+// Сущности, созданные через буфер, до Playback представлены временными Entity (IsPending),
+// которые можно передавать в последующие команды этого же буфера. В generation временной Entity
+// записана эпоха - номер записи, уникальный среди всех буферов; команды с временной Entity
+// другого буфера или уже воспроизведённой записи пропускаются.
+class SceneCommandBuffer
+{
+public:
+    static constexpr uint32_t PendingFlag = 0x80000000u;
+
+    SceneCommandBuffer();
+    ~SceneCommandBuffer();
+
+    SceneCommandBuffer(const SceneCommandBuffer&) = delete;
+    SceneCommandBuffer& operator=(const SceneCommandBuffer&) = delete;
+
+    static bool IsPending(Entity entity) { return !entity.IsNull() && (entity.index & PendingFlag) != 0; }
+
+    Entity CreateEntity();
+    void RemoveEntity(Entity entity);
+    void SetHidden(Entity entity, bool hidden);
+
+    template<typename T, typename... Args>
+    void AddComponent(Entity entity, Args&&... args);
+
+    template<typename T>
+    void RemoveComponent(Entity entity);
+
+    bool IsEmpty() const;
+
+    // Применяет все записанные команды: команды систем - в порядке их мест записи (CommandOrigin),
+    // так что результат не зависит от числа потоков, остальные - в порядке записи и раньше команд систем.
+    // Обновления кэша рендера копятся на время воспроизведения и сортируются один раз в конце.
+    void Playback(Scene& scene);
+
+private:
+    enum class CommandType : uint8_t
+    {
+        CreateEntity,
+        RemoveEntity,
+        SetHidden,
+        AddComponent,
+        RemoveComponent,
+    };
+
+    struct Command
+    {
+        CommandType type;
+        bool hidden;
+        Entity entity;
+        void* payload;
+        void (*apply)(Scene& scene, Entity entity, void* payload);
+        void (*destroyPayload)(void* payload);
+        CommandOrigin origin;
+    };
+
+    // Команды и их данные; данные лежат в страницах, которые не перемещаются при росте
+    // и переиспользуются между кадрами
+    struct Storage
+    {
+        std::vector<Command> commands;
+        std::vector<std::byte*> pages;
+        size_t pageIndex = 0;
+        size_t pageOffset = 0;
+        uint32_t pendingEntityCount = 0;
+        uint32_t epoch = 0; // generation временных Entity этой записи
+
+        void* Allocate(size_t size, size_t alignment);
+        void Reset();
+        void Release();
+    };
+
+    static constexpr size_t PageSize = 16 * 1024;
+    static constexpr size_t PageAlignment = 64;
+
+    static uint32_t NextEpoch();
+    // Сущность сцены для временной Entity из воспроизводимой записи; Entity{}, если она чужая
+    Entity ResolvePending(Entity entity) const;
+
+    void Push(const Command& command);
+
+    mutable std::mutex mutex;
+    Storage recording;
+    Storage playing;
+    std::vector<Entity> resolvedEntities;
+};
+
+template<typename T, typename... Args>
+void SceneCommandBuffer::AddComponent(Entity entity, Args&&... args)
+{
+    static_assert(sizeof(T) <= PageSize, "Component is too large for SceneCommandBuffer");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    void* payload = new (recording.Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+    Command command{ CommandType::AddComponent, false, entity, payload, nullptr, nullptr };
+    command.apply = [](Scene& scene, Entity target, void* data) { scene.AddComponent<T>(target, std::move(*static_cast<T*>(data))); };
+    command.destroyPayload = [](void* data) { static_cast<T*>(data)->~T(); };
+    Push(command);
+}
+
+template<typename T>
+void SceneCommandBuffer::RemoveComponent(Entity entity)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Command command{ CommandType::RemoveComponent, false, entity, nullptr, nullptr, nullptr };
+    command.apply = [](Scene& scene, Entity target, void*) { scene.RemoveComponent<T>(target); };
+    Push(command);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "ComponentType.h"
+
+class Scene;
+
+// Система - логика, которая обрабатывает компоненты сцены пачками (см. Scene::ForEach / ForEachParallel).
+// В конструкторе наследник объявляет, какие типы компонентов он читает и какие пишет;
+// по этим маскам SystemScheduler решает, какие системы можно выполнять одновременно.
+// Структурные изменения из системы делаются только через Scene::GetCommandBuffer(); они применяются
+// в порядке систем и чанков обхода, а не в порядке записи (см. CommandOrigin).
+class System
+{
+public:
+    virtual ~System() = default;
+    virtual void Update(Scene& scene, float deltaTime) = 0;
+
+    const ComponentMask& GetReads() const { return reads; }
+    const ComponentMask& GetWrites() const { return writes; }
+
+protected:
+    template<typename... Ts>
+    void Reads() { (reads.set(GetComponentTypeId<Ts>()), ...); }
+
+    template<typename... Ts>
+    void Writes() { (writes.set(GetComponentTypeId<Ts>()), ...); }
+
+private:
+    ComponentMask reads;
+    ComponentMask writes;
+};
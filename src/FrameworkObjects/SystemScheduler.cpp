@@ -0,0 +1,73 @@
+#include "SystemScheduler.h"
+#include <algorithm>
+#include "CommandRecordingScope.h"
+#include "../Core/Jobs/JobSystem.h"
+
+void SystemScheduler::AddSystem(std::unique_ptr<System> system)
+{
+    systems.push_back(std::move(system));
+    dirty = true;
+}
+
+const std::vector<std::vector<size_t>>& SystemScheduler::GetWaves()
+{
+    if (dirty) BuildWaves();
+    return waves;
+}
+
+void SystemScheduler::Run(Scene& scene, float deltaTime)
+{
+    for (const auto& wave : GetWaves())
+    {
+        // Команды буфера сцены помечаются номером системы, чтобы Playback применял их в одном порядке
+        auto update = [this, &scene, deltaTime](size_t index)
+        {
+            CommandRecordingScope scope(static_cast<uint32_t>(index));
+            systems[index]->Update(scene, deltaTime);
+        };
+
+        if (wave.size() == 1)
+        {
+            update(wave.front());
+            continue;
+        }
+        JobSystem& jobs = JobSystem::Get();
+        JobCounter counter;
+        for (size_t i = 1; i < wave.size(); ++i)
+        {
+            const size_t index = wave[i];
+            jobs.Run([&update, index]() { update(index); }, counter);
+        }
+        // Первую систему волны выполняет сам вызывающий поток, затем помогает с остальными
+        update(wave.front());
+        jobs.Wait(counter);
+    }
+}
+
+bool SystemScheduler::Conflicts(const System& a, const System& b)
+{
+    // Запись одной системы пересекается с чтением или записью другой
+    return (a.GetWrites() & (b.GetReads() | b.GetWrites())).any() || (b.GetWrites() & a.GetReads()).any();
+}
+
+void SystemScheduler::BuildWaves()
+{
+    // Уровень системы = 1 + максимальный уровень среди более ранних систем, с которыми она конфликтует
+    std::vector<size_t> levels(systems.size(), 0);
+    size_t levelCount = 0;
+    for (size_t j = 0; j < systems.size(); ++j)
+    {
+        for (size_t i = 0; i < j; ++i)
+        {
+            if (Conflicts(*systems[i], *systems[j])) levels[j] = std::max(levels[j], levels[i] + 1);
+        }
+        levelCount = std::max(levelCount, levels[j] + 1);
+    }
+
+    waves.assign(levelCount, {});
+    for (size_t j = 0; j < systems.size(); ++j)
+    {
+        waves[levels[j]].push_back(j);
+    }
+    dirty = false;
+}
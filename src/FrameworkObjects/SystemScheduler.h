@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "System.h"
+
+// Планировщик систем: строит граф зависимостей по объявленным чтениям/записям и
+// раскладывает системы по волнам. Внутри волны системы не конфликтуют и выполняются параллельно,
+// волны идут строго друг за другом. Конфликтующие системы упорядочены по порядку регистрации,
+// поэтому результат не зависит от числа потоков.
+class SystemScheduler
+{
+public:
+    void AddSystem(std::unique_ptr<System> system);
+    void Run(Scene& scene, float deltaTime);
+
+    size_t GetSystemCount() const { return systems.size(); }
+    const std::vector<std::vector<size_t>>& GetWaves();
+
+private:
+    static bool Conflicts(const System& a, const System& b);
+    void BuildWaves();
+
+    std::vector<std::unique_ptr<System>> systems;
+    std::vector<std::vector<size_t>> waves;
+    bool dirty = false;
+};
@@ -1,15 +1,73 @@
 #include "TransformComponent.h"
 
-
+using namespace DirectX;
 
 TransformComponent::TransformComponent(float x, float y, float z)
 {
-	this->x = x;
-	this->y = y;
-	this->z = z;
+	local.position = XMFLOAT3(x, y, z);
+}
+
+TransformComponent::TransformComponent(const TransformComponent& other)
+	: Component(other), local(other.GetLocal())
+{
+}
+
+TransformComponent& TransformComponent::operator=(const TransformComponent& other)
+{
+	if (this == &other) return *this;
+	Component::operator=(other);
+
+	const LocalTransform values = other.GetLocal();
+	SetPosition(values.position);
+	SetRotation(values.rotation);
+	SetScale(values.scale);
+	return *this;
+}
+
+XMFLOAT3 TransformComponent::GetPosition() const
+{
+	return hierarchy ? hierarchy->GetPosition(node) : local.position;
+}
+
+void TransformComponent::SetPosition(const XMFLOAT3& position)
+{
+	if (hierarchy) hierarchy->SetPosition(node, position);
+	else local.position = position;
+}
+
+XMFLOAT4 TransformComponent::GetRotation() const
+{
+	return hierarchy ? hierarchy->GetRotation(node) : local.rotation;
+}
+
+void TransformComponent::SetRotation(const XMFLOAT4& rotation)
+{
+	if (hierarchy) hierarchy->SetRotation(node, rotation);
+	else local.rotation = rotation;
+}
+
+XMFLOAT3 TransformComponent::GetScale() const
+{
+	return hierarchy ? hierarchy->GetScale(node) : local.scale;
+}
+
+void TransformComponent::SetScale(const XMFLOAT3& scale)
+{
+	if (hierarchy) hierarchy->SetScale(node, scale);
+	else local.scale = scale;
+}
+
+XMFLOAT4X4 TransformComponent::GetWorldMatrix() const
+{
+	if (hierarchy) return hierarchy->GetWorldMatrix(node);
+
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixAffineTransformation(XMLoadFloat3(&local.scale), XMVectorZero(),
+	                                                     XMLoadFloat4(&local.rotation), XMLoadFloat3(&local.position)));
+	return world;
 }
 
-void TransformComponent::Update(float deltaTime)
+LocalTransform TransformComponent::GetLocal() const
 {
-	// Например, обновление позиции
+	return hierarchy ? LocalTransform{ GetPosition(), GetRotation(), GetScale() } : local;
 }
@@ -1,14 +1,39 @@
 #pragma once
 #include "Component.h"
-#include "IUpdatable.h"
+#include "TransformHierarchy.h"
+#include <DirectXMath.h>
 
-class TransformComponent : public Component, public IUpdatable
+// Локальный трансформ сущности. Пока компонент не добавлен в сцену, значения хранятся в нём самом;
+// после добавления компонент - лишь ссылка на узел TransformHierarchy сцены, где лежат данные
+// и кэшированная мировая матрица. Иерархия задаётся через Scene::SetParent.
+class TransformComponent : public Component
 {
 public:
     TransformComponent(float x = 0.0f, float y = 0.0f, float z = 0.0f);
-    void Update(float deltaTime) override;
-    std::string GetType() const override { return "Transform"; }
+    // Копия не привязана к сцене; перемещение (в том числе между чанками) сохраняет привязку
+    TransformComponent(const TransformComponent& other);
+    TransformComponent(TransformComponent&& other) noexcept = default;
+    // Присваивание меняет только значения TRS, привязка к узлу остаётся прежней
+    TransformComponent& operator=(const TransformComponent& other);
+
+    const char* GetType() const override { return "Transform"; }
+
+    DirectX::XMFLOAT3 GetPosition() const;
+    void SetPosition(const DirectX::XMFLOAT3& position);
+    DirectX::XMFLOAT4 GetRotation() const;
+    void SetRotation(const DirectX::XMFLOAT4& rotation);
+    DirectX::XMFLOAT3 GetScale() const;
+    void SetScale(const DirectX::XMFLOAT3& scale);
+
+    // Для компонента в сцене - значение на момент последнего Scene::Update
+    DirectX::XMFLOAT4X4 GetWorldMatrix() const;
+
 private:
-    float x, y, z;
-};
+    friend class Scene;
+
+    LocalTransform GetLocal() const;
 
+    TransformHierarchy* hierarchy = nullptr;
+    uint32_t node = TransformHierarchy::InvalidNode;
+    LocalTransform local;
+};
@@ -0,0 +1,257 @@
+#include "TransformHierarchy.h"
+#include "../Core/Jobs/JobSystem.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    XMMATRIX XM_CALLCONV ComposeLocal(const XMFLOAT3& position, const XMFLOAT4& rotation, const XMFLOAT3& scale)
+    {
+        return XMMatrixAffineTransformation(XMLoadFloat3(&scale), XMVectorZero(), XMLoadFloat4(&rotation), XMLoadFloat3(&position));
+    }
+
+    // Переставляет значения так, что values[i] = old[order[i]]
+    template<typename T>
+    void Permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+    {
+        std::vector<T> result(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            result[i] = values[order[i]];
+        }
+        values.swap(result);
+    }
+}
+
+uint32_t TransformHierarchy::Create(const LocalTransform& local)
+{
+    uint32_t node;
+    if (!freeNodes.empty())
+    {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(slots.size());
+        slots.push_back(InvalidNode);
+        parents.push_back(InvalidNode);
+    }
+
+    const uint32_t slot = static_cast<uint32_t>(nodes.size());
+    slots[node] = slot;
+    parents[node] = InvalidNode;
+
+    nodes.push_back(node);
+    parentSlots.push_back(InvalidNode);
+    positions.push_back(local.position);
+    rotations.push_back(local.rotation);
+    scales.push_back(local.scale);
+    worlds.emplace_back();
+    XMStoreFloat4x4(&worlds.back(), ComposeLocal(local.position, local.rotation, local.scale));
+    dirty.push_back(0);
+    updateStamps.push_back(0);
+    MarkDirty(slot);
+
+    // Пока в иерархии только корни, новый корень в конце порядок не нарушает
+    if (!orderDirty && GetLevelCount() <= 1)
+    {
+        levelOffsets.assign({ 0u, static_cast<uint32_t>(nodes.size()) });
+    }
+    else
+    {
+        orderDirty = true;
+    }
+    return node;
+}
+
+void TransformHierarchy::Destroy(uint32_t node)
+{
+    const uint32_t slot = slots[node];
+    if (slot == InvalidNode) return;
+
+    // Слот вычищается при перестройке порядка, тогда же дети отвязываются и номер узла освобождается
+    nodes[slot] = InvalidNode;
+    slots[node] = InvalidNode;
+    destroyedNodes.push_back(node);
+    orderDirty = true;
+}
+
+bool TransformHierarchy::SetParent(uint32_t node, uint32_t parent)
+{
+    if (parents[node] == parent) return true;
+    for (uint32_t ancestor = parent; ancestor != InvalidNode; ancestor = parents[ancestor])
+    {
+        if (ancestor == node) return false;
+    }
+
+    parents[node] = parent;
+    MarkDirty(slots[node]);
+    orderDirty = true;
+    return true;
+}
+
+void TransformHierarchy::SetPosition(uint32_t node, const XMFLOAT3& position)
+{
+    const uint32_t slot = slots[node];
+    positions[slot] = position;
+    MarkDirty(slot);
+}
+
+void TransformHierarchy::SetRotation(uint32_t node, const XMFLOAT4& rotation)
+{
+    const uint32_t slot = slots[node];
+    rotations[slot] = rotation;
+    MarkDirty(slot);
+}
+
+void TransformHierarchy::SetScale(uint32_t node, const XMFLOAT3& scale)
+{
+    const uint32_t slot = slots[node];
+    scales[slot] = scale;
+    MarkDirty(slot);
+}
+
+void TransformHierarchy::MarkDirty(uint32_t slot)
+{
+    dirty[slot] = 1;
+    anyDirty.store(true, std::memory_order_relaxed);
+}
+
+void TransformHierarchy::Update()
+{
+    ++updateCount;
+    updatedNodeCount.store(0, std::memory_order_relaxed);
+    if (orderDirty) RebuildOrder();
+    if (!anyDirty.load(std::memory_order_relaxed)) return;
+    if (updatedNodes.size() < nodes.size()) updatedNodes.resize(nodes.size());
+
+    // Уровень d зависит только от уровня d - 1, поэтому внутри уровня слоты независимы
+    JobSystem& jobs = JobSystem::Get();
+    for (size_t level = 0; level + 1 < levelOffsets.size(); ++level)
+    {
+        const size_t begin = levelOffsets[level];
+        const size_t count = levelOffsets[level + 1] - begin;
+        if (count < ParallelThreshold)
+        {
+            UpdateRange(begin, begin + count);
+            continue;
+        }
+
+        const size_t grainSize = std::max<size_t>(256, count / (jobs.GetThreadCount() * 4));
+        jobs.ParallelFor(count, [this, begin](size_t first, size_t last) { UpdateRange(begin + first, begin + last); }, grainSize);
+    }
+
+    std::fill(dirty.begin(), dirty.end(), uint8_t(0));
+    anyDirty.store(false, std::memory_order_relaxed);
+}
+
+void TransformHierarchy::UpdateRange(size_t begin, size_t end)
+{
+    size_t count = 0;
+    for (size_t slot = begin; slot < end; ++slot)
+    {
+        const uint32_t parent = parentSlots[slot];
+        if (!dirty[slot] && (parent == InvalidNode || !dirty[parent])) continue;
+
+        // Помечаем пересчитанный узел, чтобы на следующем уровне пересчитались его дети
+        dirty[slot] = 1;
+        XMMATRIX world = ComposeLocal(positions[slot], rotations[slot], scales[slot]);
+        if (parent != InvalidNode) world = XMMatrixMultiply(world, XMLoadFloat4x4(&worlds[parent]));
+        XMStoreFloat4x4(&worlds[slot], world);
+        updateStamps[slot] = updateCount;
+        ++count;
+    }
+    if (count == 0) return;
+
+    // Место в updatedNodes резервируется одной операцией на диапазон, а не на узел
+    size_t offset = updatedNodeCount.fetch_add(count, std::memory_order_relaxed);
+    for (size_t slot = begin; slot < end; ++slot)
+    {
+        if (updateStamps[slot] == updateCount) updatedNodes[offset++] = nodes[slot];
+    }
+}
+
+void TransformHierarchy::RebuildOrder()
+{
+    // Глубина каждого живого узла; цепочку предков без известной глубины проходим один раз
+    std::vector<uint32_t> depths(parents.size(), InvalidNode);
+    std::vector<uint32_t> chain;
+    uint32_t maxDepth = 0;
+    size_t liveCount = 0;
+
+    for (uint32_t node : nodes)
+    {
+        if (node == InvalidNode) continue;
+        ++liveCount;
+
+        chain.clear();
+        uint32_t current = node;
+        while (current != InvalidNode && depths[current] == InvalidNode)
+        {
+            chain.push_back(current);
+            uint32_t parent = parents[current];
+            if (parent != InvalidNode && slots[parent] == InvalidNode)
+            {
+                // Родитель удалён - узел становится корнем
+                parents[current] = InvalidNode;
+                MarkDirty(slots[current]);
+                parent = InvalidNode;
+            }
+            current = parent;
+        }
+
+        uint32_t depth = current == InvalidNode ? 0 : depths[current] + 1;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+        {
+            depths[*it] = depth++;
+        }
+        maxDepth = std::max(maxDepth, depths[node]);
+    }
+
+    // Устойчивая сортировка подсчётом по глубине
+    levelOffsets.assign(liveCount > 0 ? maxDepth + 2 : 1, 0);
+    for (uint32_t node : nodes)
+    {
+        if (node != InvalidNode) ++levelOffsets[depths[node] + 1];
+    }
+    for (size_t level = 1; level < levelOffsets.size(); ++level)
+    {
+        levelOffsets[level] += levelOffsets[level - 1];
+    }
+
+    std::vector<uint32_t> order(liveCount);
+    std::vector<uint32_t> cursor(levelOffsets.begin(), levelOffsets.end());
+    for (uint32_t slot = 0; slot < nodes.size(); ++slot)
+    {
+        if (nodes[slot] != InvalidNode) order[cursor[depths[nodes[slot]]]++] = slot;
+    }
+
+    Permute(nodes, order);
+    Permute(positions, order);
+    Permute(rotations, order);
+    Permute(scales, order);
+    Permute(worlds, order);
+    Permute(dirty, order);
+    Permute(updateStamps, order);
+
+    for (uint32_t slot = 0; slot < nodes.size(); ++slot)
+    {
+        slots[nodes[slot]] = slot;
+    }
+    parentSlots.resize(nodes.size());
+    for (uint32_t slot = 0; slot < nodes.size(); ++slot)
+    {
+        const uint32_t parent = parents[nodes[slot]];
+        parentSlots[slot] = parent == InvalidNode ? InvalidNode : slots[parent];
+    }
+
+    for (uint32_t node : destroyedNodes)
+    {
+        parents[node] = InvalidNode;
+        freeNodes.push_back(node);
+    }
+    destroyedNodes.clear();
+    orderDirty = false;
+}
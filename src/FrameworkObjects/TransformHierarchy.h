@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+struct LocalTransform
+{
+    DirectX::XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
+    DirectX::XMFLOAT4 rotation = { 0.0f, 0.0f, 0.0f, 1.0f }; // Кватернион
+    DirectX::XMFLOAT3 scale = { 1.0f, 1.0f, 1.0f };
+};
+
+// Иерархия трансформов сцены.
+// Локальные TRS и кэшированные мировые матрицы хранятся SoA-массивами, упорядоченными по глубине:
+// сначала все корни, затем их дети и т.д., поэтому родитель всегда пересчитан раньше ребёнка.
+// Узлы адресуются стабильными номерами, слоты в массивах меняются только при перестройке порядка.
+// Update пересчитывает только изменённые поддеревья: уровни обходятся по очереди,
+// внутри уровня - параллельно через JobSystem.
+class TransformHierarchy
+{
+public:
+    static constexpr uint32_t InvalidNode = UINT32_MAX;
+
+    uint32_t Create(const LocalTransform& local);
+    // Дети удалённого узла становятся корнями с прежними локальными трансформами
+    void Destroy(uint32_t node);
+
+    // parent == InvalidNode делает узел корнем. Локальный трансформ сохраняется, т.е. он задаётся
+    // уже относительно нового родителя. Возвращает false, если получился бы цикл.
+    bool SetParent(uint32_t node, uint32_t parent);
+    uint32_t GetParent(uint32_t node) const { return parents[node]; }
+
+    const DirectX::XMFLOAT3& GetPosition(uint32_t node) const { return positions[slots[node]]; }
+    const DirectX::XMFLOAT4& GetRotation(uint32_t node) const { return rotations[slots[node]]; }
+    const DirectX::XMFLOAT3& GetScale(uint32_t node) const { return scales[slots[node]]; }
+    void SetPosition(uint32_t node, const DirectX::XMFLOAT3& position);
+    void SetRotation(uint32_t node, const DirectX::XMFLOAT4& rotation);
+    void SetScale(uint32_t node, const DirectX::XMFLOAT3& scale);
+
+    // Актуальна после последнего Update
+    const DirectX::XMFLOAT4X4& GetWorldMatrix(uint32_t node) const { return worlds[slots[node]]; }
+    // Мировая матрица пересчитывалась в последнем Update
+    bool WasUpdated(uint32_t node) const { return updateStamps[slots[node]] == updateCount; }
+    // Узлы, мировые матрицы которых пересчитаны в последнем Update, в произвольном порядке
+    const uint32_t* GetUpdatedNodes() const { return updatedNodes.data(); }
+    size_t GetUpdatedNodeCount() const { return updatedNodeCount.load(std::memory_order_relaxed); }
+
+    void Update();
+
+    size_t GetNodeCount() const { return nodes.size(); }
+    size_t GetLevelCount() const { return levelOffsets.empty() ? 0 : levelOffsets.size() - 1; }
+
+private:
+    // Уровни меньше этого размера считаются на вызывающем потоке
+    static constexpr size_t ParallelThreshold = 1024;
+
+    void MarkDirty(uint32_t slot);
+    void RebuildOrder();
+    void UpdateRange(size_t begin, size_t end);
+
+    // По номеру узла
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> freeNodes;
+    std::vector<uint32_t> destroyedNodes; // Освобождаются после перестройки, чтобы дети успели отвязаться
+
+    // По слоту, упорядочено по глубине
+    std::vector<uint32_t> nodes;          // InvalidNode - слот удалённого узла
+    std::vector<uint32_t> parentSlots;    // InvalidNode у корней
+    std::vector<DirectX::XMFLOAT3> positions;
+    std::vector<DirectX::XMFLOAT4> rotations;
+    std::vector<DirectX::XMFLOAT3> scales;
+    std::vector<DirectX::XMFLOAT4X4> worlds;
+    std::vector<uint8_t> dirty;           // Локальный трансформ изменился или мировая матрица пересчитана в этом Update
+    std::vector<uint32_t> updateStamps;   // Номер Update, в котором мировая матрица пересчитана последний раз
+    std::vector<uint32_t> levelOffsets;   // Уровень d занимает слоты [levelOffsets[d], levelOffsets[d + 1])
+
+    std::vector<uint32_t> updatedNodes;   // Не короче nodes, заполнены первые updatedNodeCount
+    std::atomic<size_t> updatedNodeCount{ 0 };
+
+    uint32_t updateCount = 0;
+    bool orderDirty = false;
+    std::atomic<bool> anyDirty{ false }; // SetPosition и т.п. могут вызываться из параллельных систем
+};
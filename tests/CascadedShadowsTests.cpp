@@ -0,0 +1,303 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Common/Camera.h"
+#include "Core/Memory/FrameArena.h"
+#include "Core/Rendering/CascadedShadows.h"
+#include "Core/Rendering/FrustumCulling.h"
+#include "FrameworkObjects/Scene.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct OrthoBounds
+    {
+        float left, right, bottom, top, nearZ, farZ;
+    };
+
+    // Inverse of XMMatrixOrthographicOffCenterLH
+    OrthoBounds GetOrthoBounds(const XMFLOAT4X4& proj)
+    {
+        const float width = 2.0f / proj._11, height = 2.0f / proj._22;
+        const float centerX = -proj._41 / proj._11, centerY = -proj._42 / proj._22;
+        const float nearZ = -proj._43 / proj._33;
+        return { centerX - 0.5f * width, centerX + 0.5f * width, centerY - 0.5f * height, centerY + 0.5f * height, nearZ, nearZ + 1.0f / proj._33 };
+    }
+
+    XMFLOAT3 ToLight(const XMFLOAT4X4& view, const XMFLOAT3& p)
+    {
+        return XMFLOAT3(p.x * view._11 + p.y * view._21 + p.z * view._31 + view._41,
+                        p.x * view._12 + p.y * view._22 + p.z * view._32 + view._42,
+                        p.x * view._13 + p.y * view._23 + p.z * view._33 + view._43);
+    }
+
+    Camera MakeCamera(const XMFLOAT3& position, const XMFLOAT3& target)
+    {
+        Camera camera;
+        camera.SetLens(0.25f * XM_PI, 16.0f / 9.0f, 0.5f, 1000.0f);
+        camera.LookAt(position, target, XMFLOAT3(0.0f, 1.0f, 0.0f));
+        camera.UpdateViewMatrix();
+        return camera;
+    }
+
+    void TestSplitDistances()
+    {
+        const Camera camera = MakeCamera(XMFLOAT3(0.0f, 5.0f, 0.0f), XMFLOAT3(0.0f, 5.0f, 1.0f));
+        const float nearZ = camera.GetNearZ();
+        for (float lambda : { 0.0f, 0.5f, 0.75f, 1.0f })
+        {
+            CascadeSettings settings;
+            settings.splitLambda = lambda;
+            settings.maxDistance = 200.0f;
+            CascadedShadows shadows;
+            shadows.Update(camera, XMFLOAT3(0.3f, -1.0f, 0.2f), settings);
+            CHECK(shadows.GetCascadeCount() == 4);
+
+            // Consecutive slices share their split; the last one ends at maxDistance, not the far plane
+            CHECK(shadows.GetCascade(0).splitNear == nearZ);
+            CHECK(shadows.GetCascade(3).splitFar == settings.maxDistance);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                const ShadowCascade& cascade = shadows.GetCascade(i);
+                const float t = float(i + 1) / 4.0f;
+                const float logSplit = nearZ * std::pow(settings.maxDistance / nearZ, t);
+                const float uniformSplit = nearZ + (settings.maxDistance - nearZ) * t;
+                CHECK_NEAR(cascade.splitFar, lambda * logSplit + (1.0f - lambda) * uniformSplit, 1e-3f);
+                CHECK(cascade.splitNear < cascade.splitFar);
+                if (i > 0) CHECK(cascade.splitNear == shadows.GetCascade(i - 1).splitFar);
+            }
+        }
+
+        // Cascade count is clamped; a far plane closer than maxDistance ends the last slice
+        Camera shortCamera = camera;
+        shortCamera.SetLens(0.25f * XM_PI, 1.0f, 0.5f, 50.0f);
+        CascadeSettings settings;
+        settings.cascadeCount = 9;
+        CascadedShadows shadows;
+        shadows.Update(shortCamera, XMFLOAT3(0.0f, -1.0f, 0.0f), settings);
+        CHECK(shadows.GetCascadeCount() == CascadedShadows::MaxCascades);
+        CHECK(shadows.GetCascade(CascadedShadows::MaxCascades - 1).splitFar == 50.0f);
+        settings.cascadeCount = 0;
+        shadows.Update(shortCamera, XMFLOAT3(0.0f, -1.0f, 0.0f), settings);
+        CHECK(shadows.GetCascadeCount() == 1);
+    }
+
+    void TestSnappingIsStableUnderSubTexelMotion()
+    {
+        const XMFLOAT3 lightDirection(0.3f, -1.0f, 0.4f);
+        const XMFLOAT3 probe(1.234f, 0.5f, 3.21f);
+        CascadeSettings settings;
+        CascadedShadows shadows;
+        shadows.Update(MakeCamera(XMFLOAT3(0.0f, 10.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 0.0f)), lightDirection, settings);
+
+        float width[CascadedShadows::MaxCascades], probeFraction[CascadedShadows::MaxCascades], texelSize[CascadedShadows::MaxCascades];
+        for (uint32_t k = 0; k < shadows.GetCascadeCount(); ++k)
+        {
+            const ShadowCascade& cascade = shadows.GetCascade(k);
+            const OrthoBounds bounds = GetOrthoBounds(cascade.proj);
+            texelSize[k] = cascade.texelSize;
+            width[k] = bounds.right - bounds.left;
+            CHECK_NEAR(width[k] / cascade.texelSize, float(settings.resolution), 1e-2f);
+            const float texel = (ToLight(cascade.view, probe).x - bounds.left) / cascade.texelSize;
+            probeFraction[k] = texel - std::floor(texel);
+        }
+
+        // Move the camera by a fraction of the smallest texel per frame: the shadow map window only
+        // ever shifts by whole texels, so a fixed world point keeps its position inside its texel
+        size_t shifts = 0;
+        float previousLeft = GetOrthoBounds(shadows.GetCascade(0).proj).left;
+        for (int frame = 1; frame <= 200; ++frame)
+        {
+            const float offset = 0.37f * texelSize[0] * frame;
+            shadows.Update(MakeCamera(XMFLOAT3(offset, 10.0f + 0.5f * offset, -20.0f), XMFLOAT3(offset, 0.5f * offset, 0.0f)), lightDirection, settings);
+            for (uint32_t k = 0; k < shadows.GetCascadeCount(); ++k)
+            {
+                const ShadowCascade& cascade = shadows.GetCascade(k);
+                const OrthoBounds bounds = GetOrthoBounds(cascade.proj);
+                CHECK(cascade.texelSize == texelSize[k]);
+                CHECK_NEAR(bounds.right - bounds.left, width[k], 1e-3f * width[k]);
+
+                const float texel = (ToLight(cascade.view, probe).x - bounds.left) / cascade.texelSize;
+                const float fraction = texel - std::floor(texel);
+                const float drift = std::fabs(fraction - probeFraction[k]);
+                CHECK(std::min(drift, 1.0f - drift) < 0.02f);
+            }
+
+            const float left = GetOrthoBounds(shadows.GetCascade(0).proj).left;
+            if (left != previousLeft) ++shifts;
+            previousLeft = left;
+        }
+        // The camera moved about 74 texels of cascade 0 in x; the window followed
+        CHECK(shifts > 0 && shifts < 200);
+    }
+
+    void TestRadiusIsStableUnderRotation()
+    {
+        CascadeSettings settings;
+        CascadedShadows shadows;
+        shadows.Update(MakeCamera(XMFLOAT3(0.0f, 2.0f, 0.0f), XMFLOAT3(0.0f, 2.0f, 1.0f)), XMFLOAT3(0.3f, -1.0f, 0.4f), settings);
+        float radius[CascadedShadows::MaxCascades];
+        for (uint32_t k = 0; k < shadows.GetCascadeCount(); ++k) radius[k] = shadows.GetCascade(k).radius;
+
+        for (int step = 1; step < 64; ++step)
+        {
+            const float yaw = step * 0.1f, pitch = 0.3f * std::sin(step * 0.37f);
+            const XMFLOAT3 target(std::sin(yaw) * std::cos(pitch), 2.0f + std::sin(pitch), std::cos(yaw) * std::cos(pitch));
+            shadows.Update(MakeCamera(XMFLOAT3(0.0f, 2.0f, 0.0f), target), XMFLOAT3(0.3f, -1.0f, 0.4f), settings);
+            for (uint32_t k = 0; k < shadows.GetCascadeCount(); ++k)
+            {
+                CHECK(shadows.GetCascade(k).radius == radius[k]);
+            }
+        }
+    }
+
+    void TestOffscreenCastersTowardsTheLight()
+    {
+        // Light straight down, camera looking along +z at head height
+        CascadeSettings settings;
+        CascadedShadows shadows;
+        shadows.Update(MakeCamera(XMFLOAT3(0.0f, 2.0f, 0.0f), XMFLOAT3(0.0f, 2.0f, 1.0f)), XMFLOAT3(0.0f, -1.0f, 0.0f), settings);
+        const float depth = 0.5f * (shadows.GetCascade(0).splitNear + shadows.GetCascade(0).splitFar);
+
+        FrustumCuller boxes;
+        boxes.Add(XMFLOAT3(0.0f, 2.0f, depth), XMFLOAT3(0.1f, 0.1f, 0.1f));     // 0: in view
+        boxes.Add(XMFLOAT3(0.0f, 150.0f, depth), XMFLOAT3(0.5f, 0.5f, 0.5f));   // 1: far above, out of view
+        boxes.Add(XMFLOAT3(0.0f, -150.0f, depth), XMFLOAT3(0.5f, 0.5f, 0.5f));  // 2: far below, beyond the receivers
+        boxes.Add(XMFLOAT3(5000.0f, 2.0f, depth), XMFLOAT3(0.5f, 0.5f, 0.5f));  // 3: far to the side
+        shadows.CullCasters(boxes);
+
+        const std::vector<uint32_t>& casters = shadows.GetCascade(0).casters;
+        CHECK(casters == std::vector<uint32_t>({ 0, 1 }));
+
+        // The near plane is pulled back to the top of box 1 (light-space z = -y)
+        const OrthoBounds bounds = GetOrthoBounds(shadows.GetCascade(0).proj);
+        CHECK_NEAR(bounds.nearZ, -150.5f, 1e-2f);
+        for (uint32_t k = 1; k < shadows.GetCascadeCount(); ++k)
+        {
+            for (uint32_t index : shadows.GetCascade(k).casters) CHECK(index != 3);
+        }
+    }
+
+    void TestCullCastersMatchesReference()
+    {
+        // More boxes than one block, so the parallel path and the SIMD tails all run
+        const Camera camera = MakeCamera(XMFLOAT3(10.0f, 30.0f, -40.0f), XMFLOAT3(60.0f, 0.0f, 80.0f));
+        CascadeSettings settings;
+        CascadedShadows shadows;
+        shadows.Update(camera, XMFLOAT3(-0.4f, -1.0f, 0.25f), settings);
+
+        FrustumCuller boxes;
+        constexpr uint32_t BoxCount = 40003;
+        for (uint32_t i = 0; i < BoxCount; ++i)
+        {
+            const XMFLOAT3 center(Test::Random(6 * i, -300.0f, 400.0f), Test::Random(6 * i + 1, -100.0f, 200.0f),
+                                  Test::Random(6 * i + 2, -300.0f, 400.0f));
+            const XMFLOAT3 extents(Test::Random(6 * i + 3, 0.1f, 4.0f), Test::Random(6 * i + 4, 0.1f, 4.0f), Test::Random(6 * i + 5, 0.1f, 4.0f));
+            boxes.Add(center, extents);
+        }
+        FrameArena::Get().BeginFrame();
+        shadows.CullCasters(boxes);
+
+        constexpr float Margin = 1e-3f;
+        for (uint32_t k = 0; k < shadows.GetCascadeCount(); ++k)
+        {
+            const ShadowCascade& cascade = shadows.GetCascade(k);
+            const OrthoBounds bounds = GetOrthoBounds(cascade.proj);
+            CHECK(std::is_sorted(cascade.casters.begin(), cascade.casters.end()));
+            std::vector<uint8_t> listed(BoxCount, 0);
+            for (uint32_t index : cascade.casters) listed[index] = 1;
+
+            // Boxes within the margin of a boundary may go either way
+            size_t inside = 0;
+            float nearest = FLT_MAX;
+            const float(&m)[4][4] = cascade.view.m;
+            for (uint32_t i = 0; i < BoxCount; ++i)
+            {
+                const XMFLOAT3 center = ToLight(cascade.view, boxes.GetCenter(i));
+                const XMFLOAT3 e = boxes.GetExtents(i);
+                float extent[3];
+                for (int column = 0; column < 3; ++column)
+                {
+                    extent[column] = e.x * std::fabs(m[0][column]) + e.y * std::fabs(m[1][column]) + e.z * std::fabs(m[2][column]);
+                }
+                const float gaps[] = {
+                    center.x + extent[0] - bounds.left, bounds.right - (center.x - extent[0]),
+                    center.y + extent[1] - bounds.bottom, bounds.top - (center.y - extent[1]),
+                    bounds.farZ - (center.z - extent[2]),
+                };
+                const float gap = *std::min_element(std::begin(gaps), std::end(gaps));
+                if (gap > Margin)
+                {
+                    CHECK(listed[i]);
+                    ++inside;
+                    nearest = std::min(nearest, center.z - extent[2]);
+                }
+                else if (gap < -Margin)
+                {
+                    CHECK(!listed[i]);
+                }
+            }
+            CHECK(inside > 0);
+            CHECK(bounds.nearZ <= nearest + Margin);
+        }
+    }
+
+    struct CasterRenderer : RendererComponent
+    {
+        uint32_t id = 0;
+        std::vector<uint32_t>* rendered = nullptr;
+
+        void Render(ComPtr<ID3D12GraphicsCommandList>&) override { rendered->push_back(id); }
+    };
+
+    struct Tag : Component {};
+
+    void TestRenderShadowCascadeSkipsStaleCasters()
+    {
+        Scene scene;
+        std::vector<uint32_t> rendered;
+        std::vector<Entity> entities;
+        scene.AddEntities<CasterRenderer>(4, [&](size_t i, CasterRenderer& renderer)
+        {
+            renderer.id = uint32_t(i);
+            renderer.rendered = &rendered;
+            renderer.SetBounds(BoundingBox(XMFLOAT3(0.0f, 0.0f, 5.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));
+        }, &entities);
+
+        CascadedShadows shadows;
+        shadows.Update(MakeCamera(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)), XMFLOAT3(0.0f, -1.0f, 0.0f), CascadeSettings());
+        FrameArena::Get().BeginFrame();
+        scene.PrepareShadows(shadows);
+        CHECK(shadows.GetCascade(0).casters.size() == 4);
+
+        // Structural changes between PrepareShadows and the shadow pass: entity 0 is removed, entity 1
+        // moves to another archetype, entity 2 is hidden and a new entity takes the freed slot
+        scene.RemoveEntity(entities[0]);
+        scene.AddComponent<Tag>(entities[1]);
+        scene.SetHidden(entities[2], true);
+        const Entity replacement = scene.CreateEntity();
+        CasterRenderer& renderer = scene.AddComponent<CasterRenderer>(replacement);
+        renderer.id = 99;
+        renderer.rendered = &rendered;
+
+        ComPtr<ID3D12GraphicsCommandList> commandList;
+        scene.RenderShadowCascade(commandList, shadows, 0);
+        std::sort(rendered.begin(), rendered.end());
+        CHECK(rendered == std::vector<uint32_t>({ 1, 3 }));
+    }
+}
+
+int main()
+{
+    TestSplitDistances();
+    TestSnappingIsStableUnderSubTexelMotion();
+    TestRadiusIsStableUnderRotation();
+    TestOffscreenCastersTowardsTheLight();
+    TestCullCastersMatchesReference();
+    TestRenderShadowCascadeSkipsStaleCasters();
+    return Test::Result();
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cmath>
+#include <cstdio>
+
+// Minimal checks for the test executables. A failed check prints its location and the test keeps
+// going; main returns Test::Result() so ctest sees the failure.
+namespace Test
+{
+    inline int& FailureCount()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline void Fail(const char* file, int line, const char* expression)
+    {
+        std::printf("%s(%d): check failed: %s\n", file, line, expression);
+        ++FailureCount();
+    }
+
+    inline int Result()
+    {
+        if (FailureCount() == 0)
+        {
+            std::printf("All checks passed\n");
+            return 0;
+        }
+        std::printf("%d check(s) failed\n", FailureCount());
+        return 1;
+    }
+}
+
+#define CHECK(expression) \
+    do { if (!(expression)) Test::Fail(__FILE__, __LINE__, #expression); } while (false)
+
+// For floating-point results compared against a tolerance
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { if (!(std::fabs(double(actual) - double(expected)) <= double(tolerance))) Test::Fail(__FILE__, __LINE__, #actual " ~ " #expected); } while (false)
@@ -0,0 +1,269 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Common/Camera.h"
+#include "Core/Common/d3dUtil.h"
+#include "Core/Rendering/ClusteredLights.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Squared distances within this of the radius may go either way through float rounding
+    constexpr float BoundaryTolerance = 1e-3f;
+
+    struct Sphere
+    {
+        XMFLOAT3 center;
+        float radius;
+    };
+
+    const XMFLOAT3 Eye(3.0f, 6.0f, -10.0f);
+    const XMFLOAT3 Target(-4.0f, 2.0f, 30.0f);
+
+    Camera MakeCamera()
+    {
+        Camera camera;
+        camera.SetLens(0.3f * XM_PI, 16.0f / 9.0f, 0.5f, 120.0f);
+        camera.LookAt(Eye, Target, XMFLOAT3(0.0f, 1.0f, 0.0f));
+        camera.UpdateViewMatrix();
+        return camera;
+    }
+
+    // Point and spot lights in and around the frustum, including ones behind the camera, across
+    // the near plane and past the far plane, plus a few directional lights
+    std::vector<Light> MakeLights(size_t count)
+    {
+        std::vector<Light> lights(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Light& light = lights[i];
+            const uint32_t seed = 8 * i;
+            light.type = i % 50 == 0 ? LightTypeDirectional : (Test::Hash(seed) % 2 == 0 ? LightTypeSpot : LightTypePoint);
+            light.Position = XMFLOAT3(Test::Random(seed + 1, -60.0f, 60.0f), Test::Random(seed + 2, -10.0f, 20.0f), Test::Random(seed + 3, -20.0f, 140.0f));
+            light.FalloffEnd = Test::Random(seed + 4, 0.5f, 12.0f);
+            light.SpotPower = Test::Random(seed + 5, 1.0f, 128.0f);
+            XMStoreFloat3(&light.Direction, XMVectorSet(Test::Random(seed + 6, -1.0f, 1.0f), Test::Random(seed + 7, -1.0f, 1.0f), 1.0f, 0.0f));
+        }
+        return lights;
+    }
+
+    // The sphere around the part of space a light reaches: FalloffEnd around a point light, and for
+    // a spot the smallest sphere around its cone, cut where pow(cos, SpotPower) drops below the cutoff
+    Sphere BoundingSphere(const Light& light)
+    {
+        Sphere sphere{ light.Position, light.FalloffEnd };
+        if (light.type != LightTypeSpot) return sphere;
+
+        const float cosAngle = std::pow(ClusteredLights::SpotCutoffIntensity, 1.0f / light.SpotPower);
+        const XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&light.Direction));
+        float distance;
+        if (cosAngle <= std::sqrt(0.5f))
+        {
+            // Wide cone: the sphere around the base disk also holds the apex
+            distance = light.FalloffEnd * cosAngle;
+            sphere.radius = light.FalloffEnd * std::sqrt(1.0f - cosAngle * cosAngle);
+        }
+        else
+        {
+            // Narrow cone: the sphere through the apex and the rim
+            distance = sphere.radius = light.FalloffEnd / (2.0f * cosAngle);
+        }
+        XMStoreFloat3(&sphere.center, XMVectorAdd(XMLoadFloat3(&light.Position), XMVectorScale(direction, distance)));
+        return sphere;
+    }
+
+    // View-space shape of cluster (x, y, z): the tile's slopes (x/z, y/z) and the slice's depths
+    struct Froxel
+    {
+        float left, right, bottom, top;
+        float nearZ, farZ;
+    };
+
+    Froxel GetFroxel(const Camera& camera, const ClusterGridParams& grid, uint32_t x, uint32_t y, uint32_t z)
+    {
+        const float nearZ = camera.GetNearZ(), farZ = camera.GetFarZ();
+        const float tanY = std::tan(camera.GetFovY() * 0.5f), tanX = tanY * camera.GetAspect();
+        Froxel froxel;
+        froxel.left = (2.0f * x / grid.tilesX - 1.0f) * tanX;
+        froxel.right = (2.0f * (x + 1) / grid.tilesX - 1.0f) * tanX;
+        froxel.top = (1.0f - 2.0f * y / grid.tilesY) * tanY;
+        froxel.bottom = (1.0f - 2.0f * (y + 1) / grid.tilesY) * tanY;
+        froxel.nearZ = nearZ * std::pow(farZ / nearZ, float(z) / grid.slicesZ);
+        froxel.farZ = z + 1 == grid.slicesZ ? farZ : nearZ * std::pow(farZ / nearZ, float(z + 1) / grid.slicesZ);
+        return froxel;
+    }
+
+    // Squared distance from p to the box around the froxel's corners. No light may be listed for a
+    // cluster whose box its sphere misses.
+    float DistanceToBox(const Froxel& f, const XMFLOAT3& p)
+    {
+        const float minX = std::min(f.left * f.nearZ, f.left * f.farZ), maxX = std::max(f.right * f.nearZ, f.right * f.farZ);
+        const float minY = std::min(f.bottom * f.nearZ, f.bottom * f.farZ), maxY = std::max(f.top * f.nearZ, f.top * f.farZ);
+        const float dx = std::max({ minX - p.x, p.x - maxX, 0.0f });
+        const float dy = std::max({ minY - p.y, p.y - maxY, 0.0f });
+        const float dz = std::max({ f.nearZ - p.z, p.z - f.farZ, 0.0f });
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // Exact squared distance from p to the froxel itself, a convex solid with six planes: zero inside,
+    // otherwise the nearest of the faces p projects into and of the twelve edges. Every light whose
+    // sphere reaches the froxel must be listed for the cluster.
+    float DistanceToFroxel(const Froxel& f, const XMFLOAT3& p)
+    {
+        // Inward unit normals n and offsets w, inside where dot(n, q) + w >= 0
+        const XMVECTOR normals[6] = {
+            XMVector3Normalize(XMVectorSet(1.0f, 0.0f, -f.left, 0.0f)), XMVector3Normalize(XMVectorSet(-1.0f, 0.0f, f.right, 0.0f)),
+            XMVector3Normalize(XMVectorSet(0.0f, 1.0f, -f.bottom, 0.0f)), XMVector3Normalize(XMVectorSet(0.0f, -1.0f, f.top, 0.0f)),
+            XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f) };
+        const float offsets[6] = { 0.0f, 0.0f, 0.0f, 0.0f, -f.nearZ, f.farZ };
+        auto signedDistance = [&](int plane, XMVECTOR q) { return XMVectorGetX(XMVector3Dot(normals[plane], q)) + offsets[plane]; };
+
+        const XMVECTOR point = XMLoadFloat3(&p);
+        float best = FLT_MAX;
+        bool inside = true;
+        for (int plane = 0; plane < 6; ++plane)
+        {
+            const float distance = signedDistance(plane, point);
+            if (distance >= 0.0f) continue;
+            inside = false;
+            const XMVECTOR projected = XMVectorSubtract(point, XMVectorScale(normals[plane], distance));
+            bool onFace = true;
+            for (int other = 0; other < 6 && onFace; ++other) onFace = other == plane || signedDistance(other, projected) >= -1e-5f;
+            if (onFace) best = std::min(best, distance * distance);
+        }
+        if (inside) return 0.0f;
+
+        XMVECTOR corners[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            const float depth = i < 4 ? f.nearZ : f.farZ;
+            const float slopeX = (i & 3) == 0 || (i & 3) == 3 ? f.left : f.right;
+            const float slopeY = (i & 3) < 2 ? f.bottom : f.top;
+            corners[i] = XMVectorSet(slopeX * depth, slopeY * depth, depth, 0.0f);
+        }
+        const int edges[12][2] = { { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 }, { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 } };
+        for (const auto& edge : edges)
+        {
+            const XMVECTOR a = corners[edge[0]], ab = XMVectorSubtract(corners[edge[1]], a);
+            const float t = std::clamp(XMVectorGetX(XMVector3Dot(XMVectorSubtract(point, a), ab)) / XMVectorGetX(XMVector3Dot(ab, ab)), 0.0f, 1.0f);
+            const XMVECTOR offset = XMVectorSubtract(point, XMVectorAdd(a, XMVectorScale(ab, t)));
+            best = std::min(best, XMVectorGetX(XMVector3Dot(offset, offset)));
+        }
+        return best;
+    }
+
+    // Every sphere against every cluster, compared with what Build found through the SIMD tile ranges,
+    // the box tests and the counting sort. Build may keep a light for a cluster its sphere misses only
+    // near the froxel's corners, where the box around them is looser than the tile's planes.
+    void CheckAgainstBruteForce(const Camera& camera, const std::vector<Light>& lights, const ClusterSettings& settings)
+    {
+        ClusteredLights clusters;
+        clusters.Build(camera, lights.data(), lights.size(), settings);
+        const ClusterGridParams grid = clusters.GetGridParams();
+        CHECK(clusters.GetClusterCount() == size_t(settings.tilesX) * settings.tilesY * settings.slicesZ);
+
+        std::vector<uint32_t> directional;
+        std::vector<XMFLOAT3> centers(lights.size());
+        std::vector<float> radii(lights.size());
+        const XMMATRIX view = camera.GetView();
+        for (uint32_t i = 0; i < lights.size(); ++i)
+        {
+            if (lights[i].type == LightTypeDirectional)
+            {
+                directional.push_back(i);
+                continue;
+            }
+            const Sphere sphere = BoundingSphere(lights[i]);
+            XMStoreFloat3(&centers[i], XMVector3TransformCoord(XMLoadFloat3(&sphere.center), view));
+            radii[i] = sphere.radius;
+        }
+        CHECK(clusters.GetGlobalLights() == directional);
+
+        const std::vector<uint32_t>& indices = clusters.GetLightIndices();
+        size_t missing = 0, extra = 0, unsorted = 0, assigned = 0;
+        uint32_t expectedOffset = 0;
+        for (uint32_t z = 0; z < grid.slicesZ; ++z)
+        {
+            for (uint32_t y = 0; y < grid.tilesY; ++y)
+            {
+                for (uint32_t x = 0; x < grid.tilesX; ++x)
+                {
+                    const Froxel froxel = GetFroxel(camera, grid, x, y, z);
+                    const ClusterRange& range = clusters.GetClusters()[clusters.GetClusterIndex(x, y, z)];
+                    CHECK(range.offset == expectedOffset);
+                    expectedOffset += range.count;
+                    const uint32_t* begin = indices.data() + range.offset;
+                    const uint32_t* end = begin + range.count;
+                    if (!std::is_sorted(begin, end) || std::adjacent_find(begin, end) != end) ++unsorted;
+
+                    for (uint32_t i = 0; i < lights.size(); ++i)
+                    {
+                        if (lights[i].type == LightTypeDirectional) continue;
+                        // The box holds the froxel, so spheres that miss the box need no exact test
+                        const float limit = radii[i] * radii[i];
+                        const float boxDistance = DistanceToBox(froxel, centers[i]);
+                        const bool listed = std::binary_search(begin, end, i);
+                        if (!listed && boxDistance < limit && DistanceToFroxel(froxel, centers[i]) < limit * (1.0f - BoundaryTolerance)) ++missing;
+                        if (listed && boxDistance > limit * (1.0f + BoundaryTolerance)) ++extra;
+                        assigned += listed;
+                    }
+                }
+            }
+        }
+        CHECK(expectedOffset == indices.size());
+        CHECK(assigned == indices.size());
+        CHECK(missing == 0);
+        CHECK(extra == 0);
+        CHECK(unsorted == 0);
+    }
+
+    void TestMatchesBruteForce()
+    {
+        const std::vector<Light> lights = MakeLights(600);
+        CheckAgainstBruteForce(MakeCamera(), lights, ClusterSettings());
+    }
+
+    // Tile counts that are not multiples of the SIMD width exercise the masked tail lanes
+    void TestMatchesBruteForceOnOddGrid()
+    {
+        const std::vector<Light> lights = MakeLights(400);
+        ClusterSettings settings;
+        settings.tilesX = 7;
+        settings.tilesY = 5;
+        settings.slicesZ = 11;
+        CheckAgainstBruteForce(MakeCamera(), lights, settings);
+    }
+
+    // A point light right in front of the camera reaches the clusters around the screen center in
+    // the slice of its depth, which the lookup in ClusterGridParams must find
+    void TestGridLookupFindsLight()
+    {
+        const Camera camera = MakeCamera();
+        Light light;
+        light.type = LightTypePoint;
+        light.FalloffEnd = 0.5f;
+        const XMVECTOR eye = XMLoadFloat3(&Eye);
+        const XMVECTOR look = XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&Target), eye));
+        XMStoreFloat3(&light.Position, XMVectorAdd(eye, XMVectorScale(look, 20.0f)));
+
+        ClusteredLights clusters;
+        clusters.Build(camera, &light, 1);
+        const ClusterGridParams grid = clusters.GetGridParams();
+        const uint32_t z = uint32_t(std::floor(std::log(20.0f) * grid.sliceScale + grid.sliceBias));
+        const ClusterRange& range = clusters.GetClusters()[clusters.GetClusterIndex(grid.tilesX / 2, grid.tilesY / 2, z)];
+        CHECK(range.count == 1);
+        CHECK(range.count == 1 && clusters.GetLightIndices()[range.offset] == 0);
+    }
+}
+
+int main()
+{
+    TestMatchesBruteForce();
+    TestMatchesBruteForceOnOddGrid();
+    TestGridLookupFindsLight();
+    return Test::Result();
+}
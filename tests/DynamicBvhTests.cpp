@@ -0,0 +1,128 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Spatial/DynamicBvh.h"
+#include <algorithm>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    Aabb RandomBox(uint32_t seed, float range)
+    {
+        const XMFLOAT3 center(Test::Random(6 * seed, -range, range), Test::Random(6 * seed + 1, -range, range),
+                              Test::Random(6 * seed + 2, -range, range));
+        const XMFLOAT3 extents(Test::Random(6 * seed + 3, 0.1f, 2.0f), Test::Random(6 * seed + 4, 0.1f, 2.0f),
+                               Test::Random(6 * seed + 5, 0.1f, 2.0f));
+        return Aabb::FromCenterExtents(center, extents);
+    }
+
+    bool Finds(const DynamicBvh& bvh, int32_t proxy)
+    {
+        bool found = false;
+        bvh.QueryAabb(bvh.GetBounds(proxy), [&](int32_t hit)
+        {
+            found = hit == proxy;
+            return !found;
+        });
+        return found;
+    }
+
+    // Every live proxy must be reachable through its own box, and a query must return exactly
+    // the proxies whose exact boxes overlap it
+    void CheckTree(const DynamicBvh& bvh, const std::vector<int32_t>& proxies, uint32_t seed)
+    {
+        CHECK(bvh.GetProxyCount() == proxies.size());
+        size_t missing = 0;
+        for (int32_t proxy : proxies)
+        {
+            if (!Finds(bvh, proxy)) ++missing;
+        }
+        CHECK(missing == 0);
+
+        for (uint32_t i = 0; i < 50; ++i)
+        {
+            const Aabb query = RandomBox(seed + i, 60.0f);
+            std::vector<int32_t> expected, found;
+            for (int32_t proxy : proxies)
+            {
+                if (bvh.GetBounds(proxy).Overlaps(query)) expected.push_back(proxy);
+            }
+            bvh.QueryAabb(query, [&](int32_t proxy)
+            {
+                found.push_back(proxy);
+                return true;
+            });
+            std::sort(expected.begin(), expected.end());
+            std::sort(found.begin(), found.end());
+            CHECK(found == expected);
+        }
+    }
+
+    void TestRefitAfterSetProxyBounds()
+    {
+        DynamicBvh bvh;
+        std::vector<int32_t> proxies;
+        for (uint32_t i = 0; i < 500; ++i) proxies.push_back(bvh.CreateProxy(RandomBox(i, 50.0f), i));
+
+        for (uint32_t i = 0; i < proxies.size(); i += 2) bvh.SetProxyBounds(proxies[i], RandomBox(1000 + i, 50.0f));
+        bvh.Refit();
+        CheckTree(bvh, proxies, 7000);
+    }
+
+    // Proxies created and destroyed between SetProxyBounds and Refit are paired with and
+    // rotated around subtrees whose boxes are still stale
+    void TestRefitAfterMixedUpdates()
+    {
+        DynamicBvh bvh;
+        std::vector<int32_t> proxies;
+        uint32_t seed = 0;
+        for (; seed < 300; ++seed) proxies.push_back(bvh.CreateProxy(RandomBox(seed, 50.0f), seed));
+
+        for (int frame = 0; frame < 20; ++frame)
+        {
+            for (size_t i = 0; i < proxies.size(); ++i)
+            {
+                if (Test::Hash(seed + uint32_t(i)) % 3 == 0) bvh.SetProxyBounds(proxies[i], RandomBox(seed + 5000 + uint32_t(i), 50.0f));
+            }
+            seed += uint32_t(proxies.size());
+
+            for (int i = 0; i < 20; ++i, ++seed) proxies.push_back(bvh.CreateProxy(RandomBox(seed, 50.0f), seed));
+            for (int i = 0; i < 15; ++i, ++seed)
+            {
+                const size_t victim = Test::Hash(seed) % proxies.size();
+                bvh.DestroyProxy(proxies[victim]);
+                proxies[victim] = proxies.back();
+                proxies.pop_back();
+            }
+            for (int i = 0; i < 10; ++i, ++seed)
+            {
+                const size_t mover = Test::Hash(seed) % proxies.size();
+                bvh.MoveProxy(proxies[mover], RandomBox(seed + 9000, 50.0f));
+            }
+
+            bvh.Refit();
+            CheckTree(bvh, proxies, 20000 + uint32_t(frame) * 100);
+        }
+    }
+
+    void TestRebuildKeepsProxies()
+    {
+        DynamicBvh bvh;
+        std::vector<int32_t> proxies;
+        for (uint32_t i = 0; i < 400; ++i) proxies.push_back(bvh.CreateProxy(RandomBox(i, 50.0f), i));
+        for (uint32_t i = 0; i < proxies.size(); i += 3) bvh.SetProxyBounds(proxies[i], RandomBox(3000 + i, 50.0f));
+
+        bvh.Rebuild();
+        CheckTree(bvh, proxies, 40000);
+        for (int32_t proxy : proxies) CHECK(bvh.GetFatBounds(proxy).Contains(bvh.GetBounds(proxy)));
+    }
+}
+
+int main()
+{
+    TestRefitAfterSetProxyBounds();
+    TestRefitAfterMixedUpdates();
+    TestRebuildKeepsProxies();
+    return Test::Result();
+}
@@ -0,0 +1,80 @@
+#include "Check.h"
+#include "Core/Common/GeometryGenerator.h"
+#include <vector>
+
+using MeshData = GeometryGenerator::MeshData;
+
+namespace
+{
+    // Packs a copy of the mesh and checks the stored indices against the unpacked ones
+    MeshData PackAndCompare(const MeshData& source)
+    {
+        MeshData mesh = source;
+        mesh.PackIndices();
+        CHECK(mesh.GetIndexCount() == source.Indices32.size());
+
+        bool same = mesh.GetIndexCount() == source.Indices32.size();
+        for (size_t i = 0; same && i < source.Indices32.size(); ++i)
+        {
+            const uint32_t index = mesh.Uses16BitIndices() ? mesh.Indices16[i] : mesh.Indices32[i];
+            same = index == source.Indices32[i];
+        }
+        CHECK(same);
+        return mesh;
+    }
+
+    void TestSmallMeshUses16Bits()
+    {
+        GeometryGenerator generator;
+        const MeshData mesh = PackAndCompare(generator.CreateBox(1.0f, 1.0f, 1.0f, 2));
+        CHECK(mesh.Uses16BitIndices());
+        CHECK(mesh.Indices32.empty());
+        CHECK(mesh.GetIndexData() == mesh.Indices16.data());
+        CHECK(mesh.GetIndexDataSize() == mesh.Indices16.size() * sizeof(uint16_t));
+    }
+
+    void TestLargestMeshFor16Bits()
+    {
+        // 256x256 vertices: the last vertex is index 65535, the largest a 16-bit index can address
+        GeometryGenerator generator;
+        const MeshData source = generator.CreateGrid(10.0f, 10.0f, 256, 256);
+        CHECK(source.Vertices.size() == 65536);
+
+        const MeshData mesh = PackAndCompare(source);
+        CHECK(mesh.Uses16BitIndices());
+        uint32_t largest = 0;
+        for (uint16_t index : mesh.Indices16) largest = index > largest ? index : largest;
+        CHECK(largest == 65535);
+    }
+
+    void TestLargerMeshKeeps32Bits()
+    {
+        GeometryGenerator generator;
+        const MeshData source = generator.CreateGrid(10.0f, 10.0f, 257, 256);
+        CHECK(source.Vertices.size() > 65536);
+
+        const MeshData mesh = PackAndCompare(source);
+        CHECK(!mesh.Uses16BitIndices());
+        CHECK(mesh.Vertices.size() == source.Vertices.size());
+        CHECK(mesh.GetIndexData() == mesh.Indices32.data());
+        CHECK(mesh.GetIndexDataSize() == mesh.Indices32.size() * sizeof(uint32_t));
+    }
+
+    void TestEmptyMeshIsUnchanged()
+    {
+        MeshData mesh;
+        mesh.PackIndices();
+        CHECK(!mesh.Uses16BitIndices());
+        CHECK(mesh.GetIndexCount() == 0);
+        CHECK(mesh.GetIndexDataSize() == 0);
+    }
+}
+
+int main()
+{
+    TestSmallMeshUses16Bits();
+    TestLargestMeshFor16Bits();
+    TestLargerMeshKeeps32Bits();
+    TestEmptyMeshIsUnchanged();
+    return Test::Result();
+}
@@ -0,0 +1,152 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Jobs/JobSystem.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Long randomized runs meant to shake out races in the deques, the shared queue and the job ring.
+// Build with -fsanitize=thread to have data races reported as well.
+namespace
+{
+    // Every job spawns a pseudo-random number of children and either waits for them itself or leaves
+    // them to the root counter, so deques are pushed, popped and stolen from at every depth.
+    void Spawn(JobSystem& jobs, JobCounter& root, std::atomic<uint64_t>& visited, uint32_t seed, uint32_t depth)
+    {
+        visited.fetch_add(1, std::memory_order_relaxed);
+        if (depth == 0) return;
+
+        const uint32_t children = Test::Hash(seed) % 6;
+        const bool waitHere = (Test::Hash(seed + 1) & 1) != 0;
+        JobCounter local;
+        for (uint32_t i = 0; i < children; ++i)
+        {
+            const uint32_t childSeed = Test::Hash(seed * 31 + i + 7);
+            jobs.Run([&jobs, &root, &visited, childSeed, depth]()
+            {
+                Spawn(jobs, root, visited, childSeed, depth - 1);
+            }, waitHere ? local : root);
+        }
+        if (waitHere) jobs.Wait(local);
+    }
+
+    // Same recursion without threads, to know how many jobs a seed produces
+    uint64_t CountSpawned(uint32_t seed, uint32_t depth)
+    {
+        uint64_t count = 1;
+        if (depth == 0) return count;
+        const uint32_t children = Test::Hash(seed) % 6;
+        for (uint32_t i = 0; i < children; ++i) count += CountSpawned(Test::Hash(seed * 31 + i + 7), depth - 1);
+        return count;
+    }
+
+    void StressRecursiveSpawning(uint32_t threadCount)
+    {
+        JobSystem jobs(threadCount);
+        for (uint32_t round = 0; round < 20; ++round)
+        {
+            const uint32_t seed = Test::Hash(round + 1);
+            std::atomic<uint64_t> visited{ 0 };
+            JobCounter root;
+            jobs.Run([&jobs, &root, &visited, seed]() { Spawn(jobs, root, visited, seed, 7); }, root);
+            jobs.Wait(root);
+            CHECK(visited.load() == CountSpawned(seed, 7));
+        }
+    }
+
+    // Several threads that are not workers submit and wait at the same time as the workers run
+    void StressForeignSubmitters(uint32_t threadCount)
+    {
+        JobSystem jobs(threadCount);
+        std::atomic<uint64_t> sum{ 0 };
+        std::vector<std::thread> producers;
+        for (uint32_t p = 0; p < 3; ++p)
+        {
+            producers.emplace_back([&jobs, &sum]()
+            {
+                for (uint32_t batch = 0; batch < 20; ++batch)
+                {
+                    JobCounter counter;
+                    for (uint32_t i = 0; i < 500; ++i)
+                    {
+                        jobs.Run([&sum, i]() { sum.fetch_add(i, std::memory_order_relaxed); }, counter);
+                    }
+                    jobs.Wait(counter);
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+        CHECK(sum.load() == 3ull * 20 * (499ull * 500 / 2));
+    }
+
+    // Chains of dependent jobs interleaved with free ones, well past the ring size
+    void StressDependencies(uint32_t threadCount)
+    {
+        JobSystem jobs(threadCount);
+        const uint32_t chainLength = 64;
+        std::vector<JobCounter> stages(chainLength);
+        std::vector<uint32_t> order;
+        order.reserve(chainLength);
+        std::atomic<uint32_t> filler{ 0 };
+
+        for (uint32_t stage = 0; stage < chainLength; ++stage)
+        {
+            const JobCounter* dependency = stage > 0 ? &stages[stage - 1] : nullptr;
+            jobs.Run([&order, stage]() { order.push_back(stage); }, stages[stage], dependency);
+            for (uint32_t i = 0; i < 200; ++i)
+            {
+                jobs.Run([&filler]() { filler.fetch_add(1, std::memory_order_relaxed); }, stages[stage]);
+            }
+        }
+        jobs.Wait(stages[chainLength - 1]);
+        for (auto& stage : stages) jobs.Wait(stage);
+
+        bool ordered = order.size() == chainLength;
+        for (uint32_t i = 0; ordered && i < chainLength; ++i) ordered = order[i] == i;
+        CHECK(ordered);
+        CHECK(filler.load() == chainLength * 200);
+    }
+
+    void StressNestedParallelFor(uint32_t threadCount)
+    {
+        JobSystem jobs(threadCount);
+        const size_t outer = 300;
+        const size_t inner = 1000;
+        for (uint32_t round = 0; round < 5; ++round)
+        {
+            std::vector<uint64_t> rowSums(outer, 0);
+            jobs.ParallelFor(outer, [&](size_t first, size_t last)
+            {
+                for (size_t row = first; row < last; ++row)
+                {
+                    std::atomic<uint64_t> sum{ 0 };
+                    jobs.ParallelFor(inner, [&sum, row](size_t begin, size_t end)
+                    {
+                        uint64_t local = 0;
+                        for (size_t i = begin; i < end; ++i) local += row * i;
+                        sum.fetch_add(local, std::memory_order_relaxed);
+                    }, 37);
+                    rowSums[row] = sum.load();
+                }
+            }, 1);
+
+            bool correct = true;
+            for (size_t row = 0; row < outer; ++row) correct = correct && rowSums[row] == row * (inner * (inner - 1) / 2);
+            CHECK(correct);
+        }
+    }
+}
+
+int main()
+{
+    const uint32_t threadCounts[] = { 1, 2, 4, 8 };
+    for (uint32_t threadCount : threadCounts)
+    {
+        StressRecursiveSpawning(threadCount);
+        StressForeignSubmitters(threadCount);
+        StressDependencies(threadCount);
+        StressNestedParallelFor(threadCount);
+    }
+    return Test::Result();
+}
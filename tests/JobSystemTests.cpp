@@ -0,0 +1,193 @@
+#include "Check.h"
+#include "Core/Jobs/JobSystem.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void TestRunAndWait()
+    {
+        JobSystem jobs(4);
+        JobCounter counter;
+        CHECK(counter.IsDone());
+
+        std::atomic<int> sum{ 0 };
+        for (int i = 1; i <= 100; ++i)
+        {
+            jobs.Run([&sum, i]() { sum.fetch_add(i); }, counter);
+        }
+        jobs.Wait(counter);
+        CHECK(counter.IsDone());
+        CHECK(sum.load() == 5050);
+    }
+
+    void TestParallelForCoversEveryIndexOnce()
+    {
+        JobSystem jobs(4);
+        const size_t counts[] = { 0, 1, 7, 64, 1000, 100003 };
+        const size_t grains[] = { 0, 1, 13, 4096 };
+        for (size_t count : counts)
+        {
+            for (size_t grain : grains)
+            {
+                std::vector<std::atomic<uint32_t>> hits(count);
+                jobs.ParallelFor(count, [&hits](size_t first, size_t last)
+                {
+                    for (size_t i = first; i < last; ++i) hits[i].fetch_add(1);
+                }, grain);
+
+                bool once = true;
+                for (auto& hit : hits) once = once && hit.load() == 1;
+                CHECK(once);
+            }
+        }
+    }
+
+    void TestNestedParallelFor()
+    {
+        JobSystem jobs(4);
+        std::vector<std::atomic<uint32_t>> hits(64 * 64);
+        jobs.ParallelFor(64, [&](size_t first, size_t last)
+        {
+            for (size_t row = first; row < last; ++row)
+            {
+                jobs.ParallelFor(64, [&hits, row](size_t begin, size_t end)
+                {
+                    for (size_t column = begin; column < end; ++column) hits[row * 64 + column].fetch_add(1);
+                }, 8);
+            }
+        }, 1);
+
+        bool once = true;
+        for (auto& hit : hits) once = once && hit.load() == 1;
+        CHECK(once);
+    }
+
+    void TestDependencyRunsAfterItsCounter()
+    {
+        JobSystem jobs(4);
+        for (int iteration = 0; iteration < 50; ++iteration)
+        {
+            JobCounter first;
+            JobCounter second;
+            std::atomic<int> finished{ 0 };
+            std::atomic<bool> orderKept{ true };
+
+            for (int i = 0; i < 16; ++i)
+            {
+                jobs.Run([&finished]() { finished.fetch_add(1); }, first);
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                jobs.Run([&]() { if (finished.load() != 16) orderKept.store(false); }, second, &first);
+            }
+            jobs.Wait(second);
+            CHECK(orderKept.load());
+        }
+    }
+
+    void TestSubmitFromForeignThread()
+    {
+        JobSystem jobs(2);
+        JobCounter counter;
+        std::atomic<int> sum{ 0 };
+        std::thread producer([&]()
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                jobs.Run([&sum]() { sum.fetch_add(1); }, counter);
+            }
+            jobs.Wait(counter);
+        });
+        producer.join();
+        CHECK(sum.load() == 1000);
+    }
+
+    // More than MaxJobsPerThread jobs in flight from one thread: the ring slots of jobs that have not
+    // run yet must not be handed out again, or their callables get overwritten.
+    void TestRingSlotsAreNotReusedWhileInFlight()
+    {
+        JobSystem jobs(2);
+        const uint32_t jobCount = JobSystem::MaxJobsPerThread * 3;
+        std::vector<uint32_t> results(jobCount, 0);
+        std::atomic<bool> started{ false };
+        std::atomic<bool> release{ false };
+
+        JobCounter counter;
+        // Holds the second thread so everything submitted below stays queued
+        jobs.Run([&]()
+        {
+            started.store(true);
+            while (!release.load()) std::this_thread::yield();
+        }, counter);
+        while (!started.load()) std::this_thread::yield();
+
+        for (uint32_t i = 0; i < jobCount; ++i)
+        {
+            uint32_t* result = &results[i];
+            jobs.Run([result, i]() { *result = i * 2 + 1; }, counter);
+        }
+        release.store(true);
+        jobs.Wait(counter);
+
+        bool allRan = true;
+        for (uint32_t i = 0; i < jobCount; ++i) allRan = allRan && results[i] == i * 2 + 1;
+        CHECK(allRan);
+    }
+
+    // A job waiting on work its submitter has not spawned yet; waiting for its slot would deadlock
+    void TestBlockedJobDoesNotStallSubmission()
+    {
+        JobSystem jobs(2);
+        JobCounter late;
+        JobCounter counter;
+        std::atomic<bool> lateSubmitted{ false };
+        std::atomic<int> sum{ 0 };
+
+        jobs.Run([&]()
+        {
+            while (!lateSubmitted.load()) std::this_thread::yield();
+            jobs.Wait(late);
+        }, counter);
+        for (uint32_t i = 0; i < JobSystem::MaxJobsPerThread + 16; ++i)
+        {
+            jobs.Run([&sum]() { sum.fetch_add(1); }, late);
+        }
+        lateSubmitted.store(true);
+        jobs.Wait(counter);
+        CHECK(sum.load() == int(JobSystem::MaxJobsPerThread + 16));
+    }
+
+    void TestSingleThread()
+    {
+        JobSystem jobs(1);
+        CHECK(jobs.GetThreadCount() == 1);
+        JobCounter counter;
+        int sum = 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            jobs.Run([&sum]() { ++sum; }, counter);
+        }
+        jobs.Wait(counter);
+        CHECK(sum == 10);
+
+        size_t covered = 0;
+        jobs.ParallelFor(1000, [&covered](size_t first, size_t last) { covered += last - first; });
+        CHECK(covered == 1000);
+    }
+}
+
+int main()
+{
+    TestRunAndWait();
+    TestParallelForCoversEveryIndexOnce();
+    TestNestedParallelFor();
+    TestDependencyRunsAfterItsCounter();
+    TestSubmitFromForeignThread();
+    TestRingSlotsAreNotReusedWhileInFlight();
+    TestBlockedJobDoesNotStallSubmission();
+    TestSingleThread();
+    return Test::Result();
+}
@@ -0,0 +1,152 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Mesh/MeshSimplifier.h"
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+using MeshData = GeometryGenerator::MeshData;
+
+namespace
+{
+    constexpr float GridSize = 10.0f;
+
+    size_t Simplify(const MeshData& mesh, std::vector<uint32_t>& destination, const SimplifySettings& settings, float& error)
+    {
+        destination.resize(mesh.Indices32.size());
+        const size_t count = SimplifyMesh(destination.data(), mesh.Indices32.data(), mesh.Indices32.size(), &mesh.Vertices[0].Position.x,
+                                          sizeof(GeometryGenerator::Vertex), mesh.Vertices.size(), settings, &error);
+        destination.resize(count);
+        return count;
+    }
+
+    // Area of the triangles projected onto the xz plane; a grid with its border in place
+    // covers GridSize * GridSize however its inside is triangulated
+    double ProjectedArea(const MeshData& mesh, const std::vector<uint32_t>& indices)
+    {
+        double area = 0.0;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const auto& a = mesh.Vertices[indices[i]].Position;
+            const auto& b = mesh.Vertices[indices[i + 1]].Position;
+            const auto& c = mesh.Vertices[indices[i + 2]].Position;
+            area += 0.5 * std::fabs(double(b.x - a.x) * (c.z - a.z) - double(c.x - a.x) * (b.z - a.z));
+        }
+        return area;
+    }
+
+    bool OnGridBorder(const DirectX::XMFLOAT3& p)
+    {
+        const float half = GridSize * 0.5f;
+        return std::fabs(std::fabs(p.x) - half) < 1e-4f || std::fabs(std::fabs(p.z) - half) < 1e-4f;
+    }
+
+    void TestTargetCountIsReached()
+    {
+        GeometryGenerator generator;
+        const MeshData mesh = generator.CreateSphere(1.0f, 64, 32);
+        SimplifySettings settings;
+        settings.targetIndexCount = mesh.Indices32.size() / 4 / 3 * 3;
+
+        std::vector<uint32_t> simplified;
+        float error = -1.0f;
+        const size_t count = Simplify(mesh, simplified, settings, error);
+        CHECK(count > 0);
+        CHECK(count <= settings.targetIndexCount);
+        CHECK(count % 3 == 0);
+        CHECK(error >= 0.0f);
+        CHECK(error < 0.1f);
+        for (uint32_t index : simplified) CHECK(index < mesh.Vertices.size());
+    }
+
+    void TestFlatGridHasZeroError()
+    {
+        GeometryGenerator generator;
+        const MeshData mesh = generator.CreateGrid(GridSize, GridSize, 33, 33);
+        SimplifySettings settings;
+        settings.targetIndexCount = mesh.Indices32.size() / 20 / 3 * 3;
+        settings.targetError = 0.0f;
+
+        std::vector<uint32_t> simplified;
+        float error = -1.0f;
+        const size_t count = Simplify(mesh, simplified, settings, error);
+        CHECK(count <= settings.targetIndexCount);
+        CHECK_NEAR(error, 0.0f, 1e-5f);
+        CHECK_NEAR(ProjectedArea(mesh, simplified), GridSize * GridSize, 1e-3);
+    }
+
+    // Open borders only collapse along themselves: however far a bumpy grid is simplified, every
+    // open edge of the result still runs along one side of the rectangle
+    void TestBorderStaysInPlace()
+    {
+        GeometryGenerator generator;
+        MeshData mesh = generator.CreateGrid(GridSize, GridSize, 33, 33);
+        for (size_t i = 0; i < mesh.Vertices.size(); ++i) mesh.Vertices[i].Position.y = Test::Random(uint32_t(i), 0.0f, 0.5f);
+        SimplifySettings settings;
+        settings.targetIndexCount = mesh.Indices32.size() / 10 / 3 * 3;
+
+        std::vector<uint32_t> simplified;
+        float error = 0.0f;
+        Simplify(mesh, simplified, settings, error);
+        CHECK(error > 0.0f);
+
+        std::map<std::pair<uint32_t, uint32_t>, int> edges;
+        for (size_t i = 0; i < simplified.size(); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k) ++edges[{ simplified[i + k], simplified[i + (k + 1) % 3] }];
+        }
+        size_t openEdges = 0, offBorder = 0;
+        for (const auto& edge : edges)
+        {
+            if (edges.count({ edge.first.second, edge.first.first })) continue;
+            ++openEdges;
+            const auto& a = mesh.Vertices[edge.first.first].Position;
+            const auto& b = mesh.Vertices[edge.first.second].Position;
+            const bool sameSide = (a.x == b.x && std::fabs(std::fabs(a.x) - GridSize * 0.5f) < 1e-4f) ||
+                                  (a.z == b.z && std::fabs(std::fabs(a.z) - GridSize * 0.5f) < 1e-4f);
+            if (!OnGridBorder(a) || !OnGridBorder(b) || !sameSide) ++offBorder;
+        }
+        CHECK(openEdges >= 4);
+        CHECK(offBorder == 0);
+    }
+
+    void TestLodChainLevels()
+    {
+        GeometryGenerator generator;
+        const MeshData mesh = generator.CreateSphere(1.0f, 64, 32);
+        const MeshLodChain chain = BuildLodChain(mesh);
+        CHECK(chain.levels.size() > 1);
+        CHECK(chain.levels[0].indexCount == mesh.Indices32.size());
+        for (size_t i = 1; i < chain.levels.size(); ++i)
+        {
+            const MeshLodChain::Level& level = chain.levels[i];
+            CHECK(level.startIndex == chain.levels[i - 1].startIndex + chain.levels[i - 1].indexCount);
+            CHECK(level.indexCount < chain.levels[i - 1].indexCount);
+            CHECK(level.error >= chain.levels[i - 1].error);
+        }
+        CHECK(chain.indices.size() == chain.levels.back().startIndex + chain.levels.back().indexCount);
+    }
+
+    void TestLodChainOfEmptyMesh()
+    {
+        MeshData mesh;
+        CHECK(BuildLodChain(mesh).levels.size() == 1);
+
+        // Indices without vertices, enough of them to ask for further levels, are not simplified
+        mesh.Indices32.assign(300, 0);
+        const MeshLodChain chain = BuildLodChain(mesh);
+        CHECK(chain.levels.size() == 1);
+        CHECK(chain.levels[0].indexCount == 300);
+    }
+}
+
+int main()
+{
+    TestTargetCountIsReached();
+    TestFlatGridHasZeroError();
+    TestBorderStaysInPlace();
+    TestLodChainLevels();
+    TestLodChainOfEmptyMesh();
+    return Test::Result();
+}
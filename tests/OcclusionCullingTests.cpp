@@ -0,0 +1,207 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Memory/FrameArena.h"
+#include "Core/Rendering/FrustumCulling.h"
+#include "Core/Rendering/OcclusionCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Camera at the origin looking along +z
+    XMMATRIX ViewProj()
+    {
+        const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        return XMMatrixMultiply(view, XMMatrixPerspectiveFovLH(0.5f * XM_PI, 2.0f, 0.1f, 500.0f));
+    }
+
+    XMFLOAT4X4 Identity()
+    {
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, XMMatrixIdentity());
+        return world;
+    }
+
+    // Quad facing the camera at depth z, covering [-halfSize, halfSize] in x and y
+    OccluderMesh MakeWall(float z, float halfSize)
+    {
+        OccluderMesh mesh;
+        mesh.positions = { { -halfSize, -halfSize, z }, { halfSize, -halfSize, z }, { halfSize, halfSize, z }, { -halfSize, halfSize, z } };
+        mesh.indices = { 0, 1, 2, 0, 2, 3 };
+        return mesh;
+    }
+
+    uint32_t GetLevelCount(const OcclusionCuller& culler)
+    {
+        uint32_t count = 1;
+        for (uint32_t width = culler.GetWidth(), height = culler.GetHeight(); width > 1 || height > 1; ++count)
+        {
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+        return count;
+    }
+
+    bool IsLevelClear(const OcclusionCuller& culler, uint32_t level)
+    {
+        const uint32_t width = (culler.GetWidth() + (1u << level) - 1) >> level;
+        const uint32_t height = (culler.GetHeight() + (1u << level) - 1) >> level;
+        const float* depth = culler.GetDepth(level);
+        for (size_t i = 0; i < size_t(width) * height; ++i)
+        {
+            if (depth[i] != 1.0f) return false;
+        }
+        return true;
+    }
+
+    void TestWallHidesBoxesBehindIt()
+    {
+        OcclusionCuller culler;
+        culler.BeginFrame(ViewProj());
+        culler.AddOccluder(MakeWall(10.0f, 5.0f), Identity());
+        culler.Rasterize();
+        CHECK(culler.HasOccluders());
+        CHECK(culler.GetStats().occluderTriangles == 2);
+
+        CHECK(!culler.IsVisible(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));   // Behind the wall
+        CHECK(culler.IsVisible(XMFLOAT3(0.0f, 0.0f, 5.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));     // In front of it
+        CHECK(culler.IsVisible(XMFLOAT3(30.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));   // Beside it
+        CHECK(culler.IsVisible(XMFLOAT3(10.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));   // Sticks out past the edge
+        CHECK(culler.IsVisible(XMFLOAT3(0.0f, 0.0f, 10.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));    // Intersects the wall
+        CHECK(culler.IsVisible(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));     // Crosses the near plane
+        CHECK(culler.IsVisible(XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)));   // Behind the camera
+    }
+
+    void TestNearClippedOccluder()
+    {
+        // A floor under the camera reaching behind it: only the clipped part is rasterized
+        OccluderMesh floor;
+        floor.positions = { { -50.0f, -1.0f, -20.0f }, { 50.0f, -1.0f, -20.0f }, { 50.0f, -1.0f, 200.0f }, { -50.0f, -1.0f, 200.0f } };
+        floor.indices = { 0, 1, 2, 0, 2, 3 };
+
+        OcclusionCuller culler;
+        culler.BeginFrame(ViewProj());
+        culler.AddOccluder(floor, Identity());
+        culler.Rasterize();
+        CHECK(culler.GetStats().occluderTriangles >= 2);
+
+        CHECK(!culler.IsVisible(XMFLOAT3(0.0f, -10.0f, 30.0f), XMFLOAT3(2.0f, 2.0f, 2.0f)));  // Under the floor
+        CHECK(culler.IsVisible(XMFLOAT3(0.0f, 1.0f, 30.0f), XMFLOAT3(2.0f, 0.5f, 2.0f)));     // Above it
+    }
+
+    void TestCullMatchesProjection()
+    {
+        // Boxes behind the wall whose projection is well inside it are hidden, boxes whose projection
+        // is well outside it are kept; Cull keeps the order of the survivors
+        const float wallZ = 10.0f, wallHalf = 5.0f;
+        OcclusionCuller culler;
+        culler.BeginFrame(ViewProj());
+        culler.AddOccluder(MakeWall(wallZ, wallHalf), Identity());
+        culler.Rasterize();
+
+        FrustumCuller boxes;
+        std::vector<int> expected; // 1 visible, 0 hidden, -1 either
+        for (uint32_t i = 0; i < 5000; ++i)
+        {
+            const float z = Test::Random(5 * i, wallZ + 1.0f, 100.0f);
+            const XMFLOAT3 center(Test::Random(5 * i + 1, -2.0f, 2.0f) * z / wallZ * wallHalf,
+                                  Test::Random(5 * i + 2, -2.0f, 2.0f) * z / wallZ * wallHalf, z);
+            const XMFLOAT3 extents(Test::Random(5 * i + 3, 0.1f, 2.0f), Test::Random(5 * i + 4, 0.1f, 2.0f), 0.5f);
+            boxes.Add(center, extents);
+
+            // Screen extent on the wall plane: the nearest face projects largest, and the box clears
+            // the wall's silhouette entirely if even its farthest face does
+            const float nearZ = z - extents.z, farZ = z + extents.z;
+            const float scale = wallZ / nearZ;
+            const float low = std::min((center.x - extents.x) * scale, (center.y - extents.y) * scale);
+            const float high = std::max((center.x + extents.x) * scale, (center.y + extents.y) * scale);
+            const float margin = 0.2f;
+            if (low > -wallHalf + margin && high < wallHalf - margin) expected.push_back(0);
+            else if (std::fabs(center.x) - extents.x > (wallHalf + margin) * farZ / wallZ ||
+                     std::fabs(center.y) - extents.y > (wallHalf + margin) * farZ / wallZ) expected.push_back(1);
+            else expected.push_back(-1);
+        }
+
+        std::vector<uint32_t> indices(boxes.GetCount());
+        for (uint32_t i = 0; i < indices.size(); ++i) indices[i] = i;
+        FrameArena::Get().BeginFrame();
+        const size_t count = culler.Cull(boxes, indices.data(), indices.size());
+        CHECK(culler.GetStats().testedCount == boxes.GetCount());
+        CHECK(culler.GetStats().culledCount == boxes.GetCount() - count);
+
+        std::vector<uint8_t> kept(boxes.GetCount(), 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            kept[indices[i]] = 1;
+            if (i > 0) CHECK(indices[i - 1] < indices[i]);
+        }
+        size_t hidden = 0, visible = 0;
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            if (expected[i] == 0) CHECK(!kept[i]);
+            if (expected[i] == 1) CHECK(kept[i]);
+            hidden += expected[i] == 0;
+            visible += expected[i] == 1;
+        }
+        CHECK(hidden > 100 && visible > 100);
+    }
+
+    void TestNothingToDoWithoutOccluders()
+    {
+        OcclusionCuller culler;
+        culler.BeginFrame(ViewProj());
+        culler.Rasterize();
+        CHECK(!culler.HasOccluders());
+        for (uint32_t level = 0; level < GetLevelCount(culler); ++level) CHECK(IsLevelClear(culler, level));
+
+        FrustumCuller boxes;
+        boxes.Add(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+        uint32_t index = 0;
+        CHECK(culler.Cull(boxes, &index, 1) == 1);
+        CHECK(culler.GetStats().culledCount == 0);
+
+        // Occluders entirely off screen are dropped before rasterization
+        culler.BeginFrame(ViewProj());
+        culler.AddOccluder(MakeWall(-10.0f, 5.0f), Identity());
+        culler.Rasterize();
+        CHECK(!culler.HasOccluders());
+        CHECK(culler.GetStats().occluderTriangles == 0);
+    }
+
+    void TestDepthIsClearedAfterOccludersDisappear()
+    {
+        OcclusionCuller culler;
+        const XMFLOAT3 center(0.0f, 0.0f, 20.0f), extents(1.0f, 1.0f, 1.0f);
+        culler.BeginFrame(ViewProj());
+        culler.AddOccluder(MakeWall(10.0f, 5.0f), Identity());
+        culler.Rasterize();
+        CHECK(!culler.IsVisible(center, extents));
+        CHECK(!IsLevelClear(culler, 0));
+
+        // The next frame has no occluders: every pyramid level must be clear again
+        culler.BeginFrame(ViewProj());
+        culler.Rasterize();
+        for (uint32_t level = 0; level < GetLevelCount(culler); ++level) CHECK(IsLevelClear(culler, level));
+        CHECK(culler.IsVisible(center, extents));
+
+        // And occluders coming back are rasterized into a clear buffer
+        culler.BeginFrame(ViewProj());
+        culler.AddOccluder(MakeWall(30.0f, 5.0f), Identity());
+        culler.Rasterize();
+        CHECK(culler.IsVisible(center, extents));
+        CHECK(!culler.IsVisible(XMFLOAT3(0.0f, 0.0f, 60.0f), extents));
+    }
+}
+
+int main()
+{
+    TestWallHidesBoxesBehindIt();
+    TestNearClippedOccluder();
+    TestCullMatchesProjection();
+    TestNothingToDoWithoutOccluders();
+    TestDepthIsClearedAfterOccludersDisappear();
+    return Test::Result();
+}
@@ -0,0 +1,125 @@
+#include "Check.h"
+#include "FrameworkObjects/Scene.h"
+#include "FrameworkObjects/SceneCommandBuffer.h"
+
+namespace
+{
+    struct Health : Component
+    {
+        int value = 0;
+
+        Health() = default;
+        explicit Health(int initial) : value(initial) {}
+    };
+
+    int CountHealth(Scene& scene, int* outSum = nullptr)
+    {
+        int count = 0;
+        int sum = 0;
+        scene.ForEach<Health>([&](Entity, Health& health)
+        {
+            ++count;
+            sum += health.value;
+        });
+        if (outSum) *outSum = sum;
+        return count;
+    }
+
+    void TestPendingEntitiesResolveOnPlayback()
+    {
+        Scene scene;
+        SceneCommandBuffer buffer;
+        const Entity first = buffer.CreateEntity();
+        const Entity second = buffer.CreateEntity();
+        CHECK(SceneCommandBuffer::IsPending(first));
+        CHECK(!scene.IsAlive(first));
+
+        buffer.AddComponent<Health>(first, 3);
+        buffer.AddComponent<Health>(second, 4);
+        buffer.RemoveComponent<Health>(second);
+        buffer.Playback(scene);
+
+        int sum = 0;
+        CHECK(CountHealth(scene, &sum) == 1);
+        CHECK(sum == 3);
+        CHECK(buffer.IsEmpty());
+    }
+
+    void TestPendingEntityOfAnotherBufferIsIgnored()
+    {
+        Scene scene;
+        SceneCommandBuffer buffer;
+        SceneCommandBuffer other;
+        const Entity foreign = other.CreateEntity();
+        const Entity own = buffer.CreateEntity();
+        CHECK(foreign.index == own.index); // Same slot, different epoch
+
+        buffer.AddComponent<Health>(foreign, 7);
+        buffer.Playback(scene);
+        CHECK(CountHealth(scene) == 0);
+
+        other.AddComponent<Health>(foreign, 9);
+        other.Playback(scene);
+        int sum = 0;
+        CHECK(CountHealth(scene, &sum) == 1);
+        CHECK(sum == 9);
+    }
+
+    void TestPendingEntityOfEarlierPlaybackIsIgnored()
+    {
+        Scene scene;
+        SceneCommandBuffer buffer;
+        const Entity stale = buffer.CreateEntity();
+        buffer.Playback(scene);
+
+        // The new recording reuses slot 0; the old handle must not resolve to its entity
+        const Entity fresh = buffer.CreateEntity();
+        CHECK(fresh.index == stale.index);
+        CHECK(fresh.generation != stale.generation);
+        buffer.AddComponent<Health>(stale, 1);
+        buffer.SetHidden(stale, true);
+        buffer.RemoveEntity(stale);
+        buffer.Playback(scene);
+        CHECK(CountHealth(scene) == 0);
+    }
+
+    void TestPendingIndexOutOfRangeIsIgnored()
+    {
+        Scene scene;
+        SceneCommandBuffer buffer;
+        const Entity pending = buffer.CreateEntity();
+        const Entity forged{ pending.index + 1000, pending.generation };
+        CHECK(SceneCommandBuffer::IsPending(forged));
+
+        buffer.AddComponent<Health>(forged, 5);
+        buffer.RemoveEntity(forged);
+        buffer.AddComponent<Health>(pending, 2);
+        buffer.Playback(scene);
+
+        int sum = 0;
+        CHECK(CountHealth(scene, &sum) == 1);
+        CHECK(sum == 2);
+    }
+
+    void TestCommandsOnRemovedEntitiesAreSkipped()
+    {
+        Scene scene;
+        const Entity entity = scene.CreateEntity();
+        SceneCommandBuffer buffer;
+        buffer.RemoveEntity(entity);
+        buffer.AddComponent<Health>(entity, 1);
+        buffer.Playback(scene);
+        CHECK(!scene.IsAlive(entity));
+        CHECK(CountHealth(scene) == 0);
+    }
+}
+
+int main()
+{
+    TestPendingEntitiesResolveOnPlayback();
+    TestPendingEntityOfAnotherBufferIsIgnored();
+    TestPendingEntityOfEarlierPlaybackIsIgnored();
+    TestPendingIndexOutOfRangeIsIgnored();
+    TestCommandsOnRemovedEntitiesAreSkipped();
+    return Test::Result();
+}
@@ -0,0 +1,193 @@
+#include "Check.h"
+#include "Core/Memory/FrameArena.h"
+#include "FrameworkObjects/Scene.h"
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct BoxRenderer : RendererComponent
+    {
+        void Render(ComPtr<ID3D12GraphicsCommandList>&) override {}
+    };
+
+    // One iteration of the main loop
+    void UpdateFrame(Scene& scene)
+    {
+        FrameArena::Get().BeginFrame();
+        scene.Update(0.0f);
+    }
+
+    BoundingBox UnitBox()
+    {
+        return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f));
+    }
+
+    std::vector<Entity> QueryAt(const Scene& scene, float x, float y, float z)
+    {
+        std::vector<Entity> found;
+        scene.QueryBox(BoundingBox(XMFLOAT3(x, y, z), XMFLOAT3(0.1f, 0.1f, 0.1f)), [&](Entity entity) { found.push_back(entity); });
+        return found;
+    }
+
+    bool Finds(const Scene& scene, Entity entity, float x, float y, float z)
+    {
+        for (Entity found : QueryAt(scene, x, y, z))
+        {
+            if (found == entity) return true;
+        }
+        return false;
+    }
+
+    void TestEntityWithoutTransformIsIndexed()
+    {
+        Scene scene;
+        const Entity entity = scene.CreateEntity();
+        scene.AddComponent<BoxRenderer>(entity).SetBounds(UnitBox());
+        CHECK(QueryAt(scene, 0.0f, 0.0f, 0.0f).empty());
+
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 0.0f, 0.0f, 0.0f));
+    }
+
+    void TestSetBoundsAloneUpdatesIndex()
+    {
+        Scene scene;
+        const Entity entity = scene.CreateEntity();
+        scene.AddComponent<BoxRenderer>(entity).SetBounds(UnitBox());
+        UpdateFrame(scene);
+
+        // No transform involved: only the renderer's bounds move
+        scene.GetComponent<BoxRenderer>(entity)->SetBounds(BoundingBox(XMFLOAT3(10.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 10.0f, 0.0f, 0.0f));
+        CHECK(!Finds(scene, entity, 0.0f, 0.0f, 0.0f));
+    }
+
+    void TestSetBoundsFromParallelSystem()
+    {
+        class GrowSystem : public System
+        {
+        public:
+            GrowSystem() { Writes<BoxRenderer>(); }
+
+            void Update(Scene& scene, float) override
+            {
+                scene.ForEachParallel<BoxRenderer>([](Entity entity, BoxRenderer& renderer)
+                {
+                    renderer.SetBounds(BoundingBox(XMFLOAT3(float(entity.index) * 4.0f, 20.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+                });
+            }
+        };
+
+        Scene scene;
+        std::vector<Entity> entities;
+        scene.AddEntities<BoxRenderer>(5000, [](size_t, BoxRenderer&) {}, &entities);
+        scene.AddSystem(std::make_unique<GrowSystem>());
+        UpdateFrame(scene);
+
+        for (Entity entity : entities)
+        {
+            CHECK(Finds(scene, entity, float(entity.index) * 4.0f, 20.0f, 0.0f));
+        }
+    }
+
+    void TestMovedTransformUpdatesIndex()
+    {
+        Scene scene;
+        const Entity parent = scene.CreateEntity();
+        scene.AddComponent<TransformComponent>(parent);
+        const Entity child = scene.CreateEntity();
+        scene.AddComponent<TransformComponent>(child, 1.0f, 0.0f, 0.0f);
+        scene.AddComponent<BoxRenderer>(child).SetBounds(UnitBox());
+        CHECK(scene.SetParent(child, parent));
+        UpdateFrame(scene);
+        CHECK(Finds(scene, child, 1.0f, 0.0f, 0.0f));
+
+        // Moving the parent alone must move the child's leaf
+        scene.GetComponent<TransformComponent>(parent)->SetPosition(XMFLOAT3(0.0f, 5.0f, 0.0f));
+        UpdateFrame(scene);
+        CHECK(Finds(scene, child, 1.0f, 5.0f, 0.0f));
+        CHECK(!Finds(scene, child, 1.0f, 0.0f, 0.0f));
+    }
+
+    void TestHiddenEntitiesLeaveIndex()
+    {
+        Scene scene;
+        const Entity entity = scene.CreateEntity();
+        scene.AddComponent<TransformComponent>(entity);
+        scene.AddComponent<BoxRenderer>(entity).SetBounds(UnitBox());
+        UpdateFrame(scene);
+
+        scene.SetHidden(entity, true);
+        CHECK(!Finds(scene, entity, 0.0f, 0.0f, 0.0f));
+        CHECK(scene.Raycast(XMFLOAT3(0.0f, 0.0f, -5.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), 10.0f).IsNull());
+
+        // Changes made while hidden are picked up when it is shown again
+        scene.GetComponent<TransformComponent>(entity)->SetPosition(XMFLOAT3(3.0f, 0.0f, 0.0f));
+        UpdateFrame(scene);
+        CHECK(!Finds(scene, entity, 3.0f, 0.0f, 0.0f));
+
+        scene.SetHidden(entity, false);
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 3.0f, 0.0f, 0.0f));
+    }
+
+    void TestComponentChangesUpdateIndex()
+    {
+        Scene scene;
+        const Entity entity = scene.CreateEntity();
+        scene.AddComponent<BoxRenderer>(entity).SetBounds(UnitBox());
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 0.0f, 0.0f, 0.0f));
+
+        scene.AddComponent<TransformComponent>(entity, 0.0f, 0.0f, 7.0f);
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 0.0f, 0.0f, 7.0f));
+
+        // Without its transform the entity falls back to the identity
+        scene.RemoveComponent<TransformComponent>(entity);
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 0.0f, 0.0f, 0.0f));
+        CHECK(!Finds(scene, entity, 0.0f, 0.0f, 7.0f));
+
+        scene.RemoveComponent<BoxRenderer>(entity);
+        UpdateFrame(scene);
+        CHECK(QueryAt(scene, 0.0f, 0.0f, 0.0f).empty());
+
+        scene.RemoveEntity(entity);
+        UpdateFrame(scene);
+        CHECK(QueryAt(scene, 0.0f, 0.0f, 0.0f).empty());
+    }
+
+    void TestCopiedRendererIsNotBound()
+    {
+        Scene scene;
+        const Entity entity = scene.CreateEntity();
+        scene.AddComponent<BoxRenderer>(entity).SetBounds(UnitBox());
+        UpdateFrame(scene);
+
+        BoxRenderer copy = *scene.GetComponent<BoxRenderer>(entity);
+        copy.SetBounds(BoundingBox(XMFLOAT3(9.0f, 0.0f, 0.0f), XMFLOAT3(0.5f, 0.5f, 0.5f)));
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 0.0f, 0.0f, 0.0f));
+
+        // Assigning into the scene's component keeps it bound and moves the leaf
+        *scene.GetComponent<BoxRenderer>(entity) = copy;
+        UpdateFrame(scene);
+        CHECK(Finds(scene, entity, 9.0f, 0.0f, 0.0f));
+    }
+}
+
+int main()
+{
+    TestEntityWithoutTransformIsIndexed();
+    TestSetBoundsAloneUpdatesIndex();
+    TestSetBoundsFromParallelSystem();
+    TestMovedTransformUpdatesIndex();
+    TestHiddenEntitiesLeaveIndex();
+    TestComponentChangesUpdateIndex();
+    TestCopiedRendererIsNotBound();
+    return Test::Result();
+}
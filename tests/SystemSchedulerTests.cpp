@@ -0,0 +1,143 @@
+#include "Check.h"
+#include "Core/Memory/FrameArena.h"
+#include "FrameworkObjects/Scene.h"
+#include "FrameworkObjects/SceneCommandBuffer.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    struct Spawner : Component
+    {
+        uint32_t id = 0;
+        uint32_t childCount = 0;
+    };
+
+    struct Child : Component
+    {
+        uint32_t parentId = 0;
+        uint32_t ordinal = 0;
+
+        Child() = default;
+        Child(uint32_t parent, uint32_t index) : parentId(parent), ordinal(index) {}
+    };
+
+    struct Counter : Component
+    {
+        uint32_t value = 0;
+    };
+
+    // Every spawner creates its children from a parallel loop
+    class SpawnSystem : public System
+    {
+    public:
+        SpawnSystem() { Reads<Spawner>(); }
+
+        void Update(Scene& scene, float) override
+        {
+            SceneCommandBuffer& commands = scene.GetCommandBuffer();
+            scene.ForEachParallel<Spawner>([&commands](Entity, Spawner& spawner)
+            {
+                for (uint32_t i = 0; i < spawner.childCount; ++i)
+                {
+                    commands.AddComponent<Child>(commands.CreateEntity(), spawner.id, i);
+                }
+            });
+        }
+    };
+
+    // Runs in the same wave as SpawnSystem and records directly, before and after a parallel loop
+    class CounterSystem : public System
+    {
+    public:
+        CounterSystem() { Writes<Counter>(); }
+
+        void Update(Scene& scene, float) override
+        {
+            SceneCommandBuffer& commands = scene.GetCommandBuffer();
+            const Entity first = commands.CreateEntity();
+            commands.AddComponent<Child>(first, MarkerBefore, 0u);
+            scene.ForEachParallel<Counter>([](Entity, Counter& counter) { ++counter.value; });
+            const Entity last = commands.CreateEntity();
+            commands.AddComponent<Child>(last, MarkerAfter, 0u);
+        }
+
+        static constexpr uint32_t MarkerBefore = 1000000;
+        static constexpr uint32_t MarkerAfter = 1000001;
+    };
+
+    // Playback creates entities in command order, and a fresh scene hands out indices in creation
+    // order, so sorting children by index shows the order their commands were applied in
+    std::vector<Child> ChildrenByIndex(Scene& scene)
+    {
+        std::vector<std::pair<uint32_t, Child>> children;
+        scene.ForEach<Child>([&](Entity entity, Child& child) { children.emplace_back(entity.index, child); });
+        std::sort(children.begin(), children.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        std::vector<Child> result;
+        for (const auto& child : children) result.push_back(child.second);
+        return result;
+    }
+
+    void TestParallelCommandsApplyInSystemAndChunkOrder()
+    {
+        Scene scene;
+        const uint32_t spawnerCount = 5000;
+        std::vector<uint32_t> ids;
+        scene.AddEntities<Spawner>(spawnerCount, [](size_t i, Spawner& spawner)
+        {
+            spawner.id = static_cast<uint32_t>(i);
+            spawner.childCount = 1 + static_cast<uint32_t>(i % 3);
+        });
+        scene.AddEntities<Counter>(1000, [](size_t, Counter&) {});
+
+        // ForEach visits chunks in the order ForEachParallel numbers them
+        scene.ForEach<Spawner>([&ids](Entity, Spawner& spawner) { ids.push_back(spawner.id); });
+        scene.AddSystem(std::make_unique<SpawnSystem>());
+        scene.AddSystem(std::make_unique<CounterSystem>());
+        FrameArena::Get().BeginFrame();
+        scene.Update(0.0f);
+
+        const std::vector<Child> children = ChildrenByIndex(scene);
+        std::vector<Child> expected;
+        for (uint32_t id : ids)
+        {
+            for (uint32_t i = 0; i < 1 + id % 3; ++i) expected.emplace_back(id, i);
+        }
+        expected.emplace_back(CounterSystem::MarkerBefore, 0);
+        expected.emplace_back(CounterSystem::MarkerAfter, 0);
+
+        bool ordered = children.size() == expected.size();
+        for (size_t i = 0; ordered && i < children.size(); ++i)
+        {
+            ordered = children[i].parentId == expected[i].parentId && children[i].ordinal == expected[i].ordinal;
+        }
+        CHECK(ordered);
+    }
+
+    void TestCommandsOutsideSystemsKeepRecordingOrder()
+    {
+        Scene scene;
+        SceneCommandBuffer& commands = scene.GetCommandBuffer();
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            commands.AddComponent<Child>(commands.CreateEntity(), i, 0u);
+        }
+        FrameArena::Get().BeginFrame();
+        scene.Update(0.0f);
+
+        const std::vector<Child> children = ChildrenByIndex(scene);
+        bool ordered = children.size() == 100;
+        for (uint32_t i = 0; ordered && i < children.size(); ++i) ordered = children[i].parentId == i;
+        CHECK(ordered);
+    }
+}
+
+int main()
+{
+    JobSystem::SetDefaultThreadCount(4);
+    TestParallelCommandsApplyInSystemAndChunkOrder();
+    TestCommandsOutsideSystemsKeepRecordingOrder();
+    return Test::Result();
+}
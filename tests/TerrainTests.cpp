@@ -0,0 +1,318 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Terrain/HeightField.h"
+#include "Core/Terrain/Terrain.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr uint32_t DxgiBC4Unorm = 80;
+
+    constexpr uint32_t FourCC(char a, char b, char c, char d)
+    {
+        return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+    }
+
+    void WriteU32(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+    {
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    // Writes a DDS file with a FourCC pixel format; dxgiFormat adds the DX10 header instead
+    std::filesystem::path WriteDds(const char* name, uint32_t width, uint32_t height, uint32_t fourCC,
+                                   uint32_t dxgiFormat, const std::vector<uint8_t>& image)
+    {
+        std::vector<uint8_t> file(dxgiFormat ? 148 : 128, 0);
+        WriteU32(file, 0, FourCC('D', 'D', 'S', ' '));
+        WriteU32(file, 4, 124);
+        WriteU32(file, 12, height);
+        WriteU32(file, 16, width);
+        WriteU32(file, 76, 32);
+        WriteU32(file, 80, 0x4); // DDPF_FOURCC
+        WriteU32(file, 84, dxgiFormat ? FourCC('D', 'X', '1', '0') : fourCC);
+        if (dxgiFormat)
+        {
+            WriteU32(file, 128, dxgiFormat);
+            WriteU32(file, 132, 3); // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+            WriteU32(file, 140, 1); // Array size
+        }
+        file.insert(file.end(), image.begin(), image.end());
+
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(file.data()), std::streamsize(file.size()));
+        return path;
+    }
+
+    void AppendBC4Block(std::vector<uint8_t>& image, uint8_t red0, uint8_t red1, const uint32_t (&indices)[16])
+    {
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 16; ++i) bits |= uint64_t(indices[i]) << (3 * i);
+        image.push_back(red0);
+        image.push_back(red1);
+        for (uint32_t i = 0; i < 6; ++i) image.push_back(uint8_t(bits >> (8 * i)));
+    }
+
+    void AppendBC1Block(std::vector<uint8_t>& image, uint16_t color0, uint16_t color1, const uint32_t (&indices)[16])
+    {
+        uint32_t bits = 0;
+        for (uint32_t i = 0; i < 16; ++i) bits |= indices[i] << (2 * i);
+        const uint8_t bytes[8] = { uint8_t(color0), uint8_t(color0 >> 8), uint8_t(color1), uint8_t(color1 >> 8),
+                                   uint8_t(bits), uint8_t(bits >> 8), uint8_t(bits >> 16), uint8_t(bits >> 24) };
+        image.insert(image.end(), bytes, bytes + 8);
+    }
+
+    // Two 4x4 blocks side by side, one per palette mode, each texel t of the top row using index t
+    void TestBC4Decode()
+    {
+        const uint32_t ramp[16] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+        std::vector<uint8_t> image;
+        AppendBC4Block(image, 255, 0, ramp);  // red0 > red1: six interpolated values
+        AppendBC4Block(image, 51, 204, ramp); // red0 <= red1: four interpolated values, then 0 and 1
+
+        const float eightValues[8] = { 1.0f, 0.0f, 6 / 7.0f, 5 / 7.0f, 4 / 7.0f, 3 / 7.0f, 2 / 7.0f, 1 / 7.0f };
+        const float sixValues[8] = { 0.2f, 0.8f, 0.32f, 0.44f, 0.56f, 0.68f, 0.0f, 1.0f };
+
+        // The legacy FourCC and the DX10 header decode the same way
+        const std::filesystem::path paths[2] = { WriteDds("nene_terrain_bc4.dds", 8, 4, FourCC('A', 'T', 'I', '1'), 0, image),
+                                                 WriteDds("nene_terrain_bc4_dx10.dds", 8, 4, 0, DxgiBC4Unorm, image) };
+        for (const std::filesystem::path& path : paths)
+        {
+            HeightField heightField;
+            CHECK(heightField.LoadDds(path));
+            CHECK(heightField.GetWidth() == 8 && heightField.GetHeight() == 4);
+            for (int32_t x = 0; x < 4; ++x)
+            {
+                CHECK_NEAR(heightField.GetSample(x, 0), eightValues[x], 1e-6f);
+                CHECK_NEAR(heightField.GetSample(x, 1), eightValues[x + 4], 1e-6f);
+                CHECK_NEAR(heightField.GetSample(x + 4, 0), sixValues[x], 1e-6f);
+                CHECK_NEAR(heightField.GetSample(x + 4, 1), sixValues[x + 4], 1e-6f);
+                CHECK_NEAR(heightField.GetSample(x, 3), 1.0f, 1e-6f);
+            }
+            std::filesystem::remove(path);
+        }
+    }
+
+    // A 6x6 image: the right and bottom blocks hang over it by two texels
+    void TestBC1Decode()
+    {
+        const uint32_t byColumn[16] = { 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 };
+        const uint32_t allZero[16] = {};
+        const uint32_t allTwo[16] = { 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 };
+        std::vector<uint8_t> image;
+        AppendBC1Block(image, 0xffff, 0x0000, byColumn); // White and black, four colours
+        AppendBC1Block(image, 0x0000, 0xf800, byColumn); // Black and red, three colours and transparent black
+        AppendBC1Block(image, 0x07e0, 0x001f, allZero);  // Green: one channel of three
+        AppendBC1Block(image, 0xffff, 0xffff, allTwo);   // Equal endpoints take the three colour mode
+
+        // Texels are the mean of the red, green and blue channels
+        const float palettes[4][4] = {
+            { 1.0f, 0.0f, 2 / 3.0f, 1 / 3.0f },
+            { 0.0f, 1 / 3.0f, 1 / 6.0f, 0.0f },
+            { 1 / 3.0f, 1 / 3.0f, 1 / 3.0f, 1 / 3.0f },
+            { 1.0f, 1.0f, 1.0f, 1.0f },
+        };
+        const uint32_t* indices[4] = { byColumn, byColumn, allZero, allTwo };
+
+        const std::filesystem::path path = WriteDds("nene_terrain_bc1.dds", 6, 6, FourCC('D', 'X', 'T', '1'), 0, image);
+        HeightField heightField;
+        CHECK(heightField.LoadDds(path));
+        CHECK(heightField.GetWidth() == 6 && heightField.GetHeight() == 6);
+        CHECK(heightField.GetSamples().size() == 36);
+        for (int32_t y = 0; y < 6; ++y)
+        {
+            for (int32_t x = 0; x < 6; ++x)
+            {
+                const uint32_t block = (y / 4) * 2 + x / 4;
+                const uint32_t texel = (y % 4) * 4 + x % 4;
+                CHECK_NEAR(heightField.GetSample(x, y), palettes[block][indices[block][texel]], 1e-6f);
+            }
+        }
+        std::filesystem::remove(path);
+    }
+
+    void TestTruncatedImageIsRejected()
+    {
+        const uint32_t allZero[16] = {};
+        std::vector<uint8_t> image;
+        AppendBC1Block(image, 0xffff, 0x0000, allZero);
+        const std::filesystem::path path = WriteDds("nene_terrain_truncated.dds", 8, 4, FourCC('D', 'X', 'T', '1'), 0, image);
+        HeightField heightField;
+        CHECK(!heightField.LoadDds(path));
+        CHECK(heightField.GetSamples().empty());
+        std::filesystem::remove(path);
+    }
+
+    void MakeBumpyField(HeightField& heightField, uint32_t side)
+    {
+        std::vector<float> samples(size_t(side) * side);
+        for (size_t i = 0; i < samples.size(); ++i) samples[i] = Test::Random(uint32_t(i), 0.0f, 1.0f);
+        heightField.SetSamples(side, side, std::move(samples));
+    }
+
+    // Every plane passes: selection only depends on the projected errors
+    Frustum EverythingVisible()
+    {
+        Frustum frustum;
+        for (XMFLOAT4& plane : frustum.planes) plane = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+        return frustum;
+    }
+
+    // Calls Select until the chunks it asks for are generated and the selection settles
+    std::vector<uint32_t> SelectSettled(Terrain& terrain, const Frustum& frustum, const XMFLOAT3& eye, const LodSelector& selector)
+    {
+        std::vector<uint32_t> nodes, previous;
+        for (int frame = 0; frame < 32; ++frame)
+        {
+            nodes.clear();
+            terrain.Select(frustum, eye, selector, nodes);
+            terrain.WaitForChunks();
+            if (!nodes.empty() && nodes == previous) break;
+            previous = nodes;
+        }
+        return nodes;
+    }
+
+    void TestChunkIndices()
+    {
+        HeightField heightField;
+        MakeBumpyField(heightField, 65);
+        TerrainSettings settings;
+        settings.size = 64.0f;
+        settings.chunkQuads = 20; // Rounded up to a power of two
+        settings.levelCount = 2;
+        Terrain terrain;
+        terrain.Build(heightField, settings);
+
+        const uint32_t quads = terrain.GetSettings().chunkQuads, side = quads + 1;
+        CHECK(quads == 32);
+        const std::vector<uint16_t>& indices = terrain.GetChunkIndices();
+        // Two triangles per grid quad, then two per quad of each of the four skirts
+        CHECK(indices.size() == 6 * quads * quads + 4 * 6 * quads);
+
+        LodSelector selector;
+        selector.Setup(LodSettings(), 0.25f * XM_PI);
+        SelectSettled(terrain, EverythingVisible(), XMFLOAT3(0.0f, 1000.0f, 0.0f), selector);
+        CHECK(terrain.IsChunkReady(0));
+        const std::vector<GeometryGenerator::Vertex>& vertices = terrain.GetChunkVertices(0);
+        CHECK(vertices.size() == side * side + 4 * side);
+
+        size_t outOfRange = 0, degenerate = 0, offBorder = 0;
+        const Aabb& bounds = terrain.GetNodeBounds(0);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const uint16_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            if (a >= vertices.size() || b >= vertices.size() || c >= vertices.size())
+            {
+                ++outOfRange;
+                continue;
+            }
+            if (a == b || b == c || a == c) ++degenerate;
+
+            // Skirt triangles stand on one edge of the chunk
+            if (i < 6 * quads * quads) continue;
+            const XMFLOAT3 p[3] = { vertices[a].Position, vertices[b].Position, vertices[c].Position };
+            const auto onEdge = [&](float XMFLOAT3::*axis, float edge)
+            {
+                return p[0].*axis == edge && p[1].*axis == edge && p[2].*axis == edge;
+            };
+            if (!onEdge(&XMFLOAT3::x, bounds.min.x) && !onEdge(&XMFLOAT3::x, bounds.max.x) &&
+                !onEdge(&XMFLOAT3::z, bounds.min.z) && !onEdge(&XMFLOAT3::z, bounds.max.z))
+                ++offBorder;
+        }
+        CHECK(outOfRange == 0);
+        CHECK(degenerate == 0);
+        CHECK(offBorder == 0);
+
+        // Skirt rows repeat the edge vertices, lowered to the bottom of the node's bounds
+        for (uint32_t t = 0; t < 4 * side; ++t)
+        {
+            const XMFLOAT3& skirt = vertices[side * side + t].Position;
+            CHECK(skirt.y >= bounds.min.y - 1e-4f);
+            CHECK(skirt.x == bounds.min.x || skirt.x == bounds.max.x || skirt.z == bounds.min.z || skirt.z == bounds.max.z);
+        }
+    }
+
+    void TestNodeLevels()
+    {
+        HeightField heightField;
+        MakeBumpyField(heightField, 65);
+        TerrainSettings settings;
+        settings.size = 64.0f;
+        settings.chunkQuads = 4;
+        settings.levelCount = 3;
+        Terrain terrain;
+        terrain.Build(heightField, settings);
+
+        CHECK(terrain.GetNodeCount() == 1 + 4 + 16);
+        for (uint32_t node = 0; node < terrain.GetNodeCount(); ++node)
+        {
+            const uint32_t expected = node == 0 ? 0 : node < 5 ? 1 : 2;
+            CHECK(terrain.GetNodeLevel(node) == expected);
+        }
+        // The finest level samples the grid exactly; coarser levels never have less error than their children
+        for (uint32_t node = 5; node < terrain.GetNodeCount(); ++node) CHECK(terrain.GetNodeError(node) == 0.0f);
+        CHECK(terrain.GetNodeError(0) > 0.0f);
+        for (uint32_t node = 1; node < 5; ++node) CHECK(terrain.GetNodeError(node) <= terrain.GetNodeError(0));
+    }
+
+    void TestSelectionLevels()
+    {
+        HeightField heightField;
+        MakeBumpyField(heightField, 65);
+        TerrainSettings settings;
+        settings.size = 64.0f;
+        settings.chunkQuads = 4;
+        settings.levelCount = 3;
+        Terrain terrain;
+        terrain.Build(heightField, settings);
+
+        const float fovY = 0.25f * XM_PI;
+        LodSelector selector;
+        selector.Setup(LodSettings(), fovY);
+
+        // From far away the root alone is under the threshold
+        std::vector<uint32_t> nodes = SelectSettled(terrain, EverythingVisible(), XMFLOAT3(0.0f, 1.0e6f, 0.0f), selector);
+        CHECK(nodes == std::vector<uint32_t>{ 0 });
+
+        // Close to the ground with a tiny threshold every node refines down to the finest level,
+        // which covers the terrain once
+        LodSettings sharp;
+        sharp.pixelThreshold = 1e-4f;
+        selector.Setup(sharp, fovY);
+        const XMFLOAT3 eye(0.0f, settings.heightScale + 1.0f, 0.0f);
+        nodes = SelectSettled(terrain, EverythingVisible(), eye, selector);
+        CHECK(nodes.size() == 16);
+        float area = 0.0f;
+        for (uint32_t node : nodes)
+        {
+            CHECK(terrain.GetNodeLevel(node) == 2);
+            CHECK(terrain.IsChunkReady(node));
+            const Aabb& bounds = terrain.GetNodeBounds(node);
+            area += (bounds.max.x - bounds.min.x) * (bounds.max.z - bounds.min.z);
+        }
+        CHECK_NEAR(area, settings.size * settings.size, 1e-2f);
+
+        // Nodes wholly behind a plane at x = 1 are culled: two of the four columns remain
+        Frustum frustum = EverythingVisible();
+        frustum.planes[Frustum::Left] = XMFLOAT4(1.0f, 0.0f, 0.0f, -1.0f);
+        nodes = SelectSettled(terrain, frustum, eye, selector);
+        CHECK(nodes.size() == 8);
+        for (uint32_t node : nodes) CHECK(terrain.GetNodeBounds(node).max.x > 1.0f);
+    }
+}
+
+int main()
+{
+    TestBC4Decode();
+    TestBC1Decode();
+    TestTruncatedImageIsRejected();
+    TestChunkIndices();
+    TestNodeLevels();
+    TestSelectionLevels();
+    return Test::Result();
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+// Deterministic pseudo-random values for the tests, so a failure reproduces on every run and platform.
+namespace Test
+{
+    inline uint32_t Hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Uniform in [low, high]
+    inline float Random(uint32_t seed, float low, float high)
+    {
+        return low + float(Hash(seed) & 0xFFFFFF) / float(0xFFFFFF) * (high - low);
+    }
+}
@@ -0,0 +1,227 @@
+#include "Check.h"
+#include "TestRandom.h"
+#include "Core/Mesh/VertexCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+using Vertex = GeometryGenerator::Vertex;
+
+namespace
+{
+    XMFLOAT3 Normalize(const XMFLOAT3& v)
+    {
+        const float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+    }
+
+    float Angle(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        const XMFLOAT3 u = Normalize(a), v = Normalize(b);
+        // atan2 of |u x v| and u . v stays accurate for tiny angles, unlike acos
+        const XMFLOAT3 cross(u.y * v.z - u.z * v.y, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x);
+        const float sine = std::sqrt(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z);
+        return std::atan2(sine, u.x * v.x + u.y * v.y + u.z * v.z);
+    }
+
+    std::vector<XMFLOAT3> TestDirections()
+    {
+        // Axes, octahedron edges and faces (where the fold is), then random directions on the sphere
+        std::vector<XMFLOAT3> directions = {
+            { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+            { 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 },
+            { 1, 0, -1 }, { -1, 0, -1 }, { 0, 1, -1 }, { 0, -1, -1 },
+            { 1, 1, 1 }, { -1, -1, -1 }, { 1, -1, -1 }, { -1, 1, -1 },
+            { 1e-4f, 0, -1 }, { 0, 1e-4f, -1 }, { 1e-4f, 1e-4f, -1 }, { -1e-4f, -1e-4f, -1 },
+        };
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            const float z = Test::Random(2 * i, -1.0f, 1.0f);
+            const float phi = Test::Random(2 * i + 1, 0.0f, 2.0f * XM_PI);
+            const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            directions.emplace_back(r * std::cos(phi), r * std::sin(phi), z);
+        }
+        return directions;
+    }
+
+    void TestPositionsWithinError()
+    {
+        std::vector<Vertex> vertices;
+        for (uint32_t i = 0; i < 10000; ++i)
+        {
+            Vertex vertex;
+            vertex.Position = XMFLOAT3(Test::Random(3 * i, -37.0f, 120.0f), Test::Random(3 * i + 1, 0.001f, 0.002f), Test::Random(3 * i + 2, -5000.0f, 5000.0f));
+            vertices.push_back(vertex);
+        }
+        const VertexQuantization quantization = ComputeVertexQuantization(vertices.data(), vertices.size());
+        CHECK_NEAR(quantization.origin.x, -37.0f, 0.01f);
+        CHECK(quantization.size.x > 0.0f && quantization.size.y > 0.0f && quantization.size.z > 0.0f);
+
+        std::vector<PackedVertex> packed(vertices.size());
+        std::vector<Vertex> decoded(vertices.size());
+        EncodeVertices(packed.data(), vertices.data(), vertices.size(), quantization);
+        DecodeVertices(decoded.data(), packed.data(), packed.size(), quantization);
+
+        // Both bounds are hit exactly; every axis stays within its own fraction of the size
+        const XMFLOAT3& size = quantization.size;
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            CHECK(std::fabs(decoded[i].Position.x - vertices[i].Position.x) <= PackedVertexPositionError * size.x);
+            CHECK(std::fabs(decoded[i].Position.y - vertices[i].Position.y) <= PackedVertexPositionError * size.y);
+            CHECK(std::fabs(decoded[i].Position.z - vertices[i].Position.z) <= PackedVertexPositionError * size.z);
+        }
+    }
+
+    void TestFlatAxisDecodesToOrigin()
+    {
+        std::vector<Vertex> vertices(3);
+        vertices[0].Position = XMFLOAT3(0.0f, 2.5f, 0.0f);
+        vertices[1].Position = XMFLOAT3(1.0f, 2.5f, 0.0f);
+        vertices[2].Position = XMFLOAT3(0.0f, 2.5f, 1.0f);
+        const VertexQuantization quantization = ComputeVertexQuantization(vertices.data(), vertices.size());
+        CHECK(quantization.size.y == 0.0f);
+
+        PackedVertex packed[3];
+        Vertex decoded[3];
+        EncodeVertices(packed, vertices.data(), 3, quantization);
+        DecodeVertices(decoded, packed, 3, quantization);
+        for (const Vertex& vertex : decoded) CHECK(vertex.Position.y == 2.5f);
+        CHECK(decoded[1].Position.x == 1.0f);
+        CHECK(decoded[2].Position.z == 1.0f);
+    }
+
+    void TestDequantizationTransformMatchesDecode()
+    {
+        VertexQuantization quantization;
+        quantization.origin = XMFLOAT3(-3.0f, 1.0f, 10.0f);
+        quantization.size = XMFLOAT3(6.0f, 0.5f, 40.0f);
+        Vertex vertex;
+        vertex.Position = XMFLOAT3(1.25f, 1.1f, 33.0f);
+
+        PackedVertex packed;
+        Vertex decoded;
+        EncodeVertices(&packed, &vertex, 1, quantization);
+        DecodeVertices(&decoded, &packed, 1, quantization);
+
+        // What DequantizePosition in the shader does: UNORM position, then origin + position * size
+        const XMFLOAT4X4 m = GetDequantizationTransform(quantization);
+        const float unorm[3] = { packed.position[0] / 65535.0f, packed.position[1] / 65535.0f, packed.position[2] / 65535.0f };
+        const float x = unorm[0] * m._11 + unorm[1] * m._21 + unorm[2] * m._31 + m._41;
+        const float y = unorm[0] * m._12 + unorm[1] * m._22 + unorm[2] * m._32 + m._42;
+        const float z = unorm[0] * m._13 + unorm[1] * m._23 + unorm[2] * m._33 + m._43;
+        CHECK_NEAR(x, decoded.Position.x, 1e-5f);
+        CHECK_NEAR(y, decoded.Position.y, 1e-5f);
+        CHECK_NEAR(z, decoded.Position.z, 1e-5f);
+    }
+
+    void TestDirectionsWithinError()
+    {
+        const std::vector<XMFLOAT3> directions = TestDirections();
+        std::vector<Vertex> vertices(directions.size());
+        for (size_t i = 0; i < directions.size(); ++i)
+        {
+            // Unnormalized input is accepted; the tangent runs through the same encoding independently
+            const float scale = Test::Random(uint32_t(i) + 99991, 0.1f, 10.0f);
+            vertices[i].Normal = XMFLOAT3(directions[i].x * scale, directions[i].y * scale, directions[i].z * scale);
+            vertices[i].TangentU = directions[directions.size() - 1 - i];
+        }
+
+        std::vector<PackedVertex> packed(vertices.size());
+        std::vector<Vertex> decoded(vertices.size());
+        const VertexQuantization quantization;
+        EncodeVertices(packed.data(), vertices.data(), vertices.size(), quantization);
+        DecodeVertices(decoded.data(), packed.data(), packed.size(), quantization);
+
+        float worst = 0.0f;
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            const XMFLOAT3& normal = decoded[i].Normal;
+            CHECK_NEAR(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z, 1.0f, 1e-5f);
+            worst = std::max(worst, Angle(normal, vertices[i].Normal));
+            worst = std::max(worst, Angle(decoded[i].TangentU, vertices[i].TangentU));
+        }
+        CHECK(worst <= PackedVertexDirectionError);
+    }
+
+    void TestZeroDirectionDecodesToPlusZ()
+    {
+        Vertex vertex;
+        vertex.Normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        vertex.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        PackedVertex packed;
+        Vertex decoded;
+        EncodeVertices(&packed, &vertex, 1, VertexQuantization());
+        DecodeVertices(&decoded, &packed, 1, VertexQuantization());
+        CHECK(decoded.Normal.x == 0.0f && decoded.Normal.y == 0.0f && decoded.Normal.z == 1.0f);
+        CHECK(decoded.TangentU.z == 1.0f);
+    }
+
+    void TestTexCoordsWithinError()
+    {
+        std::vector<float> values = { 0.0f, 1.0f, -1.0f, 0.5f, 1e-6f, -1e-6f, 6.1e-5f, 3.0f / 7.0f, 1000.3f, -2047.9f, 65504.0f };
+        for (uint32_t i = 0; i < 10000; ++i)
+        {
+            // Log-uniform magnitudes from 2^-20 to 2^15, both signs
+            const float magnitude = std::exp2(Test::Random(2 * i, -20.0f, 15.0f));
+            values.push_back(Test::Hash(2 * i + 1) & 1 ? magnitude : -magnitude);
+        }
+
+        std::vector<Vertex> vertices(values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            vertices[i].TexC = XMFLOAT2(values[i], values[values.size() - 1 - i]);
+        }
+        std::vector<PackedVertex> packed(vertices.size());
+        std::vector<Vertex> decoded(vertices.size());
+        EncodeVertices(packed.data(), vertices.data(), vertices.size(), VertexQuantization());
+        DecodeVertices(decoded.data(), packed.data(), packed.size(), VertexQuantization());
+
+        // Relative to the magnitude; below the smallest normal half the step is fixed
+        const float smallestNormal = std::exp2(-14.0f);
+        auto withinError = [&](float original, float result)
+        {
+            return std::fabs(result - original) <= PackedVertexTexCError * std::max(std::fabs(original), smallestNormal);
+        };
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            CHECK(withinError(vertices[i].TexC.x, decoded[i].TexC.x));
+            CHECK(withinError(vertices[i].TexC.y, decoded[i].TexC.y));
+        }
+        CHECK(decoded[0].TexC.x == 0.0f);
+        CHECK(decoded[1].TexC.x == 1.0f);
+    }
+
+    void TestTangentSigns()
+    {
+        const float signs[] = { 1.0f, -1.0f, -1.0f, 1.0f, -0.5f };
+        Vertex vertices[5];
+        PackedVertex packed[5];
+        Vertex decoded[5];
+        float decodedSigns[5] = {};
+
+        EncodeVertices(packed, vertices, 5, VertexQuantization(), signs);
+        DecodeVertices(decoded, packed, 5, VertexQuantization(), decodedSigns);
+        for (int i = 0; i < 5; ++i)
+        {
+            CHECK(decodedSigns[i] == (signs[i] < 0.0f ? -1.0f : 1.0f));
+        }
+
+        // Without signs +1 is stored
+        EncodeVertices(packed, vertices, 5, VertexQuantization());
+        DecodeVertices(decoded, packed, 5, VertexQuantization(), decodedSigns);
+        for (float sign : decodedSigns) CHECK(sign == 1.0f);
+    }
+}
+
+int main()
+{
+    TestPositionsWithinError();
+    TestFlatAxisDecodesToOrigin();
+    TestDequantizationTransformMatchesDecode();
+    TestDirectionsWithinError();
+    TestZeroDirectionDecodesToPlusZ();
+    TestTexCoordsWithinError();
+    TestTangentSigns();
+    return Test::Result();
+}